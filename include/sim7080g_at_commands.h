@@ -1,5 +1,8 @@
 #pragma once
 
+#include <stdbool.h>
+#include <stdint.h>
+
 typedef enum
 {
     AT_CMD_TYPE_TEST,
@@ -14,6 +17,17 @@ typedef struct
     const char *response_format;
 } at_cmd_info_t;
 
+/// @brief How a failed command is sent again
+/// @note Only an explicit error reply known to be transient (e.g. SIM busy, network timeout) is retried for every command.
+///       A timeout leaves the outcome unknown - it is only retried for reads, tests and idempotent commands.
+typedef struct
+{
+    uint8_t max_attempts;   // Including the first attempt
+    uint16_t base_delay_ms; // Delay before the second attempt - doubled for each later attempt (with random jitter)
+    uint16_t max_delay_ms;  // Cap on the doubled delay
+    uint32_t deadline_ms;   // Stop retrying this long after the first attempt was sent - 0 for no limit
+} at_retry_policy_t;
+
 typedef struct
 {
     const char *name;
@@ -22,8 +36,25 @@ typedef struct
     at_cmd_info_t read;
     at_cmd_info_t write;
     at_cmd_info_t execute;
+    bool idempotent;               // The write / execute form can be sent twice with the same effect as once
+    const at_retry_policy_t *retry; // NULL selects AT_RETRY_DEFAULT
+    bool info_lines_are_urcs;      // Lines starting with the command's prefix are always URCs (e.g. "+SMSUB:" messages), never its answer
 } at_cmd_t;
 
+/// @brief Up to 4 attempts with a short backoff - for quick local commands
+extern const at_retry_policy_t AT_RETRY_DEFAULT;
+
+/// @brief Up to 3 attempts with a long backoff, within 60 s - for commands that wait on the network
+extern const at_retry_policy_t AT_RETRY_NETWORK;
+
+/// @brief A single attempt - for commands that must never be sent twice (e.g. they change the link or reset the device)
+extern const at_retry_policy_t AT_RETRY_ONCE;
+
+/// @brief Attention - Check that the device responds
+/// @return On success:
+///   - OK
+extern const at_cmd_t AT_AT;
+
 extern const at_cmd_t AT_ECHO_OFF;
 
 extern const at_cmd_t AT_CPIN;
@@ -266,6 +297,26 @@ extern const at_cmd_t AT_CMEE;
 ///   - 7 Offline mode
 extern const at_cmd_t AT_CFUN;
 
+/// @brief Set TE-TA Fixed Local Rate - Set the baud rate of the device UART
+/// @param rate Baud rate (0 for auto-bauding), e.g. 115200, 230400, 921600, 2000000, 3000000
+/// @return On success:
+///   - OK (sent at the OLD rate - the device switches rate after the response)
+/// @return On failure:
+///   - ERROR
+/// @note This setting is automatically saved (AUTO_SAVE) - the device keeps the rate across ESP32 restarts
+extern const at_cmd_t AT_IPR;
+
+/// @brief Set TE-TA Local Data Flow Control
+/// @param dce_by_dte Method used by the ESP32 (TE) to stop data from the device
+///   - 0: No flow control
+///   - 2: RTS flow control
+/// @param dte_by_dce Method used by the device (TA) to stop data from the ESP32
+///   - 0: No flow control
+///   - 2: CTS flow control
+/// @return On success:
+///   - OK
+extern const at_cmd_t AT_IFC;
+
 /// @brief EPS Network Registration - Enable or disable EPS network registration status
 extern const at_cmd_t AT_CEREG;
 
@@ -0,0 +1,119 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#define AT_DECODER_MAX_FIELDS 8
+
+/// @brief A view of part of a response buffer - not null terminated, nothing is copied
+typedef struct
+{
+    const char *ptr;
+    size_t len;
+} at_str_t;
+
+/// @brief Cursor over a response buffer, a single line, or the fields of a line
+/// @note Fields are separated by ',' - a parse fxn consumes its field and the separator after it.
+///       On failure the cursor is left where it was, so another field type can be tried.
+typedef struct
+{
+    const char *pos;
+    const char *end;
+} at_parser_t;
+
+/// @brief Start a cursor over len bytes of buf (buf need not be null terminated)
+void at_parser_init(at_parser_t *parser, const char *buf, size_t len);
+
+/// @brief Move to the next non-empty line
+/// @param line_out Cursor over the line without its line ending
+/// @return false once no lines are left
+bool at_parser_next_line(at_parser_t *parser, at_parser_t *line_out);
+
+/// @brief Move to the next line starting with prefix (e.g. "+CSQ:")
+/// @param fields_out Cursor over the rest of the line, after the prefix and any spaces
+/// @return false if no line left starts with prefix
+bool at_parser_find_line(at_parser_t *parser, const char *prefix, at_parser_t *fields_out);
+
+/// @brief If the cursor starts with prefix, move past it and any spaces after it
+bool at_parser_match(at_parser_t *parser, const char *prefix);
+
+/// @brief Parse the next field as a decimal integer
+bool at_parser_int(at_parser_t *fields, int *out);
+
+/// @brief Parse the next field as a string - a quoted string (without its quotes) or a bare token (spaces trimmed)
+bool at_parser_str(at_parser_t *fields, at_str_t *out);
+
+/// @brief Parse the next field as a parenthesized list (e.g. "(0-2,4)") - out is the text inside the parentheses
+bool at_parser_list(at_parser_t *fields, at_str_t *out);
+
+/// @brief Skip the next field whatever its type
+bool at_parser_skip(at_parser_t *fields);
+
+/// @brief True once every field has been consumed
+bool at_parser_done(const at_parser_t *fields);
+
+/// @brief Compare a view with a null terminated string
+bool at_str_eq(at_str_t str, const char *literal);
+
+/// @brief Copy a view into dst and null terminate it
+/// @return false if dst was too small (the copy is truncated, but still null terminated)
+bool at_str_copy(at_str_t str, char *dst, size_t dst_size);
+
+/// @brief Decode hex digits (either case) into bytes - out may be the hex buffer itself, to decode in place
+/// @note Table driven with no branch per byte - an invalid digit is only detected once the whole buffer is decoded,
+///       so out holds garbage if this fails
+/// @param out Receives hex_len / 2 bytes
+/// @return false if hex_len is odd or a character is not a hex digit
+bool at_hex_decode(const char *hex, size_t hex_len, uint8_t *out);
+
+// ------ Typed decoding from an at_cmd_info_t response_format ------ //
+
+typedef enum
+{
+    AT_FIELD_INT,  // %d
+    AT_FIELD_STR,  // %s or \"%[^\"]\"
+    AT_FIELD_LIST, // A parenthesized range, e.g. (LIST) or (0-2)
+} at_field_type_t;
+
+/// @brief Where the caller's struct stores one response field - see AT_FIELD()
+/// @note An int field may be 1, 2 or 4 bytes wide, a string or list field is a char array (size includes the null)
+typedef struct
+{
+    uint16_t offset;
+    uint16_t size;
+} at_field_t;
+
+#define AT_FIELD(type, member) {offsetof(type, member), sizeof(((type *)0)->member)}
+#define AT_FIELD_SKIP {0, 0} // Field is parsed but not stored
+
+typedef struct
+{
+    uint16_t offset;
+    uint16_t size;
+    uint8_t type; // at_field_type_t
+} at_field_desc_t;
+
+/// @brief A response_format compiled for one caller struct
+/// @note prefix points into the format string, which must outlive the decoder (the at_cmd_t tables are static)
+typedef struct
+{
+    const char *prefix; // e.g. "+CNACT:" - not null terminated
+    uint8_t prefix_len;
+    uint8_t field_count;
+    at_field_desc_t fields[AT_DECODER_MAX_FIELDS];
+} at_decoder_t;
+
+/// @brief Compile a response_format (e.g. "+CNACT: %d,%d,\"%[^\"]\"") against the fields of a caller struct
+/// @param layout One entry per field in the format, in order
+/// @return false if the format has an unknown field type, or layout does not match it
+bool at_decoder_compile(at_decoder_t *decoder, const char *format, const at_field_t *layout, size_t layout_len);
+
+/// @brief Decode the next line starting with the decoder's prefix into out
+/// @return Number of leading fields decoded (fields missing from the end of the line are left untouched),
+///         or -1 if no line left has the prefix. A string that does not fit its field stops decoding there.
+int at_decoder_next(const at_decoder_t *decoder, at_parser_t *parser, void *out);
+
+/// @brief Decode the first line of len bytes of response that starts with the decoder's prefix
+/// @return As at_decoder_next()
+int at_decoder_decode(const at_decoder_t *decoder, const char *response, size_t len, void *out);
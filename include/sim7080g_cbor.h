@@ -0,0 +1,92 @@
+#pragma once
+
+#include <esp_err.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "sim7080g_driver_esp_idf.h"
+
+#define SIM7080G_CBOR_POOL_BUFFERS 2 // Shared SIM7080G_MQTT_MAX_PAYLOAD_LEN byte buffers for publishes that bring none
+
+/// @brief Writes CBOR (RFC 8949) straight into a fixed buffer - nothing is allocated
+/// @note Running out of room is sticky: every later put fails too, so a whole record can be written and checked once
+///       with cbor_writer_ok(). Maps and arrays are definite length - give the number of pairs / items up front.
+typedef struct
+{
+    uint8_t *buf;
+    size_t size;
+    size_t len; // Bytes written so far
+    bool overflow;
+} cbor_writer_t;
+
+void cbor_writer_init(cbor_writer_t *writer, void *buf, size_t size);
+
+/// @brief True if every put so far fitted in the buffer
+bool cbor_writer_ok(const cbor_writer_t *writer);
+
+bool cbor_put_uint(cbor_writer_t *writer, uint64_t value);
+bool cbor_put_int(cbor_writer_t *writer, int64_t value);
+bool cbor_put_bool(cbor_writer_t *writer, bool value);
+bool cbor_put_null(cbor_writer_t *writer);
+
+/// @brief Write a float as a half (2 bytes) when that loses nothing, otherwise as a single (4 bytes)
+bool cbor_put_float(cbor_writer_t *writer, float value);
+
+/// @brief Write a double in the shortest of half, single and double that holds it exactly
+bool cbor_put_double(cbor_writer_t *writer, double value);
+
+/// @brief Write a null terminated UTF-8 string
+bool cbor_put_text(cbor_writer_t *writer, const char *text);
+bool cbor_put_text_len(cbor_writer_t *writer, const char *text, size_t len);
+bool cbor_put_bytes(cbor_writer_t *writer, const void *data, size_t len);
+
+/// @brief Start a map - write pairs key then value, pairs times
+bool cbor_open_map(cbor_writer_t *writer, size_t pairs);
+
+/// @brief Start an array - write count items
+bool cbor_open_array(cbor_writer_t *writer, size_t count);
+
+// ------ Sensor records ------ //
+
+/// @brief One named measurement, e.g. {"temp", 21.5f}
+typedef struct
+{
+    const char *name; // Map key - keep it short, it is sent with every record
+    float value;
+} cbor_reading_t;
+
+/// @brief Write {"ts": timestamp, <name>: <value>, ...} - the CBOR form of the usual JSON telemetry object
+bool cbor_put_readings(cbor_writer_t *writer, uint64_t timestamp, const cbor_reading_t *readings, size_t count);
+
+// ------ Publishing ------ //
+
+/// @brief Writes one message with the writer it is given
+/// @return false to abandon the publish
+typedef bool (*sim7080g_cbor_encode_t)(cbor_writer_t *writer, void *arg);
+
+/// @brief Encode a message with encode and publish the bytes it wrote - there is no text form and nothing is copied
+/// @param buf Buffer to encode into - NULL to borrow one of SIM7080G_CBOR_POOL_BUFFERS pooled buffers for the publish
+/// @param buf_size Ignored if buf is NULL
+/// @return ESP_ERR_INVALID_SIZE if the message did not fit the buffer, ESP_ERR_NO_MEM if buf is NULL and every pooled
+///         buffer is in use, ESP_FAIL if encode returned false, otherwise the result of the publish
+esp_err_t sim7080g_cbor_publish(const sim7080g_handle_t *sim7080g_handle,
+                                const char *topic,
+                                uint8_t qos,
+                                bool retain,
+                                sim7080g_cbor_encode_t encode,
+                                void *arg,
+                                uint8_t *buf,
+                                size_t buf_size);
+
+/// @brief Encode readings with cbor_put_readings into a pooled buffer and publish them
+esp_err_t sim7080g_cbor_publish_readings(const sim7080g_handle_t *sim7080g_handle,
+                                         const char *topic,
+                                         uint8_t qos,
+                                         uint64_t timestamp,
+                                         const cbor_reading_t *readings,
+                                         size_t count);
+
+/// @brief Compare encoded size and CPU cycles of a typical sensor record as CBOR and as snprintf JSON
+/// @note Also checks the CBOR bytes against a known encoding - does not need the device
+bool sim7080g_test_cbor_encode(int iterations);
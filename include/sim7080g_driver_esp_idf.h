@@ -2,23 +2,65 @@
 
 #include <esp_err.h>
 #include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/event_groups.h>
 
-#define SIM7080G_UART_BAUD_RATE 115200
+#include "sim7080g_at_commands.h"
+
+#define SIM7080G_UART_BAUD_RATE 115200 // Rate the device is first contacted at - target_baud_rate is negotiated from here
 #define SIM87080G_UART_BUFF_SIZE 1024
 
+#define SIM7080G_RX_TASK_DEFAULT_PRIORITY 10
+#define SIM7080G_RX_TASK_STACK_SIZE 4096
+
+#define SIM7080G_ARBITER_TASK_DEFAULT_PRIORITY 9
+#define SIM7080G_ARBITER_TASK_STACK_SIZE 6144
+#define SIM7080G_ARBITER_QUEUE_LEN 8            // Requests waiting for the device at once - further callers block for a slot
+#define SIM7080G_ARBITER_DEFAULT_DEADLINE_MS 30000 // Deadline of the exchanges driver calls queue on their own
+
+#define SIM7080G_ASYNC_MAX_REQUESTS 8 // Async requests queued or running at once
+
+#define SIM7080G_ERR_BASE 0x7080
+#define SIM7080G_ERR_CANCELLED (SIM7080G_ERR_BASE + 1) // Async request cancelled before it started
+
+#define SIM7080G_AT_BATCH_MAX_CMDS 8
+
+#define SIM7080G_STATUS_CACHE_DEFAULT_TTL_MS 5000 // How long a status read is reused when nothing reports a change
+
+#define SIM7080G_URC_MAX_HANDLERS 16
+#define SIM7080G_URC_PREFIX_MAX_LEN 16
+
 // TODO - Check these values against  MQTT v3 protocol specs
 #define MQTT_BROKER_URL_MAX_CHARS 128
 #define MQTT_BROKER_USERNAME_MAX_CHARS 32
 #define MQTT_BROKER_CLIENT_ID_MAX_CHARS 32
 #define MQTT_BROKER_PASSWORD_MAX_CHARS 32
 
+#define SIM7080G_MQTT_MAX_PAYLOAD_LEN 1024 // AT+SMPUB content limit - larger payloads go through sim7080g_mqtt_publish_large
+#define SIM7080G_MQTT_CHUNK_HEADER_LEN 10
+#define SIM7080G_MQTT_CHUNK_DATA_MAX_LEN (SIM7080G_MQTT_MAX_PAYLOAD_LEN - SIM7080G_MQTT_CHUNK_HEADER_LEN)
+#define SIM7080G_MQTT_INFLIGHT_WINDOW 8           // Pipelined QoS 1/2 publishes awaiting the broker's ack at once
+#define SIM7080G_MQTT_INFLIGHT_TIMEOUT_MS 30000 // Longest a pipelined publish may wait for its ack
+
 /// @brief UART config struct defined by user of driver and passed to driver init
 /// @note TX and RX here are in the perspective of the SIM7080G, and thus they are swapped in the perspecive of the ESP32
+/// @note RTS and CTS are named as on the SIM7080G pins - connect ESP32 RTS to SIM7080G RTS and ESP32 CTS to SIM7080G CTS
 typedef struct
 {
     int gpio_num_tx;
     int gpio_num_rx;
     int port_num; // This was chosen to be an INT because the esp-idf uart driver takes an int type
+    uint32_t target_baud_rate; // Switched to on init with AT+IPR (falls back to lower rates if the link check fails) - 0 keeps SIM7080G_UART_BAUD_RATE
+    bool hw_flow_control;      // Enable RTS/CTS flow control on both ends - gpio_num_rts/cts are ignored if false
+    int gpio_num_rts;
+    int gpio_num_cts;
+    int rx_task_priority;     // Priority of the driver UART RX task - 0 selects SIM7080G_RX_TASK_DEFAULT_PRIORITY
+    bool rx_task_pin_to_core; // If false the RX task has no core affinity and rx_task_core_id is ignored
+    int rx_task_core_id;
+    int arbiter_task_priority; // Priority of the command arbiter task - 0 selects SIM7080G_ARBITER_TASK_DEFAULT_PRIORITY (core affinity follows the RX task)
+    uint32_t status_cache_ttl_ms; // Longest a status read is answered from the cache - 0 selects SIM7080G_STATUS_CACHE_DEFAULT_TTL_MS
 } sim7080g_uart_config_t;
 
 /// @brief For config device with MQTT broker.
@@ -30,6 +72,9 @@ typedef struct
     char client_id[MQTT_BROKER_CLIENT_ID_MAX_CHARS];
     char client_password[MQTT_BROKER_PASSWORD_MAX_CHARS];
     uint16_t port;
+    bool async_publish; // ASYNCMODE=1 - a publish returns once sent and its ack is reported later (see sim7080g_mqtt_publish_pipelined)
+    bool binary_downlink; // SUBHEX=1 - received messages arrive hex encoded and reach subscribers decoded, so they may hold any bytes
+    bool warm_start;      // On init, reuse a bearer and MQTT session that survived an ESP32 restart (see sim7080g_init)
 } sim7080g_mqtt_config_t;
 
 /**
@@ -74,14 +119,111 @@ typedef struct
     bool async_mode;
 } mqtt_parameters_t;
 
+/// @brief EPS registration as last reported by +CEREG (AT+CEREG=2 adds the location fields)
+typedef struct
+{
+    uint8_t stat;     // 1 = home network, 5 = roaming (2 = searching, 3 = denied, 0 / 4 = not registered)
+    uint16_t tac;     // Tracking area code
+    uint32_t cell_id; // E-UTRAN cell id
+    uint8_t act;      // Access technology - 7 = LTE-M, 9 = NB-IoT
+    uint32_t wait_ms; // Time sim7080g_wait_for_registration waited
+} sim7080g_registration_t;
+
+typedef struct
+{
+    uint32_t hits;          // Status reads answered from the cache
+    uint32_t misses;        // Status reads sent to the device
+    uint32_t invalidations; // Cached reads dropped before their TTL ran out, by a URC or a command that changes them
+} sim7080g_status_cache_stats_t;
+
+/// @brief Driver runtime state (RX task, line framer, pending command response) - private to the driver
+typedef struct sim7080g_ctx sim7080g_ctx_t;
+
 typedef struct
 {
     sim7080g_uart_config_t uart_config;
     sim7080g_mqtt_config_t mqtt_config;
     bool uart_initialized;
     bool mqtt_initialized;
+    sim7080g_ctx_t *ctx; // Allocated by sim7080g_init, freed by sim7080g_deinit
 } sim7080g_handle_t;
 
+/// @brief Order in which queued requests get the device - FIFO within the same priority
+typedef enum
+{
+    SIM7080G_CMD_PRIORITY_LOW = 0,
+    SIM7080G_CMD_PRIORITY_NORMAL,
+    SIM7080G_CMD_PRIORITY_HIGH,
+} sim7080g_cmd_priority_t;
+
+/// @brief Function run by the command arbiter with exclusive use of the device
+typedef esp_err_t (*sim7080g_cmd_fn_t)(const sim7080g_handle_t *sim7080g_handle, void *arg);
+
+/// @brief Identifies an async request - 0 is never a valid id
+typedef uint32_t sim7080g_request_id_t;
+
+/// @brief Called once an async request is done (or cancelled)
+/// @note Runs on the command arbiter task - driver fxns may be called from it (they run directly), but keep it short.
+///       For a cancelled request it runs in the task that called sim7080g_request_cancel.
+typedef void (*sim7080g_request_cb_t)(sim7080g_request_id_t id, esp_err_t result, void *user_ctx);
+
+/// @brief How an async request reports completion - both the callback and the event group are optional
+typedef struct
+{
+    sim7080g_request_cb_t callback;
+    void *user_ctx;
+    EventGroupHandle_t event_group;
+    EventBits_t success_bits; // Set in event_group when the request succeeds
+    EventBits_t failure_bits; // Set in event_group when the request fails, times out or is cancelled
+    sim7080g_cmd_priority_t priority;
+    uint32_t deadline_ms; // Longest time the request may wait for the device before failing with ESP_ERR_TIMEOUT - 0 for no limit
+} sim7080g_async_opts_t;
+
+/// @brief One command of a batch sent to the device as a single semicolon concatenated line
+/// @note The device stops at the first command that fails without saying which one it was. Entries that got an info
+///       line succeeded, every other entry gets the batch's error - a failed entry may not be the one that failed.
+typedef struct
+{
+    const at_cmd_t *cmd;
+    at_cmd_type_t type;
+    const char *args;     // Arguments for write commands (as for a single command), otherwise NULL
+    char *response;       // Receives this command's info lines followed by the final result code line - may be NULL
+    size_t response_size;
+    esp_err_t result;     // Set by sim7080g_send_at_batch
+} sim7080g_at_batch_entry_t;
+
+/// @brief One segment of a scatter-gather publish payload - any bytes, including zeros
+typedef struct
+{
+    const void *base;
+    size_t len;
+} sim7080g_iovec_t;
+
+/// @brief Reports the outcome of a pipelined publish
+/// @note Never called with a driver lock held, but keep it short and do NOT send AT commands from it. It runs in the driver
+///       RX task when the ack arrives or the session drops; in whichever task finds the window expired (a publishing or
+///       waiting task, or the command arbiter); or, for QoS 0 or without ASYNCMODE, in the publishing task before
+///       sim7080g_mqtt_publish_pipelined returns.
+///       ESP_ERR_TIMEOUT if no ack came within SIM7080G_MQTT_INFLIGHT_TIMEOUT_MS, ESP_ERR_INVALID_STATE if the session dropped first.
+typedef void (*sim7080g_publish_cb_t)(uint16_t msg_id, esp_err_t result, void *user_ctx);
+
+/// @brief Receives a message on a topic matching a subscribed filter
+/// @note Runs in the driver RX task - keep it short and do NOT send AT commands or (un)subscribe from it.
+///       topic and payload point into the driver's receive buffer (neither is null terminated) - copy what must outlive the call.
+///       With mqtt_config.binary_downlink the payload is the raw bytes sent, decoded from hex into a driver buffer.
+typedef void (*sim7080g_mqtt_message_handler_t)(const char *topic,
+                                                size_t topic_len,
+                                                const uint8_t *payload,
+                                                size_t payload_len,
+                                                void *user_ctx);
+
+/// @brief Callback for an unsolicited result code (URC) line
+/// @note Runs in the driver RX task - keep it short and do NOT send AT commands or (un)register handlers from it
+/// @param line The complete URC line without its CRLF (null terminated)
+/// @param len Length of the line
+/// @param user_ctx Pointer given when the handler was registered
+typedef void (*sim7080g_urc_handler_t)(const char *line, size_t len, void *user_ctx);
+
 /// @brief Creates a device handle that stores the provided configurations
 /// @note This must be called before a device can be init
 /// @param sim7080g_handle
@@ -94,12 +236,79 @@ esp_err_t sim7080g_config(sim7080g_handle_t *sim7080g_handle,
 
 /// @brief Use configured UART and MQTT settings to initialize drivers for this device
 /// @note This can only be called after a handle is configured
+/// @note With mqtt_config.warm_start, after a restart that kept RTC memory (watchdog, panic, esp_restart) the driver
+///       recognises the device it brought up before with the same config, and asks AT+CNACT?;+SMSTATE? in one exchange.
+///       If the bearer and MQTT session are still up it returns straight away, ready to publish - sim7080g_is_warm_started
+///       then returns true and the bring-up calls can be skipped. Otherwise the usual init runs.
 /// @param sim7080g_handle
 /// @return
 esp_err_t sim7080g_init(sim7080g_handle_t *sim7080g_handle);
 
+/// @brief True if sim7080g_init found the bearer and MQTT session up and skipped bring-up
+/// @note Subscriptions are driver state - subscribe again after a warm start
+bool sim7080g_is_warm_started(const sim7080g_handle_t *sim7080g_handle);
+
+/// @brief Stop the driver RX task and release the UART driver and runtime state created by init
+/// @param sim7080g_handle
+/// @return
 esp_err_t sim7080g_deinit(sim7080g_handle_t *sim7080g_handle);
 
+/// @brief Run a function on the command arbiter task with exclusive use of the device
+/// @note Every exchange with the device (including those made by the other driver fxns) is run one at a time by the
+///       arbiter task, so several tasks can share one handle. Driver fxns called from inside fn run directly - use this
+///       to keep a sequence of commands together or to give a group of calls a higher priority.
+/// @note Completion is signalled to the calling task with a task notification. Must not be called from a URC handler.
+/// @param sim7080g_handle
+/// @param fn Run on the arbiter task
+/// @param arg Passed to fn
+/// @param priority Position in the queue relative to other waiting requests
+/// @param deadline_ms Longest time the request may wait for the device before it is dropped - 0 waits as long as needed
+/// @return ESP_ERR_TIMEOUT if fn did not start before the deadline, otherwise the result of fn
+esp_err_t sim7080g_arbiter_call(const sim7080g_handle_t *sim7080g_handle,
+                                sim7080g_cmd_fn_t fn,
+                                void *arg,
+                                sim7080g_cmd_priority_t priority,
+                                uint32_t deadline_ms);
+
+/// @brief Cancel an async request that has not started yet
+/// @note A request already running on the device can not be cancelled - it completes normally
+/// @param sim7080g_handle
+/// @param id Returned when the request was queued
+/// @return ESP_OK if cancelled (it completes with SIM7080G_ERR_CANCELLED), ESP_ERR_INVALID_STATE if already running,
+///         ESP_ERR_NOT_FOUND if already done or unknown
+esp_err_t sim7080g_request_cancel(const sim7080g_handle_t *sim7080g_handle, sim7080g_request_id_t id);
+
+/// @brief Register a handler called for every received line that starts with the given prefix (e.g. "+APP PDP:")
+/// @note Lines that answer the command currently in flight (same prefix as the command) go to that command instead
+/// @note The driver registers its own handlers for '+APP PDP', '+SMSTATE', '+CEREG', '+CPIN', '+CFUN', 'SMS Ready', '+SMSUB' and '+SMPUB' on init
+/// @param sim7080g_handle Initialized device handle
+/// @param prefix Line prefix to match - copied, max SIM7080G_URC_PREFIX_MAX_LEN - 1 chars
+/// @param handler
+/// @param user_ctx Passed to the handler as is
+/// @return ESP_ERR_NO_MEM if all SIM7080G_URC_MAX_HANDLERS slots are in use
+esp_err_t sim7080g_urc_register(const sim7080g_handle_t *sim7080g_handle,
+                                const char *prefix,
+                                sim7080g_urc_handler_t handler,
+                                void *user_ctx);
+
+/// @brief Remove a handler previously registered for the given prefix
+esp_err_t sim7080g_urc_unregister(const sim7080g_handle_t *sim7080g_handle,
+                                  const char *prefix,
+                                  sim7080g_urc_handler_t handler);
+
+/// @brief Send several commands in one exchange (e.g. "AT+CSQ;+CGATT?;+COPS?") and split the response per command
+/// @note Every command after the first must be an extended ("AT+") command. Info lines are assigned to the
+///       command whose name they start with, so a batch should not hold the same command twice.
+/// @param sim7080g_handle
+/// @param entries Commands to send, in order - each entry's response and result are filled in
+/// @param num_entries 1 to SIM7080G_AT_BATCH_MAX_CMDS
+/// @param timeout_ms Timeout for the whole batch
+/// @return ESP_OK if the device answered OK for the whole line, otherwise the error it answered with
+esp_err_t sim7080g_send_at_batch(const sim7080g_handle_t *sim7080g_handle,
+                                 sim7080g_at_batch_entry_t *entries,
+                                 size_t num_entries,
+                                 uint32_t timeout_ms);
+
 esp_err_t sim7080g_check_sim_status(const sim7080g_handle_t *sim7080g_handle);
 
 esp_err_t sim7080g_check_signal_quality(const sim7080g_handle_t *sim7080g_handle,
@@ -122,9 +331,28 @@ esp_err_t sim7080g_set_apn(const sim7080g_handle_t *sim7080g_handle, const char
 
 esp_err_t sim7080g_app_network_activate(const sim7080g_handle_t *sim7080g_handle);
 
+/// @brief Activate PDP context 0 (AT+CNACT=0,1) without the CFUN cycle sim7080g_app_network_activate starts with
+/// @note For bringing back a bearer that dropped while the device stayed registered
+esp_err_t sim7080g_app_network_reactivate(const sim7080g_handle_t *sim7080g_handle);
+
+/// @brief Queue sim7080g_app_network_activate and return without waiting for it
+/// @param sim7080g_handle
+/// @param opts Completion reporting and queueing options - NULL for none
+/// @param id_out Receives the request id - may be NULL
+/// @return ESP_OK once queued, ESP_ERR_NO_MEM if SIM7080G_ASYNC_MAX_REQUESTS are already outstanding
+esp_err_t sim7080g_app_network_activate_async(const sim7080g_handle_t *sim7080g_handle,
+                                              const sim7080g_async_opts_t *opts,
+                                              sim7080g_request_id_t *id_out);
+
 esp_err_t sim7080g_app_network_deactivate(const sim7080g_handle_t *sim7080g_handle);
 
-esp_err_t sim7080g_cycle_cfun(const sim7080g_handle_t *sim7080g_handle);
+/// @brief Restart the radio (AT+CFUN=0 then AT+CFUN=1) and wait until the device is ready for commands again
+/// @note Waits for the device's own readiness reports ('+CPIN: READY', 'SMS Ready'), probing AT+CPIN? in case one is missed,
+///       for at most 20 s - rather than for a fixed time
+/// @param sim7080g_handle
+/// @param recovery_ms_out Time from sending CFUN=0 until the device was ready - may be NULL
+/// @return ESP_ERR_TIMEOUT if the device did not report ready in time
+esp_err_t sim7080g_cycle_cfun(const sim7080g_handle_t *sim7080g_handle, uint32_t *recovery_ms_out);
 
 esp_err_t sim7080g_get_app_network_active(const sim7080g_handle_t *sim7080g_handle,
                                           int pdpidx,
@@ -132,9 +360,23 @@ esp_err_t sim7080g_get_app_network_active(const sim7080g_handle_t *sim7080g_hand
                                           char *address,
                                           int address_len);
 
+/// @brief Whether a +CNACT status (0 deactivated, 1 activated, 2 in operation) means the PDP context is up
+bool sim7080g_cnact_status_active(int status);
+
 ///...... Other functions for interacting with and configure device
 // TODO - Create a 'SIM' config struct that holds the SIM card APN (for now - later we can add more)
 
+/// @brief Wait until the device is registered on its home network or roaming, driven by +CEREG URCs rather than polling
+/// @note Turns on AT+CEREG=2 reporting and reads the current status once - returns straight away if already registered,
+///       otherwise the instant the URC reporting registration arrives. Call before sim7080g_connect_to_network_bearer.
+/// @param sim7080g_handle
+/// @param timeout_ms Deadline for the whole wait
+/// @param registration_out Status, TAC and cell id - may be NULL. Filled in on timeout too, with the last status reported
+/// @return ESP_ERR_TIMEOUT if the device was not registered within timeout_ms
+esp_err_t sim7080g_wait_for_registration(const sim7080g_handle_t *sim7080g_handle,
+                                         uint32_t timeout_ms,
+                                         sim7080g_registration_t *registration_out);
+
 /// @brief Send series of AT commands to set the device various network settings to connect to LTE network bearer
 /// @param sim7080g_handle
 /// @param apn
@@ -172,6 +414,129 @@ esp_err_t sim7080g_mqtt_publish(const sim7080g_handle_t *sim7080g_handle,
                                 uint8_t qos,
                                 bool retain);
 
+/// @brief Publish a payload made of several segments (e.g. a fixed header and a sensor buffer) without joining them first
+/// @note Each segment is written straight from the caller's buffer to the UART - the payload is sent as is, so it may be binary.
+///       With ASYNCMODE a QoS 1/2 publish still only returns once the broker has acked it (it waits on its own window entry)
+/// @param sim7080g_handle
+/// @param topic
+/// @param iov Payload segments, in order - empty segments are skipped. Together at most SIM7080G_MQTT_MAX_PAYLOAD_LEN bytes
+/// @param iov_count
+/// @param qos
+/// @param retain
+/// @return ESP_ERR_INVALID_ARG if the segments add up to an empty payload
+esp_err_t sim7080g_mqtt_publish_iov(const sim7080g_handle_t *sim7080g_handle,
+                                    const char *topic,
+                                    const sim7080g_iovec_t *iov,
+                                    size_t iov_count,
+                                    uint8_t qos,
+                                    bool retain);
+
+/// @brief Publish a payload larger than SIM7080G_MQTT_MAX_PAYLOAD_LEN as a run of chunk publishes to the same topic
+/// @note Every chunk is a SIM7080G_MQTT_CHUNK_HEADER_LEN byte header followed by up to SIM7080G_MQTT_CHUNK_DATA_MAX_LEN
+///       payload bytes. Header fields are little endian:
+///       - u16 message id (the same for every chunk of one payload)
+///       - u16 chunk index (from 0)
+///       - u16 chunk count
+///       - u32 CRC-32 (IEEE, as zlib crc32) of this chunk's payload bytes
+/// @note Chunks are sent back to back as one arbiter request, straight from payload - the payload is not copied.
+///       Chunks are never retained. If a chunk fails the rest are not sent - the receiver drops the incomplete message.
+/// @param sim7080g_handle
+/// @param topic
+/// @param payload Any bytes
+/// @param payload_len 1 to SIM7080G_MQTT_CHUNK_DATA_MAX_LEN * 65535
+/// @param qos
+/// @param msg_id_out Receives the message id written in the chunk headers - may be NULL
+/// @return The result of the first chunk that failed, otherwise ESP_OK
+esp_err_t sim7080g_mqtt_publish_large(const sim7080g_handle_t *sim7080g_handle,
+                                      const char *topic,
+                                      const void *payload,
+                                      size_t payload_len,
+                                      uint8_t qos,
+                                      uint16_t *msg_id_out);
+
+/// @brief Queue a publish and return without waiting for it
+/// @note The topic and message are copied, so the caller's buffers may be reused straight away
+/// @param sim7080g_handle
+/// @param topic
+/// @param message
+/// @param qos
+/// @param retain
+/// @param opts Completion reporting and queueing options - NULL for none
+/// @param id_out Receives the request id - may be NULL
+/// @return ESP_OK once queued, ESP_ERR_NO_MEM if SIM7080G_ASYNC_MAX_REQUESTS are already outstanding
+esp_err_t sim7080g_mqtt_publish_async(const sim7080g_handle_t *sim7080g_handle,
+                                      const char *topic,
+                                      const char *message,
+                                      uint8_t qos,
+                                      bool retain,
+                                      const sim7080g_async_opts_t *opts,
+                                      sim7080g_request_id_t *id_out);
+
+/// @brief Queue a scatter-gather publish and return without waiting for it
+/// @note The segments are joined into one copy owned by the driver, so the caller's buffers may be reused straight away.
+///       Never blocks on the device - safe to call from an esp_timer callback.
+///       In ASYNCMODE a QoS 1/2 publish completes with ESP_ERR_NO_MEM if the publish window is full when its turn comes.
+/// @return ESP_OK once queued, ESP_ERR_NO_MEM if SIM7080G_ASYNC_MAX_REQUESTS are already outstanding
+esp_err_t sim7080g_mqtt_publish_iov_async(const sim7080g_handle_t *sim7080g_handle,
+                                          const char *topic,
+                                          const sim7080g_iovec_t *iov,
+                                          size_t iov_count,
+                                          uint8_t qos,
+                                          bool retain,
+                                          const sim7080g_async_opts_t *opts,
+                                          sim7080g_request_id_t *id_out);
+
+/// @brief Publish without waiting for the broker's ack, so several QoS 1/2 publishes share one network round trip
+/// @note Needs mqtt_config.async_publish (ASYNCMODE=1) - returns once the device has sent the publish, and the ack
+///       is reported to callback later. Up to SIM7080G_MQTT_INFLIGHT_WINDOW publishes may await their ack at once.
+///       QoS 0 publishes (and every publish without ASYNCMODE) are complete on return - callback is called before this returns.
+///       Blocking, large and async publishes take window entries too, so they may be mixed with these.
+/// @param sim7080g_handle
+/// @param topic
+/// @param iov Payload segments, as for sim7080g_mqtt_publish_iov
+/// @param iov_count
+/// @param qos
+/// @param retain
+/// @param callback Called once with the outcome if this returns ESP_OK - may be NULL
+/// @param user_ctx Passed to callback
+/// @param wait_ms Longest time to wait for a free window entry
+/// @param msg_id_out Receives the id passed to callback (assigned by the driver) - may be NULL
+/// @return ESP_ERR_TIMEOUT if the window stayed full for wait_ms, otherwise the result of sending the publish
+esp_err_t sim7080g_mqtt_publish_pipelined(const sim7080g_handle_t *sim7080g_handle,
+                                          const char *topic,
+                                          const sim7080g_iovec_t *iov,
+                                          size_t iov_count,
+                                          uint8_t qos,
+                                          bool retain,
+                                          sim7080g_publish_cb_t callback,
+                                          void *user_ctx,
+                                          uint32_t wait_ms,
+                                          uint16_t *msg_id_out);
+
+/// @brief Wait until every pipelined publish has been acked (or has failed)
+/// @return ESP_ERR_TIMEOUT if some are still awaiting their ack after timeout_ms
+esp_err_t sim7080g_mqtt_wait_inflight(const sim7080g_handle_t *sim7080g_handle, uint32_t timeout_ms);
+
+/// @brief Subscribe to a topic filter and route its messages to handler
+/// @note Incoming messages are matched against every filter in a topic trie - the cost follows the topic's levels,
+///       not the number of subscriptions. A message matching several filters is passed to each of their handlers.
+///       The same filter may be subscribed more than once with different handlers (the broker sees the latest qos).
+/// @param sim7080g_handle
+/// @param topic_filter May use the '+' and '#' wildcards
+/// @param qos
+/// @param handler
+/// @param user_ctx Passed to handler
+/// @return ESP_ERR_INVALID_ARG if the filter is not a valid MQTT topic filter, otherwise the result of AT+SMSUB
+esp_err_t sim7080g_mqtt_subscribe(const sim7080g_handle_t *sim7080g_handle,
+                                  const char *topic_filter,
+                                  uint8_t qos,
+                                  sim7080g_mqtt_message_handler_t handler,
+                                  void *user_ctx);
+
+/// @brief Unsubscribe from a topic filter, dropping every handler subscribed to it
+/// @note Handlers are dropped first, so none is called after this returns even if AT+SMUNSUB fails
+esp_err_t sim7080g_mqtt_unsubscribe(const sim7080g_handle_t *sim7080g_handle, const char *topic_filter);
+
 esp_err_t sim7080g_set_verbose_error_reporting(const sim7080g_handle_t *sim7080g_handle);
 
 esp_err_t sim7080g_is_physical_layer_connected(const sim7080g_handle_t *sim7080g_handle, bool *connected);
@@ -183,5 +548,50 @@ esp_err_t sim7080g_is_network_layer_connected(const sim7080g_handle_t *sim7080g_
 
 esp_err_t sim7080g_is_application_layer_connected(const sim7080g_handle_t *sim7080g_handle, bool *connected);
 
+/// @brief Hit and miss counts of the status cache
+/// @note The status getters and sim7080g_is_*_layer_connected() answer from responses read less than status_cache_ttl_ms ago
+///       (AT+CPIN?, +CSQ, +CEREG?, +CGATT?, +COPS?, +CNACT?, +SMSTATE?). A URC reporting a change, or a command
+///       making one (e.g. AT+CFUN, AT+CNACT=0,1, AT+SMCONN), drops the responses it affects straight away.
+esp_err_t sim7080g_get_status_cache_stats(const sim7080g_handle_t *sim7080g_handle, sim7080g_status_cache_stats_t *stats_out);
+
+/// @brief Drop every cached status read, so the next status call reads from the device
+esp_err_t sim7080g_status_cache_invalidate(const sim7080g_handle_t *sim7080g_handle);
+
 /// @brief Test the UART connection by sending a command and checking for a response
-bool sim7080g_test_uart_loopback(sim7080g_handle_t *sim7080g_handle);
\ No newline at end of file
+bool sim7080g_test_uart_loopback(sim7080g_handle_t *sim7080g_handle);
+
+/// @brief Measure UART throughput and line error rate at each supported baud rate
+/// @note Like the loopback test this requires the UART TX and RX pins to be looped back (device disconnected)
+bool sim7080g_test_uart_throughput(sim7080g_handle_t *sim7080g_handle);
+
+/// @brief Measure AT command round trip time (AT+CSQ) against a fake modem run on a second UART (fake_modem_port_num)
+/// @note Logs the p50/p90/p99/max round trip - fails only if a command fails. The device must be disconnected, as for
+///       sim7080g_test_publish_rate
+bool sim7080g_test_at_cmd_latency(sim7080g_handle_t *sim7080g_handle, int fake_modem_port_num, int iterations);
+
+/// @brief Compare the zero-copy response parser against the old strtok/sscanf parsing (AT+SMCONF? and AT+COPS? responses)
+/// @note Logs CPU cycles per parse and peak stack use of each - does not need the device
+bool sim7080g_test_response_parser(int iterations);
+
+/// @brief Fuzz the table-driven response decoders with corrupted and truncated copies of well formed responses
+/// @note Fails if a decoder writes outside its reply struct or leaves a string field unterminated - does not need the device
+bool sim7080g_test_response_decoder(int iterations);
+
+/// @brief Measure publishes per second against a fake modem run on a second UART (fake_modem_port_num)
+/// @note The device must be disconnected - the fake modem is routed onto the driver's TX/RX pins, so no wiring is needed
+bool sim7080g_test_publish_rate(sim7080g_handle_t *sim7080g_handle, int fake_modem_port_num, int publishes);
+
+/// @brief Mix blocking and pipelined QoS 1 publishes in ASYNCMODE against a fake modem run on a second UART (fake_modem_port_num)
+/// @note Fails if a pipelined publish is reported with another publish's ack, or a blocking publish returns before its own ack.
+///       The device must be disconnected, as for sim7080g_test_publish_rate
+bool sim7080g_test_publish_mixed(sim7080g_handle_t *sim7080g_handle, int fake_modem_port_num, int rounds);
+
+/// @brief Measure hex decoding throughput (MB/s of payload) of the table-driven decoder against one sscanf per byte
+/// @note Decodes a full SIM7080G_MQTT_MAX_PAYLOAD_LEN payload per iteration, as a SUBHEX=1 +SMSUB line carries it.
+///       Also checks in place decoding and the rejection of bad input - does not need the device
+bool sim7080g_test_hex_decode(int iterations);
+
+/// @brief Time a full health check (every sim7080g_is_*_layer_connected()) read from the device against the same check answered by the status cache
+/// @note Fails if a check within the TTL sends anything to the device, or if a status read racing a state changing
+///       command caches the state from before it
+bool sim7080g_test_status_cache(sim7080g_handle_t *sim7080g_handle, int iterations);
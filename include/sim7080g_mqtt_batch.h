@@ -0,0 +1,54 @@
+#pragma once
+
+#include <esp_err.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "sim7080g_driver_esp_idf.h"
+
+/// @brief Coalesces small telemetry records for one topic into fewer, larger publishes
+/// @note A batch is flushed as one publish when the next record would not fit (or max_bytes is reached),
+///       when the oldest buffered record is max_age_ms old, or on sim7080g_batch_flush.
+///       Flushes are queued with sim7080g_mqtt_publish_iov_async - producers never wait on the device.
+typedef struct sim7080g_batch sim7080g_batch_t;
+typedef sim7080g_batch_t *sim7080g_batch_handle_t;
+
+typedef struct
+{
+    const char *topic; // Not copied - must outlive the batch
+    uint8_t qos;
+    size_t max_bytes;    // Payload size that triggers a flush - 0 (or above SIM7080G_MQTT_MAX_PAYLOAD_LEN) selects SIM7080G_MQTT_MAX_PAYLOAD_LEN
+    uint32_t max_age_ms; // Longest a record may wait in the buffer - 0 for no limit (size and explicit flushes only)
+    char separator;      // Written between records (e.g. '\n' for JSON lines) - '\0' for none
+} sim7080g_batch_config_t;
+
+typedef struct
+{
+    uint32_t records;            // Records appended
+    uint32_t publishes;          // Publishes queued
+    uint32_t messages_coalesced; // Records sent inside another record's publish rather than as their own
+    uint32_t bytes_saved;        // MQTT PUBLISH header bytes not sent thanks to coalescing (less the separators added)
+    uint32_t flush_errors;       // Flushes that could not be queued - the records stay buffered for the next one
+    uint32_t size_flushes;
+    uint32_t age_flushes;
+    uint32_t manual_flushes;
+} sim7080g_batch_stats_t;
+
+/// @brief Create a batch publisher for one topic
+esp_err_t sim7080g_batch_create(const sim7080g_handle_t *sim7080g_handle,
+                                const sim7080g_batch_config_t *config,
+                                sim7080g_batch_handle_t *batch_out);
+
+/// @brief Append one record - safe to call from several tasks
+/// @note Flushes first if the record does not fit beside the buffered ones
+/// @return ESP_ERR_INVALID_SIZE if the record alone exceeds max_bytes, or the flush error if it did not fit and could not be flushed
+esp_err_t sim7080g_batch_append(sim7080g_batch_handle_t batch, const void *record, size_t len);
+
+/// @brief Queue whatever is buffered as one publish now (does nothing if the buffer is empty)
+esp_err_t sim7080g_batch_flush(sim7080g_batch_handle_t batch);
+
+esp_err_t sim7080g_batch_get_stats(sim7080g_batch_handle_t batch, sim7080g_batch_stats_t *stats_out);
+
+/// @brief Flush what is buffered (best effort) and free the batch
+esp_err_t sim7080g_batch_delete(sim7080g_batch_handle_t batch);
@@ -0,0 +1,103 @@
+#pragma once
+
+#include <esp_err.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "sim7080g_driver_esp_idf.h"
+
+#define SIM7080G_OUTBOX_DEFAULT_SEGMENT_SIZE 4096 // One flash sector
+#define SIM7080G_OUTBOX_MAX_TOPIC_LEN 255
+
+/// @brief Persistent store-and-forward queue of MQTT messages for periods without a broker connection
+/// @note Messages are appended to a log of fixed-size segments on a flash data partition.
+///       Every record carries a CRC, so a record torn by power loss is found and skipped on the next open.
+///       Each record also has a commit word that is programmed to zero (no erase needed) once the message is published -
+///       that is the replay cursor, so messages published before a power loss are not replayed after it.
+///       A message is only sent twice if power is lost between the broker accepting it and its commit word being written.
+/// @note A segment is only erased when it is reused, and the free segment erased the fewest times is always picked next.
+typedef struct sim7080g_outbox sim7080g_outbox_t;
+typedef sim7080g_outbox_t *sim7080g_outbox_handle_t;
+
+typedef struct
+{
+    const char *partition_label; // Data partition holding the log (subtype any)
+    size_t segment_size;         // Multiple of the flash sector size - 0 selects SIM7080G_OUTBOX_DEFAULT_SEGMENT_SIZE
+} sim7080g_outbox_config_t;
+
+/// @brief A queued message as returned by sim7080g_outbox_peek
+/// @note Points into the outbox - valid until the next call on the outbox
+typedef struct
+{
+    const char *topic;
+    const uint8_t *payload;
+    size_t payload_len;
+    uint8_t qos;
+} sim7080g_outbox_record_t;
+
+typedef struct
+{
+    uint32_t pending;          // Messages stored and not yet committed
+    uint32_t appended;         // Since open
+    uint32_t replayed;         // Committed since open
+    uint32_t corrupt_records;  // Torn or corrupt records skipped (found on open or on replay)
+    uint32_t rejected_records; // Records the publish refused as invalid on replay - committed and dropped
+    uint16_t segments;
+    uint16_t segments_in_use;
+    uint32_t min_erase_count;
+    uint32_t max_erase_count;
+} sim7080g_outbox_stats_t;
+
+/// @brief Open the log, recovering the replay cursor and write position from what is stored
+esp_err_t sim7080g_outbox_open(const sim7080g_outbox_config_t *config, sim7080g_outbox_handle_t *outbox_out);
+
+esp_err_t sim7080g_outbox_close(sim7080g_outbox_handle_t outbox);
+
+/// @brief Store a message - it is on flash when this returns
+/// @return ESP_ERR_NO_MEM if every segment holds unsent messages (nothing is overwritten),
+///         ESP_ERR_INVALID_SIZE if the message is too large for a segment or a publish,
+///         ESP_ERR_INVALID_ARG if the payload is empty (a publish needs at least one byte)
+esp_err_t sim7080g_outbox_append(sim7080g_outbox_handle_t outbox,
+                                 const char *topic,
+                                 const void *payload,
+                                 size_t payload_len,
+                                 uint8_t qos);
+
+/// @brief Read the oldest message not yet committed
+/// @return ESP_ERR_NOT_FOUND if the outbox is empty
+esp_err_t sim7080g_outbox_peek(sim7080g_outbox_handle_t outbox, sim7080g_outbox_record_t *record_out);
+
+/// @brief Mark the message returned by sim7080g_outbox_peek as delivered and move the cursor past it
+esp_err_t sim7080g_outbox_commit(sim7080g_outbox_handle_t outbox);
+
+/// @brief Publish stored messages in order, back to back, committing each once the publish succeeds
+/// @note Checks sim7080g_mqtt_get_broker_connection_status first - stops at the first failed publish, which is kept for next time.
+///       A message the publish refuses outright (ESP_ERR_INVALID_ARG / ESP_ERR_INVALID_SIZE) would never go out - it is
+///       committed, logged and counted in rejected_records instead.
+/// @param max_messages 0 to replay everything stored
+/// @param sent_out Messages published and committed - may be NULL
+/// @return ESP_OK once the outbox is empty or max_messages were sent, ESP_ERR_INVALID_STATE if the broker is not connected
+///         (or another replay is running), otherwise the error of the failed publish
+esp_err_t sim7080g_outbox_replay(sim7080g_outbox_handle_t outbox,
+                                 const sim7080g_handle_t *sim7080g_handle,
+                                 uint32_t max_messages,
+                                 uint32_t *sent_out);
+
+/// @brief Publish now if connected and nothing is waiting in the outbox, otherwise store the message for replay
+/// @note Messages are never reordered - while the outbox is not empty new messages are stored behind the old ones.
+///       While a message is being published past an empty outbox, sim7080g_outbox_append and sim7080g_outbox_replay wait
+///       for it to be sent or stored.
+/// @return ESP_OK if the message was published or stored
+esp_err_t sim7080g_outbox_publish(sim7080g_outbox_handle_t outbox,
+                                  const sim7080g_handle_t *sim7080g_handle,
+                                  const char *topic,
+                                  const void *payload,
+                                  size_t payload_len,
+                                  uint8_t qos);
+
+esp_err_t sim7080g_outbox_get_stats(sim7080g_outbox_handle_t outbox, sim7080g_outbox_stats_t *stats_out);
+
+/// @brief Check segment rotation and wear levelling, cursor recovery after a reopen and the skipping of a torn record
+/// @note ERASES the whole partition (at least 3 segments) - does not need the device
+bool sim7080g_test_outbox(const char *partition_label);
@@ -0,0 +1,103 @@
+#pragma once
+
+#include <esp_err.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "sim7080g_driver_esp_idf.h"
+
+#define SIM7080G_SUPERVISOR_DEFAULT_CHECK_INTERVAL_MS 30000
+#define SIM7080G_SUPERVISOR_DEFAULT_ATTEMPTS_PER_RUNG 2
+#define SIM7080G_SUPERVISOR_DEFAULT_BACKOFF_BASE_MS 1000
+#define SIM7080G_SUPERVISOR_DEFAULT_BACKOFF_MAX_MS 60000
+#define SIM7080G_SUPERVISOR_DEFAULT_REGISTRATION_TIMEOUT_MS 60000
+#define SIM7080G_SUPERVISOR_TASK_DEFAULT_PRIORITY 5
+#define SIM7080G_SUPERVISOR_TASK_STACK_SIZE 4096
+
+/// @brief Connection layers, lowest first - each one needs every layer below it
+typedef enum
+{
+    SIM7080G_LAYER_PHYSICAL = 0, // Radio on (CFUN=1) and SIM ready
+    SIM7080G_LAYER_DATA_LINK,    // Registered on the home network or roaming
+    SIM7080G_LAYER_NETWORK,      // PDP context 0 active
+    SIM7080G_LAYER_APPLICATION,  // MQTT session up
+    SIM7080G_LAYER_COUNT
+} sim7080g_layer_t;
+
+/// @brief Repairs, cheapest first - the escalation ladder
+/// @note Each layer starts at its own repair (SIM7080G_REPAIR_MQTT_RECONNECT for the application layer,
+///       SIM7080G_REPAIR_CFUN_CYCLE for the physical layer) and only climbs once that repair keeps failing
+typedef enum
+{
+    SIM7080G_REPAIR_MQTT_RECONNECT = 0, // AT+SMCONN
+    SIM7080G_REPAIR_PDP_REACTIVATE,     // AT+CNACT=0,1 (deactivated first if the context looks up)
+    SIM7080G_REPAIR_REATTACH,           // AT+CGATT=1 (detached first if the device looks attached), then wait for registration
+    SIM7080G_REPAIR_CFUN_CYCLE,         // sim7080g_cycle_cfun
+    SIM7080G_REPAIR_POWER_CYCLE,        // The config's power_cycle callback - skipped if there is none
+    SIM7080G_REPAIR_COUNT
+} sim7080g_repair_t;
+
+/// @brief Power the device off and on again (PWRKEY or supply - board specific) and return once it answers AT commands
+typedef esp_err_t (*sim7080g_power_cycle_t)(const sim7080g_handle_t *sim7080g_handle, void *arg);
+
+/// @brief Called from the supervisor task whenever a layer goes down or comes back up
+/// @note Subscriptions do not survive a new MQTT session - renew them here once the application layer is back up
+typedef void (*sim7080g_layer_change_cb_t)(sim7080g_layer_t layer, bool up, void *arg);
+
+typedef struct
+{
+    uint32_t check_interval_ms;       // Probe period while every layer is up - 0 selects SIM7080G_SUPERVISOR_DEFAULT_CHECK_INTERVAL_MS
+    uint8_t attempts_per_rung;        // Failed repairs before climbing to the next one - 0 selects SIM7080G_SUPERVISOR_DEFAULT_ATTEMPTS_PER_RUNG
+    uint32_t backoff_base_ms;         // Wait after the first failed repair, doubled each failure after - 0 selects SIM7080G_SUPERVISOR_DEFAULT_BACKOFF_BASE_MS
+    uint32_t backoff_max_ms;          // 0 selects SIM7080G_SUPERVISOR_DEFAULT_BACKOFF_MAX_MS
+    uint32_t registration_timeout_ms; // Wait for registration after a reattach - 0 selects SIM7080G_SUPERVISOR_DEFAULT_REGISTRATION_TIMEOUT_MS
+    sim7080g_power_cycle_t power_cycle; // Last rung - NULL leaves the CFUN cycle as the last resort
+    void *power_cycle_arg;
+    sim7080g_layer_change_cb_t on_layer_change; // May be NULL
+    void *on_layer_change_arg;
+    int task_priority; // 0 selects SIM7080G_SUPERVISOR_TASK_DEFAULT_PRIORITY
+} sim7080g_supervisor_config_t;
+
+typedef struct
+{
+    bool up;
+    uint32_t drops;            // Times found down after having been up
+    uint32_t recoveries;
+    uint32_t last_recover_ms;  // From being found down to being found up again
+    uint32_t max_recover_ms;
+    uint64_t total_recover_ms; // Mean time to recover is total_recover_ms / recoveries
+} sim7080g_layer_stats_t;
+
+typedef struct
+{
+    sim7080g_layer_stats_t layers[SIM7080G_LAYER_COUNT];
+    uint32_t repairs[SIM7080G_REPAIR_COUNT];         // Times each repair was run
+    uint32_t repair_failures[SIM7080G_REPAIR_COUNT]; // Runs that did not bring their layer back up
+    uint32_t probes;
+} sim7080g_supervisor_stats_t;
+
+/// @brief Watches the connection layer by layer and repairs only the lowest one that is down
+/// @note The state of every layer is read in one exchange (AT+CFUN?;+CPIN?;+CEREG?;+CNACT?;+SMSTATE?) every
+///       check_interval_ms, and straight away when the device reports a change ('+SMSTATE', '+APP PDP', '+CEREG', '+CPIN', '+CFUN').
+///       A dropped MQTT session costs one AT+SMCONN - the radio is only restarted once the repairs below it have failed.
+/// @note While the supervisor runs it owns connection repair - the application should not bring layers up or down itself
+typedef struct sim7080g_supervisor sim7080g_supervisor_t;
+typedef sim7080g_supervisor_t *sim7080g_supervisor_handle_t;
+
+/// @brief Start supervising - layers that are down when this is called are brought up as if they had dropped
+/// @param config NULL for every default
+esp_err_t sim7080g_supervisor_create(const sim7080g_handle_t *sim7080g_handle,
+                                     const sim7080g_supervisor_config_t *config,
+                                     sim7080g_supervisor_handle_t *supervisor_out);
+
+/// @brief Probe the layers now rather than at the next check
+esp_err_t sim7080g_supervisor_check_now(sim7080g_supervisor_handle_t supervisor);
+
+esp_err_t sim7080g_supervisor_get_stats(sim7080g_supervisor_handle_t supervisor, sim7080g_supervisor_stats_t *stats_out);
+
+/// @brief Stop supervising and free the supervisor - waits for a repair in progress to finish
+esp_err_t sim7080g_supervisor_delete(sim7080g_supervisor_handle_t supervisor);
+
+const char *sim7080g_layer_name(sim7080g_layer_t layer);
+const char *sim7080g_repair_name(sim7080g_repair_t repair);
@@ -0,0 +1,57 @@
+#pragma once
+
+#include <esp_err.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "sim7080g_driver_esp_idf.h"
+
+#define SIM7080G_TELEMETRY_DEFAULT_CAPACITY 32
+#define SIM7080G_TELEMETRY_DEFAULT_PAYLOAD_LEN 128
+#define SIM7080G_TELEMETRY_DRAIN_TASK_DEFAULT_PRIORITY 5
+#define SIM7080G_TELEMETRY_DRAIN_TASK_STACK_SIZE 3072
+
+/// @brief Bounded multi-producer queue of {topic_id, payload} records, published in order by one drain task
+/// @note Any number of tasks may enqueue - an enqueue copies the record into a free slot without taking a lock
+///       and never waits on the device. The drain task owns the device side and publishes each record with sim7080g_mqtt_publish_iov.
+typedef struct sim7080g_telemetry_queue sim7080g_telemetry_queue_t;
+typedef sim7080g_telemetry_queue_t *sim7080g_telemetry_queue_handle_t;
+
+typedef struct
+{
+    const char *const *topics; // Topic of each topic_id - the table and strings are not copied and must outlive the queue
+    size_t topic_count;
+    size_t capacity;        // Records the queue holds - rounded up to a power of two, 0 selects SIM7080G_TELEMETRY_DEFAULT_CAPACITY
+    size_t max_payload_len; // Largest record payload - 0 selects SIM7080G_TELEMETRY_DEFAULT_PAYLOAD_LEN (at most SIM7080G_MQTT_MAX_PAYLOAD_LEN)
+    uint8_t qos;
+    int drain_task_priority; // 0 selects SIM7080G_TELEMETRY_DRAIN_TASK_DEFAULT_PRIORITY
+} sim7080g_telemetry_config_t;
+
+typedef struct
+{
+    uint32_t enqueued;
+    uint32_t dropped;        // Enqueues refused because the queue was full
+    uint32_t published;
+    uint32_t publish_errors; // Records the drain task dequeued but could not publish (they are not retried)
+} sim7080g_telemetry_stats_t;
+
+/// @brief Create a queue and start its drain task
+esp_err_t sim7080g_telemetry_create(const sim7080g_handle_t *sim7080g_handle,
+                                    const sim7080g_telemetry_config_t *config,
+                                    sim7080g_telemetry_queue_handle_t *queue_out);
+
+/// @brief Copy a record into the queue - safe to call from any number of tasks at once (not from an ISR)
+/// @return ESP_ERR_NO_MEM if the queue is full (the record is dropped), ESP_ERR_INVALID_SIZE if len exceeds max_payload_len,
+///         ESP_ERR_INVALID_ARG if len is 0 (a publish needs at least one byte)
+esp_err_t sim7080g_telemetry_enqueue(sim7080g_telemetry_queue_handle_t queue, uint16_t topic_id, const void *payload, size_t len);
+
+esp_err_t sim7080g_telemetry_get_stats(sim7080g_telemetry_queue_handle_t queue, sim7080g_telemetry_stats_t *stats_out);
+
+/// @brief Publish what is queued, stop the drain task and free the queue
+/// @note No task may enqueue once this is called
+esp_err_t sim7080g_telemetry_delete(sim7080g_telemetry_queue_handle_t queue);
+
+/// @brief Measure enqueue cost (CPU cycles) with several producer tasks pushing at once, and check no record is lost, duplicated or reordered
+/// @note Does not need the device - the test drains the queue itself
+bool sim7080g_test_telemetry_queue(int iterations);
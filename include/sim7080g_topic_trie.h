@@ -0,0 +1,42 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/// @brief MQTT topic filters (with '+' and '#' wildcards) stored one level per node
+/// @note Matching a topic walks one path per wildcard branch - its cost follows the number of topic levels,
+///       not the number of filters stored. Values are opaque to the trie, and one filter may hold several.
+typedef struct topic_trie_node topic_trie_node_t;
+
+typedef struct
+{
+    topic_trie_node_t *root;
+} topic_trie_t;
+
+/// @brief Called for each value of a filter matching the topic
+typedef void (*topic_trie_visit_t)(void *value, void *arg);
+
+/// @brief Called for each value removed from the trie (e.g. to free it)
+typedef void (*topic_trie_release_t)(void *value);
+
+void topic_trie_init(topic_trie_t *trie);
+
+/// @brief Remove every filter, releasing each value - release may be NULL
+void topic_trie_clear(topic_trie_t *trie, topic_trie_release_t release);
+
+/// @brief Check a filter against the MQTT rules - '+' and '#' fill a whole level and '#' is the last level
+bool topic_filter_is_valid(const char *filter);
+
+/// @brief Add a value to a filter
+/// @return false if the filter is invalid or out of memory
+bool topic_trie_insert(topic_trie_t *trie, const char *filter, void *value);
+
+/// @brief Remove value from a filter, or every value of the filter if value is NULL, releasing each one removed
+/// @return Number of values removed
+size_t topic_trie_remove(topic_trie_t *trie, const char *filter, void *value, topic_trie_release_t release);
+
+/// @brief Visit the values of every filter matching a topic
+/// @note topic need not be null terminated. As MQTT requires, a topic starting with '$' is not matched by a wildcard in its first level.
+/// @return Number of values visited
+size_t topic_trie_match(const topic_trie_t *trie, const char *topic, size_t topic_len, topic_trie_visit_t visit, void *arg);
@@ -9,13 +9,38 @@
 #define WRITE_CMD(cmd) cmd "="
 #define EXECUTE_CMD(cmd) cmd
 
+const at_retry_policy_t AT_RETRY_DEFAULT = {
+    .max_attempts = 4,
+    .base_delay_ms = 100,
+    .max_delay_ms = 1000,
+    .deadline_ms = 0};
+
+const at_retry_policy_t AT_RETRY_NETWORK = {
+    .max_attempts = 3,
+    .base_delay_ms = 1000,
+    .max_delay_ms = 8000,
+    .deadline_ms = 60000};
+
+const at_retry_policy_t AT_RETRY_ONCE = {
+    .max_attempts = 1};
+
+const at_cmd_t AT_AT = {
+    .name = "AT",
+    .description = "Attention - Check that the device responds",
+    .test = {0},
+    .read = {0},
+    .write = {0},
+    .execute = {EXECUTE_CMD("AT"), "OK"},
+    .idempotent = true};
+
 const at_cmd_t AT_ECHO_OFF = {
     .name = "ATE0",
     .description = "Echo Off - Disable command echo",
     .test = {0},
     .read = {0},
     .write = {0},
-    .execute = {EXECUTE_CMD("ATE0"), "OK"}};
+    .execute = {EXECUTE_CMD("ATE0"), "OK"},
+    .idempotent = true};
 
 const at_cmd_t AT_CPIN = {
     .name = "AT+CPIN",
@@ -31,7 +56,8 @@ const at_cmd_t AT_CSQ = {
     .test = {TEST_CMD("AT+CSQ"), "OK"},
     .read = {0},
     .write = {0},
-    .execute = {EXECUTE_CMD("AT+CSQ"), "+CSQ: %d,%d"}};
+    .execute = {EXECUTE_CMD("AT+CSQ"), "+CSQ: %d,%d"},
+    .idempotent = true};
 
 const at_cmd_t AT_CGATT = {
     .name = "AT+CGATT",
@@ -39,7 +65,9 @@ const at_cmd_t AT_CGATT = {
     .test = {TEST_CMD("AT+CGATT"), "OK"},
     .read = {READ_CMD("AT+CGATT"), "+CGATT: %d"},
     .write = {WRITE_CMD("AT+CGATT"), "OK"},
-    .execute = {0}};
+    .execute = {0},
+    .idempotent = true,
+    .retry = &AT_RETRY_NETWORK};
 
 const at_cmd_t AT_COPS = {
     .name = "AT+COPS",
@@ -47,7 +75,9 @@ const at_cmd_t AT_COPS = {
     .test = {TEST_CMD("AT+COPS"), "+COPS: (LIST)"},
     .read = {READ_CMD("AT+COPS"), "+COPS: %d,%d,\"%[^\"]\",%d"},
     .write = {WRITE_CMD("AT+COPS"), "OK"},
-    .execute = {0}};
+    .execute = {0},
+    .idempotent = true,
+    .retry = &AT_RETRY_NETWORK};
 
 const at_cmd_t AT_CGNAPN = {
     .name = "AT+CGNAPN",
@@ -55,7 +85,8 @@ const at_cmd_t AT_CGNAPN = {
     .test = {0},
     .read = {0},
     .write = {0},
-    .execute = {EXECUTE_CMD("AT+CGNAPN"), "+CGNAPN: %d,\"%[^\"]\""}};
+    .execute = {EXECUTE_CMD("AT+CGNAPN"), "+CGNAPN: %d,\"%[^\"]\""},
+    .idempotent = true};
 
 const at_cmd_t AT_CNCFG = {
     .name = "AT+CNCFG",
@@ -63,7 +94,8 @@ const at_cmd_t AT_CNCFG = {
     .test = {TEST_CMD("AT+CNCFG"), "OK"},
     .read = {READ_CMD("AT+CNCFG"), "+CNCFG: %d,%d,\"%[^\"]\""},
     .write = {WRITE_CMD("AT+CNCFG"), "OK"},
-    .execute = {0}};
+    .execute = {0},
+    .idempotent = true};
 
 const at_cmd_t AT_CNACT = {
     .name = "AT+CNACT",
@@ -71,7 +103,8 @@ const at_cmd_t AT_CNACT = {
     .test = {TEST_CMD("AT+CNACT"), "OK"},
     .read = {READ_CMD("AT+CNACT"), "+CNACT: %d,%d,\"%[^\"]\""},
     .write = {WRITE_CMD("AT+CNACT"), "OK"},
-    .execute = {0}};
+    .execute = {0},
+    .retry = &AT_RETRY_NETWORK};
 
 const at_cmd_t AT_SMCONF = {
     .name = "AT+SMCONF",
@@ -79,7 +112,8 @@ const at_cmd_t AT_SMCONF = {
     .test = {TEST_CMD("AT+SMCONF"), "OK"},
     .read = {READ_CMD("AT+SMCONF"), "+SMCONF: \"%[^\"]\",\"%[^\"]\""},
     .write = {WRITE_CMD("AT+SMCONF"), "OK"},
-    .execute = {0}};
+    .execute = {0},
+    .idempotent = true};
 
 const at_cmd_t AT_SMCONN = {
     .name = "AT+SMCONN",
@@ -87,7 +121,8 @@ const at_cmd_t AT_SMCONN = {
     .test = {0},
     .read = {0},
     .write = {0},
-    .execute = {EXECUTE_CMD("AT+SMCONN"), "OK"}};
+    .execute = {EXECUTE_CMD("AT+SMCONN"), "OK"},
+    .retry = &AT_RETRY_NETWORK};
 
 const at_cmd_t AT_SMSUB = {
     .name = "AT+SMSUB",
@@ -95,7 +130,9 @@ const at_cmd_t AT_SMSUB = {
     .test = {0},
     .read = {0},
     .write = {WRITE_CMD("AT+SMSUB"), "OK"},
-    .execute = {0}};
+    .execute = {0},
+    .idempotent = true,
+    .info_lines_are_urcs = true};
 
 const at_cmd_t AT_SMPUB = {
     .name = "AT+SMPUB",
@@ -103,7 +140,9 @@ const at_cmd_t AT_SMPUB = {
     .test = {0},
     .read = {0},
     .write = {WRITE_CMD("AT+SMPUB"), ">"},
-    .execute = {0}};
+    .execute = {0},
+    .retry = &AT_RETRY_ONCE,
+    .info_lines_are_urcs = true};
 
 const at_cmd_t AT_SMUNSUB = {
     .name = "AT+SMUNSUB",
@@ -111,7 +150,8 @@ const at_cmd_t AT_SMUNSUB = {
     .test = {TEST_CMD("AT+SMUNSUB"), "OK"},
     .read = {0},
     .write = {WRITE_CMD("AT+SMUNSUB"), "OK"},
-    .execute = {0}};
+    .execute = {0},
+    .idempotent = true};
 
 const at_cmd_t AT_SMDISC = {
     .name = "AT+SMDISC",
@@ -135,7 +175,8 @@ const at_cmd_t AT_CMEE = {
     .test = {TEST_CMD("AT+CMEE"), "OK"},
     .read = {READ_CMD("AT+CMEE"), "+CMEE: %d"},
     .write = {WRITE_CMD("AT+CMEE"), "OK"},
-    .execute = {0}};
+    .execute = {0},
+    .idempotent = true};
 
 const at_cmd_t AT_CFUN = {
     .name = "AT+CFUN",
@@ -143,7 +184,26 @@ const at_cmd_t AT_CFUN = {
     .test = {TEST_CMD("AT+CFUN"), "OK"},
     .read = {READ_CMD("AT+CFUN"), "+CFUN: %d"},
     .write = {WRITE_CMD("AT+CFUN"), "OK"},
-    .execute = {0}};
+    .execute = {0},
+    .retry = &AT_RETRY_ONCE};
+
+const at_cmd_t AT_IPR = {
+    .name = "AT+IPR",
+    .description = "Set Local Baud Rate - Set the baud rate of the device UART",
+    .test = {TEST_CMD("AT+IPR"), "+IPR: (LIST),(LIST)"},
+    .read = {READ_CMD("AT+IPR"), "+IPR: %d"},
+    .write = {WRITE_CMD("AT+IPR"), "OK"},
+    .execute = {0},
+    .retry = &AT_RETRY_ONCE};
+
+const at_cmd_t AT_IFC = {
+    .name = "AT+IFC",
+    .description = "Local Data Flow Control - Enable or disable RTS/CTS hardware flow control",
+    .test = {TEST_CMD("AT+IFC"), "+IFC: (0,2),(0,2)"},
+    .read = {READ_CMD("AT+IFC"), "+IFC: %d,%d"},
+    .write = {WRITE_CMD("AT+IFC"), "OK"},
+    .execute = {0},
+    .idempotent = true};
 
 const at_cmd_t AT_CEREG = {
     .name = "AT+CEREG",
@@ -151,7 +211,8 @@ const at_cmd_t AT_CEREG = {
     .test = {TEST_CMD("AT+CEREG"), "+CEREG: (0-2,4)"},
     .read = {READ_CMD("AT+CEREG"), "+CEREG: %d,%d"}, // Basic format: mode,status
     .write = {WRITE_CMD("AT+CEREG"), "OK"},
-    .execute = {0}};
+    .execute = {0},
+    .idempotent = true};
 
 // TODO - Implement this if its found relevant later to check  transport layer connection
 //  const at_cmd_t AT_CASTATE = {
@@ -0,0 +1,417 @@
+#include <limits.h>
+#include <string.h>
+#include "sim7080g_at_parser.h"
+
+static void at_parser_skip_spaces(at_parser_t *parser)
+{
+    while (parser->pos < parser->end && *parser->pos == ' ')
+    {
+        parser->pos++;
+    }
+}
+
+/// @brief Finish a field - only spaces may follow it before the ',' separator or the end
+static bool at_parser_end_field(at_parser_t *fields)
+{
+    at_parser_skip_spaces(fields);
+    if (fields->pos == fields->end)
+    {
+        return true;
+    }
+    if (*fields->pos == ',')
+    {
+        fields->pos++;
+        at_parser_skip_spaces(fields);
+        return true;
+    }
+    return false;
+}
+
+void at_parser_init(at_parser_t *parser, const char *buf, size_t len)
+{
+    parser->pos = buf;
+    parser->end = buf + len;
+}
+
+bool at_parser_next_line(at_parser_t *parser, at_parser_t *line_out)
+{
+    while (parser->pos < parser->end && (*parser->pos == '\r' || *parser->pos == '\n'))
+    {
+        parser->pos++;
+    }
+    if (parser->pos == parser->end)
+    {
+        return false;
+    }
+
+    const char *start = parser->pos;
+    while (parser->pos < parser->end && *parser->pos != '\r' && *parser->pos != '\n')
+    {
+        parser->pos++;
+    }
+
+    line_out->pos = start;
+    line_out->end = parser->pos;
+    return true;
+}
+
+bool at_parser_find_line(at_parser_t *parser, const char *prefix, at_parser_t *fields_out)
+{
+    at_parser_t line;
+    while (at_parser_next_line(parser, &line))
+    {
+        if (at_parser_match(&line, prefix))
+        {
+            *fields_out = line;
+            return true;
+        }
+    }
+    return false;
+}
+
+static bool at_parser_match_len(at_parser_t *parser, const char *prefix, size_t prefix_len)
+{
+    if ((size_t)(parser->end - parser->pos) < prefix_len || memcmp(parser->pos, prefix, prefix_len) != 0)
+    {
+        return false;
+    }
+
+    parser->pos += prefix_len;
+    at_parser_skip_spaces(parser);
+    return true;
+}
+
+bool at_parser_match(at_parser_t *parser, const char *prefix)
+{
+    return at_parser_match_len(parser, prefix, strlen(prefix));
+}
+
+bool at_parser_int(at_parser_t *fields, int *out)
+{
+    at_parser_t cursor = *fields;
+    at_parser_skip_spaces(&cursor);
+
+    bool negative = false;
+    if (cursor.pos < cursor.end && (*cursor.pos == '-' || *cursor.pos == '+'))
+    {
+        negative = *cursor.pos == '-';
+        cursor.pos++;
+    }
+
+    const char *digits = cursor.pos;
+    int value = 0;
+    while (cursor.pos < cursor.end && *cursor.pos >= '0' && *cursor.pos <= '9')
+    {
+        int digit = *cursor.pos - '0';
+        if (value > (INT_MAX - digit) / 10)
+        {
+            return false; // Out of range - never a valid AT field
+        }
+        value = value * 10 + digit;
+        cursor.pos++;
+    }
+
+    if (cursor.pos == digits || !at_parser_end_field(&cursor))
+    {
+        return false;
+    }
+
+    *out = negative ? -value : value;
+    *fields = cursor;
+    return true;
+}
+
+bool at_parser_str(at_parser_t *fields, at_str_t *out)
+{
+    at_parser_t cursor = *fields;
+    at_parser_skip_spaces(&cursor);
+
+    const char *start;
+    const char *stop;
+    if (cursor.pos < cursor.end && *cursor.pos == '"')
+    {
+        start = ++cursor.pos;
+        const char *quote = memchr(start, '"', cursor.end - start);
+        if (quote == NULL)
+        {
+            return false;
+        }
+        stop = quote;
+        cursor.pos = quote + 1;
+    }
+    else
+    {
+        start = cursor.pos;
+        const char *comma = memchr(start, ',', cursor.end - start);
+        cursor.pos = (comma != NULL) ? comma : cursor.end;
+        stop = cursor.pos;
+        while (stop > start && stop[-1] == ' ')
+        {
+            stop--;
+        }
+    }
+
+    if (!at_parser_end_field(&cursor))
+    {
+        return false;
+    }
+
+    out->ptr = start;
+    out->len = (size_t)(stop - start);
+    *fields = cursor;
+    return true;
+}
+
+bool at_parser_list(at_parser_t *fields, at_str_t *out)
+{
+    at_parser_t cursor = *fields;
+    at_parser_skip_spaces(&cursor);
+
+    if (cursor.pos == cursor.end || *cursor.pos != '(')
+    {
+        return false;
+    }
+
+    const char *start = ++cursor.pos;
+    const char *close = memchr(start, ')', cursor.end - start);
+    if (close == NULL)
+    {
+        return false;
+    }
+    cursor.pos = close + 1;
+
+    if (!at_parser_end_field(&cursor))
+    {
+        return false;
+    }
+
+    out->ptr = start;
+    out->len = (size_t)(close - start);
+    *fields = cursor;
+    return true;
+}
+
+bool at_parser_skip(at_parser_t *fields)
+{
+    at_str_t unused;
+    return at_parser_list(fields, &unused) || at_parser_str(fields, &unused);
+}
+
+bool at_parser_done(const at_parser_t *fields)
+{
+    return fields->pos == fields->end;
+}
+
+bool at_str_eq(at_str_t str, const char *literal)
+{
+    return strlen(literal) == str.len && memcmp(str.ptr, literal, str.len) == 0;
+}
+
+bool at_str_copy(at_str_t str, char *dst, size_t dst_size)
+{
+    if (dst_size == 0)
+    {
+        return false;
+    }
+
+    size_t len = str.len < dst_size - 1 ? str.len : dst_size - 1;
+    memcpy(dst, str.ptr, len);
+    dst[len] = '\0';
+    return len == str.len;
+}
+
+// ------ Hex ------ //
+
+// Value of each hex digit with bit 4 set as a valid flag - 0 for every other character
+#define AT_HEX_DIGIT(value) (0x10 | (value))
+static const uint8_t AT_HEX_TABLE[256] = {
+    ['0'] = AT_HEX_DIGIT(0x0), ['1'] = AT_HEX_DIGIT(0x1), ['2'] = AT_HEX_DIGIT(0x2), ['3'] = AT_HEX_DIGIT(0x3),
+    ['4'] = AT_HEX_DIGIT(0x4), ['5'] = AT_HEX_DIGIT(0x5), ['6'] = AT_HEX_DIGIT(0x6), ['7'] = AT_HEX_DIGIT(0x7),
+    ['8'] = AT_HEX_DIGIT(0x8), ['9'] = AT_HEX_DIGIT(0x9),
+    ['A'] = AT_HEX_DIGIT(0xA), ['B'] = AT_HEX_DIGIT(0xB), ['C'] = AT_HEX_DIGIT(0xC),
+    ['D'] = AT_HEX_DIGIT(0xD), ['E'] = AT_HEX_DIGIT(0xE), ['F'] = AT_HEX_DIGIT(0xF),
+    ['a'] = AT_HEX_DIGIT(0xA), ['b'] = AT_HEX_DIGIT(0xB), ['c'] = AT_HEX_DIGIT(0xC),
+    ['d'] = AT_HEX_DIGIT(0xD), ['e'] = AT_HEX_DIGIT(0xE), ['f'] = AT_HEX_DIGIT(0xF),
+};
+
+bool at_hex_decode(const char *hex, size_t hex_len, uint8_t *out)
+{
+    if (hex_len % 2 != 0)
+    {
+        return false;
+    }
+
+    // Byte i only reads hex[2i] and hex[2i + 1], so writing it never clobbers input still to be read.
+    // The high digit's flag bit is shifted out of the byte, the low one's is masked off.
+    const uint8_t *in = (const uint8_t *)hex;
+    uint8_t valid = 0x10;
+    for (size_t i = 0; i < hex_len / 2; i++)
+    {
+        uint8_t hi = AT_HEX_TABLE[in[2 * i]];
+        uint8_t lo = AT_HEX_TABLE[in[2 * i + 1]];
+        valid &= hi & lo;
+        out[i] = (uint8_t)((hi << 4) | (lo & 0x0F));
+    }
+    return valid != 0;
+}
+
+// ------ Typed decoding ------ //
+
+#define AT_FORMAT_QUOTED_STR "\"%[^\"]\""
+
+bool at_decoder_compile(at_decoder_t *decoder, const char *format, const at_field_t *layout, size_t layout_len)
+{
+    if (decoder == NULL || format == NULL || (layout == NULL && layout_len > 0))
+    {
+        return false;
+    }
+    memset(decoder, 0, sizeof(*decoder));
+
+    // Prefix is everything up to and including the ':' - a format without one (e.g. "OK", ">") has no fields
+    const char *colon = strchr(format, ':');
+    const char *fmt = (colon != NULL) ? colon + 1 : format + strlen(format);
+    if (fmt - format > UINT8_MAX)
+    {
+        return false;
+    }
+    decoder->prefix = format;
+    decoder->prefix_len = (uint8_t)(fmt - format);
+
+    while (*fmt == ' ')
+    {
+        fmt++;
+    }
+
+    while (*fmt != '\0')
+    {
+        if (decoder->field_count == AT_DECODER_MAX_FIELDS || decoder->field_count == layout_len)
+        {
+            return false;
+        }
+
+        at_field_type_t type;
+        if (strncmp(fmt, "%d", 2) == 0)
+        {
+            type = AT_FIELD_INT;
+            fmt += 2;
+        }
+        else if (strncmp(fmt, "%s", 2) == 0)
+        {
+            type = AT_FIELD_STR;
+            fmt += 2;
+        }
+        else if (strncmp(fmt, AT_FORMAT_QUOTED_STR, strlen(AT_FORMAT_QUOTED_STR)) == 0)
+        {
+            type = AT_FIELD_STR;
+            fmt += strlen(AT_FORMAT_QUOTED_STR);
+        }
+        else if (*fmt == '(' && strchr(fmt, ')') != NULL)
+        {
+            type = AT_FIELD_LIST;
+            fmt = strchr(fmt, ')') + 1;
+        }
+        else
+        {
+            return false;
+        }
+
+        const at_field_t *field = &layout[decoder->field_count];
+        if (type == AT_FIELD_INT && field->size != 0 && field->size != 1 && field->size != 2 && field->size != 4)
+        {
+            return false;
+        }
+        decoder->fields[decoder->field_count].offset = field->offset;
+        decoder->fields[decoder->field_count].size = field->size;
+        decoder->fields[decoder->field_count].type = (uint8_t)type;
+        decoder->field_count++;
+
+        if (*fmt == ',')
+        {
+            fmt++;
+        }
+        else if (*fmt != '\0')
+        {
+            return false;
+        }
+    }
+
+    return decoder->field_count == layout_len;
+}
+
+static void at_decoder_store_int(void *dst, uint16_t size, int value)
+{
+    switch (size)
+    {
+    case 1:
+    {
+        int8_t v = (int8_t)value;
+        memcpy(dst, &v, sizeof(v));
+        break;
+    }
+    case 2:
+    {
+        int16_t v = (int16_t)value;
+        memcpy(dst, &v, sizeof(v));
+        break;
+    }
+    case 4:
+    {
+        int32_t v = (int32_t)value;
+        memcpy(dst, &v, sizeof(v));
+        break;
+    }
+    default:
+        break;
+    }
+}
+
+static int at_decoder_fields(const at_decoder_t *decoder, at_parser_t *fields, void *out)
+{
+    int decoded = 0;
+    for (int i = 0; i < decoder->field_count && !at_parser_done(fields); i++)
+    {
+        const at_field_desc_t *desc = &decoder->fields[i];
+        char *dst = (char *)out + desc->offset;
+
+        if (desc->type == AT_FIELD_INT)
+        {
+            int value;
+            if (!at_parser_int(fields, &value))
+            {
+                break;
+            }
+            at_decoder_store_int(dst, desc->size, value);
+        }
+        else
+        {
+            at_str_t str;
+            bool ok = (desc->type == AT_FIELD_LIST) ? at_parser_list(fields, &str) : at_parser_str(fields, &str);
+            if (!ok || (desc->size > 0 && !at_str_copy(str, dst, desc->size)))
+            {
+                break;
+            }
+        }
+        decoded++;
+    }
+    return decoded;
+}
+
+int at_decoder_next(const at_decoder_t *decoder, at_parser_t *parser, void *out)
+{
+    at_parser_t line;
+    while (at_parser_next_line(parser, &line))
+    {
+        if (at_parser_match_len(&line, decoder->prefix, decoder->prefix_len))
+        {
+            return at_decoder_fields(decoder, &line, out);
+        }
+    }
+    return -1;
+}
+
+int at_decoder_decode(const at_decoder_t *decoder, const char *response, size_t len, void *out)
+{
+    at_parser_t parser;
+    at_parser_init(&parser, response, len);
+    return at_decoder_next(decoder, &parser, out);
+}
@@ -0,0 +1,401 @@
+#include <math.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <string.h>
+#include <esp_err.h>
+#include <esp_log.h>
+#include <esp_cpu.h>
+
+#include "sim7080g_cbor.h"
+
+#define CBOR_MAJOR_UINT 0
+#define CBOR_MAJOR_NEGINT 1
+#define CBOR_MAJOR_BYTES 2
+#define CBOR_MAJOR_TEXT 3
+#define CBOR_MAJOR_ARRAY 4
+#define CBOR_MAJOR_MAP 5
+#define CBOR_MAJOR_SIMPLE 7
+
+#define CBOR_FALSE 0xF4
+#define CBOR_TRUE 0xF5
+#define CBOR_NULL 0xF6
+#define CBOR_HALF 0xF9
+#define CBOR_SINGLE 0xFA
+#define CBOR_DOUBLE 0xFB
+
+static const char *TAG = "SIM7080G CBOR";
+
+// Claimed with a compare-and-swap on the busy mask, so publishing tasks never block each other here
+static uint8_t cbor_pool[SIM7080G_CBOR_POOL_BUFFERS][SIM7080G_MQTT_MAX_PAYLOAD_LEN];
+static _Atomic uint32_t cbor_pool_busy;
+
+void cbor_writer_init(cbor_writer_t *writer, void *buf, size_t size)
+{
+    writer->buf = buf;
+    writer->size = size;
+    writer->len = 0;
+    writer->overflow = false;
+}
+
+bool cbor_writer_ok(const cbor_writer_t *writer)
+{
+    return !writer->overflow;
+}
+
+static bool cbor_put_raw(cbor_writer_t *writer, const void *data, size_t len)
+{
+    if (writer->overflow || writer->size - writer->len < len)
+    {
+        writer->overflow = true;
+        return false;
+    }
+    memcpy(&writer->buf[writer->len], data, len);
+    writer->len += len;
+    return true;
+}
+
+/// @brief Write a big endian value of width bytes after an initial byte
+static bool cbor_put_be(cbor_writer_t *writer, uint8_t initial, uint64_t value, size_t width)
+{
+    uint8_t head[9];
+    head[0] = initial;
+    for (size_t i = 0; i < width; i++)
+    {
+        head[width - i] = (uint8_t)(value >> (8 * i));
+    }
+    return cbor_put_raw(writer, head, width + 1);
+}
+
+/// @brief Write a major type with its argument in the fewest bytes
+static bool cbor_put_head(cbor_writer_t *writer, uint8_t major, uint64_t value)
+{
+    uint8_t type = (uint8_t)(major << 5);
+    if (value < 24)
+    {
+        return cbor_put_be(writer, type | (uint8_t)value, 0, 0);
+    }
+    if (value <= UINT8_MAX)
+    {
+        return cbor_put_be(writer, type | 24, value, 1);
+    }
+    if (value <= UINT16_MAX)
+    {
+        return cbor_put_be(writer, type | 25, value, 2);
+    }
+    if (value <= UINT32_MAX)
+    {
+        return cbor_put_be(writer, type | 26, value, 4);
+    }
+    return cbor_put_be(writer, type | 27, value, 8);
+}
+
+bool cbor_put_uint(cbor_writer_t *writer, uint64_t value)
+{
+    return cbor_put_head(writer, CBOR_MAJOR_UINT, value);
+}
+
+bool cbor_put_int(cbor_writer_t *writer, int64_t value)
+{
+    // -1 - value without overflowing for INT64_MIN
+    return (value >= 0) ? cbor_put_head(writer, CBOR_MAJOR_UINT, (uint64_t)value)
+                        : cbor_put_head(writer, CBOR_MAJOR_NEGINT, ~(uint64_t)value);
+}
+
+bool cbor_put_bool(cbor_writer_t *writer, bool value)
+{
+    uint8_t byte = value ? CBOR_TRUE : CBOR_FALSE;
+    return cbor_put_raw(writer, &byte, 1);
+}
+
+bool cbor_put_null(cbor_writer_t *writer)
+{
+    uint8_t byte = CBOR_NULL;
+    return cbor_put_raw(writer, &byte, 1);
+}
+
+/// @brief Convert a single to a half if no bits are lost - halves have 5 exponent and 10 mantissa bits
+/// @note Values that would be subnormal halves are left as singles
+static bool cbor_float_to_half(float value, uint16_t *half_out)
+{
+    uint32_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+    uint16_t sign = (uint16_t)((bits >> 16) & 0x8000);
+    int32_t exponent = (int32_t)((bits >> 23) & 0xFF);
+    uint32_t mantissa = bits & 0x7FFFFF;
+
+    if ((mantissa & 0x1FFF) != 0)
+    {
+        return false;
+    }
+    if (exponent == 0xFF)
+    {
+        *half_out = sign | 0x7C00 | (uint16_t)(mantissa >> 13); // Infinity or NaN
+        return true;
+    }
+    if (exponent == 0 && mantissa == 0)
+    {
+        *half_out = sign;
+        return true;
+    }
+
+    exponent = exponent - 127 + 15;
+    if (exponent < 1 || exponent > 30)
+    {
+        return false;
+    }
+    *half_out = sign | (uint16_t)(exponent << 10) | (uint16_t)(mantissa >> 13);
+    return true;
+}
+
+bool cbor_put_float(cbor_writer_t *writer, float value)
+{
+    uint16_t half;
+    if (cbor_float_to_half(value, &half))
+    {
+        return cbor_put_be(writer, CBOR_HALF, half, 2);
+    }
+
+    uint32_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+    return cbor_put_be(writer, CBOR_SINGLE, bits, 4);
+}
+
+bool cbor_put_double(cbor_writer_t *writer, double value)
+{
+    if (isnan(value) || (double)(float)value == value)
+    {
+        return cbor_put_float(writer, (float)value);
+    }
+
+    uint64_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+    return cbor_put_be(writer, CBOR_DOUBLE, bits, 8);
+}
+
+bool cbor_put_text(cbor_writer_t *writer, const char *text)
+{
+    return cbor_put_text_len(writer, text, strlen(text));
+}
+
+bool cbor_put_text_len(cbor_writer_t *writer, const char *text, size_t len)
+{
+    return cbor_put_head(writer, CBOR_MAJOR_TEXT, len) && cbor_put_raw(writer, text, len);
+}
+
+bool cbor_put_bytes(cbor_writer_t *writer, const void *data, size_t len)
+{
+    return cbor_put_head(writer, CBOR_MAJOR_BYTES, len) && cbor_put_raw(writer, data, len);
+}
+
+bool cbor_open_map(cbor_writer_t *writer, size_t pairs)
+{
+    return cbor_put_head(writer, CBOR_MAJOR_MAP, pairs);
+}
+
+bool cbor_open_array(cbor_writer_t *writer, size_t count)
+{
+    return cbor_put_head(writer, CBOR_MAJOR_ARRAY, count);
+}
+
+// ------ Sensor records ------ //
+
+bool cbor_put_readings(cbor_writer_t *writer, uint64_t timestamp, const cbor_reading_t *readings, size_t count)
+{
+    cbor_open_map(writer, count + 1);
+    cbor_put_text_len(writer, "ts", 2);
+    cbor_put_uint(writer, timestamp);
+    for (size_t i = 0; i < count; i++)
+    {
+        cbor_put_text(writer, readings[i].name);
+        cbor_put_float(writer, readings[i].value);
+    }
+    return cbor_writer_ok(writer);
+}
+
+// ------ Publishing ------ //
+
+/// @return Index of the claimed buffer, -1 if all are in use
+static int cbor_pool_claim(void)
+{
+    const uint32_t all = (1u << SIM7080G_CBOR_POOL_BUFFERS) - 1;
+    uint32_t busy = atomic_load(&cbor_pool_busy);
+    while ((busy & all) != all)
+    {
+        int slot = __builtin_ctz(~busy);
+        if (atomic_compare_exchange_weak(&cbor_pool_busy, &busy, busy | (1u << slot)))
+        {
+            return slot;
+        }
+    }
+    return -1;
+}
+
+static void cbor_pool_release(int slot)
+{
+    atomic_fetch_and(&cbor_pool_busy, ~(1u << slot));
+}
+
+esp_err_t sim7080g_cbor_publish(const sim7080g_handle_t *sim7080g_handle,
+                                const char *topic,
+                                uint8_t qos,
+                                bool retain,
+                                sim7080g_cbor_encode_t encode,
+                                void *arg,
+                                uint8_t *buf,
+                                size_t buf_size)
+{
+    if (!sim7080g_handle || !topic || !encode)
+    {
+        ESP_LOGE(TAG, "Invalid parameters");
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    int slot = -1;
+    if (buf == NULL)
+    {
+        slot = cbor_pool_claim();
+        if (slot < 0)
+        {
+            ESP_LOGW(TAG, "All %d pooled buffers in use", SIM7080G_CBOR_POOL_BUFFERS);
+            return ESP_ERR_NO_MEM;
+        }
+        buf = cbor_pool[slot];
+        buf_size = sizeof(cbor_pool[slot]);
+    }
+
+    cbor_writer_t writer;
+    cbor_writer_init(&writer, buf, buf_size);
+    bool encoded = encode(&writer, arg);
+
+    esp_err_t err;
+    if (!cbor_writer_ok(&writer))
+    {
+        ESP_LOGE(TAG, "Message for %s does not fit in %zu bytes", topic, buf_size);
+        err = ESP_ERR_INVALID_SIZE;
+    }
+    else if (!encoded)
+    {
+        err = ESP_FAIL;
+    }
+    else
+    {
+        sim7080g_iovec_t iov = {.base = buf, .len = writer.len};
+        err = sim7080g_mqtt_publish_iov(sim7080g_handle, topic, &iov, 1, qos, retain);
+    }
+
+    if (slot >= 0)
+    {
+        cbor_pool_release(slot);
+    }
+    return err;
+}
+
+typedef struct
+{
+    uint64_t timestamp;
+    const cbor_reading_t *readings;
+    size_t count;
+} cbor_readings_arg_t;
+
+static bool cbor_encode_readings(cbor_writer_t *writer, void *arg)
+{
+    const cbor_readings_arg_t *record = arg;
+    return cbor_put_readings(writer, record->timestamp, record->readings, record->count);
+}
+
+esp_err_t sim7080g_cbor_publish_readings(const sim7080g_handle_t *sim7080g_handle,
+                                         const char *topic,
+                                         uint8_t qos,
+                                         uint64_t timestamp,
+                                         const cbor_reading_t *readings,
+                                         size_t count)
+{
+    if (!readings && count > 0)
+    {
+        ESP_LOGE(TAG, "Invalid parameters");
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    cbor_readings_arg_t record = {.timestamp = timestamp, .readings = readings, .count = count};
+    return sim7080g_cbor_publish(sim7080g_handle, topic, qos, false, cbor_encode_readings, &record, NULL, 0);
+}
+
+// ------ INTERNAL TESTING ------ //
+
+static const cbor_reading_t CBOR_TEST_READINGS[] = {
+    {"t", 21.5f},   // Exact as a half
+    {"h", 40.25f},  // Exact as a half
+    {"p", 1013.3f}, // Needs a single
+};
+#define CBOR_TEST_TIMESTAMP 1700000000ull
+
+// {"ts": 1700000000, "t": 21.5, "h": 40.25, "p": 1013.3}
+static const uint8_t CBOR_TEST_EXPECTED[] = {
+    0xA4,
+    0x62, 't', 's', 0x1A, 0x65, 0x53, 0xF1, 0x00,
+    0x61, 't', 0xF9, 0x4D, 0x60,
+    0x61, 'h', 0xF9, 0x51, 0x08,
+    0x61, 'p', 0xFA, 0x44, 0x7D, 0x53, 0x33,
+};
+
+bool sim7080g_test_cbor_encode(int iterations)
+{
+    if (iterations <= 0)
+    {
+        ESP_LOGE(TAG, "CBOR encode test: Invalid parameters");
+        return false;
+    }
+
+    uint8_t cbor[64];
+    char json[128];
+    cbor_writer_t writer;
+
+    // Known encodings first - the record, the integer edges and running out of room
+    cbor_writer_init(&writer, cbor, sizeof(cbor));
+    bool ok = cbor_put_readings(&writer, CBOR_TEST_TIMESTAMP, CBOR_TEST_READINGS, 3) &&
+              writer.len == sizeof(CBOR_TEST_EXPECTED) && memcmp(cbor, CBOR_TEST_EXPECTED, writer.len) == 0;
+
+    static const uint8_t edges[] = {0x17, 0x18, 0x18, 0x39, 0x01, 0xF3, 0x3B, 0x7F, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF};
+    cbor_writer_init(&writer, cbor, sizeof(cbor));
+    cbor_put_uint(&writer, 23);
+    cbor_put_uint(&writer, 24);
+    cbor_put_int(&writer, -500);
+    cbor_put_int(&writer, INT64_MIN);
+    ok = ok && cbor_writer_ok(&writer) && writer.len == sizeof(edges) && memcmp(cbor, edges, writer.len) == 0;
+
+    cbor_writer_init(&writer, cbor, sizeof(CBOR_TEST_EXPECTED) - 1);
+    ok = ok && !cbor_put_readings(&writer, CBOR_TEST_TIMESTAMP, CBOR_TEST_READINGS, 3) &&
+         !cbor_put_null(&writer) && writer.len <= sizeof(CBOR_TEST_EXPECTED) - 1;
+    if (!ok)
+    {
+        ESP_LOGE(TAG, "CBOR encode test failed! Encoding did not match the expected bytes");
+        return false;
+    }
+
+    uint64_t cbor_cycles = 0;
+    uint64_t json_cycles = 0;
+    size_t cbor_len = 0;
+    int json_len = 0;
+    for (int i = 0; i < iterations; i++)
+    {
+        esp_cpu_cycle_count_t start = esp_cpu_get_cycle_count();
+        cbor_writer_init(&writer, cbor, sizeof(cbor));
+        cbor_put_readings(&writer, CBOR_TEST_TIMESTAMP + i, CBOR_TEST_READINGS, 3);
+        cbor_cycles += (uint32_t)(esp_cpu_get_cycle_count() - start);
+        cbor_len = writer.len;
+
+        start = esp_cpu_get_cycle_count();
+        json_len = snprintf(json, sizeof(json), "{\"ts\":%llu,\"t\":%.2f,\"h\":%.2f,\"p\":%.2f}",
+                            (unsigned long long)(CBOR_TEST_TIMESTAMP + i),
+                            (double)CBOR_TEST_READINGS[0].value,
+                            (double)CBOR_TEST_READINGS[1].value,
+                            (double)CBOR_TEST_READINGS[2].value);
+        json_cycles += (uint32_t)(esp_cpu_get_cycle_count() - start);
+    }
+
+    ESP_LOGI(TAG, "CBOR encode test: timestamp + 3 readings, %d iterations", iterations);
+    ESP_LOGI(TAG, "  snprintf JSON: %d bytes, %llu cycles/record", json_len, (unsigned long long)(json_cycles / iterations));
+    ESP_LOGI(TAG, "  CBOR:          %zu bytes, %llu cycles/record", cbor_len, (unsigned long long)(cbor_cycles / iterations));
+    ESP_LOGI(TAG, "CBOR encode test passed!");
+    return true;
+}
@@ -1,21 +1,388 @@
 #include <stdio.h>
+#include <stdlib.h>
 #include <esp_err.h>
 #include <esp_log.h>
 #include <string.h>
+#include <strings.h>
 #include <driver/uart.h>
+#include <esp_timer.h>
+#include <esp_random.h>
+#include <esp_cpu.h>
+#include <esp_rom_crc.h>
+#include <esp_attr.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include <freertos/queue.h>
+#include <freertos/semphr.h>
+#include <freertos/event_groups.h>
 
 #include "sim7080g_driver_esp_idf.h"
 #include "sim7080g_at_commands.h"
+#include "sim7080g_at_parser.h"
+#include "sim7080g_topic_trie.h"
 
 #define AT_CMD_MAX_LEN 256
-#define AT_CMD_MAX_RETRIES 4
 #define AT_RESPONSE_MAX_LEN 256
+#define AT_PARSER_TEST_STACK_SIZE 4096
+
+#define SIM7080G_UART_EVENT_QUEUE_LEN 20
+#define SIM7080G_RX_LINE_MAX_LEN (2 * SIM7080G_MQTT_MAX_PAYLOAD_LEN + 256) // Fits a +SMSUB line with a full payload in hex
+#define SIM7080G_RX_CHUNK_LEN 128
+#define SIM7080G_URC_BUCKETS 32
+#define SIM7080G_BAUD_PROBE_TIMEOUT_MS 300
+#define SIM7080G_UART_RTS_THRESHOLD 100
+#define SIM7080G_RX_LINE_PATTERN '\n'
+#define SIM7080G_RX_PROMPT_PATTERN '>' // The data prompt has no line ending to detect
+#define SIM7080G_MQTT_SUBSCRIBE_TIMEOUT_MS 10000 // AT+SMSUB / AT+SMUNSUB wait for the broker's SUBACK / UNSUBACK
+#if configTASK_NOTIFICATION_ARRAY_ENTRIES > 1
+#define SIM7080G_ARBITER_NOTIFY_INDEX 1 // Leave the default notification to the application
+#else
+#define SIM7080G_ARBITER_NOTIFY_INDEX 0
+#endif
+#define SIM7080G_ARBITER_FULL -1     // sim7080g_arbiter_enqueue - no pending list slot came free in time
+#define SIM7080G_ARBITER_STOPPING -2 // sim7080g_arbiter_enqueue - the driver is being deinitialized
+#define SIM7080G_MQTT_PUBLISH_WAIT_MARGIN_MS 5000 // A blocking ASYNCMODE publish gives up this long after its ack was due
+#define UART_THROUGHPUT_TEST_LINES 64
+#define UART_THROUGHPUT_TEST_PAYLOAD_LEN 48
+#define PUBLISH_RATE_TEST_TOPIC "sim7080g/test/publish_rate"
+#define PUBLISH_RATE_TEST_MESSAGE "{\"seq\":0,\"temp\":21.5,\"rssi\":-71,\"batt\":3.92}"
+
+// Status event bits kept up to date by the built-in URC handlers
+#define SIM7080G_EVT_SIM_READY (1 << 0)
+#define SIM7080G_EVT_FUNCTIONAL (1 << 1)
+#define SIM7080G_EVT_REGISTERED (1 << 2)
+#define SIM7080G_EVT_PDP_ACTIVE (1 << 3)
+#define SIM7080G_EVT_MQTT_CONNECTED (1 << 4)
+#define SIM7080G_EVT_SMS_READY (1 << 5) // "SMS Ready" - the last line of the start up sequence
+
+#define SIM7080G_CFUN_READY_TIMEOUT_MS 20000  // Longest a CFUN cycle waits for the device to be ready again
+#define SIM7080G_CFUN_PROBE_INTERVAL_MS 500   // AT+CPIN? probe period while no readiness URC has been seen
+#define SIM7080G_SMS_READY_GRACE_MS 3000      // Once the SIM is ready, how long to wait for "SMS Ready" (not every firmware sends it)
+
+#define SIM7080G_WARM_STATE_MAGIC 0x57415231 // "WAR1"
+#if CONFIG_IDF_TARGET_LINUX
+#define SIM7080G_WARM_STATE_ATTR // No RTC memory - every start is a cold start
+#else
+#define SIM7080G_WARM_STATE_ATTR RTC_NOINIT_ATTR
+#endif
 
 static const char *TAG = "SIM7080G Driver";
 
+/// @brief What the last cold init left the device with - kept in RTC memory, which survives a restart but not power loss
+typedef struct
+{
+    uint32_t magic;
+    uint32_t fingerprint; // CRC-32 of the config the device was brought up with
+    uint32_t baud_rate;   // Device UART rate
+    uint32_t crc;         // Of the fields above - RTC_NOINIT memory holds garbage after power on
+} sim7080g_warm_state_t;
+
+static SIM7080G_WARM_STATE_ATTR sim7080g_warm_state_t sim7080g_warm_state;
+
+// Device (AT+IPR) rates the ESP32 UART can also run at - highest first
+static const uint32_t sim7080g_supported_baud_rates[] = {3000000, 2000000, 921600, 230400, 115200};
+#define SIM7080G_NUM_SUPPORTED_BAUD_RATES (sizeof(sim7080g_supported_baud_rates) / sizeof(sim7080g_supported_baud_rates[0]))
+
+/// @brief Response buffer of the command currently waiting on the RX task
+/// @note Complete lines are appended with their CRLF restored so the response parsing code sees the raw device output
+typedef struct
+{
+    char *buf;
+    size_t size;
+    size_t len;
+    const char *solicited[SIM7080G_AT_BATCH_MAX_CMDS]; // Info line prefixes of the command(s) in flight (e.g. "+CSQ") - these lines are never treated as URCs
+    size_t num_solicited;
+    const char *expect; // Line prefix that must also be received before an OK completes the response (NULL for none)
+    bool expect_only;   // Complete on the expected line alone - without waiting for a final result code
+    bool wait_for_prompt;
+    bool expect_seen;
+    bool ok_seen;
+    bool error_seen;
+    bool complete;
+} sim7080g_rx_waiter_t;
+
+/// @brief URC registry entry - entries sharing a bucket are chained through 'next'
+typedef struct
+{
+    char prefix[SIM7080G_URC_PREFIX_MAX_LEN];
+    uint8_t prefix_len;
+    int8_t next; // Index of the next entry in the same bucket, -1 ends the chain
+    sim7080g_urc_handler_t handler;
+    void *user_ctx;
+} sim7080g_urc_entry_t;
+
+typedef struct
+{
+    const char *topic;
+    const sim7080g_iovec_t *iov; // Payload segments - written to the UART one after another
+    size_t iov_count;
+    size_t message_len; // Sum of the segment lengths
+    uint8_t qos;
+    bool retain;
+} sim7080g_mqtt_publish_args_t;
+
+/// @brief Collects the acks of publishes a blocking caller waits for - lives on the caller's stack
+typedef struct
+{
+    sim7080g_ctx_t *ctx;
+    SemaphoreHandle_t acked; // Given once per completed publish
+    esp_err_t result; // First failure reported - guarded by inflight_lock
+} sim7080g_publish_waiter_t;
+
+typedef struct
+{
+    const char *topic;
+    const uint8_t *payload;
+    size_t payload_len;
+    uint8_t qos;
+    uint16_t msg_id; // Written in every chunk header
+} sim7080g_mqtt_publish_large_args_t;
+
+/// @brief A pipelined publish awaiting the broker's ack
+typedef struct
+{
+    uint16_t msg_id;
+    sim7080g_publish_cb_t callback;
+    void *user_ctx;
+    int64_t deadline_us; // esp_timer time by which the ack must have arrived
+    esp_err_t result;    // Outcome, once taken off the window
+} sim7080g_inflight_t;
+
+typedef struct
+{
+    sim7080g_mqtt_publish_args_t publish;
+    sim7080g_inflight_t entry;
+    bool track;            // Add to the in-flight window - QoS 1/2 in ASYNCMODE
+    esp_err_t send_result; // What sending the publish returned - set even when the outcome goes to the callback
+} sim7080g_mqtt_publish_pipelined_args_t;
+
+/// @brief A request waiting for (or running on) the command arbiter task - lives on the caller's stack
+typedef struct
+{
+    const sim7080g_handle_t *handle;
+    sim7080g_cmd_fn_t fn;
+    void *arg;
+    sim7080g_cmd_priority_t priority;
+    uint32_t seq; // Submission order - keeps requests of the same priority FIFO
+    bool has_deadline;
+    TickType_t deadline; // Tick count by which the request must have started
+    TaskHandle_t caller;             // Notified once the request is done (blocking requests)
+    struct sim7080g_async_req *async; // Completed through its opts instead (async requests)
+    esp_err_t result;
+    bool done;
+} sim7080g_arbiter_req_t;
+
+/// @brief An async request - owned by the driver from submission until it completes
+typedef struct sim7080g_async_req
+{
+    sim7080g_arbiter_req_t req;
+    sim7080g_request_id_t id; // 0 while the slot is free
+    sim7080g_async_opts_t opts;
+    void *data; // Heap copy of the request arguments - freed on completion
+} sim7080g_async_req_t;
+
+typedef struct
+{
+    sim7080g_mqtt_message_handler_t handler;
+    void *user_ctx;
+} sim7080g_subscription_t;
+
+/// @brief Status reads the cache holds - one response each
+typedef enum
+{
+    SIM7080G_STATUS_CPIN = 0,
+    SIM7080G_STATUS_CSQ,
+    SIM7080G_STATUS_CEREG,
+    SIM7080G_STATUS_CGATT,
+    SIM7080G_STATUS_COPS,
+    SIM7080G_STATUS_CNACT,
+    SIM7080G_STATUS_SMSTATE,
+    SIM7080G_STATUS_NUM_FIELDS
+} sim7080g_status_field_t;
+
+#define SIM7080G_STATUS_BIT(field) (1u << (field))
+#define SIM7080G_STATUS_ALL (SIM7080G_STATUS_BIT(SIM7080G_STATUS_NUM_FIELDS) - 1)
+#define SIM7080G_STATUS_REGISTRATION (SIM7080G_STATUS_BIT(SIM7080G_STATUS_CEREG) | SIM7080G_STATUS_BIT(SIM7080G_STATUS_CGATT) | \
+                                      SIM7080G_STATUS_BIT(SIM7080G_STATUS_COPS))
+#define SIM7080G_STATUS_BEARER (SIM7080G_STATUS_BIT(SIM7080G_STATUS_CNACT) | SIM7080G_STATUS_BIT(SIM7080G_STATUS_SMSTATE))
+
+typedef struct
+{
+    char response[AT_RESPONSE_MAX_LEN];
+    int64_t read_at_us;
+    uint32_t generation; // Bumped on every invalidation - a read in flight across one does not store its (stale) response
+    bool valid;
+} sim7080g_status_entry_t;
+
+struct sim7080g_ctx
+{
+    uart_port_t port;
+    uint32_t baud_rate; // Rate both ends are currently running at
+    QueueHandle_t uart_event_queue;
+    TaskHandle_t rx_task;
+    SemaphoreHandle_t rx_lock; // Guards the waiter pointer and the waiter it points to
+    SemaphoreHandle_t rx_done; // Given by the RX task when the waiter completes
+    sim7080g_rx_waiter_t *waiter;
+
+    // CRLF line framer - only touched by the RX task
+    char line[SIM7080G_RX_LINE_MAX_LEN];
+    size_t line_len;
+    bool line_truncated;
+    uint8_t sub_payload[SIM7080G_MQTT_MAX_PAYLOAD_LEN]; // A SUBHEX=1 +SMSUB payload, decoded - only touched by the RX task
+
+    uint32_t rx_overflow_count;
+
+    // URC registry - lines are bucketed on their first significant character so a lookup only compares a short chain
+    SemaphoreHandle_t urc_lock;
+    sim7080g_urc_entry_t urc_entries[SIM7080G_URC_MAX_HANDLERS];
+    int8_t urc_buckets[SIM7080G_URC_BUCKETS];
+
+    EventGroupHandle_t status_events; // SIM7080G_EVT_* bits
+
+    // Last +CEREG status - guarded by urc_lock (URC handlers run holding it)
+    sim7080g_registration_t registration;
+    uint32_t registration_reports; // +CEREG URCs received
+
+    // Command arbiter - the only task that exchanges commands with the device once init is done
+    TaskHandle_t arbiter_task;
+    SemaphoreHandle_t arbiter_lock;  // Guards the pending list and the done flag of every request
+    SemaphoreHandle_t arbiter_slots; // Counts free pending list slots
+    sim7080g_arbiter_req_t *pending[SIM7080G_ARBITER_QUEUE_LEN];
+    uint32_t arbiter_seq;
+    sim7080g_async_req_t async_reqs[SIM7080G_ASYNC_MAX_REQUESTS]; // Guarded by arbiter_lock
+    sim7080g_request_id_t async_next_id;
+    bool arbiter_stopping;             // Set by deinit - no request is accepted once set (guarded by arbiter_lock)
+    uint32_t arbiter_callers;          // Tasks inside sim7080g_arbiter_call - guarded by arbiter_lock
+    SemaphoreHandle_t arbiter_stopped; // Given by the arbiter task as it exits
+
+    uint16_t chunk_msg_id; // Message id of the last large publish - guarded by inflight_lock
+
+    // Pipelined publishes awaiting the broker's ack, oldest first (a ring) - guarded by inflight_lock
+    SemaphoreHandle_t inflight_lock;
+    SemaphoreHandle_t inflight_slots; // Counts free window entries
+    sim7080g_inflight_t inflight[SIM7080G_MQTT_INFLIGHT_WINDOW];
+    uint8_t inflight_head;
+    uint8_t inflight_count;
+    // Publishes taken off the window whose callbacks have not run yet (a ring) - guarded by inflight_lock
+    sim7080g_inflight_t inflight_done[SIM7080G_MQTT_INFLIGHT_WINDOW];
+    uint8_t inflight_done_head;
+    uint8_t inflight_done_count;
+    bool inflight_flushing; // A task is running callbacks - see sim7080g_inflight_flush
+    uint16_t publish_msg_id;
+    bool async_publish; // ASYNCMODE=1 has been set on the device
+    bool sub_hex;       // SUBHEX=1 has been set on the device
+    bool warm_started;  // Init found the bearer and MQTT session up and skipped bring-up
+
+    // Subscribed topic filters -> sim7080g_subscription_t - guarded by sub_lock, which is held while handlers run
+    SemaphoreHandle_t sub_lock;
+    topic_trie_t subscriptions;
+
+    // Status reads answered without the device until their TTL runs out or a change is reported - guarded by status_cache_lock
+    SemaphoreHandle_t status_cache_lock;
+    sim7080g_status_entry_t status_cache[SIM7080G_STATUS_NUM_FIELDS];
+    uint32_t status_cache_ttl_ms;
+    sim7080g_status_cache_stats_t status_cache_stats;
+};
+
+// ------ Typed response decoding ------ //
+// Each getter decodes into one of these structs through a decoder compiled (once) from its command's response_format.
+// Adding a command is one layout and one SIM7080G_DECODER_TABLE entry.
+
+typedef struct
+{
+    char code[16]; // READY, SIM PIN, ...
+} sim7080g_cpin_reply_t;
+
+typedef struct
+{
+    int rssi;
+    int ber;
+} sim7080g_csq_reply_t;
+
+typedef struct
+{
+    int value;
+} sim7080g_int_reply_t; // Single int replies - +CGATT:, +SMSTATE:
+
+typedef struct
+{
+    int mode;
+    int format;
+    char name[64];
+    int act;
+} sim7080g_cops_reply_t;
+
+typedef struct
+{
+    int valid;
+    char apn[101]; // 3GPP TS 23.003 max APN length + null
+} sim7080g_cgnapn_reply_t;
+
+typedef struct
+{
+    int pdpidx;
+    int status;
+    char address[64];
+} sim7080g_cnact_reply_t;
+
+typedef struct
+{
+    int n;
+    int stat;
+} sim7080g_cereg_reply_t;
+
+typedef enum
+{
+    SIM7080G_DECODER_CPIN,
+    SIM7080G_DECODER_CSQ,
+    SIM7080G_DECODER_CGATT,
+    SIM7080G_DECODER_COPS,
+    SIM7080G_DECODER_CGNAPN,
+    SIM7080G_DECODER_CNACT,
+    SIM7080G_DECODER_SMSTATE,
+    SIM7080G_DECODER_CEREG,
+    SIM7080G_DECODER_COUNT,
+} sim7080g_decoder_id_t;
+
+typedef struct
+{
+    const at_cmd_info_t *info; // Response_format is compiled from here
+    const at_field_t *layout;
+    uint8_t layout_len;
+    uint16_t reply_size; // Size of the reply struct the layout points into
+} sim7080g_decoder_entry_t;
+
+static const at_field_t SIM7080G_CPIN_LAYOUT[] = {AT_FIELD(sim7080g_cpin_reply_t, code)};
+static const at_field_t SIM7080G_CSQ_LAYOUT[] = {AT_FIELD(sim7080g_csq_reply_t, rssi), AT_FIELD(sim7080g_csq_reply_t, ber)};
+static const at_field_t SIM7080G_INT_LAYOUT[] = {AT_FIELD(sim7080g_int_reply_t, value)};
+static const at_field_t SIM7080G_COPS_LAYOUT[] = {AT_FIELD(sim7080g_cops_reply_t, mode), AT_FIELD(sim7080g_cops_reply_t, format),
+                                                  AT_FIELD(sim7080g_cops_reply_t, name), AT_FIELD(sim7080g_cops_reply_t, act)};
+static const at_field_t SIM7080G_CGNAPN_LAYOUT[] = {AT_FIELD(sim7080g_cgnapn_reply_t, valid), AT_FIELD(sim7080g_cgnapn_reply_t, apn)};
+static const at_field_t SIM7080G_CNACT_LAYOUT[] = {AT_FIELD(sim7080g_cnact_reply_t, pdpidx), AT_FIELD(sim7080g_cnact_reply_t, status),
+                                                   AT_FIELD(sim7080g_cnact_reply_t, address)};
+static const at_field_t SIM7080G_CEREG_LAYOUT[] = {AT_FIELD(sim7080g_cereg_reply_t, n), AT_FIELD(sim7080g_cereg_reply_t, stat)};
+
+#define SIM7080G_DECODER_ENTRY(cmd_info, layout, reply_type) \
+    {&(cmd_info), layout, sizeof(layout) / sizeof(layout[0]), sizeof(reply_type)}
+
+static const sim7080g_decoder_entry_t SIM7080G_DECODER_TABLE[SIM7080G_DECODER_COUNT] = {
+    [SIM7080G_DECODER_CPIN] = SIM7080G_DECODER_ENTRY(AT_CPIN.read, SIM7080G_CPIN_LAYOUT, sim7080g_cpin_reply_t),
+    [SIM7080G_DECODER_CSQ] = SIM7080G_DECODER_ENTRY(AT_CSQ.execute, SIM7080G_CSQ_LAYOUT, sim7080g_csq_reply_t),
+    [SIM7080G_DECODER_CGATT] = SIM7080G_DECODER_ENTRY(AT_CGATT.read, SIM7080G_INT_LAYOUT, sim7080g_int_reply_t),
+    [SIM7080G_DECODER_COPS] = SIM7080G_DECODER_ENTRY(AT_COPS.read, SIM7080G_COPS_LAYOUT, sim7080g_cops_reply_t),
+    [SIM7080G_DECODER_CGNAPN] = SIM7080G_DECODER_ENTRY(AT_CGNAPN.execute, SIM7080G_CGNAPN_LAYOUT, sim7080g_cgnapn_reply_t),
+    [SIM7080G_DECODER_CNACT] = SIM7080G_DECODER_ENTRY(AT_CNACT.read, SIM7080G_CNACT_LAYOUT, sim7080g_cnact_reply_t),
+    [SIM7080G_DECODER_SMSTATE] = SIM7080G_DECODER_ENTRY(AT_SMSTATE.read, SIM7080G_INT_LAYOUT, sim7080g_int_reply_t),
+    [SIM7080G_DECODER_CEREG] = SIM7080G_DECODER_ENTRY(AT_CEREG.read, SIM7080G_CEREG_LAYOUT, sim7080g_cereg_reply_t),
+};
+
+// Compiled by the first sim7080g_init() - read only after that
+static at_decoder_t sim7080g_decoders[SIM7080G_DECODER_COUNT];
+static bool sim7080g_decoders_compiled = false;
+
 // Static Fxn Declarations:
 static esp_err_t sim7080g_echo_off(const sim7080g_handle_t *sim7080g_handle);
-static esp_err_t sim7080g_uart_init(const sim7080g_uart_config_t sim7080g_uart_config);
+static esp_err_t sim7080g_uart_init(sim7080g_handle_t *sim7080g_handle);
 static void sim7080g_log_config_params(const sim7080g_handle_t *sim7080g_handle);
 static esp_err_t send_at_cmd(const sim7080g_handle_t *sim7080g_handle,
                              const at_cmd_t *cmd,
@@ -24,8 +391,111 @@ static esp_err_t send_at_cmd(const sim7080g_handle_t *sim7080g_handle,
                              char *response,
                              size_t response_size,
                              uint32_t timeout_ms);
+static esp_err_t send_at_cmd_expect(const sim7080g_handle_t *sim7080g_handle,
+                                    const at_cmd_t *cmd,
+                                    at_cmd_type_t type,
+                                    const char *args,
+                                    const char *expect,
+                                    char *response,
+                                    size_t response_size,
+                                    uint32_t timeout_ms);
+static esp_err_t send_at_line(const sim7080g_handle_t *sim7080g_handle,
+                              const char *at_cmd,
+                              const char *description,
+                              const char *const *solicited,
+                              size_t num_solicited,
+                              const char *expect,
+                              char *response,
+                              size_t response_size,
+                              uint32_t timeout_ms,
+                              const at_retry_policy_t *retry,
+                              bool idempotent);
+static void sim7080g_rx_begin(const sim7080g_handle_t *sim7080g_handle, sim7080g_rx_waiter_t *waiter);
+static esp_err_t sim7080g_rx_set_pattern(const sim7080g_ctx_t *ctx, char pattern_chr);
+static int sim7080g_rx_wait(const sim7080g_handle_t *sim7080g_handle, sim7080g_rx_waiter_t *waiter, uint32_t timeout_ms);
+static void sim7080g_rx_task(void *arg);
+static void sim7080g_arbiter_task(void *arg);
+static void sim7080g_async_complete(sim7080g_ctx_t *ctx, sim7080g_async_req_t *async, esp_err_t result);
+static esp_err_t sim7080g_arbiter_run(const sim7080g_handle_t *sim7080g_handle,
+                                      sim7080g_cmd_fn_t fn,
+                                      void *arg,
+                                      sim7080g_cmd_priority_t priority,
+                                      uint32_t deadline_ms);
+static esp_err_t sim7080g_exchange(const sim7080g_handle_t *sim7080g_handle,
+                                   const char *data,
+                                   size_t len,
+                                   sim7080g_rx_waiter_t *waiter,
+                                   uint32_t timeout_ms,
+                                   int *bytes_read_out);
+static bool at_line_is_final_result(const char *line);
+static bool sim7080g_urc_dispatch(sim7080g_ctx_t *ctx, const char *line, size_t len);
+static void sim7080g_inflight_ack(sim7080g_ctx_t *ctx, esp_err_t result);
+static void sim7080g_inflight_fail_all(sim7080g_ctx_t *ctx, esp_err_t result);
+static void sim7080g_functionality_lost(sim7080g_ctx_t *ctx);
+static bool sim7080g_parse_cereg(at_parser_t *fields, sim7080g_registration_t *out);
+static void sim7080g_registration_update(sim7080g_ctx_t *ctx, const sim7080g_registration_t *registration);
+static esp_err_t sim7080g_urc_register_builtin_handlers(const sim7080g_handle_t *sim7080g_handle);
+static esp_err_t sim7080g_detect_baud_rate(const sim7080g_handle_t *sim7080g_handle);
+static esp_err_t sim7080g_enable_hw_flow_control(const sim7080g_handle_t *sim7080g_handle);
+static esp_err_t sim7080g_negotiate_baud_rate(const sim7080g_handle_t *sim7080g_handle);
+static esp_err_t sim7080g_warm_start(const sim7080g_handle_t *sim7080g_handle);
+static void sim7080g_warm_state_save(const sim7080g_handle_t *sim7080g_handle);
+static bool at_line_is_error(const char *line);
+static void sim7080g_status_cache_drop(sim7080g_ctx_t *ctx, uint32_t fields);
+static void sim7080g_status_cache_command(sim7080g_ctx_t *ctx, const at_cmd_t *cmd, at_cmd_type_t type);
+static esp_err_t send_at_cmd_cached(const sim7080g_handle_t *sim7080g_handle,
+                                    const at_cmd_t *cmd,
+                                    at_cmd_type_t type,
+                                    char *response,
+                                    size_t response_size,
+                                    uint32_t timeout_ms);
+static esp_err_t sim7080g_send_at_batch_cached(const sim7080g_handle_t *sim7080g_handle,
+                                               sim7080g_at_batch_entry_t *entries,
+                                               size_t num_entries,
+                                               uint32_t timeout_ms);
+static esp_err_t at_cmd_format(const at_cmd_t *cmd,
+                               at_cmd_type_t type,
+                               const char *args,
+                               char *out,
+                               size_t out_size);
+static const char *at_cmd_solicited_prefix(const at_cmd_t *cmd);
+static bool at_cmd_is_idempotent(const at_cmd_t *cmd, at_cmd_type_t type);
+static uint32_t at_retry_delay_ms(const at_retry_policy_t *retry, int attempt);
+static bool at_response_error_is_retryable(const char *response);
+static esp_err_t sim7080g_parse_sim_status(const char *response);
+static esp_err_t sim7080g_parse_signal_quality(const char *response, int8_t *rssi_out, uint8_t *ber_out);
+static esp_err_t sim7080g_parse_gprs_attach_status(const char *response, bool *attached_out);
+static esp_err_t sim7080g_parse_operator_info(const char *response,
+                                              int *operator_code,
+                                              int *operator_format,
+                                              char *operator_name,
+                                              int operator_name_len);
 static esp_err_t sim7080g_mqtt_check_parameters_match(const sim7080g_handle_t *sim7080g_handle,
                                                       bool *params_match_out);
+static esp_err_t sim7080g_mqtt_publish_fn(const sim7080g_handle_t *sim7080g_handle, void *arg);
+static esp_err_t sim7080g_mqtt_publish_large_fn(const sim7080g_handle_t *sim7080g_handle, void *arg);
+static esp_err_t sim7080g_mqtt_publish_async_fn(const sim7080g_handle_t *sim7080g_handle, void *arg);
+static esp_err_t sim7080g_mqtt_publish_send(const sim7080g_handle_t *sim7080g_handle,
+                                            const sim7080g_mqtt_publish_args_t *args,
+                                            bool *maybe_sent_out);
+static uint16_t sim7080g_chunk_next_msg_id(sim7080g_ctx_t *ctx);
+static uint16_t sim7080g_chunk_count(size_t payload_len);
+static void sim7080g_chunk_build(const sim7080g_mqtt_publish_large_args_t *args,
+                                 uint16_t index,
+                                 uint16_t total,
+                                 uint8_t header[SIM7080G_MQTT_CHUNK_HEADER_LEN],
+                                 sim7080g_iovec_t iov[2]);
+static void sim7080g_inflight_flush(sim7080g_ctx_t *ctx);
+static esp_err_t sim7080g_publish_waiter_init(sim7080g_ctx_t *ctx, sim7080g_publish_waiter_t *waiter);
+static void sim7080g_publish_waiter_cb(uint16_t msg_id, esp_err_t result, void *user_ctx);
+static esp_err_t sim7080g_publish_waiter_wait(sim7080g_publish_waiter_t *waiter, uint32_t count);
+static bool sim7080g_parse_mqtt_parameters(const char *response, size_t len, mqtt_parameters_t *params_out);
+static esp_err_t sim7080g_compile_decoders(void);
+static int sim7080g_decode(sim7080g_decoder_id_t id, const char *response, void *reply_out);
+static esp_err_t sim7080g_mqtt_publish_check_args(const sim7080g_handle_t *sim7080g_handle,
+                                                  const char *topic,
+                                                  size_t message_len,
+                                                  uint8_t qos);
 
 esp_err_t sim7080g_config(sim7080g_handle_t *sim7080g_handle,
                           const sim7080g_uart_config_t sim7080g_uart_config,
@@ -36,6 +506,10 @@ esp_err_t sim7080g_config(sim7080g_handle_t *sim7080g_handle,
 
     sim7080g_handle->mqtt_config = sim7080g_mqtt_config;
 
+    sim7080g_handle->uart_initialized = false;
+    sim7080g_handle->mqtt_initialized = false;
+    sim7080g_handle->ctx = NULL;
+
     sim7080g_log_config_params(sim7080g_handle);
 
     return ESP_OK;
@@ -44,7 +518,27 @@ esp_err_t sim7080g_config(sim7080g_handle_t *sim7080g_handle,
 // ---------------------  EXTERNAL EXPOSED API FXNs  -------------------------//
 esp_err_t sim7080g_init(sim7080g_handle_t *sim7080g_handle)
 {
-    esp_err_t err = sim7080g_uart_init(sim7080g_handle->uart_config);
+    if (!sim7080g_handle)
+    {
+        ESP_LOGE(TAG, "Invalid parameters");
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    if (sim7080g_handle->ctx != NULL)
+    {
+        ESP_LOGE(TAG, "SIM7080G driver already initialized");
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    int64_t init_start = esp_timer_get_time();
+    esp_err_t err = sim7080g_compile_decoders();
+    if (err != ESP_OK)
+    {
+        ESP_LOGE(TAG, "Failed to compile response decoders: %s", esp_err_to_name(err));
+        return err;
+    }
+
+    err = sim7080g_uart_init(sim7080g_handle);
     if (err != ESP_OK)
     {
         ESP_LOGE(TAG, "UART not initiailzed : %s", esp_err_to_name(err));
@@ -57,12 +551,53 @@ esp_err_t sim7080g_init(sim7080g_handle_t *sim7080g_handle)
         sim7080g_handle->uart_initialized = true;
     }
 
+    err = sim7080g_urc_register_builtin_handlers(sim7080g_handle);
+    if (err != ESP_OK)
+    {
+        ESP_LOGE(TAG, "Failed to register built-in URC handlers: %s", esp_err_to_name(err));
+        return err;
+    }
+
+    if (sim7080g_handle->mqtt_config.warm_start && sim7080g_warm_start(sim7080g_handle) == ESP_OK)
+    {
+        ESP_LOGI(TAG, "SIM7080G Driver initialized (warm start) in %lu ms",
+                 (unsigned long)((esp_timer_get_time() - init_start) / 1000));
+        return ESP_OK;
+    }
+
+    // The device keeps its AT+IPR rate across ESP32 restarts - so find the rate it is at before anything else
+    err = sim7080g_detect_baud_rate(sim7080g_handle);
+    if (err != ESP_OK)
+    {
+        ESP_LOGE(TAG, "Device not responding at any supported baud rate: %s", esp_err_to_name(err));
+        return err;
+    }
+
+    if (sim7080g_handle->uart_config.hw_flow_control)
+    {
+        err = sim7080g_enable_hw_flow_control(sim7080g_handle);
+        if (err != ESP_OK)
+        {
+            ESP_LOGE(TAG, "Failed to enable RTS/CTS flow control: %s", esp_err_to_name(err));
+            return err;
+        }
+    }
+
+    err = sim7080g_negotiate_baud_rate(sim7080g_handle);
+    if (err != ESP_OK)
+    {
+        ESP_LOGE(TAG, "Failed to negotiate baud rate: %s", esp_err_to_name(err));
+        return err;
+    }
+
     // The sim7080g can remain powered and init while the ESP32 restarts - so it may not be necessary to always set the mqtt params on driver init
     bool params_match;
     sim7080g_mqtt_check_parameters_match(sim7080g_handle, &params_match);
     if (params_match == true)
     {
         ESP_LOGI(TAG, "Device MQTT parameter check: Param values already match Config values - skipping MQTT set params on init");
+        sim7080g_handle->ctx->async_publish = sim7080g_handle->mqtt_config.async_publish;
+        sim7080g_handle->ctx->sub_hex = sim7080g_handle->mqtt_config.binary_downlink;
     }
     else
     {
@@ -87,11 +622,18 @@ esp_err_t sim7080g_init(sim7080g_handle_t *sim7080g_handle)
         return err;
     }
 
-    ESP_LOGI(TAG, "SIM7080G Driver initialized");
+    sim7080g_warm_state_save(sim7080g_handle);
+
+    ESP_LOGI(TAG, "SIM7080G Driver initialized in %lu ms", (unsigned long)((esp_timer_get_time() - init_start) / 1000));
     return ESP_OK;
 }
 
-esp_err_t sim7080g_check_sim_status(const sim7080g_handle_t *sim7080g_handle)
+bool sim7080g_is_warm_started(const sim7080g_handle_t *sim7080g_handle)
+{
+    return sim7080g_handle != NULL && sim7080g_handle->ctx != NULL && sim7080g_handle->ctx->warm_started;
+}
+
+esp_err_t sim7080g_deinit(sim7080g_handle_t *sim7080g_handle)
 {
     if (!sim7080g_handle)
     {
@@ -99,434 +641,655 @@ esp_err_t sim7080g_check_sim_status(const sim7080g_handle_t *sim7080g_handle)
         return ESP_ERR_INVALID_ARG;
     }
 
-    ESP_LOGI(TAG, "Sending check SIM status cmd");
+    sim7080g_ctx_t *ctx = sim7080g_handle->ctx;
+    if (ctx == NULL)
+    {
+        ESP_LOGW(TAG, "SIM7080G driver not initialized - nothing to deinit");
+        return ESP_OK;
+    }
 
-    char response[AT_RESPONSE_MAX_LEN] = {0};
-    esp_err_t ret = send_at_cmd(sim7080g_handle, &AT_CPIN, AT_CMD_TYPE_READ, NULL, response, sizeof(response), 5000);
-    if (ret == ESP_OK)
+    sim7080g_handle->uart_initialized = false;
+    sim7080g_handle->mqtt_initialized = false;
+
+    // Refuse new requests and fail every queued one - the request running on the device (if any) is left to finish
+    sim7080g_async_req_t *dropped[SIM7080G_ARBITER_QUEUE_LEN];
+    size_t num_dropped = 0;
+    xSemaphoreTake(ctx->arbiter_lock, portMAX_DELAY);
+    ctx->arbiter_stopping = true;
+    for (int i = 0; i < SIM7080G_ARBITER_QUEUE_LEN; i++)
     {
-        if (strstr(response, "READY") != NULL)
+        sim7080g_arbiter_req_t *req = ctx->pending[i];
+        if (req == NULL)
         {
-            ESP_LOGI(TAG, "SIM card is ready");
-            return ESP_OK;
+            continue;
         }
-        else
+        ctx->pending[i] = NULL;
+        xSemaphoreGive(ctx->arbiter_slots); // Also wakes a caller waiting for a slot, which then sees arbiter_stopping
+        if (req->async != NULL)
         {
-            ESP_LOGE(TAG, "SIM card is not ready: %s", response);
-            return ESP_FAIL;
+            dropped[num_dropped++] = req->async;
+            continue;
         }
+        req->result = ESP_ERR_INVALID_STATE;
+        req->done = true;
+        xTaskNotifyGiveIndexed(req->caller, SIM7080G_ARBITER_NOTIFY_INDEX);
     }
-    return ret;
-}
+    xSemaphoreGive(ctx->arbiter_lock);
 
-esp_err_t sim7080g_check_signal_quality(const sim7080g_handle_t *sim7080g_handle,
-                                        int8_t *rssi_out,
-                                        uint8_t *ber_out)
-{
-    if (!sim7080g_handle || !rssi_out || !ber_out)
+    for (size_t i = 0; i < num_dropped; i++)
     {
-        ESP_LOGE(TAG, "Invalid parameters");
-        return ESP_ERR_INVALID_ARG;
+        sim7080g_async_complete(ctx, dropped[i], ESP_ERR_INVALID_STATE);
     }
 
-    ESP_LOGI(TAG, "Sending check signal quality cmd");
-
-    char response[256] = {0};
-    esp_err_t ret = send_at_cmd(sim7080g_handle,
-                                &AT_CSQ,
-                                AT_CMD_TYPE_EXECUTE,
-                                NULL,
-                                response,
-                                sizeof(response),
-                                5000);
+    // The arbiter exits by itself once its current request is done
+    xTaskNotifyGive(ctx->arbiter_task);
+    xSemaphoreTake(ctx->arbiter_stopped, portMAX_DELAY);
 
-    if (ret == ESP_OK)
+    // Callers woken above still read their request under the arbiter lock - wait for them to leave
+    for (;;)
     {
-        int rssi, ber;
-        char *csq_response = strstr(response, "+CSQ:");
-        if (csq_response && sscanf(csq_response, "+CSQ: %d,%d", &rssi, &ber) == 2)
+        xSemaphoreTake(ctx->arbiter_lock, portMAX_DELAY);
+        uint32_t callers = ctx->arbiter_callers;
+        xSemaphoreGive(ctx->arbiter_lock);
+        if (callers == 0)
         {
-            // Store values in output parameters
-            *rssi_out = (int8_t)rssi;
-            *ber_out = (uint8_t)ber;
+            break;
+        }
+        vTaskDelay(1);
+    }
 
-            ESP_LOGI(TAG, "Signal quality: RSSI=%d, BER=%d", rssi, ber);
+    // Holding the RX lock guarantees the RX task is not part way through delivering a line
+    xSemaphoreTake(ctx->rx_lock, portMAX_DELAY);
+    vTaskDelete(ctx->rx_task);
+    xSemaphoreGive(ctx->rx_lock);
 
-            // Interpret and log RSSI value
-            if (rssi == 99)
-            {
-                ESP_LOGI(TAG, "RSSI unknown or not detectable");
-            }
-            else if (rssi >= 0 && rssi <= 31)
-            {
-                int16_t dbm = -113 + (2 * rssi);
-                ESP_LOGI(TAG, "RSSI: %d dBm", dbm);
-            }
-            else
-            {
-                ESP_LOGW(TAG, "RSSI value out of expected range");
-                return ESP_ERR_INVALID_RESPONSE;
-            }
+    esp_err_t err = uart_driver_delete(ctx->port);
+    if (err != ESP_OK)
+    {
+        ESP_LOGE(TAG, "Error deleting UART driver: %s", esp_err_to_name(err));
+    }
+
+    topic_trie_clear(&ctx->subscriptions, free);
+    vSemaphoreDelete(ctx->status_cache_lock);
+    vSemaphoreDelete(ctx->sub_lock);
+    vSemaphoreDelete(ctx->inflight_slots);
+    vSemaphoreDelete(ctx->inflight_lock);
+    vSemaphoreDelete(ctx->arbiter_slots);
+    vSemaphoreDelete(ctx->arbiter_stopped);
+    vSemaphoreDelete(ctx->arbiter_lock);
+    vEventGroupDelete(ctx->status_events);
+    vSemaphoreDelete(ctx->urc_lock);
+    vSemaphoreDelete(ctx->rx_done);
+    vSemaphoreDelete(ctx->rx_lock);
+    free(ctx);
+    sim7080g_handle->ctx = NULL;
+
+    ESP_LOGI(TAG, "SIM7080G Driver deinitialized");
+    return err;
+}
 
-            // Interpret and log BER value
-            if (ber == 99)
-            {
-                ESP_LOGI(TAG, "BER unknown or not detectable");
-            }
-            else if (ber >= 0 && ber <= 7)
-            {
-                static const char *const ber_meanings[] = {
-                    "BER < 0.2%",
-                    "0.2% <= BER < 0.4%",
-                    "0.4% <= BER < 0.8%",
-                    "0.8% <= BER < 1.6%",
-                    "1.6% <= BER < 3.2%",
-                    "3.2% <= BER < 6.4%",
-                    "6.4% <= BER < 12.8%",
-                    "BER >= 12.8%"};
-                ESP_LOGI(TAG, "BER: %s", ber_meanings[ber]);
-            }
-            else
-            {
-                ESP_LOGW(TAG, "BER value out of expected range");
-                return ESP_ERR_INVALID_RESPONSE;
-            }
+/// @brief Add a request to the pending list, waiting up to 'wait' for a free slot
+/// @return Index of the pending list slot used, SIM7080G_ARBITER_FULL if none came free in time,
+///         SIM7080G_ARBITER_STOPPING if the driver is being deinitialized
+static int sim7080g_arbiter_enqueue(sim7080g_ctx_t *ctx, sim7080g_arbiter_req_t *req, TickType_t wait)
+{
+    if (xSemaphoreTake(ctx->arbiter_slots, wait) != pdTRUE)
+    {
+        return SIM7080G_ARBITER_FULL;
+    }
 
-            return ESP_OK;
-        }
-        else
-        {
-            ESP_LOGE(TAG, "Failed to parse signal quality response: %s", response);
-            return ESP_ERR_INVALID_RESPONSE;
-        }
+    xSemaphoreTake(ctx->arbiter_lock, portMAX_DELAY);
+    if (ctx->arbiter_stopping)
+    {
+        xSemaphoreGive(ctx->arbiter_lock);
+        xSemaphoreGive(ctx->arbiter_slots); // Passes the wake up on to the next caller waiting for a slot
+        return SIM7080G_ARBITER_STOPPING;
+    }
+    int slot = 0;
+    while (ctx->pending[slot] != NULL)
+    {
+        slot++; // A free slot is guaranteed by arbiter_slots
     }
+    req->seq = ctx->arbiter_seq++;
+    ctx->pending[slot] = req;
+    xSemaphoreGive(ctx->arbiter_lock);
 
-    return ret;
+    xTaskNotifyGive(ctx->arbiter_task);
+    return slot;
 }
 
-esp_err_t sim7080g_get_gprs_attach_status(const sim7080g_handle_t *sim7080g_handle,
-                                          bool *attached_out)
+/// @brief Release an async request and report its result through its opts
+static void sim7080g_async_complete(sim7080g_ctx_t *ctx, sim7080g_async_req_t *async, esp_err_t result)
 {
-    if (!sim7080g_handle || !attached_out)
+    xSemaphoreTake(ctx->arbiter_lock, portMAX_DELAY);
+    const sim7080g_request_id_t id = async->id;
+    const sim7080g_async_opts_t opts = async->opts;
+    void *data = async->data;
+    async->data = NULL;
+    async->id = 0;
+    xSemaphoreGive(ctx->arbiter_lock);
+
+    free(data);
+
+    if (opts.event_group != NULL)
     {
-        ESP_LOGE(TAG, "Invalid parameters");
-        return ESP_ERR_INVALID_ARG;
+        EventBits_t bits = (result == ESP_OK) ? opts.success_bits : opts.failure_bits;
+        if (bits != 0)
+        {
+            xEventGroupSetBits(opts.event_group, bits);
+        }
     }
+    if (opts.callback != NULL)
+    {
+        opts.callback(id, result, opts.user_ctx);
+    }
+}
 
-    ESP_LOGI(TAG, "Sending get operator info cmd");
-
-    char response[AT_RESPONSE_MAX_LEN] = {0};
+/// @brief Queue fn as an async request - takes ownership of data (freed once the request is done, also on failure)
+static esp_err_t sim7080g_async_submit(const sim7080g_handle_t *sim7080g_handle,
+                                       sim7080g_cmd_fn_t fn,
+                                       void *data,
+                                       const sim7080g_async_opts_t *opts,
+                                       sim7080g_request_id_t *id_out)
+{
+    static const sim7080g_async_opts_t default_opts = {.priority = SIM7080G_CMD_PRIORITY_NORMAL};
+    if (opts == NULL)
+    {
+        opts = &default_opts;
+    }
 
-    esp_err_t ret = send_at_cmd(sim7080g_handle,
-                                &AT_CGATT,
-                                AT_CMD_TYPE_READ,
-                                NULL,
-                                response,
-                                sizeof(response),
-                                15000);
-    // TODO - 75 seconds is spec - but this is a long time to wait in REAL life...
+    sim7080g_ctx_t *ctx = sim7080g_handle->ctx;
+    if (ctx == NULL || ctx->arbiter_task == NULL)
+    {
+        ESP_LOGE(TAG, "SIM7080G driver not initialized");
+        free(data);
+        return ESP_ERR_INVALID_STATE;
+    }
 
-    if (ret == ESP_OK)
+    if (opts->priority > SIM7080G_CMD_PRIORITY_HIGH)
     {
-        int status;
-        char *cgatt_response = strstr(response, "+CGATT:");
+        ESP_LOGE(TAG, "Invalid parameters");
+        free(data);
+        return ESP_ERR_INVALID_ARG;
+    }
 
-        if (cgatt_response && sscanf(cgatt_response, "+CGATT: %d", &status) == 1)
+    sim7080g_async_req_t *async = NULL;
+    xSemaphoreTake(ctx->arbiter_lock, portMAX_DELAY);
+    for (int i = 0; i < SIM7080G_ASYNC_MAX_REQUESTS; i++)
+    {
+        if (ctx->async_reqs[i].id == 0)
         {
-            // Validate status value is within spec (0 or 1)
-            if (status == 0 || status == 1)
-            {
-                *attached_out = (status == 1);
-
-                if (status == 1)
-                {
-                    ESP_LOGI(TAG, "Device is attached to the GPRS network");
-                }
-                else
-                {
-                    ESP_LOGW(TAG, "Device is not attached to the GPRS network");
-                }
-
-                return ESP_OK;
-            }
-            else
-            {
-                ESP_LOGE(TAG, "Invalid attachment status value: %d", status);
-                return ESP_ERR_INVALID_RESPONSE;
-            }
+            async = &ctx->async_reqs[i];
+            break;
         }
-        else
+    }
+    if (async != NULL)
+    {
+        if (++ctx->async_next_id == 0)
         {
-            ESP_LOGE(TAG, "Failed to parse GPRS attachment status from response: %s",
-                     response);
-            return ESP_ERR_INVALID_RESPONSE;
+            ctx->async_next_id = 1;
         }
+        async->id = ctx->async_next_id;
+        async->opts = *opts;
+        async->data = data;
+        async->req = (sim7080g_arbiter_req_t){
+            .handle = sim7080g_handle,
+            .fn = fn,
+            .arg = data,
+            .priority = opts->priority,
+            .has_deadline = opts->deadline_ms > 0,
+            .deadline = xTaskGetTickCount() + pdMS_TO_TICKS(opts->deadline_ms),
+            .async = async,
+        };
     }
-    else
+    xSemaphoreGive(ctx->arbiter_lock);
+
+    if (async == NULL)
     {
-        ESP_LOGE(TAG, "Failed to send CGATT command or command timed out");
+        ESP_LOGW(TAG, "Async request dropped - %d requests already outstanding", SIM7080G_ASYNC_MAX_REQUESTS);
+        free(data);
+        return ESP_ERR_NO_MEM;
     }
 
-    return ret;
+    const sim7080g_request_id_t id = async->id;
+    int slot = sim7080g_arbiter_enqueue(ctx, &async->req, 0);
+    if (slot < 0)
+    {
+        ESP_LOGW(TAG, "Async request dropped - %s", slot == SIM7080G_ARBITER_STOPPING ? "driver deinitializing" : "arbiter queue full");
+        xSemaphoreTake(ctx->arbiter_lock, portMAX_DELAY);
+        async->id = 0;
+        async->data = NULL;
+        xSemaphoreGive(ctx->arbiter_lock);
+        free(data);
+        return slot == SIM7080G_ARBITER_STOPPING ? ESP_ERR_INVALID_STATE : ESP_ERR_NO_MEM;
+    }
+
+    if (id_out != NULL)
+    {
+        *id_out = id;
+    }
+    return ESP_OK;
 }
 
-esp_err_t sim7080g_get_operator_info(const sim7080g_handle_t *sim7080g_handle,
-                                     int *operator_code,
-                                     int *operator_format,
-                                     char *operator_name,
-                                     int operator_name_len)
+esp_err_t sim7080g_arbiter_call(const sim7080g_handle_t *sim7080g_handle,
+                                sim7080g_cmd_fn_t fn,
+                                void *arg,
+                                sim7080g_cmd_priority_t priority,
+                                uint32_t deadline_ms)
 {
-    if (!sim7080g_handle || !operator_code || !operator_format ||
-        !operator_name || operator_name_len <= 0)
+    if (!sim7080g_handle || !fn || priority > SIM7080G_CMD_PRIORITY_HIGH)
     {
         ESP_LOGE(TAG, "Invalid parameters");
         return ESP_ERR_INVALID_ARG;
     }
 
-    ESP_LOGI(TAG, "Sending get operator info cmd");
-
-    // Initialize output buffer
-    memset(operator_name, 0, operator_name_len);
+    sim7080g_ctx_t *ctx = sim7080g_handle->ctx;
+    if (ctx == NULL || ctx->arbiter_task == NULL)
+    {
+        ESP_LOGE(TAG, "SIM7080G driver not initialized");
+        return ESP_ERR_INVALID_STATE;
+    }
 
-    char response[AT_RESPONSE_MAX_LEN] = {0};
-    esp_err_t ret = send_at_cmd(sim7080g_handle,
-                                &AT_COPS,
-                                AT_CMD_TYPE_READ,
-                                NULL,
-                                response,
-                                sizeof(response),
-                                5000);
+    // Already holding the device (a driver fxn called from inside a request) - queueing again would deadlock
+    if (xTaskGetCurrentTaskHandle() == ctx->arbiter_task)
+    {
+        return fn(sim7080g_handle, arg);
+    }
 
-    if (ret == ESP_OK)
+    // Counted so deinit does not free the arbiter state while this caller still reads its request
+    xSemaphoreTake(ctx->arbiter_lock, portMAX_DELAY);
+    if (ctx->arbiter_stopping)
     {
-        char *cops_response = strstr(response, "+COPS:");
-        if (cops_response)
-        {
-            int mode = 0;
-            int format = 0;
-            char operator_str[64] = {0}; // Temporary buffer for operator name
-            int act = 0;                 // Access Technology
+        xSemaphoreGive(ctx->arbiter_lock);
+        return ESP_ERR_INVALID_STATE;
+    }
+    ctx->arbiter_callers++;
+    xSemaphoreGive(ctx->arbiter_lock);
 
-            // Try to parse the response with all fields
-            int parsed = sscanf(cops_response,
-                                "+COPS: %d,%d,\"%63[^\"]\",%d",
-                                &mode, &format, operator_str, &act);
+    esp_err_t ret = sim7080g_arbiter_run(sim7080g_handle, fn, arg, priority, deadline_ms);
 
-            if (parsed >= 3) // We need at least mode, format and operator name
-            {
-                // Validate mode value (0-4)
-                if (mode < 0 || mode > 4)
-                {
-                    ESP_LOGE(TAG, "Invalid operator mode: %d", mode);
-                    return ESP_ERR_INVALID_RESPONSE;
-                }
+    xSemaphoreTake(ctx->arbiter_lock, portMAX_DELAY);
+    ctx->arbiter_callers--;
+    xSemaphoreGive(ctx->arbiter_lock);
+    return ret;
+}
 
-                // Validate format value (0-2)
-                if (format < 0 || format > 2)
-                {
-                    ESP_LOGE(TAG, "Invalid operator format: %d", format);
-                    return ESP_ERR_INVALID_RESPONSE;
-                }
+/// @brief Queue a request on the arbiter and wait for it to be done (or dropped at its deadline)
+static esp_err_t sim7080g_arbiter_run(const sim7080g_handle_t *sim7080g_handle,
+                                      sim7080g_cmd_fn_t fn,
+                                      void *arg,
+                                      sim7080g_cmd_priority_t priority,
+                                      uint32_t deadline_ms)
+{
+    sim7080g_ctx_t *ctx = sim7080g_handle->ctx;
+    sim7080g_arbiter_req_t req = {
+        .handle = sim7080g_handle,
+        .fn = fn,
+        .arg = arg,
+        .priority = priority,
+        .has_deadline = deadline_ms > 0,
+        .deadline = xTaskGetTickCount() + pdMS_TO_TICKS(deadline_ms),
+        .caller = xTaskGetCurrentTaskHandle(),
+    };
 
-                // Check if operator name will fit in provided buffer
-                if (strlen(operator_str) >= operator_name_len)
-                {
-                    ESP_LOGE(TAG, "Operator name buffer too small");
-                    return ESP_ERR_INVALID_SIZE;
-                }
+    int slot = sim7080g_arbiter_enqueue(ctx, &req, req.has_deadline ? pdMS_TO_TICKS(deadline_ms) : portMAX_DELAY);
+    if (slot == SIM7080G_ARBITER_STOPPING)
+    {
+        return ESP_ERR_INVALID_STATE;
+    }
+    if (slot < 0)
+    {
+        ESP_LOGW(TAG, "Arbiter queue full - request dropped at its deadline");
+        return ESP_ERR_TIMEOUT;
+    }
 
-                // Store values in output parameters
-                *operator_code = mode;
-                *operator_format = format;
-                strncpy(operator_name, operator_str, operator_name_len - 1);
-                operator_name[operator_name_len - 1] = '\0'; // Ensure null termination
+    for (;;)
+    {
+        TickType_t wait = portMAX_DELAY;
 
-                ESP_LOGI(TAG, "Operator info: mode=%d, format=%d, name=%s, AcT=%d",
-                         mode, format, operator_name, act);
+        xSemaphoreTake(ctx->arbiter_lock, portMAX_DELAY);
+        if (req.done)
+        {
+            xSemaphoreGive(ctx->arbiter_lock);
+            return req.result;
+        }
 
-                return ESP_OK;
-            }
-            else
+        // Only a request that has not started yet can be dropped - once running it must be waited out
+        if (req.has_deadline && ctx->pending[slot] == &req)
+        {
+            TickType_t now = xTaskGetTickCount();
+            if ((int32_t)(now - req.deadline) >= 0)
             {
-                // Try alternate format without operator name (might be in limited service)
-                if (sscanf(cops_response, "+COPS: %d", &mode) == 1)
-                {
-                    *operator_code = mode;
-                    *operator_format = 0;
-                    strncpy(operator_name, "NO SERVICE", operator_name_len - 1);
-                    operator_name[operator_name_len - 1] = '\0';
-
-                    ESP_LOGW(TAG, "Limited service, mode=%d", mode);
-                    return ESP_OK;
-                }
-                else
-                {
-                    ESP_LOGE(TAG, "Failed to parse operator info response");
-                    return ESP_ERR_INVALID_RESPONSE;
-                }
+                ctx->pending[slot] = NULL;
+                xSemaphoreGive(ctx->arbiter_lock);
+                xSemaphoreGive(ctx->arbiter_slots);
+                ESP_LOGW(TAG, "Request dropped - device busy past its deadline");
+                return ESP_ERR_TIMEOUT;
             }
+            wait = req.deadline - now;
         }
-        else
-        {
-            ESP_LOGE(TAG, "No COPS response found in: %s", response);
-            return ESP_ERR_INVALID_RESPONSE;
-        }
-    }
+        xSemaphoreGive(ctx->arbiter_lock);
 
-    return ret;
+        ulTaskNotifyTakeIndexed(SIM7080G_ARBITER_NOTIFY_INDEX, pdTRUE, wait);
+    }
 }
 
-esp_err_t sim7080g_get_apn(const sim7080g_handle_t *sim7080g_handle, char *apn, int apn_len)
+esp_err_t sim7080g_request_cancel(const sim7080g_handle_t *sim7080g_handle, sim7080g_request_id_t id)
 {
-    if (!sim7080g_handle || !apn || apn_len <= 0)
+    if (!sim7080g_handle || id == 0)
     {
         ESP_LOGE(TAG, "Invalid parameters");
         return ESP_ERR_INVALID_ARG;
     }
 
-    ESP_LOGI(TAG, "Sending get APN cmd");
-
-    char response[AT_RESPONSE_MAX_LEN] = {0};
-    esp_err_t err = send_at_cmd(sim7080g_handle, &AT_CGNAPN, AT_CMD_TYPE_EXECUTE, NULL, response, sizeof(response), 8000);
-    if (err != ESP_OK)
+    sim7080g_ctx_t *ctx = sim7080g_handle->ctx;
+    if (ctx == NULL)
     {
-        ESP_LOGE(TAG, "Failed to send AT command");
-        return err;
+        ESP_LOGE(TAG, "SIM7080G driver not initialized");
+        return ESP_ERR_INVALID_STATE;
     }
 
-    // Check if response contains "+CGNAPN:"
-    char *cgnapn_start = strstr(response, "+CGNAPN:");
-    if (!cgnapn_start)
+    xSemaphoreTake(ctx->arbiter_lock, portMAX_DELAY);
+    sim7080g_async_req_t *async = NULL;
+    for (int i = 0; i < SIM7080G_ASYNC_MAX_REQUESTS; i++)
     {
-        ESP_LOGE(TAG, "No CGNAPN response found");
-        return ESP_ERR_INVALID_RESPONSE;
+        if (ctx->async_reqs[i].id == id)
+        {
+            async = &ctx->async_reqs[i];
+            break;
+        }
     }
-
-    // Parse using strtok to handle potential variations in response format
-    char *line = strtok(cgnapn_start, "\r\n");
-    if (!line)
+    if (async == NULL)
     {
-        ESP_LOGE(TAG, "Failed to tokenize response");
-        return ESP_ERR_INVALID_RESPONSE;
+        xSemaphoreGive(ctx->arbiter_lock);
+        return ESP_ERR_NOT_FOUND;
     }
 
-    int valid;
-    char apn_str[64] = {0};
-
-    // Try different parsing approaches
-    if (sscanf(line, "+CGNAPN: %d,\"%63[^\"]\"", &valid, apn_str) == 2)
+    // Only a request still on the pending list can be cancelled - once taken off it is running on the device
+    for (int i = 0; i < SIM7080G_ARBITER_QUEUE_LEN; i++)
     {
-        // Standard format: +CGNAPN: 1,"simbase"
-        if (valid != 1)
+        if (ctx->pending[i] == &async->req)
         {
-            ESP_LOGW(TAG, "APN not valid (valid=%d)", valid);
-            return ESP_ERR_NOT_FOUND;
+            ctx->pending[i] = NULL;
+            xSemaphoreGive(ctx->arbiter_lock);
+            xSemaphoreGive(ctx->arbiter_slots);
+
+            ESP_LOGI(TAG, "Request %lu cancelled", (unsigned long)id);
+            sim7080g_async_complete(ctx, async, SIM7080G_ERR_CANCELLED);
+            return ESP_OK;
         }
     }
-    else if (sscanf(line, "+CGNAPN: \"%63[^\"]\"", apn_str) == 1)
+    xSemaphoreGive(ctx->arbiter_lock);
+
+    ESP_LOGW(TAG, "Request %lu already running - can not cancel", (unsigned long)id);
+    return ESP_ERR_INVALID_STATE;
+}
+
+static uint8_t sim7080g_urc_bucket(const char *str)
+{
+    // Nearly all URCs start with '+' - so bucket on the character after it
+    unsigned char c = (unsigned char)((str[0] == '+') ? str[1] : str[0]);
+    return (uint8_t)(c % SIM7080G_URC_BUCKETS);
+}
+
+esp_err_t sim7080g_urc_register(const sim7080g_handle_t *sim7080g_handle,
+                                const char *prefix,
+                                sim7080g_urc_handler_t handler,
+                                void *user_ctx)
+{
+    if (!sim7080g_handle || !prefix || !handler)
     {
-        // Alternative format without valid flag: +CGNAPN: "simbase"
-        valid = 1;
+        ESP_LOGE(TAG, "Invalid parameters");
+        return ESP_ERR_INVALID_ARG;
     }
-    else
+
+    size_t prefix_len = strlen(prefix);
+    if (prefix_len == 0 || (prefix[0] == '+' && prefix_len < 2) || prefix_len >= SIM7080G_URC_PREFIX_MAX_LEN)
     {
-        ESP_LOGE(TAG, "Failed to parse APN response format: %s", line);
-        return ESP_ERR_INVALID_RESPONSE;
+        ESP_LOGE(TAG, "Invalid URC prefix: '%s'", prefix);
+        return ESP_ERR_INVALID_ARG;
     }
 
-    // Copy the APN if we got here
-    if (strlen(apn_str) > 0)
+    sim7080g_ctx_t *ctx = sim7080g_handle->ctx;
+    if (ctx == NULL)
     {
-        strncpy(apn, apn_str, apn_len - 1);
-        apn[apn_len - 1] = '\0';
-        ESP_LOGI(TAG, "Successfully parsed APN: %s", apn);
+        ESP_LOGE(TAG, "SIM7080G driver not initialized");
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    xSemaphoreTake(ctx->urc_lock, portMAX_DELAY);
+    for (int8_t i = 0; i < SIM7080G_URC_MAX_HANDLERS; i++)
+    {
+        sim7080g_urc_entry_t *entry = &ctx->urc_entries[i];
+        if (entry->handler != NULL)
+        {
+            continue;
+        }
+
+        memcpy(entry->prefix, prefix, prefix_len + 1);
+        entry->prefix_len = (uint8_t)prefix_len;
+        entry->handler = handler;
+        entry->user_ctx = user_ctx;
+
+        uint8_t bucket = sim7080g_urc_bucket(prefix);
+        entry->next = ctx->urc_buckets[bucket];
+        ctx->urc_buckets[bucket] = i;
+
+        xSemaphoreGive(ctx->urc_lock);
+        ESP_LOGD(TAG, "Registered URC handler for '%s'", prefix);
         return ESP_OK;
     }
+    xSemaphoreGive(ctx->urc_lock);
 
-    ESP_LOGE(TAG, "No valid APN found in response");
-    return ESP_ERR_NOT_FOUND;
+    ESP_LOGE(TAG, "No free URC handler slot for '%s'", prefix);
+    return ESP_ERR_NO_MEM;
 }
 
-esp_err_t sim7080g_set_apn(const sim7080g_handle_t *sim7080g_handle, const char *apn)
+esp_err_t sim7080g_urc_unregister(const sim7080g_handle_t *sim7080g_handle,
+                                  const char *prefix,
+                                  sim7080g_urc_handler_t handler)
 {
-    if (!sim7080g_handle || !apn)
+    if (!sim7080g_handle || !prefix || !handler)
     {
         ESP_LOGE(TAG, "Invalid parameters");
         return ESP_ERR_INVALID_ARG;
     }
 
-    ESP_LOGI(TAG, "Sending Set APN cmd to set APN to %s", apn);
+    sim7080g_ctx_t *ctx = sim7080g_handle->ctx;
+    if (ctx == NULL)
+    {
+        ESP_LOGE(TAG, "SIM7080G driver not initialized");
+        return ESP_ERR_INVALID_STATE;
+    }
 
-    char cmd[AT_CMD_MAX_LEN];
-    snprintf(cmd, sizeof(cmd), "0,1,\"%s\"", apn);
-    char response[AT_RESPONSE_MAX_LEN] = {0};
-    esp_err_t ret = send_at_cmd(sim7080g_handle, &AT_CNCFG, AT_CMD_TYPE_WRITE, cmd, response, sizeof(response), 10000);
-    if (ret == ESP_OK)
+    xSemaphoreTake(ctx->urc_lock, portMAX_DELAY);
+    int8_t *link = &ctx->urc_buckets[sim7080g_urc_bucket(prefix)];
+    while (*link >= 0)
     {
-        ESP_LOGI(TAG, "APN configured successfully");
-        return ESP_OK;
+        sim7080g_urc_entry_t *entry = &ctx->urc_entries[*link];
+        if (entry->handler == handler && strcmp(entry->prefix, prefix) == 0)
+        {
+            *link = entry->next;
+            memset(entry, 0, sizeof(*entry));
+            xSemaphoreGive(ctx->urc_lock);
+            return ESP_OK;
+        }
+        link = &entry->next;
     }
-    return ret;
+    xSemaphoreGive(ctx->urc_lock);
+
+    ESP_LOGW(TAG, "No URC handler registered for '%s'", prefix);
+    return ESP_ERR_NOT_FOUND;
 }
 
-esp_err_t sim7080g_app_network_activate(const sim7080g_handle_t *sim7080g_handle)
+esp_err_t sim7080g_send_at_batch(const sim7080g_handle_t *sim7080g_handle,
+                                 sim7080g_at_batch_entry_t *entries,
+                                 size_t num_entries,
+                                 uint32_t timeout_ms)
 {
-    if (!sim7080g_handle)
+    if (!sim7080g_handle || !entries || num_entries == 0 || num_entries > SIM7080G_AT_BATCH_MAX_CMDS)
     {
-        ESP_LOGE(TAG, "Invalid parameters");
+        ESP_LOGE(TAG, "Send AT batch failed: Invalid parameters");
         return ESP_ERR_INVALID_ARG;
     }
-    // ESP_LOGI(TAG, "Sending Activating network APP network PDP context cmd");
-    // To ensure clear state - deactivate first (if currently active), then clear any pending errors
-    int pdpidx = 0;
-    int status;
-    char address[64] = {0};
-    esp_err_t ret = sim7080g_get_app_network_active(sim7080g_handle, pdpidx, &status, address, sizeof(address));
-    if (ret == ESP_OK)
+
+    // Build the concatenated line - "AT+CPIN?" "AT+CSQ" -> "AT+CPIN?;+CSQ"
+    char at_cmd[AT_CMD_MAX_LEN] = {0};
+    const char *solicited[SIM7080G_AT_BATCH_MAX_CMDS];
+    size_t num_solicited = 0;
+    size_t cmd_len = 0;
+    bool idempotent = true;
+
+    for (size_t i = 0; i < num_entries; i++)
     {
-        if (status == 2)
-        { // IF network  is  already active
-            ret = sim7080g_app_network_deactivate(sim7080g_handle);
-            if (ret != ESP_OK)
+        sim7080g_at_batch_entry_t *entry = &entries[i];
+        entry->result = ESP_ERR_NOT_FINISHED;
+        if (entry->response != NULL && entry->response_size > 0)
+        {
+            entry->response[0] = '\0';
+        }
+
+        if (entry->cmd == NULL)
+        {
+            ESP_LOGE(TAG, "Send AT batch failed: Entry %u has no command", (unsigned)i);
+            return ESP_ERR_INVALID_ARG;
+        }
+
+        if (i > 0)
+        {
+            if (strncmp(entry->cmd->name, "AT+", 3) != 0)
             {
-                ESP_LOGE(TAG, "Failed to deactivate network before activating");
-                return ret;
+                ESP_LOGE(TAG, "Send AT batch failed: %s can not follow another command", entry->cmd->name);
+                return ESP_ERR_INVALID_ARG;
             }
-            return ESP_OK;
+            if (cmd_len + 1 >= sizeof(at_cmd))
+            {
+                ESP_LOGE(TAG, "Send AT batch failed: AT command too long");
+                return ESP_ERR_INVALID_SIZE;
+            }
+            at_cmd[cmd_len++] = ';';
+        }
+
+        // Format in place, then drop the leading "AT" of every command after the first
+        esp_err_t err = at_cmd_format(entry->cmd, entry->type, entry->args, &at_cmd[cmd_len], sizeof(at_cmd) - cmd_len - 2);
+        if (err != ESP_OK)
+        {
+            return err;
         }
+        size_t len = strlen(&at_cmd[cmd_len]);
+        if (i > 0)
+        {
+            memmove(&at_cmd[cmd_len], &at_cmd[cmd_len + 2], len - 1);
+            len -= 2;
+        }
+        cmd_len += len;
+
+        const char *prefix = at_cmd_solicited_prefix(entry->cmd);
+        if (prefix != NULL)
+        {
+            solicited[num_solicited++] = prefix;
+        }
+        idempotent = idempotent && at_cmd_is_idempotent(entry->cmd, entry->type);
     }
-    else
+    strcat(at_cmd, "\r\n");
+
+    for (size_t i = 0; i < num_entries; i++)
     {
-        ESP_LOGE(TAG, "Failed to get network status before activating");
-        return ret;
+        sim7080g_status_cache_command(sim7080g_handle->ctx, entries[i].cmd, entries[i].type);
     }
 
-    ret = sim7080g_cycle_cfun(sim7080g_handle);
-    if (ret != ESP_OK)
+    // An error part way through leaves the commands before it applied - so the line is only resent if all of them can be
+    char response[AT_RESPONSE_MAX_LEN * 2] = {0};
+    esp_err_t ret = send_at_line(sim7080g_handle,
+                                 at_cmd,
+                                 "Batched AT commands",
+                                 solicited,
+                                 num_solicited,
+                                 NULL,
+                                 response,
+                                 sizeof(response),
+                                 timeout_ms,
+                                 idempotent ? &AT_RETRY_DEFAULT : &AT_RETRY_ONCE,
+                                 idempotent);
+
+    for (size_t i = 0; i < num_entries; i++)
     {
-        ESP_LOGE(TAG, "Failed to cycle CFUN before activating network");
-        return ret;
+        sim7080g_status_cache_command(sim7080g_handle->ctx, entries[i].cmd, entries[i].type);
     }
 
-    // Repeat this command multiple times - response needs to be validated - sometimes it can return OK and still be deactive
-    for (int i = 0; i < 3; i++)
+    // Split the response - info lines go to the command they start with, the final result code line to all
+    const char *final_line = NULL;
+    size_t final_len = 0;
+    bool answered[SIM7080G_AT_BATCH_MAX_CMDS] = {false};
+
+    const char *line = response;
+    while (*line != '\0')
     {
-        char response[AT_RESPONSE_MAX_LEN] = {0};
-        ret = send_at_cmd(sim7080g_handle, &AT_CNACT, AT_CMD_TYPE_WRITE, "0,1", response, sizeof(response), 15000);
-        if (ret == ESP_OK)
+        const char *end = strstr(line, "\r\n");
+        size_t len = end ? (size_t)(end - line) : strlen(line);
+        const char *next = end ? end + 2 : line + len;
+
+        if (len > 0)
         {
-            if (strstr(response, "+APP PDP: 0,ACTIVE") != NULL)
+            char first_word[16] = {0}; // Long enough for "+CME ERROR: <n>"
+            memcpy(first_word, line, len < sizeof(first_word) - 1 ? len : sizeof(first_word) - 1);
+            if (at_line_is_final_result(first_word))
             {
-                ESP_LOGI(TAG, "Network activated successfully");
-                return ESP_OK;
+                final_line = line;
+                final_len = len;
+            }
+            else
+            {
+                for (size_t i = 0; i < num_entries; i++)
+                {
+                    const char *prefix = at_cmd_solicited_prefix(entries[i].cmd);
+                    size_t prefix_len = prefix ? strlen(prefix) : 0;
+                    if (prefix_len == 0 || len <= prefix_len || strncmp(line, prefix, prefix_len) != 0 ||
+                        line[prefix_len] != ':')
+                    {
+                        continue;
+                    }
+
+                    answered[i] = true;
+                    sim7080g_at_batch_entry_t *entry = &entries[i];
+                    if (entry->response != NULL)
+                    {
+                        size_t used = strlen(entry->response);
+                        if (used + len + 2 < entry->response_size)
+                        {
+                            memcpy(&entry->response[used], line, len);
+                            memcpy(&entry->response[used + len], "\r\n", 3);
+                        }
+                    }
+                    break;
+                }
             }
         }
+        line = next;
     }
-    ESP_LOGE(TAG, "Failed to activate network");
-    return ESP_FAIL;
+
+    // An info line means its command ran. The error itself names no command, and commands without info lines
+    // (write commands) look the same whether they succeeded or never ran - so the rest all get the error.
+    for (size_t i = 0; i < num_entries; i++)
+    {
+        sim7080g_at_batch_entry_t *entry = &entries[i];
+        entry->result = (ret == ESP_OK || answered[i]) ? ESP_OK : ret;
+
+        if (final_line != NULL && entry->response != NULL)
+        {
+            size_t used = strlen(entry->response);
+            if (used + final_len + 2 < entry->response_size)
+            {
+                memcpy(&entry->response[used], final_line, final_len);
+                memcpy(&entry->response[used + final_len], "\r\n", 3);
+            }
+        }
+    }
+
+    return ret;
 }
 
-esp_err_t sim7080g_cycle_cfun(const sim7080g_handle_t *sim7080g_handle)
+esp_err_t sim7080g_check_sim_status(const sim7080g_handle_t *sim7080g_handle)
 {
     if (!sim7080g_handle)
     {
@@ -534,1633 +1297,5961 @@ esp_err_t sim7080g_cycle_cfun(const sim7080g_handle_t *sim7080g_handle)
         return ESP_ERR_INVALID_ARG;
     }
 
-    char response[AT_RESPONSE_MAX_LEN] = {0};
-    esp_err_t ret = send_at_cmd(sim7080g_handle, &AT_CFUN, AT_CMD_TYPE_WRITE, "0", response, sizeof(response), 10000);
-    if (ret != ESP_OK)
-    {
-        ESP_LOGE(TAG, "Failed to send CFUN=0 command");
-        return ret;
-    }
-
-    ESP_LOGI(TAG, "Waiting for CFUN=0 to take effect");
-    vTaskDelay(5000 / portTICK_PERIOD_MS);
+    ESP_LOGI(TAG, "Sending check SIM status cmd");
 
-    ret = send_at_cmd(sim7080g_handle, &AT_CFUN, AT_CMD_TYPE_WRITE, "1", response, sizeof(response), 10000);
-    if (ret != ESP_OK)
+    char response[AT_RESPONSE_MAX_LEN] = {0};
+    esp_err_t ret = send_at_cmd_cached(sim7080g_handle, &AT_CPIN, AT_CMD_TYPE_READ, response, sizeof(response), 5000);
+    if (ret == ESP_OK)
     {
-        ESP_LOGE(TAG, "Failed to send CFUN=1 command");
-        return ret;
+        return sim7080g_parse_sim_status(response);
     }
-
-    ESP_LOGI(TAG, "Waiting for CFUN=1 to take effect");
-    vTaskDelay(5000 / portTICK_PERIOD_MS);
-
-    return ESP_OK;
+    return ret;
 }
 
-// TODO -
-// esp_err_t sim7080g_get_cfun(const sim7080g_handle_t *sim7080g_handle)
-// {
-//     if (!sim7080g_handle)
-//     {
-//         ESP_LOGE(TAG, "Invalid parameters");
-//         return ESP_ERR_INVALID_ARG;
-//     }
-//     ESP_LOGI(TAG, "Sending get CFUN cmd");
-// }
-
-esp_err_t sim7080g_app_network_deactivate(const sim7080g_handle_t *sim7080g_handle)
+/// @brief Parse an AT+CPIN? response
+static esp_err_t sim7080g_parse_sim_status(const char *response)
 {
-    if (!sim7080g_handle)
+    sim7080g_cpin_reply_t reply = {0};
+    if (sim7080g_decode(SIM7080G_DECODER_CPIN, response, &reply) == 1 && strcmp(reply.code, "READY") == 0)
     {
-        ESP_LOGE(TAG, "Invalid parameters");
-        return ESP_ERR_INVALID_ARG;
+        ESP_LOGI(TAG, "SIM card is ready");
+        return ESP_OK;
     }
-    ESP_LOGI(TAG, "Sending app network deactivate cmd");
-
-    for (int i = 0; i < 3; i++)
+    else
     {
-        /// Loops becasue the send at cmd fxn might get an OK - but the device might remain active
-        char response[AT_RESPONSE_MAX_LEN] = {0};
-        esp_err_t ret = send_at_cmd(sim7080g_handle, &AT_CNACT, AT_CMD_TYPE_WRITE, "0,0", response, sizeof(response), 15000);
-        if (ret == ESP_OK)
-        {
-            if (strstr(response, "+APP PDP: 0,DEACTIVE") != NULL)
-            {
-                ESP_LOGI(TAG, "Network deactivated successfully");
-                return ESP_OK;
-            }
-        }
+        ESP_LOGE(TAG, "SIM card is not ready: %s", response);
+        return ESP_FAIL;
     }
-    ESP_LOGE(TAG, "Failed to deactivate network");
-    return ESP_FAIL;
 }
 
-esp_err_t sim7080g_get_app_network_active(const sim7080g_handle_t *sim7080g_handle,
-                                          int pdpidx,
-                                          int *status,
-                                          char *address,
-                                          int address_len)
+esp_err_t sim7080g_check_signal_quality(const sim7080g_handle_t *sim7080g_handle,
+                                        int8_t *rssi_out,
+                                        uint8_t *ber_out)
 {
-    if (!sim7080g_handle || !status || !address || address_len <= 0)
+    if (!sim7080g_handle || !rssi_out || !ber_out)
     {
         ESP_LOGE(TAG, "Invalid parameters");
         return ESP_ERR_INVALID_ARG;
     }
 
-    if (pdpidx < 0 || pdpidx > 3)
+    ESP_LOGI(TAG, "Sending check signal quality cmd");
+
+    char response[256] = {0};
+    esp_err_t ret = send_at_cmd_cached(sim7080g_handle,
+                                       &AT_CSQ,
+                                       AT_CMD_TYPE_EXECUTE,
+                                       response,
+                                       sizeof(response),
+                                       5000);
+
+    if (ret == ESP_OK)
     {
-        ESP_LOGE(TAG, "Invalid PDP context index: %d", pdpidx);
-        return ESP_ERR_INVALID_ARG;
+        return sim7080g_parse_signal_quality(response, rssi_out, ber_out);
     }
-    // ESP_LOGI(TAG, "Reading network status for PDP context %d", pdpidx);
 
-    // Initialize output parameters
-    *status = 0;
-    memset(address, 0, address_len);
-
-    char response[256] = {0};
-    esp_err_t ret = send_at_cmd(sim7080g_handle,
-                                &AT_CNACT,
-                                AT_CMD_TYPE_READ,
-                                NULL,
-                                response,
-                                sizeof(response),
-                                20000);
+    return ret;
+}
 
-    if (ret == ESP_OK)
+/// @brief Parse an AT+CSQ response
+static esp_err_t sim7080g_parse_signal_quality(const char *response, int8_t *rssi_out, uint8_t *ber_out)
+{
+    sim7080g_csq_reply_t reply;
+    if (sim7080g_decode(SIM7080G_DECODER_CSQ, response, &reply) == 2)
     {
-        char *cnact_response = strstr(response, "+CNACT:");
-        bool found_context = false;
+        int rssi = reply.rssi;
+        int ber = reply.ber;
 
-        // Process each CNACT response line (there may be multiple contexts)
-        while (cnact_response)
+        // Store values in output parameters
+        *rssi_out = (int8_t)rssi;
+        *ber_out = (uint8_t)ber;
+
+        ESP_LOGI(TAG, "Signal quality: RSSI=%d, BER=%d", rssi, ber);
+
+        // Interpret and log RSSI value
+        if (rssi == 99)
+        {
+            ESP_LOGI(TAG, "RSSI unknown or not detectable");
+        }
+        else if (rssi >= 0 && rssi <= 31)
         {
-            int parsed_idx;
-            int parsed_status;
-            char parsed_addr[64] = {0};
+            int16_t dbm = -113 + (2 * rssi);
+            ESP_LOGI(TAG, "RSSI: %d dBm", dbm);
+        }
+        else
+        {
+            ESP_LOGW(TAG, "RSSI value out of expected range");
+            return ESP_ERR_INVALID_RESPONSE;
+        }
 
-            // Parse the response line
-            int fields = sscanf(cnact_response,
-                                "+CNACT: %d,%d,\"%63[^\"]\"",
-                                &parsed_idx,
-                                &parsed_status,
-                                parsed_addr);
+        // Interpret and log BER value
+        if (ber == 99)
+        {
+            ESP_LOGI(TAG, "BER unknown or not detectable");
+        }
+        else if (ber >= 0 && ber <= 7)
+        {
+            static const char *const ber_meanings[] = {
+                "BER < 0.2%",
+                "0.2% <= BER < 0.4%",
+                "0.4% <= BER < 0.8%",
+                "0.8% <= BER < 1.6%",
+                "1.6% <= BER < 3.2%",
+                "3.2% <= BER < 6.4%",
+                "6.4% <= BER < 12.8%",
+                "BER >= 12.8%"};
+            ESP_LOGI(TAG, "BER: %s", ber_meanings[ber]);
+        }
+        else
+        {
+            ESP_LOGW(TAG, "BER value out of expected range");
+            return ESP_ERR_INVALID_RESPONSE;
+        }
 
-            if (fields >= 2) // At minimum need index and status
-            {
-                if (parsed_idx == pdpidx)
-                {
-                    // Found our target PDP context
-                    found_context = true;
+        return ESP_OK;
+    }
+    else
+    {
+        ESP_LOGE(TAG, "Failed to parse signal quality response: %s", response);
+        return ESP_ERR_INVALID_RESPONSE;
+    }
+}
 
-                    // Validate status value
-                    if (parsed_status < 0 || parsed_status > 2)
-                    {
-                        ESP_LOGE(TAG, "Invalid status value: %d", parsed_status);
-                        return ESP_ERR_INVALID_RESPONSE;
-                    }
+esp_err_t sim7080g_get_gprs_attach_status(const sim7080g_handle_t *sim7080g_handle,
+                                          bool *attached_out)
+{
+    if (!sim7080g_handle || !attached_out)
+    {
+        ESP_LOGE(TAG, "Invalid parameters");
+        return ESP_ERR_INVALID_ARG;
+    }
 
-                    // Store status
-                    *status = parsed_status;
+    ESP_LOGI(TAG, "Sending get operator info cmd");
 
-                    // If we have an IP address, store it
-                    if (fields == 3 && parsed_status > 0)
-                    {
-                        if (strlen(parsed_addr) >= address_len)
-                        {
-                            ESP_LOGE(TAG, "IP address buffer too small");
-                            return ESP_ERR_INVALID_SIZE;
-                        }
-                        strncpy(address, parsed_addr, address_len - 1);
-                        address[address_len - 1] = '\0';
-                    }
+    char response[AT_RESPONSE_MAX_LEN] = {0};
 
-                    // Log the status
-                    const char *status_str[] = {
-                        "Deactivated",
-                        "Activated",
-                        "In Operation"};
-                    ESP_LOGI(TAG, "PDP Context %d: %s, IP: %s",
-                             pdpidx,
-                             status_str[parsed_status],
-                             (parsed_status > 0) ? address : "None");
+    esp_err_t ret = send_at_cmd_cached(sim7080g_handle,
+                                       &AT_CGATT,
+                                       AT_CMD_TYPE_READ,
+                                       response,
+                                       sizeof(response),
+                                       15000);
+    // TODO - 75 seconds is spec - but this is a long time to wait in REAL life...
 
-                    return ESP_OK;
-                }
+    if (ret == ESP_OK)
+    {
+        return sim7080g_parse_gprs_attach_status(response, attached_out);
+    }
+    else
+    {
+        ESP_LOGE(TAG, "Failed to send CGATT command or command timed out");
+    }
+
+    return ret;
+}
+
+/// @brief Parse an AT+CGATT? response
+static esp_err_t sim7080g_parse_gprs_attach_status(const char *response, bool *attached_out)
+{
+    sim7080g_int_reply_t reply;
+    if (sim7080g_decode(SIM7080G_DECODER_CGATT, response, &reply) == 1)
+    {
+        int status = reply.value;
+
+        // Validate status value is within spec (0 or 1)
+        if (status == 0 || status == 1)
+        {
+            *attached_out = (status == 1);
+
+            if (status == 1)
+            {
+                ESP_LOGI(TAG, "Device is attached to the GPRS network");
             }
             else
             {
-                ESP_LOGW(TAG, "Failed to parse CNACT response line: %s",
-                         cnact_response);
+                ESP_LOGW(TAG, "Device is not attached to the GPRS network");
             }
 
-            // Look for next CNACT line
-            cnact_response = strstr(cnact_response + 1, "+CNACT:");
+            return ESP_OK;
         }
-
-        if (!found_context)
+        else
         {
-            ESP_LOGW(TAG, "PDP context %d not found in response", pdpidx);
-            return ESP_ERR_NOT_FOUND;
+            ESP_LOGE(TAG, "Invalid attachment status value: %d", status);
+            return ESP_ERR_INVALID_RESPONSE;
         }
     }
     else
     {
-        ESP_LOGE(TAG, "Failed to read network status");
+        ESP_LOGE(TAG, "Failed to parse GPRS attachment status from response: %s",
+                 response);
+        return ESP_ERR_INVALID_RESPONSE;
     }
-
-    return ret;
 }
 
-esp_err_t sim7080g_connect_to_network_bearer(const sim7080g_handle_t *sim7080g_handle, const char *apn)
+esp_err_t sim7080g_get_operator_info(const sim7080g_handle_t *sim7080g_handle,
+                                     int *operator_code,
+                                     int *operator_format,
+                                     char *operator_name,
+                                     int operator_name_len)
 {
-    if (!sim7080g_handle || !apn)
+    if (!sim7080g_handle || !operator_code || !operator_format ||
+        !operator_name || operator_name_len <= 0)
     {
         ESP_LOGE(TAG, "Invalid parameters");
         return ESP_ERR_INVALID_ARG;
     }
 
-    ESP_LOGI(TAG, "Beginning sequence of AT commands to connect to sim7080g to network bearer");
+    ESP_LOGI(TAG, "Sending get operator info cmd");
 
-    esp_err_t err = sim7080g_check_sim_status(sim7080g_handle);
-    if (err != ESP_OK)
-    {
-        ESP_LOGE(TAG, "Error checking SIM status: %s", esp_err_to_name(err));
-        return err;
-    }
+    // Initialize output buffer
+    memset(operator_name, 0, operator_name_len);
 
-    int8_t rssi;
-    uint8_t ber;
-    err = sim7080g_check_signal_quality(sim7080g_handle, &rssi, &ber);
-    if (err != ESP_OK)
+    char response[AT_RESPONSE_MAX_LEN] = {0};
+    esp_err_t ret = send_at_cmd_cached(sim7080g_handle,
+                                       &AT_COPS,
+                                       AT_CMD_TYPE_READ,
+                                       response,
+                                       sizeof(response),
+                                       5000);
+
+    if (ret == ESP_OK)
     {
-        ESP_LOGE(TAG, "Error checking signal quality: %s", esp_err_to_name(err));
-        return err;
+        return sim7080g_parse_operator_info(response, operator_code, operator_format, operator_name, operator_name_len);
     }
-    else
+
+    return ret;
+}
+
+/// @brief Parse an AT+COPS? response
+static esp_err_t sim7080g_parse_operator_info(const char *response,
+                                              int *operator_code,
+                                              int *operator_format,
+                                              char *operator_name,
+                                              int operator_name_len)
+{
+    sim7080g_cops_reply_t reply = {0}; // AcT (Access Technology) is optional - left 0 if missing
+    int decoded = sim7080g_decode(SIM7080G_DECODER_COPS, response, &reply);
+    if (decoded >= 0)
     {
-        if (rssi <= 0)
+        int mode = reply.mode;
+        int format = reply.format;
+        int act = reply.act;
+
+        if (decoded < 1)
         {
-            ESP_LOGE(TAG, "Signal quality is too low (-115dBm or less) to connect to network");
-            return ESP_FAIL;
+            ESP_LOGE(TAG, "Failed to parse operator info response");
+            return ESP_ERR_INVALID_RESPONSE;
         }
-        if (rssi == 99)
+
+        // We need at least mode, format and operator name - the AcT is optional
+        if (decoded >= 3)
         {
-            ESP_LOGE(TAG, "Signal quality is unknown or not detectable");
-            return ESP_FAIL;
+            // Validate mode value (0-4)
+            if (mode < 0 || mode > 4)
+            {
+                ESP_LOGE(TAG, "Invalid operator mode: %d", mode);
+                return ESP_ERR_INVALID_RESPONSE;
+            }
+
+            // Validate format value (0-2)
+            if (format < 0 || format > 2)
+            {
+                ESP_LOGE(TAG, "Invalid operator format: %d", format);
+                return ESP_ERR_INVALID_RESPONSE;
+            }
+
+            // Check if operator name will fit in provided buffer
+            if (strlen(reply.name) >= (size_t)operator_name_len)
+            {
+                ESP_LOGE(TAG, "Operator name buffer too small");
+                return ESP_ERR_INVALID_SIZE;
+            }
+
+            // Store values in output parameters
+            strcpy(operator_name, reply.name);
+            *operator_code = mode;
+            *operator_format = format;
+
+            ESP_LOGI(TAG, "Operator info: mode=%d, format=%d, name=%s, AcT=%d",
+                     mode, format, operator_name, act);
+
+            return ESP_OK;
         }
-    }
+        else
+        {
+            // Alternate format without operator name (might be in limited service)
+            *operator_code = mode;
+            *operator_format = 0;
+            strncpy(operator_name, "NO SERVICE", operator_name_len - 1);
+            operator_name[operator_name_len - 1] = '\0';
 
-    bool attached;
-    err = sim7080g_get_gprs_attach_status(sim7080g_handle, &attached);
-    if (err != ESP_OK)
+            ESP_LOGW(TAG, "Limited service, mode=%d", mode);
+            return ESP_OK;
+        }
+    }
+    else
     {
-        ESP_LOGE(TAG, "Error checking GPRS attach status: %s", esp_err_to_name(err));
-        return err;
+        ESP_LOGE(TAG, "No COPS response found in: %s", response);
+        return ESP_ERR_INVALID_RESPONSE;
     }
+}
 
-    int operator_code;
-    int operator_format;
-    char operator_name[32];
-    err = sim7080g_get_operator_info(sim7080g_handle, &operator_code, &operator_format, operator_name, sizeof(operator_name));
-    if (err != ESP_OK)
+esp_err_t sim7080g_get_apn(const sim7080g_handle_t *sim7080g_handle, char *apn, int apn_len)
+{
+    if (!sim7080g_handle || !apn || apn_len <= 0)
     {
-        ESP_LOGE(TAG, "Error getting operator info: %s", esp_err_to_name(err));
-        return err;
+        ESP_LOGE(TAG, "Invalid parameters");
+        return ESP_ERR_INVALID_ARG;
     }
 
-    char current_apn[32];
-    int apn_len = sizeof(current_apn);
-    err = sim7080g_get_apn(sim7080g_handle, current_apn, apn_len);
+    ESP_LOGI(TAG, "Sending get APN cmd");
+
+    char response[AT_RESPONSE_MAX_LEN] = {0};
+    esp_err_t err = send_at_cmd(sim7080g_handle, &AT_CGNAPN, AT_CMD_TYPE_EXECUTE, NULL, response, sizeof(response), 8000);
     if (err != ESP_OK)
     {
-        ESP_LOGE(TAG, "Error getting APN: %s", esp_err_to_name(err));
+        ESP_LOGE(TAG, "Failed to send AT command");
         return err;
     }
 
-    err = sim7080g_set_apn(sim7080g_handle, apn);
-    if (err != ESP_OK)
+    sim7080g_cgnapn_reply_t reply = {0};
+    int decoded = sim7080g_decode(SIM7080G_DECODER_CGNAPN, response, &reply);
+    if (decoded < 0)
     {
-        ESP_LOGE(TAG, "Error setting APN: %s", esp_err_to_name(err));
-        return err;
+        ESP_LOGE(TAG, "No CGNAPN response found");
+        return ESP_ERR_INVALID_RESPONSE;
     }
 
-    err = sim7080g_app_network_activate(sim7080g_handle);
-    if (err != ESP_OK)
+    if (decoded == 2)
     {
-        ESP_LOGE(TAG, "Error activating network: %s", esp_err_to_name(err));
-        return err;
+        // Standard format: +CGNAPN: 1,"simbase"
+        if (reply.valid != 1)
+        {
+            ESP_LOGW(TAG, "APN not valid (valid=%d)", reply.valid);
+            return ESP_ERR_NOT_FOUND;
+        }
     }
-
-    int pdpdix = 0;
-    int status;
-    char address[32];
-    int address_len = sizeof(address);
-    err = sim7080g_get_app_network_active(sim7080g_handle, pdpdix, &status, address, address_len);
-    if (err != ESP_OK)
+    else
     {
-        ESP_LOGE(TAG, "Error getting network active status: %s", esp_err_to_name(err));
-        return err;
+        // Alternative format without valid flag: +CGNAPN: "simbase"
+        at_parser_t parser, fields;
+        at_str_t apn_str;
+        at_parser_init(&parser, response, strlen(response));
+        if (decoded != 0 || !at_parser_find_line(&parser, "+CGNAPN:", &fields) ||
+            !at_parser_str(&fields, &apn_str) || !at_str_copy(apn_str, reply.apn, sizeof(reply.apn)))
+        {
+            ESP_LOGE(TAG, "Failed to parse APN response format: %s", response);
+            return ESP_ERR_INVALID_RESPONSE;
+        }
     }
-    if (status <= 0) // 1 - connected, 2 - in operation
+
+    // Copy the APN if we got here
+    if (reply.apn[0] != '\0')
     {
-        ESP_LOGE(TAG, "Network bearer not connected");
-        return ESP_FAIL;
+        strncpy(apn, reply.apn, apn_len - 1);
+        apn[apn_len - 1] = '\0';
+        ESP_LOGI(TAG, "Successfully parsed APN: %s", apn);
+        return ESP_OK;
     }
 
-    // TODO DEBUG THIS - Somehow this can be reached when the network is not actually connected
-    ESP_LOGI(TAG, "Network bearer connected successfully");
-    return ESP_OK;
+    ESP_LOGE(TAG, "No valid APN found in response");
+    return ESP_ERR_NOT_FOUND;
 }
 
-esp_err_t sim7080g_mqtt_set_parameters(const sim7080g_handle_t *sim7080g_handle)
+esp_err_t sim7080g_set_apn(const sim7080g_handle_t *sim7080g_handle, const char *apn)
 {
-    if (!sim7080g_handle)
+    if (!sim7080g_handle || !apn)
     {
-        ESP_LOGE(TAG, "Invalid device handle");
+        ESP_LOGE(TAG, "Invalid parameters");
         return ESP_ERR_INVALID_ARG;
     }
 
-    ESP_LOGI(TAG, "Beginning sequence of AT commands to set MQTT parameters on sim7080g to match driver handle config");
-
-    esp_err_t ret = ESP_OK;
+    ESP_LOGI(TAG, "Sending Set APN cmd to set APN to %s", apn);
 
-    // Log configuration parameters for debugging
-    ESP_LOGI(TAG, "Configuring MQTT with parameters:");
-    ESP_LOGI(TAG, "  URL: %s", sim7080g_handle->mqtt_config.broker_url);
-    ESP_LOGI(TAG, "  Port: %d", sim7080g_handle->mqtt_config.port);
-    ESP_LOGI(TAG, "  Client ID: %s", sim7080g_handle->mqtt_config.client_id);
-    ESP_LOGI(TAG, "  Username: %s", sim7080g_handle->mqtt_config.username);
-
-    char cmd[AT_CMD_MAX_LEN] = {0};
+    char cmd[AT_CMD_MAX_LEN];
+    snprintf(cmd, sizeof(cmd), "0,1,\"%s\"", apn);
     char response[AT_RESPONSE_MAX_LEN] = {0};
-
-    // Configure URL and port
-    if (snprintf(cmd, sizeof(cmd), "\"URL\",\"%s\",%d",
-                 sim7080g_handle->mqtt_config.broker_url,
-                 sim7080g_handle->mqtt_config.port) >= sizeof(cmd))
+    esp_err_t ret = send_at_cmd(sim7080g_handle, &AT_CNCFG, AT_CMD_TYPE_WRITE, cmd, response, sizeof(response), 10000);
+    if (ret == ESP_OK)
     {
-        ESP_LOGE(TAG, "URL command string too long");
-        return ESP_ERR_INVALID_SIZE;
+        ESP_LOGI(TAG, "APN configured successfully");
+        return ESP_OK;
     }
+    return ret;
+}
 
-    ESP_LOGI(TAG, "Setting MQTT URL");
-    ret = send_at_cmd(sim7080g_handle,
-                      &AT_SMCONF,
-                      AT_CMD_TYPE_WRITE,
-                      cmd,
-                      response,
-                      sizeof(response),
-                      5000);
-    if (ret != ESP_OK)
+esp_err_t sim7080g_app_network_activate(const sim7080g_handle_t *sim7080g_handle)
+{
+    if (!sim7080g_handle)
     {
-        ESP_LOGE(TAG, "Failed to set MQTT URL");
-        return ret;
+        ESP_LOGE(TAG, "Invalid parameters");
+        return ESP_ERR_INVALID_ARG;
     }
-
-    // Configure Client ID
-    if (snprintf(cmd, sizeof(cmd), "\"CLIENTID\",\"%s\"",
-                 sim7080g_handle->mqtt_config.client_id) >= sizeof(cmd))
+    // ESP_LOGI(TAG, "Sending Activating network APP network PDP context cmd");
+    // To ensure clear state - deactivate first (if currently active), then clear any pending errors
+    int pdpidx = 0;
+    int status;
+    char address[64] = {0};
+    esp_err_t ret = sim7080g_get_app_network_active(sim7080g_handle, pdpidx, &status, address, sizeof(address));
+    if (ret == ESP_OK)
     {
-        ESP_LOGE(TAG, "Client ID command string too long");
-        return ESP_ERR_INVALID_SIZE;
+        if (status == 2)
+        { // IF network  is  already active
+            ret = sim7080g_app_network_deactivate(sim7080g_handle);
+            if (ret != ESP_OK)
+            {
+                ESP_LOGE(TAG, "Failed to deactivate network before activating");
+                return ret;
+            }
+            return ESP_OK;
+        }
     }
-
-    ESP_LOGI(TAG, "Setting MQTT Client ID");
-    ret = send_at_cmd(sim7080g_handle,
-                      &AT_SMCONF,
-                      AT_CMD_TYPE_WRITE,
-                      cmd,
-                      response,
-                      sizeof(response),
-                      5000);
-    if (ret != ESP_OK)
+    else
     {
-        ESP_LOGE(TAG, "Failed to set MQTT Client ID");
+        ESP_LOGE(TAG, "Failed to get network status before activating");
         return ret;
     }
 
-    // Configure Username
-    if (snprintf(cmd, sizeof(cmd), "\"USERNAME\",\"%s\"",
-                 sim7080g_handle->mqtt_config.username) >= sizeof(cmd))
-    {
-        ESP_LOGE(TAG, "Username command string too long");
-        return ESP_ERR_INVALID_SIZE;
-    }
-
-    ESP_LOGI(TAG, "Setting MQTT Username");
-    ret = send_at_cmd(sim7080g_handle,
-                      &AT_SMCONF,
-                      AT_CMD_TYPE_WRITE,
-                      cmd,
-                      response,
-                      sizeof(response),
-                      5000);
+    ret = sim7080g_cycle_cfun(sim7080g_handle, NULL);
     if (ret != ESP_OK)
     {
-        ESP_LOGE(TAG, "Failed to set MQTT Username");
+        ESP_LOGE(TAG, "Failed to cycle CFUN before activating network");
         return ret;
     }
 
-    // Configure Password
-    if (snprintf(cmd, sizeof(cmd), "\"PASSWORD\",\"%s\"",
-                 sim7080g_handle->mqtt_config.client_password) >= sizeof(cmd))
-    {
-        ESP_LOGE(TAG, "Password command string too long");
-        return ESP_ERR_INVALID_SIZE;
-    }
+    return sim7080g_app_network_reactivate(sim7080g_handle);
+}
 
-    ESP_LOGI(TAG, "Setting MQTT Password");
-    ret = send_at_cmd(sim7080g_handle,
-                      &AT_SMCONF,
-                      AT_CMD_TYPE_WRITE,
-                      cmd,
-                      response,
-                      sizeof(response),
-                      5000);
-    if (ret != ESP_OK)
+esp_err_t sim7080g_app_network_reactivate(const sim7080g_handle_t *sim7080g_handle)
+{
+    if (!sim7080g_handle)
     {
-        ESP_LOGE(TAG, "Failed to set MQTT Password");
-        return ret;
+        ESP_LOGE(TAG, "Invalid parameters");
+        return ESP_ERR_INVALID_ARG;
     }
 
-    // Set additional MQTT parameters with default values
-    const struct
-    {
-        const char *param;
-        const char *value;
-    } default_params[] = {
-        {"KEEPTIME", "60"}, // 60 second keepalive
-        {"CLEANSS", "1"},   // Clean session enabled
-        {"QOS", "0"},       // QoS 1 default
-        {"RETAIN", "0"},    // Don't retain messages
-        {"SUBHEX", "0"},    // Normal (not hex) subscribe data
-        {"ASYNCMODE", "0"}  // Synchronous mode
-    };
-
-    for (size_t i = 0; i < sizeof(default_params) / sizeof(default_params[0]); i++)
+    // Repeat this command multiple times - response needs to be validated - sometimes it can return OK and still be deactive
+    for (int i = 0; i < 3; i++)
     {
-        if (snprintf(cmd, sizeof(cmd), "\"%s\",\"%s\"",
-                     default_params[i].param,
-                     default_params[i].value) >= sizeof(cmd))
-        {
-            ESP_LOGE(TAG, "Default parameter command string too long");
-            return ESP_ERR_INVALID_SIZE;
-        }
-
-        ESP_LOGI(TAG, "Setting MQTT %s=%s", default_params[i].param, default_params[i].value);
-        ret = send_at_cmd(sim7080g_handle,
-                          &AT_SMCONF,
-                          AT_CMD_TYPE_WRITE,
-                          cmd,
-                          response,
-                          sizeof(response),
-                          5000);
-        if (ret != ESP_OK)
+        char response[AT_RESPONSE_MAX_LEN] = {0};
+        // The OK comes back first - the '+APP PDP' URC only follows once the context state actually changes
+        esp_err_t ret = send_at_cmd_expect(sim7080g_handle, &AT_CNACT, AT_CMD_TYPE_WRITE, "0,1", "+APP PDP: 0,", response, sizeof(response), 15000);
+        if (ret == ESP_OK)
         {
-            ESP_LOGE(TAG, "Failed to set MQTT %s", default_params[i].param);
-            return ret;
+            if (strstr(response, "+APP PDP: 0,ACTIVE") != NULL)
+            {
+                ESP_LOGI(TAG, "Network activated successfully");
+                return ESP_OK;
+            }
         }
     }
+    ESP_LOGE(TAG, "Failed to activate network");
+    return ESP_FAIL;
+}
 
-    ESP_LOGI(TAG, "MQTT setting sim7080g device params successful");
-    return ESP_OK;
+static esp_err_t sim7080g_app_network_activate_fn(const sim7080g_handle_t *sim7080g_handle, void *arg)
+{
+    return sim7080g_app_network_activate(sim7080g_handle);
 }
 
-esp_err_t sim7080g_mqtt_connect_to_broker(const sim7080g_handle_t *sim7080g_handle)
+esp_err_t sim7080g_app_network_activate_async(const sim7080g_handle_t *sim7080g_handle,
+                                              const sim7080g_async_opts_t *opts,
+                                              sim7080g_request_id_t *id_out)
 {
     if (!sim7080g_handle)
     {
-        ESP_LOGE(TAG, "Invalid device handle");
+        ESP_LOGE(TAG, "Invalid parameters");
         return ESP_ERR_INVALID_ARG;
     }
 
-    sim7080g_mqtt_connection_status_t curr_status;
-    esp_err_t ret = sim7080g_mqtt_get_broker_connection_status(sim7080g_handle, &curr_status);
-    if (ret != ESP_OK)
+    return sim7080g_async_submit(sim7080g_handle, sim7080g_app_network_activate_fn, NULL, opts, id_out);
+}
+
+esp_err_t sim7080g_cycle_cfun(const sim7080g_handle_t *sim7080g_handle, uint32_t *recovery_ms_out)
+{
+    if (!sim7080g_handle)
     {
-        ESP_LOGE(TAG, "Failed to check current connection status");
-        return ret;
+        ESP_LOGE(TAG, "Invalid parameters");
+        return ESP_ERR_INVALID_ARG;
     }
 
-    if (curr_status != MQTT_STATUS_DISCONNECTED)
+    if (!sim7080g_handle->uart_initialized || sim7080g_handle->ctx == NULL)
     {
-        ESP_LOGI(TAG, "MQTT broker already connected");
-        return ESP_OK;
+        ESP_LOGE(TAG, "SIM7080G driver not initialized");
+        return ESP_ERR_INVALID_STATE;
     }
 
-    // Verify network broker connected before attempting MQTT connect
-    int pdpidx = 0;
-    int status;
-    char address[32];
-    ret = sim7080g_get_app_network_active(sim7080g_handle, pdpidx, &status, address, sizeof(address));
+    sim7080g_ctx_t *ctx = sim7080g_handle->ctx;
+    int64_t start = esp_timer_get_time();
+
+    // CFUN=0 has taken effect once it is answered - no need to wait on it
+    char response[AT_RESPONSE_MAX_LEN] = {0};
+    esp_err_t ret = send_at_cmd(sim7080g_handle, &AT_CFUN, AT_CMD_TYPE_WRITE, "0", response, sizeof(response), 10000);
     if (ret != ESP_OK)
     {
-        ESP_LOGE(TAG, "Failed to get network active status");
+        ESP_LOGE(TAG, "Failed to send CFUN=0 command");
         return ret;
     }
-    if (status <= 0)
-    {
-        ESP_LOGE(TAG, "Network bearer not connected");
-        return ESP_FAIL;
-    }
-
-    ESP_LOGI(TAG, "Attempting to connect to MQTT broker");
-
-    char response[AT_RESPONSE_MAX_LEN] = {0};
-    ret = send_at_cmd(sim7080g_handle,
-                      &AT_SMCONN,
-                      AT_CMD_TYPE_EXECUTE,
-                      NULL,
-                      response,
-                      sizeof(response),
-                      15000); // 15 second timeout for connection
+    sim7080g_functionality_lost(ctx);
+    sim7080g_inflight_flush(ctx);
 
+    ret = send_at_cmd(sim7080g_handle, &AT_CFUN, AT_CMD_TYPE_WRITE, "1", response, sizeof(response), 10000);
     if (ret != ESP_OK)
     {
-        ESP_LOGE(TAG, "Failed to send MQTT connect command");
+        ESP_LOGE(TAG, "Failed to send CFUN=1 command");
         return ret;
     }
+    xEventGroupSetBits(ctx->status_events, SIM7080G_EVT_FUNCTIONAL);
 
-    // Check for error responses
-    if (strstr(response, "ERROR") != NULL)
+    // Ready once "+CPIN: READY" and "SMS Ready" are in - if the SIM URC is missed an AT+CPIN? probe stands in for it,
+    // and if "SMS Ready" never comes the SIM being ready is enough after a grace period
+    const EventBits_t ready = SIM7080G_EVT_SIM_READY | SIM7080G_EVT_SMS_READY;
+    int64_t sim_ready_at = 0;
+    while (true)
     {
-        // Extract error code if present
-        char *error_start = strstr(response, "+CME ERROR:");
-        if (error_start != NULL)
+        EventBits_t bits = xEventGroupWaitBits(ctx->status_events, ready, pdFALSE, pdTRUE,
+                                               pdMS_TO_TICKS(SIM7080G_CFUN_PROBE_INTERVAL_MS));
+        int64_t now = esp_timer_get_time();
+        if ((bits & ready) == ready)
         {
-            int error_code;
-            if (sscanf(error_start, "+CME ERROR: %d", &error_code) == 1)
-            {
-                // Map error code to appropriate ESP error code and log details
-                switch (error_code)
-                {
-                case MQTT_ERR_NETWORK:
-                    ESP_LOGE(TAG, "MQTT connection failed: Network error");
-                    return MQTT_ERR_NETWORK;
-
-                case MQTT_ERR_PROTOCOL:
-                    ESP_LOGE(TAG, "MQTT connection failed: Protocol error");
-                    return MQTT_ERR_PROTOCOL;
-
-                case MQTT_ERR_UNAVAILABLE:
-                    ESP_LOGE(TAG, "MQTT connection failed: Broker unavailable");
-                    return ESP_ERR_NOT_FOUND;
-
-                case MQTT_ERR_TIMEOUT:
-                    ESP_LOGE(TAG, "MQTT connection failed: Connection timeout");
-                    return ESP_ERR_TIMEOUT;
-
-                case MQTT_ERR_REJECTED:
-                    ESP_LOGE(TAG, "MQTT connection failed: Connection rejected by broker");
-                    return ESP_ERR_INVALID_STATE;
+            break;
+        }
 
-                default:
-                    ESP_LOGE(TAG, "MQTT connection failed with unknown error code: %d",
-                             error_code);
-                    return ESP_FAIL;
-                }
+        if ((bits & SIM7080G_EVT_SIM_READY) == 0)
+        {
+            memset(response, 0, sizeof(response));
+            sim7080g_cpin_reply_t cpin = {0};
+            if (send_at_cmd(sim7080g_handle, &AT_CPIN, AT_CMD_TYPE_READ, NULL, response, sizeof(response), 1000) == ESP_OK &&
+                sim7080g_decode(SIM7080G_DECODER_CPIN, response, &cpin) == 1 && strcmp(cpin.code, "READY") == 0)
+            {
+                xEventGroupSetBits(ctx->status_events, SIM7080G_EVT_SIM_READY);
+                bits |= SIM7080G_EVT_SIM_READY;
             }
         }
-        ESP_LOGE(TAG, "MQTT connection failed with unspecified error: %s", response);
-        return ESP_FAIL;
+        if ((bits & SIM7080G_EVT_SIM_READY) != 0)
+        {
+            sim_ready_at = (sim_ready_at == 0) ? now : sim_ready_at;
+            if (now - sim_ready_at >= (int64_t)SIM7080G_SMS_READY_GRACE_MS * 1000)
+            {
+                ESP_LOGW(TAG, "No 'SMS Ready' after the SIM was ready - continuing");
+                break;
+            }
+        }
+
+        if (now - start >= (int64_t)SIM7080G_CFUN_READY_TIMEOUT_MS * 1000)
+        {
+            ESP_LOGE(TAG, "Device not ready %d ms after CFUN cycle", SIM7080G_CFUN_READY_TIMEOUT_MS);
+            return ESP_ERR_TIMEOUT;
+        }
     }
 
-    // Verify successful connection
-    if (strstr(response, "OK") != NULL)
+    uint32_t recovery_ms = (uint32_t)((esp_timer_get_time() - start) / 1000);
+    ESP_LOGI(TAG, "CFUN cycle done - device ready after %lu ms", (unsigned long)recovery_ms);
+    if (recovery_ms_out != NULL)
+    {
+        *recovery_ms_out = recovery_ms;
+    }
+    return ESP_OK;
+}
+
+// TODO -
+// esp_err_t sim7080g_get_cfun(const sim7080g_handle_t *sim7080g_handle)
+// {
+//     if (!sim7080g_handle)
+//     {
+//         ESP_LOGE(TAG, "Invalid parameters");
+//         return ESP_ERR_INVALID_ARG;
+//     }
+//     ESP_LOGI(TAG, "Sending get CFUN cmd");
+// }
+
+esp_err_t sim7080g_app_network_deactivate(const sim7080g_handle_t *sim7080g_handle)
+{
+    if (!sim7080g_handle)
+    {
+        ESP_LOGE(TAG, "Invalid parameters");
+        return ESP_ERR_INVALID_ARG;
+    }
+    ESP_LOGI(TAG, "Sending app network deactivate cmd");
+
+    for (int i = 0; i < 3; i++)
+    {
+        /// Loops becasue the send at cmd fxn might get an OK - but the device might remain active
+        char response[AT_RESPONSE_MAX_LEN] = {0};
+        esp_err_t ret = send_at_cmd_expect(sim7080g_handle, &AT_CNACT, AT_CMD_TYPE_WRITE, "0,0", "+APP PDP: 0,", response, sizeof(response), 15000);
+        if (ret == ESP_OK)
+        {
+            if (strstr(response, "+APP PDP: 0,DEACTIVE") != NULL)
+            {
+                ESP_LOGI(TAG, "Network deactivated successfully");
+                return ESP_OK;
+            }
+        }
+    }
+    ESP_LOGE(TAG, "Failed to deactivate network");
+    return ESP_FAIL;
+}
+
+bool sim7080g_cnact_status_active(int status)
+{
+    return status == 1 || status == 2;
+}
+
+esp_err_t sim7080g_get_app_network_active(const sim7080g_handle_t *sim7080g_handle,
+                                          int pdpidx,
+                                          int *status,
+                                          char *address,
+                                          int address_len)
+{
+    if (!sim7080g_handle || !status || !address || address_len <= 0)
+    {
+        ESP_LOGE(TAG, "Invalid parameters");
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    if (pdpidx < 0 || pdpidx > 3)
+    {
+        ESP_LOGE(TAG, "Invalid PDP context index: %d", pdpidx);
+        return ESP_ERR_INVALID_ARG;
+    }
+    // ESP_LOGI(TAG, "Reading network status for PDP context %d", pdpidx);
+
+    // Initialize output parameters
+    *status = 0;
+    memset(address, 0, address_len);
+
+    char response[256] = {0};
+    esp_err_t ret = send_at_cmd_cached(sim7080g_handle,
+                                       &AT_CNACT,
+                                       AT_CMD_TYPE_READ,
+                                       response,
+                                       sizeof(response),
+                                       20000);
+
+    if (ret == ESP_OK)
+    {
+        at_parser_t parser;
+        at_parser_init(&parser, response, strlen(response));
+        bool found_context = false;
+
+        // Process each CNACT response line (there may be multiple contexts)
+        sim7080g_cnact_reply_t reply;
+        int decoded;
+        while ((decoded = at_decoder_next(&sim7080g_decoders[SIM7080G_DECODER_CNACT], &parser, &reply)) >= 0)
+        {
+            int parsed_idx = reply.pdpidx;
+            int parsed_status = reply.status;
+
+            // At minimum need index and status - the address is optional
+            if (decoded >= 2)
+            {
+                bool has_addr = decoded == 3;
+
+                if (parsed_idx == pdpidx)
+                {
+                    // Found our target PDP context
+                    found_context = true;
+
+                    // Validate status value
+                    if (parsed_status < 0 || parsed_status > 2)
+                    {
+                        ESP_LOGE(TAG, "Invalid status value: %d", parsed_status);
+                        return ESP_ERR_INVALID_RESPONSE;
+                    }
+
+                    // Store status
+                    *status = parsed_status;
+
+                    // If we have an IP address, store it
+                    if (has_addr && parsed_status > 0)
+                    {
+                        if (strlen(reply.address) >= (size_t)address_len)
+                        {
+                            ESP_LOGE(TAG, "IP address buffer too small");
+                            return ESP_ERR_INVALID_SIZE;
+                        }
+                        strcpy(address, reply.address);
+                    }
+
+                    // Log the status
+                    const char *status_str[] = {
+                        "Deactivated",
+                        "Activated",
+                        "In Operation"};
+                    ESP_LOGI(TAG, "PDP Context %d: %s, IP: %s",
+                             pdpidx,
+                             status_str[parsed_status],
+                             (parsed_status > 0) ? address : "None");
+
+                    return ESP_OK;
+                }
+            }
+            else
+            {
+                ESP_LOGW(TAG, "Failed to parse CNACT response line (%d fields decoded)", decoded);
+            }
+        }
+
+        if (!found_context)
+        {
+            ESP_LOGW(TAG, "PDP context %d not found in response", pdpidx);
+            return ESP_ERR_NOT_FOUND;
+        }
+    }
+    else
+    {
+        ESP_LOGE(TAG, "Failed to read network status");
+    }
+
+    return ret;
+}
+
+esp_err_t sim7080g_wait_for_registration(const sim7080g_handle_t *sim7080g_handle,
+                                         uint32_t timeout_ms,
+                                         sim7080g_registration_t *registration_out)
+{
+    if (!sim7080g_handle)
+    {
+        ESP_LOGE(TAG, "Invalid parameters");
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    if (!sim7080g_handle->uart_initialized || sim7080g_handle->ctx == NULL)
+    {
+        ESP_LOGE(TAG, "SIM7080G driver not initialized");
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    sim7080g_ctx_t *ctx = sim7080g_handle->ctx;
+    int64_t start = esp_timer_get_time();
+
+    char response[AT_RESPONSE_MAX_LEN] = {0};
+    esp_err_t err = send_at_cmd(sim7080g_handle, &AT_CEREG, AT_CMD_TYPE_WRITE, "2", response, sizeof(response), 5000);
+    if (err != ESP_OK)
+    {
+        ESP_LOGE(TAG, "Failed to enable registration reporting: %s", esp_err_to_name(err));
+        return err;
+    }
+
+    // A URC only reports a change - read where things stand now, in case the device registered before reporting was on
+    xSemaphoreTake(ctx->urc_lock, portMAX_DELAY);
+    uint32_t reports_before = ctx->registration_reports;
+    xSemaphoreGive(ctx->urc_lock);
+
+    memset(response, 0, sizeof(response));
+    err = send_at_cmd(sim7080g_handle, &AT_CEREG, AT_CMD_TYPE_READ, NULL, response, sizeof(response), 5000);
+    if (err != ESP_OK)
+    {
+        ESP_LOGE(TAG, "Network registration status check failed: %s", esp_err_to_name(err));
+        return err;
+    }
+
+    int n;
+    sim7080g_registration_t registration;
+    at_parser_t parser;
+    at_parser_t fields;
+    at_parser_init(&parser, response, strlen(response));
+    if (!at_parser_find_line(&parser, "+CEREG:", &fields) || !at_parser_int(&fields, &n) ||
+        !sim7080g_parse_cereg(&fields, &registration))
+    {
+        ESP_LOGE(TAG, "Failed to parse network registration status: %s", response);
+        return ESP_ERR_INVALID_RESPONSE;
+    }
+
+    // A URC that came in meanwhile is at least as recent as the read - do not overwrite it
+    xSemaphoreTake(ctx->urc_lock, portMAX_DELAY);
+    if (ctx->registration_reports == reports_before)
+    {
+        sim7080g_registration_update(ctx, &registration);
+    }
+    xSemaphoreGive(ctx->urc_lock);
+
+    uint32_t elapsed_ms = (uint32_t)((esp_timer_get_time() - start) / 1000);
+    TickType_t wait = (elapsed_ms < timeout_ms) ? pdMS_TO_TICKS(timeout_ms - elapsed_ms) : 0;
+    EventBits_t bits = xEventGroupWaitBits(ctx->status_events, SIM7080G_EVT_REGISTERED, pdFALSE, pdTRUE, wait);
+
+    xSemaphoreTake(ctx->urc_lock, portMAX_DELAY);
+    registration = ctx->registration;
+    xSemaphoreGive(ctx->urc_lock);
+    registration.wait_ms = (uint32_t)((esp_timer_get_time() - start) / 1000);
+    if (registration_out != NULL)
+    {
+        *registration_out = registration;
+    }
+
+    if ((bits & SIM7080G_EVT_REGISTERED) == 0)
+    {
+        ESP_LOGW(TAG, "Not registered after %lu ms (status %d)", (unsigned long)registration.wait_ms, registration.stat);
+        return ESP_ERR_TIMEOUT;
+    }
+
+    ESP_LOGI(TAG, "Registered (%s) after %lu ms - TAC %04X, cell %08lX",
+             registration.stat == 1 ? "home network" : "roaming",
+             (unsigned long)registration.wait_ms, registration.tac, (unsigned long)registration.cell_id);
+    return ESP_OK;
+}
+
+esp_err_t sim7080g_connect_to_network_bearer(const sim7080g_handle_t *sim7080g_handle, const char *apn)
+{
+    if (!sim7080g_handle || !apn)
+    {
+        ESP_LOGE(TAG, "Invalid parameters");
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    ESP_LOGI(TAG, "Beginning sequence of AT commands to connect to sim7080g to network bearer");
+
+    // The status queries are answered in one exchange rather than one round trip each
+    char cpin_response[64];
+    char csq_response[64];
+    char cgatt_response[64];
+    char cops_response[AT_RESPONSE_MAX_LEN];
+    sim7080g_at_batch_entry_t preflight[] = {
+        {.cmd = &AT_CPIN, .type = AT_CMD_TYPE_READ, .response = cpin_response, .response_size = sizeof(cpin_response)},
+        {.cmd = &AT_CSQ, .type = AT_CMD_TYPE_EXECUTE, .response = csq_response, .response_size = sizeof(csq_response)},
+        {.cmd = &AT_CGATT, .type = AT_CMD_TYPE_READ, .response = cgatt_response, .response_size = sizeof(cgatt_response)},
+        {.cmd = &AT_COPS, .type = AT_CMD_TYPE_READ, .response = cops_response, .response_size = sizeof(cops_response)},
+    };
+    esp_err_t err = sim7080g_send_at_batch_cached(sim7080g_handle, preflight, sizeof(preflight) / sizeof(preflight[0]), 15000);
+    if (preflight[0].result != ESP_OK)
+    {
+        ESP_LOGE(TAG, "Error checking SIM status: %s", esp_err_to_name(preflight[0].result));
+        return preflight[0].result;
+    }
+
+    err = sim7080g_parse_sim_status(cpin_response);
+    if (err != ESP_OK)
+    {
+        ESP_LOGE(TAG, "Error checking SIM status: %s", esp_err_to_name(err));
+        return err;
+    }
+
+    int8_t rssi;
+    uint8_t ber;
+    err = preflight[1].result;
+    if (err == ESP_OK)
+    {
+        err = sim7080g_parse_signal_quality(csq_response, &rssi, &ber);
+    }
+    if (err != ESP_OK)
+    {
+        ESP_LOGE(TAG, "Error checking signal quality: %s", esp_err_to_name(err));
+        return err;
+    }
+    else
+    {
+        if (rssi <= 0)
+        {
+            ESP_LOGE(TAG, "Signal quality is too low (-115dBm or less) to connect to network");
+            return ESP_FAIL;
+        }
+        if (rssi == 99)
+        {
+            ESP_LOGE(TAG, "Signal quality is unknown or not detectable");
+            return ESP_FAIL;
+        }
+    }
+
+    bool attached;
+    err = preflight[2].result;
+    if (err == ESP_OK)
+    {
+        err = sim7080g_parse_gprs_attach_status(cgatt_response, &attached);
+    }
+    if (err != ESP_OK)
+    {
+        ESP_LOGE(TAG, "Error checking GPRS attach status: %s", esp_err_to_name(err));
+        return err;
+    }
+
+    int operator_code;
+    int operator_format;
+    char operator_name[32];
+    err = preflight[3].result;
+    if (err == ESP_OK)
+    {
+        err = sim7080g_parse_operator_info(cops_response, &operator_code, &operator_format, operator_name, sizeof(operator_name));
+    }
+    if (err != ESP_OK)
+    {
+        ESP_LOGE(TAG, "Error getting operator info: %s", esp_err_to_name(err));
+        return err;
+    }
+
+    char current_apn[32];
+    int apn_len = sizeof(current_apn);
+    err = sim7080g_get_apn(sim7080g_handle, current_apn, apn_len);
+    if (err != ESP_OK)
+    {
+        ESP_LOGE(TAG, "Error getting APN: %s", esp_err_to_name(err));
+        return err;
+    }
+
+    err = sim7080g_set_apn(sim7080g_handle, apn);
+    if (err != ESP_OK)
+    {
+        ESP_LOGE(TAG, "Error setting APN: %s", esp_err_to_name(err));
+        return err;
+    }
+
+    err = sim7080g_app_network_activate(sim7080g_handle);
+    if (err != ESP_OK)
+    {
+        ESP_LOGE(TAG, "Error activating network: %s", esp_err_to_name(err));
+        return err;
+    }
+
+    int pdpdix = 0;
+    int status;
+    char address[32];
+    int address_len = sizeof(address);
+    err = sim7080g_get_app_network_active(sim7080g_handle, pdpdix, &status, address, address_len);
+    if (err != ESP_OK)
+    {
+        ESP_LOGE(TAG, "Error getting network active status: %s", esp_err_to_name(err));
+        return err;
+    }
+    if (status <= 0) // 1 - connected, 2 - in operation
+    {
+        ESP_LOGE(TAG, "Network bearer not connected");
+        return ESP_FAIL;
+    }
+
+    // TODO DEBUG THIS - Somehow this can be reached when the network is not actually connected
+    ESP_LOGI(TAG, "Network bearer connected successfully");
+    return ESP_OK;
+}
+
+esp_err_t sim7080g_mqtt_set_parameters(const sim7080g_handle_t *sim7080g_handle)
+{
+    if (!sim7080g_handle)
+    {
+        ESP_LOGE(TAG, "Invalid device handle");
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    ESP_LOGI(TAG, "Beginning sequence of AT commands to set MQTT parameters on sim7080g to match driver handle config");
+
+    esp_err_t ret = ESP_OK;
+
+    // Log configuration parameters for debugging
+    ESP_LOGI(TAG, "Configuring MQTT with parameters:");
+    ESP_LOGI(TAG, "  URL: %s", sim7080g_handle->mqtt_config.broker_url);
+    ESP_LOGI(TAG, "  Port: %d", sim7080g_handle->mqtt_config.port);
+    ESP_LOGI(TAG, "  Client ID: %s", sim7080g_handle->mqtt_config.client_id);
+    ESP_LOGI(TAG, "  Username: %s", sim7080g_handle->mqtt_config.username);
+
+    char cmd[AT_CMD_MAX_LEN] = {0};
+    char response[AT_RESPONSE_MAX_LEN] = {0};
+
+    // Configure URL and port
+    if (snprintf(cmd, sizeof(cmd), "\"URL\",\"%s\",%d",
+                 sim7080g_handle->mqtt_config.broker_url,
+                 sim7080g_handle->mqtt_config.port) >= sizeof(cmd))
+    {
+        ESP_LOGE(TAG, "URL command string too long");
+        return ESP_ERR_INVALID_SIZE;
+    }
+
+    ESP_LOGI(TAG, "Setting MQTT URL");
+    ret = send_at_cmd(sim7080g_handle,
+                      &AT_SMCONF,
+                      AT_CMD_TYPE_WRITE,
+                      cmd,
+                      response,
+                      sizeof(response),
+                      5000);
+    if (ret != ESP_OK)
+    {
+        ESP_LOGE(TAG, "Failed to set MQTT URL");
+        return ret;
+    }
+
+    // Configure Client ID
+    if (snprintf(cmd, sizeof(cmd), "\"CLIENTID\",\"%s\"",
+                 sim7080g_handle->mqtt_config.client_id) >= sizeof(cmd))
+    {
+        ESP_LOGE(TAG, "Client ID command string too long");
+        return ESP_ERR_INVALID_SIZE;
+    }
+
+    ESP_LOGI(TAG, "Setting MQTT Client ID");
+    ret = send_at_cmd(sim7080g_handle,
+                      &AT_SMCONF,
+                      AT_CMD_TYPE_WRITE,
+                      cmd,
+                      response,
+                      sizeof(response),
+                      5000);
+    if (ret != ESP_OK)
+    {
+        ESP_LOGE(TAG, "Failed to set MQTT Client ID");
+        return ret;
+    }
+
+    // Configure Username
+    if (snprintf(cmd, sizeof(cmd), "\"USERNAME\",\"%s\"",
+                 sim7080g_handle->mqtt_config.username) >= sizeof(cmd))
+    {
+        ESP_LOGE(TAG, "Username command string too long");
+        return ESP_ERR_INVALID_SIZE;
+    }
+
+    ESP_LOGI(TAG, "Setting MQTT Username");
+    ret = send_at_cmd(sim7080g_handle,
+                      &AT_SMCONF,
+                      AT_CMD_TYPE_WRITE,
+                      cmd,
+                      response,
+                      sizeof(response),
+                      5000);
+    if (ret != ESP_OK)
+    {
+        ESP_LOGE(TAG, "Failed to set MQTT Username");
+        return ret;
+    }
+
+    // Configure Password
+    if (snprintf(cmd, sizeof(cmd), "\"PASSWORD\",\"%s\"",
+                 sim7080g_handle->mqtt_config.client_password) >= sizeof(cmd))
+    {
+        ESP_LOGE(TAG, "Password command string too long");
+        return ESP_ERR_INVALID_SIZE;
+    }
+
+    ESP_LOGI(TAG, "Setting MQTT Password");
+    ret = send_at_cmd(sim7080g_handle,
+                      &AT_SMCONF,
+                      AT_CMD_TYPE_WRITE,
+                      cmd,
+                      response,
+                      sizeof(response),
+                      5000);
+    if (ret != ESP_OK)
+    {
+        ESP_LOGE(TAG, "Failed to set MQTT Password");
+        return ret;
+    }
+
+    // Set additional MQTT parameters with default values
+    const struct
+    {
+        const char *param;
+        const char *value;
+    } default_params[] = {
+        {"KEEPTIME", "60"}, // 60 second keepalive
+        {"CLEANSS", "1"},   // Clean session enabled
+        {"QOS", "0"},       // QoS 1 default
+        {"RETAIN", "0"},    // Don't retain messages
+        {"SUBHEX", sim7080g_handle->mqtt_config.binary_downlink ? "1" : "0"}, // 1 = received messages arrive hex encoded
+        {"ASYNCMODE", sim7080g_handle->mqtt_config.async_publish ? "1" : "0"} // 1 = publishes return once sent, acks come as URCs
+    };
+
+    for (size_t i = 0; i < sizeof(default_params) / sizeof(default_params[0]); i++)
+    {
+        if (snprintf(cmd, sizeof(cmd), "\"%s\",\"%s\"",
+                     default_params[i].param,
+                     default_params[i].value) >= sizeof(cmd))
+        {
+            ESP_LOGE(TAG, "Default parameter command string too long");
+            return ESP_ERR_INVALID_SIZE;
+        }
+
+        ESP_LOGI(TAG, "Setting MQTT %s=%s", default_params[i].param, default_params[i].value);
+        ret = send_at_cmd(sim7080g_handle,
+                          &AT_SMCONF,
+                          AT_CMD_TYPE_WRITE,
+                          cmd,
+                          response,
+                          sizeof(response),
+                          5000);
+        if (ret != ESP_OK)
+        {
+            ESP_LOGE(TAG, "Failed to set MQTT %s", default_params[i].param);
+            return ret;
+        }
+    }
+
+    sim7080g_handle->ctx->async_publish = sim7080g_handle->mqtt_config.async_publish;
+    sim7080g_handle->ctx->sub_hex = sim7080g_handle->mqtt_config.binary_downlink;
+
+    ESP_LOGI(TAG, "MQTT setting sim7080g device params successful");
+    return ESP_OK;
+}
+
+esp_err_t sim7080g_mqtt_connect_to_broker(const sim7080g_handle_t *sim7080g_handle)
+{
+    if (!sim7080g_handle)
+    {
+        ESP_LOGE(TAG, "Invalid device handle");
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    sim7080g_mqtt_connection_status_t curr_status;
+    esp_err_t ret = sim7080g_mqtt_get_broker_connection_status(sim7080g_handle, &curr_status);
+    if (ret != ESP_OK)
+    {
+        ESP_LOGE(TAG, "Failed to check current connection status");
+        return ret;
+    }
+
+    if (curr_status != MQTT_STATUS_DISCONNECTED)
+    {
+        ESP_LOGI(TAG, "MQTT broker already connected");
+        return ESP_OK;
+    }
+
+    // Verify network broker connected before attempting MQTT connect
+    int pdpidx = 0;
+    int status;
+    char address[32];
+    ret = sim7080g_get_app_network_active(sim7080g_handle, pdpidx, &status, address, sizeof(address));
+    if (ret != ESP_OK)
+    {
+        ESP_LOGE(TAG, "Failed to get network active status");
+        return ret;
+    }
+    if (status <= 0)
+    {
+        ESP_LOGE(TAG, "Network bearer not connected");
+        return ESP_FAIL;
+    }
+
+    ESP_LOGI(TAG, "Attempting to connect to MQTT broker");
+
+    char response[AT_RESPONSE_MAX_LEN] = {0};
+    ret = send_at_cmd(sim7080g_handle,
+                      &AT_SMCONN,
+                      AT_CMD_TYPE_EXECUTE,
+                      NULL,
+                      response,
+                      sizeof(response),
+                      15000); // 15 second timeout for connection
+
+    if (ret != ESP_OK)
+    {
+        ESP_LOGE(TAG, "Failed to send MQTT connect command");
+        return ret;
+    }
+
+    // Check for error responses
+    if (strstr(response, "ERROR") != NULL)
+    {
+        // Extract error code if present
+        char *error_start = strstr(response, "+CME ERROR:");
+        if (error_start != NULL)
+        {
+            int error_code;
+            if (sscanf(error_start, "+CME ERROR: %d", &error_code) == 1)
+            {
+                // Map error code to appropriate ESP error code and log details
+                switch (error_code)
+                {
+                case MQTT_ERR_NETWORK:
+                    ESP_LOGE(TAG, "MQTT connection failed: Network error");
+                    return MQTT_ERR_NETWORK;
+
+                case MQTT_ERR_PROTOCOL:
+                    ESP_LOGE(TAG, "MQTT connection failed: Protocol error");
+                    return MQTT_ERR_PROTOCOL;
+
+                case MQTT_ERR_UNAVAILABLE:
+                    ESP_LOGE(TAG, "MQTT connection failed: Broker unavailable");
+                    return ESP_ERR_NOT_FOUND;
+
+                case MQTT_ERR_TIMEOUT:
+                    ESP_LOGE(TAG, "MQTT connection failed: Connection timeout");
+                    return ESP_ERR_TIMEOUT;
+
+                case MQTT_ERR_REJECTED:
+                    ESP_LOGE(TAG, "MQTT connection failed: Connection rejected by broker");
+                    return ESP_ERR_INVALID_STATE;
+
+                default:
+                    ESP_LOGE(TAG, "MQTT connection failed with unknown error code: %d",
+                             error_code);
+                    return ESP_FAIL;
+                }
+            }
+        }
+        ESP_LOGE(TAG, "MQTT connection failed with unspecified error: %s", response);
+        return ESP_FAIL;
+    }
+
+    // Verify successful connection
+    if (strstr(response, "OK") != NULL)
     {
         // Double check connection status
         ret = sim7080g_mqtt_get_broker_connection_status(sim7080g_handle, &curr_status);
         if (ret == ESP_OK && curr_status != MQTT_STATUS_DISCONNECTED)
         {
-            ESP_LOGI(TAG, "Successfully connected to MQTT broker");
-            return ESP_OK;
+            ESP_LOGI(TAG, "Successfully connected to MQTT broker");
+            return ESP_OK;
+        }
+        else
+        {
+            ESP_LOGE(TAG, "Got OK but connection status check failed");
+            return ESP_ERR_INVALID_STATE;
+        }
+    }
+
+    ESP_LOGE(TAG, "Unexpected response from MQTT connect command: %s", response);
+    return ESP_ERR_INVALID_RESPONSE;
+}
+
+esp_err_t sim7080g_mqtt_get_broker_connection_status(
+    const sim7080g_handle_t *sim7080g_handle,
+    sim7080g_mqtt_connection_status_t *status_out)
+{
+    if (!sim7080g_handle || !status_out)
+    {
+        ESP_LOGE(TAG, "Invalid parameters");
+        return ESP_ERR_INVALID_ARG;
+    }
+    ESP_LOGI(TAG, "Checking MQTT broker connection status");
+
+    *status_out = MQTT_STATUS_DISCONNECTED;
+
+    char response[AT_RESPONSE_MAX_LEN] = {0};
+    esp_err_t ret = send_at_cmd_cached(sim7080g_handle,
+                                       &AT_SMSTATE,
+                                       AT_CMD_TYPE_READ,
+                                       response,
+                                       sizeof(response),
+                                       5000);
+
+    if (ret == ESP_OK)
+    {
+        // Look for the "+SMSTATE:" response line
+        sim7080g_int_reply_t reply;
+        int decoded = sim7080g_decode(SIM7080G_DECODER_SMSTATE, response, &reply);
+        if (decoded >= 0)
+        {
+            int raw_status = reply.value;
+            if (decoded == 1)
+            {
+                // Validate status value
+                if (raw_status < 0 || raw_status > 2)
+                {
+                    ESP_LOGE(TAG, "Invalid MQTT status value: %d", raw_status);
+                    return ESP_ERR_INVALID_RESPONSE;
+                }
+
+                // Store status in output parameter
+                *status_out = (sim7080g_mqtt_connection_status_t)raw_status;
+
+                static const char *const status_str[] = {
+                    "Disconnected",
+                    "Connected",
+                    "Connected (Session Present)"};
+
+                ESP_LOGI(TAG, "MQTT Broker Status: %s", status_str[raw_status]);
+
+                return ESP_OK;
+            }
+            else
+            {
+                ESP_LOGE(TAG, "Failed to parse MQTT status number");
+                return ESP_ERR_INVALID_RESPONSE;
+            }
+        }
+        else
+        {
+            ESP_LOGE(TAG, "No SMSTATE response found in: %s", response);
+            return ESP_ERR_INVALID_RESPONSE;
+        }
+    }
+
+    ESP_LOGE(TAG, "Failed to check MQTT broker connection status: %d", ret);
+    return ret;
+}
+
+esp_err_t sim7080g_mqtt_publish(const sim7080g_handle_t *sim7080g_handle,
+                                const char *topic,
+                                const char *message,
+                                uint8_t qos,
+                                bool retain)
+{
+    if (!message)
+    {
+        ESP_LOGE(TAG, "Invalid parameters");
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    sim7080g_iovec_t iov = {.base = message, .len = strlen(message)};
+    return sim7080g_mqtt_publish_iov(sim7080g_handle, topic, &iov, 1, qos, retain);
+}
+
+esp_err_t sim7080g_mqtt_publish_iov(const sim7080g_handle_t *sim7080g_handle,
+                                    const char *topic,
+                                    const sim7080g_iovec_t *iov,
+                                    size_t iov_count,
+                                    uint8_t qos,
+                                    bool retain)
+{
+    if (!iov && iov_count > 0)
+    {
+        ESP_LOGE(TAG, "Invalid parameters");
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    size_t message_len = 0;
+    for (size_t i = 0; i < iov_count; i++)
+    {
+        if (!iov[i].base && iov[i].len > 0)
+        {
+            ESP_LOGE(TAG, "Invalid parameters: payload segment %zu has no buffer", i);
+            return ESP_ERR_INVALID_ARG;
+        }
+        message_len += iov[i].len;
+    }
+
+    esp_err_t err = sim7080g_mqtt_publish_check_args(sim7080g_handle, topic, message_len, qos);
+    if (err != ESP_OK)
+    {
+        return err;
+    }
+
+    sim7080g_ctx_t *ctx = sim7080g_handle->ctx;
+    if (ctx->async_publish && qos > 0)
+    {
+        // In ASYNCMODE the device answers before the broker has acked - so wait on this publish's own window entry.
+        // Going through the window also keeps its ack from being taken for a pipelined publish's.
+        sim7080g_publish_waiter_t waiter;
+        err = sim7080g_publish_waiter_init(ctx, &waiter);
+        if (err != ESP_OK)
+        {
+            return err;
+        }
+        err = sim7080g_mqtt_publish_pipelined(sim7080g_handle, topic, iov, iov_count, qos, retain,
+                                              sim7080g_publish_waiter_cb, &waiter, SIM7080G_MQTT_INFLIGHT_TIMEOUT_MS, NULL);
+        esp_err_t acked = sim7080g_publish_waiter_wait(&waiter, err == ESP_OK ? 1 : 0);
+        return err != ESP_OK ? err : acked;
+    }
+
+    // The prompt and the payload must reach the device back to back - so the whole publish is one arbiter request
+    sim7080g_mqtt_publish_args_t args = {
+        .topic = topic,
+        .iov = iov,
+        .iov_count = iov_count,
+        .message_len = message_len,
+        .qos = qos,
+        .retain = retain,
+    };
+    return sim7080g_arbiter_call(sim7080g_handle,
+                                 sim7080g_mqtt_publish_fn,
+                                 &args,
+                                 SIM7080G_CMD_PRIORITY_NORMAL,
+                                 SIM7080G_ARBITER_DEFAULT_DEADLINE_MS);
+}
+
+esp_err_t sim7080g_mqtt_publish_large(const sim7080g_handle_t *sim7080g_handle,
+                                      const char *topic,
+                                      const void *payload,
+                                      size_t payload_len,
+                                      uint8_t qos,
+                                      uint16_t *msg_id_out)
+{
+    if (!payload)
+    {
+        ESP_LOGE(TAG, "Invalid parameters");
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    // No chunk is over the publish limit - so check the args as for the first chunk
+    size_t first_chunk_len = payload_len < SIM7080G_MQTT_MAX_PAYLOAD_LEN ? payload_len : SIM7080G_MQTT_MAX_PAYLOAD_LEN;
+    esp_err_t err = sim7080g_mqtt_publish_check_args(sim7080g_handle, topic, first_chunk_len, qos);
+    if (err != ESP_OK)
+    {
+        return err;
+    }
+    if (payload_len > (size_t)SIM7080G_MQTT_CHUNK_DATA_MAX_LEN * UINT16_MAX)
+    {
+        ESP_LOGE(TAG, "Message of %zu bytes needs more than %d chunks", payload_len, UINT16_MAX);
+        return ESP_ERR_INVALID_SIZE;
+    }
+
+    sim7080g_ctx_t *ctx = sim7080g_handle->ctx;
+    sim7080g_mqtt_publish_large_args_t args = {
+        .topic = topic,
+        .payload = (const uint8_t *)payload,
+        .payload_len = payload_len,
+        .qos = qos,
+        .msg_id = sim7080g_chunk_next_msg_id(ctx),
+    };
+    if (msg_id_out != NULL)
+    {
+        *msg_id_out = args.msg_id;
+    }
+
+    if (!ctx->async_publish || qos == 0)
+    {
+        return sim7080g_arbiter_call(sim7080g_handle,
+                                     sim7080g_mqtt_publish_large_fn,
+                                     &args,
+                                     SIM7080G_CMD_PRIORITY_NORMAL,
+                                     SIM7080G_ARBITER_DEFAULT_DEADLINE_MS);
+    }
+
+    // ASYNCMODE - every chunk takes a window entry, reserved here rather than on the arbiter task, so each is its own request
+    sim7080g_publish_waiter_t waiter;
+    err = sim7080g_publish_waiter_init(ctx, &waiter);
+    if (err != ESP_OK)
+    {
+        return err;
+    }
+    const uint16_t total = sim7080g_chunk_count(payload_len);
+    uint32_t tracked = 0;
+    for (uint16_t index = 0; index < total && err == ESP_OK; index++)
+    {
+        uint8_t header[SIM7080G_MQTT_CHUNK_HEADER_LEN];
+        sim7080g_iovec_t iov[2];
+        sim7080g_chunk_build(&args, index, total, header, iov);
+        err = sim7080g_mqtt_publish_pipelined(sim7080g_handle, topic, iov, 2, qos, false, sim7080g_publish_waiter_cb, &waiter,
+                                              SIM7080G_MQTT_INFLIGHT_TIMEOUT_MS, NULL);
+        if (err != ESP_OK)
+        {
+            ESP_LOGE(TAG, "Large publish %u: chunk %u of %u failed: %s", args.msg_id, index + 1, total, esp_err_to_name(err));
+            break;
+        }
+        tracked++;
+    }
+
+    // Even after a failed chunk, the ones already in the window report to waiter - so it must outlive them
+    esp_err_t acked = sim7080g_publish_waiter_wait(&waiter, tracked);
+    return err != ESP_OK ? err : acked;
+}
+
+static void sim7080g_put_le16(uint8_t *out, uint16_t value)
+{
+    out[0] = (uint8_t)value;
+    out[1] = (uint8_t)(value >> 8);
+}
+
+static void sim7080g_put_le32(uint8_t *out, uint32_t value)
+{
+    sim7080g_put_le16(out, (uint16_t)value);
+    sim7080g_put_le16(out + 2, (uint16_t)(value >> 16));
+}
+
+static uint16_t sim7080g_chunk_next_msg_id(sim7080g_ctx_t *ctx)
+{
+    xSemaphoreTake(ctx->inflight_lock, portMAX_DELAY);
+    uint16_t msg_id = ++ctx->chunk_msg_id;
+    xSemaphoreGive(ctx->inflight_lock);
+    return msg_id;
+}
+
+static uint16_t sim7080g_chunk_count(size_t payload_len)
+{
+    return (uint16_t)((payload_len + SIM7080G_MQTT_CHUNK_DATA_MAX_LEN - 1) / SIM7080G_MQTT_CHUNK_DATA_MAX_LEN);
+}
+
+/// @brief Fill in the header of chunk index and point iov at it and its slice of the caller's payload
+static void sim7080g_chunk_build(const sim7080g_mqtt_publish_large_args_t *args,
+                                 uint16_t index,
+                                 uint16_t total,
+                                 uint8_t header[SIM7080G_MQTT_CHUNK_HEADER_LEN],
+                                 sim7080g_iovec_t iov[2])
+{
+    size_t offset = (size_t)index * SIM7080G_MQTT_CHUNK_DATA_MAX_LEN;
+    size_t chunk_len = args->payload_len - offset;
+    chunk_len = chunk_len < SIM7080G_MQTT_CHUNK_DATA_MAX_LEN ? chunk_len : SIM7080G_MQTT_CHUNK_DATA_MAX_LEN;
+    const uint8_t *chunk = args->payload + offset;
+
+    sim7080g_put_le16(&header[0], args->msg_id);
+    sim7080g_put_le16(&header[2], index);
+    sim7080g_put_le16(&header[4], total);
+    sim7080g_put_le32(&header[6], esp_rom_crc32_le(0, chunk, (uint32_t)chunk_len));
+
+    iov[0] = (sim7080g_iovec_t){.base = header, .len = SIM7080G_MQTT_CHUNK_HEADER_LEN};
+    iov[1] = (sim7080g_iovec_t){.base = chunk, .len = chunk_len};
+}
+
+static esp_err_t sim7080g_mqtt_publish_large_fn(const sim7080g_handle_t *sim7080g_handle, void *arg)
+{
+    const sim7080g_mqtt_publish_large_args_t *args = (const sim7080g_mqtt_publish_large_args_t *)arg;
+    const uint16_t msg_id = args->msg_id;
+    const uint16_t total = sim7080g_chunk_count(args->payload_len);
+
+    ESP_LOGI(TAG, "Large publish %u: %zu bytes in %u chunks to topic '%s'",
+             msg_id, args->payload_len, total, args->topic);
+
+    // Each chunk is the header plus a slice of the caller's payload - the next AT+SMPUB follows the previous OK at once
+    for (uint16_t index = 0; index < total; index++)
+    {
+        uint8_t header[SIM7080G_MQTT_CHUNK_HEADER_LEN];
+        sim7080g_iovec_t iov[2];
+        sim7080g_chunk_build(args, index, total, header, iov);
+        sim7080g_mqtt_publish_args_t chunk_args = {
+            .topic = args->topic,
+            .iov = iov,
+            .iov_count = sizeof(iov) / sizeof(iov[0]),
+            .message_len = iov[0].len + iov[1].len,
+            .qos = args->qos,
+            .retain = false,
+        };
+
+        esp_err_t err = sim7080g_mqtt_publish_fn(sim7080g_handle, &chunk_args);
+        if (err != ESP_OK)
+        {
+            ESP_LOGE(TAG, "Large publish %u: chunk %u of %u failed: %s", msg_id, index + 1, total, esp_err_to_name(err));
+            return err;
+        }
+    }
+
+    ESP_LOGI(TAG, "Large publish %u: all %u chunks sent", msg_id, total);
+    return ESP_OK;
+}
+
+esp_err_t sim7080g_mqtt_publish_async(const sim7080g_handle_t *sim7080g_handle,
+                                      const char *topic,
+                                      const char *message,
+                                      uint8_t qos,
+                                      bool retain,
+                                      const sim7080g_async_opts_t *opts,
+                                      sim7080g_request_id_t *id_out)
+{
+    if (!message)
+    {
+        ESP_LOGE(TAG, "Invalid parameters");
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    sim7080g_iovec_t iov = {.base = message, .len = strlen(message)};
+    return sim7080g_mqtt_publish_iov_async(sim7080g_handle, topic, &iov, 1, qos, retain, opts, id_out);
+}
+
+esp_err_t sim7080g_mqtt_publish_iov_async(const sim7080g_handle_t *sim7080g_handle,
+                                          const char *topic,
+                                          const sim7080g_iovec_t *iov,
+                                          size_t iov_count,
+                                          uint8_t qos,
+                                          bool retain,
+                                          const sim7080g_async_opts_t *opts,
+                                          sim7080g_request_id_t *id_out)
+{
+    if (!iov && iov_count > 0)
+    {
+        ESP_LOGE(TAG, "Invalid parameters");
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    size_t message_len = 0;
+    for (size_t i = 0; i < iov_count; i++)
+    {
+        if (!iov[i].base && iov[i].len > 0)
+        {
+            ESP_LOGE(TAG, "Invalid parameters: payload segment %zu has no buffer", i);
+            return ESP_ERR_INVALID_ARG;
+        }
+        message_len += iov[i].len;
+    }
+
+    esp_err_t err = sim7080g_mqtt_publish_check_args(sim7080g_handle, topic, message_len, qos);
+    if (err != ESP_OK)
+    {
+        return err;
+    }
+
+    // The args, one joined payload segment and a copy of the topic share one allocation - freed by the driver once the publish is done
+    size_t topic_len = strlen(topic);
+    sim7080g_mqtt_publish_args_t *args = malloc(sizeof(*args) + sizeof(sim7080g_iovec_t) + topic_len + 1 + message_len);
+    if (args == NULL)
+    {
+        ESP_LOGE(TAG, "Error allocating async publish request");
+        return ESP_ERR_NO_MEM;
+    }
+    sim7080g_iovec_t *message_iov = (sim7080g_iovec_t *)(args + 1);
+    char *topic_copy = (char *)(message_iov + 1);
+    uint8_t *message_copy = (uint8_t *)topic_copy + topic_len + 1;
+    memcpy(topic_copy, topic, topic_len + 1);
+
+    size_t offset = 0;
+    for (size_t i = 0; i < iov_count; i++)
+    {
+        if (iov[i].len > 0)
+        {
+            memcpy(message_copy + offset, iov[i].base, iov[i].len);
+            offset += iov[i].len;
+        }
+    }
+    *message_iov = (sim7080g_iovec_t){.base = message_copy, .len = message_len};
+
+    *args = (sim7080g_mqtt_publish_args_t){
+        .topic = topic_copy,
+        .iov = message_iov,
+        .iov_count = 1,
+        .message_len = message_len,
+        .qos = qos,
+        .retain = retain,
+    };
+
+    return sim7080g_async_submit(sim7080g_handle, sim7080g_mqtt_publish_async_fn, args, opts, id_out);
+}
+
+static esp_err_t sim7080g_mqtt_publish_check_args(const sim7080g_handle_t *sim7080g_handle,
+                                                  const char *topic,
+                                                  size_t message_len,
+                                                  uint8_t qos)
+{
+    if (!sim7080g_handle || !topic)
+    {
+        ESP_LOGE(TAG, "Invalid parameters");
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    if (!sim7080g_handle->uart_initialized || sim7080g_handle->ctx == NULL)
+    {
+        ESP_LOGE(TAG, "SIM7080G driver not initialized");
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    if (qos > 2)
+    {
+        ESP_LOGE(TAG, "Invalid QoS value: %d", qos);
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    if (message_len == 0)
+    {
+        ESP_LOGW(TAG, "Empty message content");
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    if (message_len > SIM7080G_MQTT_MAX_PAYLOAD_LEN)
+    {
+        ESP_LOGE(TAG, "Message of %zu bytes over the %d byte publish limit - use sim7080g_mqtt_publish_large",
+                 message_len, SIM7080G_MQTT_MAX_PAYLOAD_LEN);
+        return ESP_ERR_INVALID_SIZE;
+    }
+
+    return ESP_OK;
+}
+
+static esp_err_t sim7080g_mqtt_publish_fn(const sim7080g_handle_t *sim7080g_handle, void *arg)
+{
+    return sim7080g_mqtt_publish_send(sim7080g_handle, (const sim7080g_mqtt_publish_args_t *)arg, NULL);
+}
+
+/// @param maybe_sent_out Set on failure if the device may still have sent the publish (the payload went out but no
+///                       result code came back) - may be NULL
+static esp_err_t sim7080g_mqtt_publish_send(const sim7080g_handle_t *sim7080g_handle,
+                                            const sim7080g_mqtt_publish_args_t *args,
+                                            bool *maybe_sent_out)
+{
+    bool maybe_sent_unused;
+    bool *maybe_sent = maybe_sent_out != NULL ? maybe_sent_out : &maybe_sent_unused;
+    *maybe_sent = false;
+    const char *topic = args->topic;
+    const size_t message_len = args->message_len;
+    const uint8_t qos = args->qos;
+    const bool retain = args->retain;
+
+    // First construct and send the publish command
+    char cmd[256] = {0};
+    if (snprintf(cmd, sizeof(cmd), "AT+SMPUB=\"%s\",%zu,%d,%d\r\n",
+                 topic,
+                 message_len,
+                 qos,
+                 retain ? 1 : 0) >= sizeof(cmd))
+    {
+        ESP_LOGE(TAG, "Publish command too long");
+        return ESP_ERR_INVALID_SIZE;
+    }
+
+    ESP_LOGD(TAG, "Sending MQTT publish command: %s", cmd);
+
+    // Send command and wait for '>' prompt - detected as a pattern so the payload goes out the moment it arrives
+    // (a pattern only clears the RX FIFO timeout for the prompt - lines still arrive, just a few char times later)
+    char response[AT_RESPONSE_MAX_LEN] = {0};
+    sim7080g_rx_waiter_t waiter = {
+        .buf = response,
+        .size = sizeof(response),
+        .wait_for_prompt = true,
+    };
+    sim7080g_rx_begin(sim7080g_handle, &waiter);
+    sim7080g_rx_set_pattern(sim7080g_handle->ctx, SIM7080G_RX_PROMPT_PATTERN);
+
+    int bytes_written = uart_write_bytes(sim7080g_handle->uart_config.port_num,
+                                         cmd,
+                                         strlen(cmd));
+    if (bytes_written != strlen(cmd))
+    {
+        sim7080g_rx_set_pattern(sim7080g_handle->ctx, SIM7080G_RX_LINE_PATTERN);
+        sim7080g_rx_wait(sim7080g_handle, &waiter, 0);
+        ESP_LOGE(TAG, "Failed to send complete publish command");
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    // Wait for '>' prompt with timeout
+    int bytes_read = sim7080g_rx_wait(sim7080g_handle, &waiter, 1000);
+    sim7080g_rx_set_pattern(sim7080g_handle->ctx, SIM7080G_RX_LINE_PATTERN);
+
+    if (bytes_read <= 0)
+    {
+        ESP_LOGE(TAG, "Timeout waiting for '>' prompt");
+        return ESP_ERR_TIMEOUT;
+    }
+
+    ESP_LOGD(TAG, "Response after publish command: %s", response);
+
+    if (strstr(response, ">") == NULL)
+    {
+        ESP_LOGE(TAG, "Did not receive '>' prompt");
+        return ESP_ERR_INVALID_RESPONSE;
+    }
+
+    // Now send the actual message content - each segment straight from the caller's buffer
+    ESP_LOGD(TAG, "Sending message content (length %zu bytes in %zu segments)", message_len, args->iov_count);
+
+    memset(response, 0, sizeof(response));
+    waiter = (sim7080g_rx_waiter_t){
+        .buf = response,
+        .size = sizeof(response),
+    };
+    sim7080g_rx_begin(sim7080g_handle, &waiter);
+
+    *maybe_sent = true; // From the first payload byte on, the device may act on it
+    size_t total_written = 0;
+    for (size_t i = 0; i < args->iov_count; i++)
+    {
+        if (args->iov[i].len == 0)
+        {
+            continue;
+        }
+        bytes_written = uart_write_bytes(sim7080g_handle->uart_config.port_num,
+                                         args->iov[i].base,
+                                         args->iov[i].len);
+        if (bytes_written != (int)args->iov[i].len)
+        {
+            break;
+        }
+        total_written += (size_t)bytes_written;
+    }
+    if (total_written != message_len)
+    {
+        sim7080g_rx_wait(sim7080g_handle, &waiter, 0);
+        ESP_LOGE(TAG, "Failed to send complete message content");
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    bytes_read = sim7080g_rx_wait(sim7080g_handle, &waiter, 5000);
+
+    if (bytes_read <= 0)
+    {
+        ESP_LOGE(TAG, "Timeout waiting for publish confirmation");
+        return ESP_ERR_TIMEOUT;
+    }
+
+    ESP_LOGD(TAG, "Publish response: %s", response);
+
+    if (strstr(response, "ERROR") != NULL)
+    {
+        *maybe_sent = false; // Refused outright
+        char *error_start = strstr(response, "+CME ERROR:");
+        if (error_start)
+        {
+            int error_code;
+            if (sscanf(error_start, "+CME ERROR: %d", &error_code) == 1)
+            {
+                ESP_LOGE(TAG, "Publish failed with CME ERROR: %d", error_code);
+                return ESP_ERR_INVALID_RESPONSE;
+            }
+        }
+        ESP_LOGE(TAG, "Publish failed with ERROR response");
+        return ESP_ERR_INVALID_RESPONSE;
+    }
+
+    if (strstr(response, "OK") == NULL)
+    {
+        ESP_LOGE(TAG, "Did not receive OK response");
+        return ESP_ERR_INVALID_RESPONSE;
+    }
+
+    ESP_LOGD(TAG, "Successfully published %zu bytes to topic '%s'",
+             message_len, topic);
+    return ESP_OK;
+}
+
+// ------ Pipelined publish (ASYNCMODE) ------ //
+// In ASYNCMODE the device answers AT+SMPUB once the packet is sent and reports the broker's ack later in a +SMPUB URC.
+// The URC does not carry an id the host knows, but a broker acks QoS 1/2 publishes in the order it received them
+// (MQTT 3.1.1 section 4.6) - so each ack completes the oldest publish in the window.
+
+/// @brief Move up to max entries from the head of the window to the completed ring - called with inflight_lock held
+/// @note Their window entries stay taken until sim7080g_inflight_flush has reported them, so the ring can not overflow
+static size_t sim7080g_inflight_retire_locked(sim7080g_ctx_t *ctx, size_t max, esp_err_t result)
+{
+    size_t count = (max < ctx->inflight_count) ? max : ctx->inflight_count;
+    for (size_t i = 0; i < count; i++)
+    {
+        size_t done = (ctx->inflight_done_head + ctx->inflight_done_count) % SIM7080G_MQTT_INFLIGHT_WINDOW;
+        ctx->inflight_done[done] = ctx->inflight[ctx->inflight_head];
+        ctx->inflight_done[done].result = result;
+        ctx->inflight_done_count++;
+        ctx->inflight_head = (uint8_t)((ctx->inflight_head + 1) % SIM7080G_MQTT_INFLIGHT_WINDOW);
+        ctx->inflight_count--;
+    }
+    return count;
+}
+
+/// @brief Run the callbacks of completed publishes and free their window entries
+/// @note Must be called without any driver lock held - by the RX task once it has handled what it read, and by any other
+///       task that completes publishes. Only one task runs callbacks at a time, so they run in the order the acks came.
+static void sim7080g_inflight_flush(sim7080g_ctx_t *ctx)
+{
+    xSemaphoreTake(ctx->inflight_lock, portMAX_DELAY);
+    if (ctx->inflight_flushing)
+    {
+        // The task already running callbacks picks these up before it stops
+        xSemaphoreGive(ctx->inflight_lock);
+        return;
+    }
+    ctx->inflight_flushing = true;
+    while (ctx->inflight_done_count > 0)
+    {
+        sim7080g_inflight_t entry = ctx->inflight_done[ctx->inflight_done_head];
+        ctx->inflight_done_head = (uint8_t)((ctx->inflight_done_head + 1) % SIM7080G_MQTT_INFLIGHT_WINDOW);
+        ctx->inflight_done_count--;
+        xSemaphoreGive(ctx->inflight_lock);
+
+        if (entry.callback != NULL)
+        {
+            entry.callback(entry.msg_id, entry.result, entry.user_ctx);
+        }
+        xSemaphoreGive(ctx->inflight_slots);
+
+        xSemaphoreTake(ctx->inflight_lock, portMAX_DELAY);
+    }
+    ctx->inflight_flushing = false;
+    xSemaphoreGive(ctx->inflight_lock);
+}
+
+/// @note Runs in a URC handler - the callback runs once the RX task calls sim7080g_inflight_flush
+static void sim7080g_inflight_ack(sim7080g_ctx_t *ctx, esp_err_t result)
+{
+    xSemaphoreTake(ctx->inflight_lock, portMAX_DELAY);
+    uint16_t msg_id = ctx->inflight[ctx->inflight_head].msg_id;
+    size_t count = sim7080g_inflight_retire_locked(ctx, 1, result);
+    xSemaphoreGive(ctx->inflight_lock);
+
+    if (count == 0)
+    {
+        ESP_LOGW(TAG, "Publish ack with no publish in flight - ignored");
+        return;
+    }
+    ESP_LOGD(TAG, "Publish %u %s", msg_id, result == ESP_OK ? "acked" : "failed");
+}
+
+/// @brief Take every publish off the window - callers not in a URC handler follow with sim7080g_inflight_flush
+static void sim7080g_inflight_fail_all(sim7080g_ctx_t *ctx, esp_err_t result)
+{
+    xSemaphoreTake(ctx->inflight_lock, portMAX_DELAY);
+    size_t count = sim7080g_inflight_retire_locked(ctx, SIM7080G_MQTT_INFLIGHT_WINDOW, result);
+    xSemaphoreGive(ctx->inflight_lock);
+
+    if (count > 0)
+    {
+        ESP_LOGW(TAG, "Failing %u publishes awaiting their ack: %s", (unsigned)count, esp_err_to_name(result));
+    }
+}
+
+/// @brief Fail the whole window once its oldest publish has waited too long for its ack
+/// @note Acks are matched by order - once one has gone missing the later ones can no longer be matched
+static void sim7080g_inflight_expire(sim7080g_ctx_t *ctx)
+{
+    xSemaphoreTake(ctx->inflight_lock, portMAX_DELAY);
+    bool expired = ctx->inflight_count > 0 && esp_timer_get_time() >= ctx->inflight[ctx->inflight_head].deadline_us;
+    xSemaphoreGive(ctx->inflight_lock);
+
+    if (expired)
+    {
+        sim7080g_inflight_fail_all(ctx, ESP_ERR_TIMEOUT);
+        sim7080g_inflight_flush(ctx);
+    }
+}
+
+/// @brief Take a free window entry, waiting up to wait_ms - never called on the arbiter task, which others queue behind
+static esp_err_t sim7080g_inflight_reserve(sim7080g_ctx_t *ctx, uint32_t wait_ms)
+{
+    int64_t wait_until = esp_timer_get_time() + (int64_t)wait_ms * 1000;
+    while (xSemaphoreTake(ctx->inflight_slots, 0) != pdTRUE)
+    {
+        // Window full - expire it if its oldest publish is never going to be acked
+        sim7080g_inflight_expire(ctx);
+        int64_t remaining_ms = (wait_until - esp_timer_get_time()) / 1000;
+        if (remaining_ms <= 0)
+        {
+            return ESP_ERR_TIMEOUT;
+        }
+        if (xSemaphoreTake(ctx->inflight_slots, pdMS_TO_TICKS(remaining_ms < 100 ? remaining_ms : 100)) == pdTRUE)
+        {
+            break;
+        }
+    }
+    return ESP_OK;
+}
+
+/// @brief Stop the window entries reporting to user_ctx through callback - returns how many were still waiting to
+/// @note Entries already taken off to be reported are not found - their callbacks are running or about to
+static uint32_t sim7080g_inflight_detach(sim7080g_ctx_t *ctx, sim7080g_publish_cb_t callback, void *user_ctx)
+{
+    uint32_t detached = 0;
+    xSemaphoreTake(ctx->inflight_lock, portMAX_DELAY);
+    for (size_t i = 0; i < ctx->inflight_count; i++)
+    {
+        sim7080g_inflight_t *entry = &ctx->inflight[(ctx->inflight_head + i) % SIM7080G_MQTT_INFLIGHT_WINDOW];
+        if (entry->callback == callback && entry->user_ctx == user_ctx)
+        {
+            entry->callback = NULL;
+            detached++;
+        }
+    }
+    for (size_t i = 0; i < ctx->inflight_done_count; i++)
+    {
+        sim7080g_inflight_t *entry = &ctx->inflight_done[(ctx->inflight_done_head + i) % SIM7080G_MQTT_INFLIGHT_WINDOW];
+        if (entry->callback == callback && entry->user_ctx == user_ctx)
+        {
+            entry->callback = NULL;
+            detached++;
+        }
+    }
+    xSemaphoreGive(ctx->inflight_lock);
+    return detached;
+}
+
+static uint16_t sim7080g_publish_next_msg_id(sim7080g_ctx_t *ctx)
+{
+    xSemaphoreTake(ctx->inflight_lock, portMAX_DELAY);
+    uint16_t msg_id = ++ctx->publish_msg_id;
+    if (msg_id == 0)
+    {
+        msg_id = ++ctx->publish_msg_id;
+    }
+    xSemaphoreGive(ctx->inflight_lock);
+    return msg_id;
+}
+
+static esp_err_t sim7080g_publish_waiter_init(sim7080g_ctx_t *ctx, sim7080g_publish_waiter_t *waiter)
+{
+    waiter->ctx = ctx;
+    waiter->result = ESP_OK;
+    waiter->acked = xSemaphoreCreateCounting(UINT16_MAX, 0);
+    if (waiter->acked == NULL)
+    {
+        ESP_LOGE(TAG, "Error allocating publish ack semaphore");
+        return ESP_ERR_NO_MEM;
+    }
+    return ESP_OK;
+}
+
+static void sim7080g_publish_waiter_cb(uint16_t msg_id, esp_err_t result, void *user_ctx)
+{
+    sim7080g_publish_waiter_t *waiter = (sim7080g_publish_waiter_t *)user_ctx;
+    if (result != ESP_OK)
+    {
+        xSemaphoreTake(waiter->ctx->inflight_lock, portMAX_DELAY);
+        waiter->result = (waiter->result == ESP_OK) ? result : waiter->result;
+        xSemaphoreGive(waiter->ctx->inflight_lock);
+    }
+    xSemaphoreGive(waiter->acked);
+}
+
+/// @brief Wait until count publishes have reported to waiter, then release it
+/// @note Gives up SIM7080G_MQTT_PUBLISH_WAIT_MARGIN_MS after the last ack was due - by then the window should long have
+///       expired. The publishes still outstanding are detached, so none reports to waiter once this returns.
+/// @return The first failure reported, ESP_ERR_TIMEOUT if it gave up, ESP_OK if every publish was acked
+static esp_err_t sim7080g_publish_waiter_wait(sim7080g_publish_waiter_t *waiter, uint32_t count)
+{
+    const int64_t wait_until = esp_timer_get_time() +
+                               (int64_t)(SIM7080G_MQTT_INFLIGHT_TIMEOUT_MS + SIM7080G_MQTT_PUBLISH_WAIT_MARGIN_MS) * 1000;
+    uint32_t reported = 0;
+    while (reported < count)
+    {
+        int64_t remaining_ms = (wait_until - esp_timer_get_time()) / 1000;
+        if (remaining_ms <= 0)
+        {
+            break;
+        }
+        if (xSemaphoreTake(waiter->acked, pdMS_TO_TICKS(remaining_ms < 100 ? remaining_ms : 100)) == pdTRUE)
+        {
+            reported++;
+            continue;
+        }
+        sim7080g_inflight_expire(waiter->ctx);
+    }
+
+    esp_err_t result = waiter->result;
+    if (reported < count)
+    {
+        ESP_LOGW(TAG, "Gave up waiting for %lu publish acks", (unsigned long)(count - reported));
+        uint32_t detached = sim7080g_inflight_detach(waiter->ctx, sim7080g_publish_waiter_cb, waiter);
+        // The rest were already taken off the window - their callbacks are running now and end straight away
+        for (; reported + detached < count; reported++)
+        {
+            xSemaphoreTake(waiter->acked, portMAX_DELAY);
+        }
+        result = ESP_ERR_TIMEOUT;
+    }
+    vSemaphoreDelete(waiter->acked);
+    return result;
+}
+
+static esp_err_t sim7080g_mqtt_publish_pipelined_fn(const sim7080g_handle_t *sim7080g_handle, void *arg)
+{
+    sim7080g_mqtt_publish_pipelined_args_t *args = (sim7080g_mqtt_publish_pipelined_args_t *)arg;
+    sim7080g_ctx_t *ctx = sim7080g_handle->ctx;
+
+    if (args->track)
+    {
+        // Added before the publish is sent so an ack can never arrive ahead of its entry.
+        // Only the arbiter task adds entries, so the window stays in send order.
+        xSemaphoreTake(ctx->inflight_lock, portMAX_DELAY);
+        ctx->inflight[(ctx->inflight_head + ctx->inflight_count) % SIM7080G_MQTT_INFLIGHT_WINDOW] = args->entry;
+        ctx->inflight_count++;
+        xSemaphoreGive(ctx->inflight_lock);
+    }
+
+    bool maybe_sent;
+    esp_err_t err = sim7080g_mqtt_publish_send(sim7080g_handle, &args->publish, &maybe_sent);
+    args->send_result = err;
+    if (err != ESP_OK && args->track)
+    {
+        if (maybe_sent)
+        {
+            // The broker may yet ack it - dropping just this entry would let that ack complete the publish behind it
+            ESP_LOGW(TAG, "Publish %u may have been sent (%s) - failing the window", args->entry.msg_id, esp_err_to_name(err));
+            sim7080g_inflight_fail_all(ctx, err);
+            sim7080g_inflight_flush(ctx);
+            return ESP_OK; // Reported through the callback
+        }
+
+        xSemaphoreTake(ctx->inflight_lock, portMAX_DELAY);
+        size_t newest = (ctx->inflight_head + ctx->inflight_count + SIM7080G_MQTT_INFLIGHT_WINDOW - 1) % SIM7080G_MQTT_INFLIGHT_WINDOW;
+        bool still_queued = ctx->inflight_count > 0 && ctx->inflight[newest].msg_id == args->entry.msg_id;
+        if (still_queued)
+        {
+            ctx->inflight_count--;
+        }
+        xSemaphoreGive(ctx->inflight_lock);
+
+        if (!still_queued)
+        {
+            // Already completed through the window (e.g. the session dropped) - the callback has been called
+            ESP_LOGW(TAG, "Publish %u completed despite: %s", args->entry.msg_id, esp_err_to_name(err));
+            err = ESP_OK;
+        }
+    }
+    return err;
+}
+
+/// @brief sim7080g_mqtt_publish_iov_async's request - completes once the device has sent the publish, as without ASYNCMODE
+/// @note In ASYNCMODE a QoS 1/2 publish takes a window entry with no callback, so its ack is not taken for another
+///       publish's. This runs on the arbiter task, which must not wait for an entry to come free - so a full window
+///       fails the request with ESP_ERR_NO_MEM instead.
+static esp_err_t sim7080g_mqtt_publish_async_fn(const sim7080g_handle_t *sim7080g_handle, void *arg)
+{
+    const sim7080g_mqtt_publish_args_t *publish = (const sim7080g_mqtt_publish_args_t *)arg;
+    sim7080g_ctx_t *ctx = sim7080g_handle->ctx;
+    if (!ctx->async_publish || publish->qos == 0)
+    {
+        return sim7080g_mqtt_publish_fn(sim7080g_handle, arg);
+    }
+
+    sim7080g_inflight_expire(ctx);
+    if (xSemaphoreTake(ctx->inflight_slots, 0) != pdTRUE)
+    {
+        ESP_LOGW(TAG, "Publish window full - async publish not sent");
+        return ESP_ERR_NO_MEM;
+    }
+
+    sim7080g_mqtt_publish_pipelined_args_t args = {
+        .publish = *publish,
+        .entry = {
+            .msg_id = sim7080g_publish_next_msg_id(ctx),
+            .deadline_us = esp_timer_get_time() + (int64_t)SIM7080G_MQTT_INFLIGHT_TIMEOUT_MS * 1000,
+        },
+        .track = true,
+    };
+    if (sim7080g_mqtt_publish_pipelined_fn(sim7080g_handle, &args) != ESP_OK)
+    {
+        xSemaphoreGive(ctx->inflight_slots);
+    }
+    return args.send_result;
+}
+
+esp_err_t sim7080g_mqtt_publish_pipelined(const sim7080g_handle_t *sim7080g_handle,
+                                          const char *topic,
+                                          const sim7080g_iovec_t *iov,
+                                          size_t iov_count,
+                                          uint8_t qos,
+                                          bool retain,
+                                          sim7080g_publish_cb_t callback,
+                                          void *user_ctx,
+                                          uint32_t wait_ms,
+                                          uint16_t *msg_id_out)
+{
+    if (!iov && iov_count > 0)
+    {
+        ESP_LOGE(TAG, "Invalid parameters");
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    size_t message_len = 0;
+    for (size_t i = 0; i < iov_count; i++)
+    {
+        if (!iov[i].base && iov[i].len > 0)
+        {
+            ESP_LOGE(TAG, "Invalid parameters: payload segment %zu has no buffer", i);
+            return ESP_ERR_INVALID_ARG;
+        }
+        message_len += iov[i].len;
+    }
+
+    esp_err_t err = sim7080g_mqtt_publish_check_args(sim7080g_handle, topic, message_len, qos);
+    if (err != ESP_OK)
+    {
+        return err;
+    }
+
+    sim7080g_ctx_t *ctx = sim7080g_handle->ctx;
+    bool track = ctx->async_publish && qos > 0;
+    if (track)
+    {
+        err = sim7080g_inflight_reserve(ctx, wait_ms);
+        if (err != ESP_OK)
+        {
+            ESP_LOGW(TAG, "Publish window full for %lu ms", (unsigned long)wait_ms);
+            return err;
+        }
+    }
+
+    uint16_t msg_id = sim7080g_publish_next_msg_id(ctx);
+    if (msg_id_out != NULL)
+    {
+        *msg_id_out = msg_id; // Before the publish - its callback may run before this returns
+    }
+
+    sim7080g_mqtt_publish_pipelined_args_t args = {
+        .publish = {
+            .topic = topic,
+            .iov = iov,
+            .iov_count = iov_count,
+            .message_len = message_len,
+            .qos = qos,
+            .retain = retain,
+        },
+        .entry = {
+            .msg_id = msg_id,
+            .callback = callback,
+            .user_ctx = user_ctx,
+            .deadline_us = esp_timer_get_time() + (int64_t)SIM7080G_MQTT_INFLIGHT_TIMEOUT_MS * 1000,
+        },
+        .track = track,
+    };
+    err = sim7080g_arbiter_call(sim7080g_handle,
+                                sim7080g_mqtt_publish_pipelined_fn,
+                                &args,
+                                SIM7080G_CMD_PRIORITY_NORMAL,
+                                SIM7080G_ARBITER_DEFAULT_DEADLINE_MS);
+    if (err != ESP_OK)
+    {
+        if (track)
+        {
+            xSemaphoreGive(ctx->inflight_slots);
+        }
+        return err;
+    }
+
+    if (!track && callback != NULL)
+    {
+        // Nothing left to wait for - QoS 0, or the device only answered once the broker had acked
+        callback(msg_id, ESP_OK, user_ctx);
+    }
+    return ESP_OK;
+}
+
+esp_err_t sim7080g_mqtt_wait_inflight(const sim7080g_handle_t *sim7080g_handle, uint32_t timeout_ms)
+{
+    if (!sim7080g_handle || sim7080g_handle->ctx == NULL)
+    {
+        ESP_LOGE(TAG, "Invalid parameters");
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    sim7080g_ctx_t *ctx = sim7080g_handle->ctx;
+    int64_t wait_until = esp_timer_get_time() + (int64_t)timeout_ms * 1000;
+    while (uxSemaphoreGetCount(ctx->inflight_slots) < SIM7080G_MQTT_INFLIGHT_WINDOW)
+    {
+        sim7080g_inflight_expire(ctx);
+        if (esp_timer_get_time() >= wait_until)
+        {
+            return ESP_ERR_TIMEOUT;
+        }
+        vTaskDelay(pdMS_TO_TICKS(10));
+    }
+    return ESP_OK;
+}
+
+esp_err_t sim7080g_mqtt_subscribe(const sim7080g_handle_t *sim7080g_handle,
+                                  const char *topic_filter,
+                                  uint8_t qos,
+                                  sim7080g_mqtt_message_handler_t handler,
+                                  void *user_ctx)
+{
+    if (!sim7080g_handle || !topic_filter || !handler || qos > 2)
+    {
+        ESP_LOGE(TAG, "Invalid parameters");
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    if (!sim7080g_handle->uart_initialized || sim7080g_handle->ctx == NULL)
+    {
+        ESP_LOGE(TAG, "SIM7080G driver not initialized");
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    if (!topic_filter_is_valid(topic_filter) || strchr(topic_filter, '"') != NULL)
+    {
+        ESP_LOGE(TAG, "Invalid topic filter: %s", topic_filter);
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    char args[AT_CMD_MAX_LEN] = {0};
+    if (snprintf(args, sizeof(args), "\"%s\",%u", topic_filter, qos) >= (int)sizeof(args))
+    {
+        ESP_LOGE(TAG, "Topic filter too long: %s", topic_filter);
+        return ESP_ERR_INVALID_SIZE;
+    }
+
+    sim7080g_subscription_t *sub = malloc(sizeof(*sub));
+    if (sub == NULL)
+    {
+        return ESP_ERR_NO_MEM;
+    }
+    sub->handler = handler;
+    sub->user_ctx = user_ctx;
+
+    // Route the filter before subscribing - the broker sends retained messages straight after the SUBACK
+    sim7080g_ctx_t *ctx = sim7080g_handle->ctx;
+    xSemaphoreTake(ctx->sub_lock, portMAX_DELAY);
+    bool inserted = topic_trie_insert(&ctx->subscriptions, topic_filter, sub);
+    xSemaphoreGive(ctx->sub_lock);
+    if (!inserted)
+    {
+        free(sub);
+        return ESP_ERR_NO_MEM;
+    }
+
+    char response[AT_RESPONSE_MAX_LEN] = {0};
+    esp_err_t err = send_at_cmd(sim7080g_handle,
+                                &AT_SMSUB,
+                                AT_CMD_TYPE_WRITE,
+                                args,
+                                response,
+                                sizeof(response),
+                                SIM7080G_MQTT_SUBSCRIBE_TIMEOUT_MS);
+    if (err != ESP_OK)
+    {
+        ESP_LOGE(TAG, "Failed to subscribe to %s: %s", topic_filter, esp_err_to_name(err));
+        xSemaphoreTake(ctx->sub_lock, portMAX_DELAY);
+        topic_trie_remove(&ctx->subscriptions, topic_filter, sub, free);
+        xSemaphoreGive(ctx->sub_lock);
+        return err;
+    }
+
+    ESP_LOGI(TAG, "Subscribed to %s (QoS %u)", topic_filter, qos);
+    return ESP_OK;
+}
+
+esp_err_t sim7080g_mqtt_unsubscribe(const sim7080g_handle_t *sim7080g_handle, const char *topic_filter)
+{
+    if (!sim7080g_handle || !topic_filter)
+    {
+        ESP_LOGE(TAG, "Invalid parameters");
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    if (!sim7080g_handle->uart_initialized || sim7080g_handle->ctx == NULL)
+    {
+        ESP_LOGE(TAG, "SIM7080G driver not initialized");
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    if (!topic_filter_is_valid(topic_filter) || strchr(topic_filter, '"') != NULL)
+    {
+        ESP_LOGE(TAG, "Invalid topic filter: %s", topic_filter);
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    char args[AT_CMD_MAX_LEN] = {0};
+    if (snprintf(args, sizeof(args), "\"%s\"", topic_filter) >= (int)sizeof(args))
+    {
+        ESP_LOGE(TAG, "Topic filter too long: %s", topic_filter);
+        return ESP_ERR_INVALID_SIZE;
+    }
+
+    sim7080g_ctx_t *ctx = sim7080g_handle->ctx;
+    xSemaphoreTake(ctx->sub_lock, portMAX_DELAY);
+    size_t removed = topic_trie_remove(&ctx->subscriptions, topic_filter, NULL, free);
+    xSemaphoreGive(ctx->sub_lock);
+    if (removed == 0)
+    {
+        ESP_LOGW(TAG, "No handler was subscribed to %s", topic_filter);
+    }
+
+    char response[AT_RESPONSE_MAX_LEN] = {0};
+    esp_err_t err = send_at_cmd(sim7080g_handle,
+                                &AT_SMUNSUB,
+                                AT_CMD_TYPE_WRITE,
+                                args,
+                                response,
+                                sizeof(response),
+                                SIM7080G_MQTT_SUBSCRIBE_TIMEOUT_MS);
+    if (err != ESP_OK)
+    {
+        ESP_LOGE(TAG, "Failed to unsubscribe from %s: %s", topic_filter, esp_err_to_name(err));
+        return err;
+    }
+
+    ESP_LOGI(TAG, "Unsubscribed from %s", topic_filter);
+    return ESP_OK;
+}
+
+esp_err_t sim7080g_set_verbose_error_reporting(const sim7080g_handle_t *sim7080g_handle)
+{
+    if (!sim7080g_handle)
+    {
+        ESP_LOGE(TAG, "Invalid device handle");
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    ESP_LOGI(TAG, "Setting verbose error reporting");
+
+    char response[AT_RESPONSE_MAX_LEN] = {0};
+    esp_err_t ret = send_at_cmd(sim7080g_handle,
+                                &AT_CMEE,
+                                AT_CMD_TYPE_WRITE,
+                                "2",
+                                response,
+                                sizeof(response),
+                                5000);
+
+    if (ret != ESP_OK)
+    {
+        ESP_LOGE(TAG, "Failed to set verbose error reporting");
+        return ret;
+    }
+
+    ESP_LOGI(TAG, "Verbose error reporting enabled");
+    return ESP_OK;
+}
+
+// ---------------------  INTERNAL HELPER / STATIC FXNs  ---------------------//
+
+/// @brief Format the command line for the given command type (without the trailing CRLF)
+static esp_err_t at_cmd_format(const at_cmd_t *cmd,
+                               at_cmd_type_t type,
+                               const char *args,
+                               char *out,
+                               size_t out_size)
+{
+    const at_cmd_info_t *cmd_info;
+
+    // Determine the correct command string based on the command type
+    switch (type)
+    {
+    case AT_CMD_TYPE_TEST:
+        cmd_info = &cmd->test;
+        break;
+    case AT_CMD_TYPE_READ:
+        cmd_info = &cmd->read;
+        break;
+    case AT_CMD_TYPE_WRITE:
+        cmd_info = &cmd->write;
+        break;
+    case AT_CMD_TYPE_EXECUTE:
+        cmd_info = &cmd->execute;
+        break;
+    default:
+        ESP_LOGE(TAG, "Send AT cmd failed: Invalid command type");
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    if (cmd_info->cmd_string == NULL)
+    {
+        ESP_LOGE(TAG, "Send AT cmd failed: Command string is NULL");
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    // Format the AT command string
+    int len;
+    if (type == AT_CMD_TYPE_WRITE && args != NULL)
+    {
+        len = snprintf(out, out_size, "%s%s", cmd_info->cmd_string, args);
+    }
+    else
+    {
+        len = snprintf(out, out_size, "%s", cmd_info->cmd_string);
+    }
+
+    if (len < 0 || (size_t)len >= out_size)
+    {
+        ESP_LOGE(TAG, "Send AT cmd failed: AT command too long");
+        return ESP_ERR_INVALID_SIZE;
+    }
+
+    return ESP_OK;
+}
+
+// ------ Status cache ------ //
+
+typedef struct
+{
+    const at_cmd_t *cmd;
+    at_cmd_type_t type;
+} sim7080g_status_read_t;
+
+// Indexed by sim7080g_status_field_t
+static const sim7080g_status_read_t SIM7080G_STATUS_READS[SIM7080G_STATUS_NUM_FIELDS] = {
+    {&AT_CPIN, AT_CMD_TYPE_READ},
+    {&AT_CSQ, AT_CMD_TYPE_EXECUTE},
+    {&AT_CEREG, AT_CMD_TYPE_READ},
+    {&AT_CGATT, AT_CMD_TYPE_READ},
+    {&AT_COPS, AT_CMD_TYPE_READ},
+    {&AT_CNACT, AT_CMD_TYPE_READ},
+    {&AT_SMSTATE, AT_CMD_TYPE_READ},
+};
+
+typedef struct
+{
+    const at_cmd_t *cmd;
+    uint32_t fields;
+} sim7080g_status_change_t;
+
+// Commands that change what a status read answers when sent as anything but a read (or test)
+static const sim7080g_status_change_t SIM7080G_STATUS_CHANGES[] = {
+    {&AT_CFUN, SIM7080G_STATUS_ALL},
+    {&AT_CPIN, SIM7080G_STATUS_ALL},
+    {&AT_CEREG, SIM7080G_STATUS_BIT(SIM7080G_STATUS_CEREG)},
+    {&AT_CGATT, SIM7080G_STATUS_REGISTRATION | SIM7080G_STATUS_BEARER},
+    {&AT_COPS, SIM7080G_STATUS_REGISTRATION | SIM7080G_STATUS_BEARER},
+    {&AT_CNACT, SIM7080G_STATUS_BEARER},
+    {&AT_SMCONN, SIM7080G_STATUS_BIT(SIM7080G_STATUS_SMSTATE)},
+    {&AT_SMDISC, SIM7080G_STATUS_BIT(SIM7080G_STATUS_SMSTATE)},
+};
+
+/// @brief Cache field holding the response of a command, -1 if it is not a cached status read
+static int sim7080g_status_cache_field(const at_cmd_t *cmd, at_cmd_type_t type)
+{
+    for (int field = 0; field < SIM7080G_STATUS_NUM_FIELDS; field++)
+    {
+        if (SIM7080G_STATUS_READS[field].cmd == cmd && SIM7080G_STATUS_READS[field].type == type)
+        {
+            return field;
+        }
+    }
+    return -1;
+}
+
+/// @brief Drop cached responses - any read of them still in flight will not store what it gets back
+static void sim7080g_status_cache_drop(sim7080g_ctx_t *ctx, uint32_t fields)
+{
+    if (ctx == NULL || fields == 0)
+    {
+        return;
+    }
+
+    xSemaphoreTake(ctx->status_cache_lock, portMAX_DELAY);
+    for (int field = 0; field < SIM7080G_STATUS_NUM_FIELDS; field++)
+    {
+        sim7080g_status_entry_t *entry = &ctx->status_cache[field];
+        if (fields & SIM7080G_STATUS_BIT(field))
+        {
+            if (entry->valid)
+            {
+                ctx->status_cache_stats.invalidations++;
+            }
+            entry->valid = false;
+            entry->generation++;
+        }
+    }
+    xSemaphoreGive(ctx->status_cache_lock);
+}
+
+/// @brief Drop the cached responses a command may change - called both before it is sent and once it is done, as a read
+///        that started while the command was in flight may have answered with the state from before it
+static void sim7080g_status_cache_command(sim7080g_ctx_t *ctx, const at_cmd_t *cmd, at_cmd_type_t type)
+{
+    if (type == AT_CMD_TYPE_READ || type == AT_CMD_TYPE_TEST)
+    {
+        return;
+    }
+    for (size_t i = 0; i < sizeof(SIM7080G_STATUS_CHANGES) / sizeof(SIM7080G_STATUS_CHANGES[0]); i++)
+    {
+        if (SIM7080G_STATUS_CHANGES[i].cmd == cmd)
+        {
+            sim7080g_status_cache_drop(ctx, SIM7080G_STATUS_CHANGES[i].fields);
+            return;
+        }
+    }
+}
+
+/// @brief Copy a cached response younger than the TTL into response
+/// @param generation_out On a miss, what sim7080g_status_cache_store needs to store the response read instead
+/// @return true on a hit
+static bool sim7080g_status_cache_lookup(sim7080g_ctx_t *ctx, int field, char *response, size_t response_size, uint32_t *generation_out)
+{
+    const sim7080g_status_entry_t *entry = &ctx->status_cache[field];
+    bool hit;
+
+    xSemaphoreTake(ctx->status_cache_lock, portMAX_DELAY);
+    hit = entry->valid && esp_timer_get_time() - entry->read_at_us < (int64_t)ctx->status_cache_ttl_ms * 1000;
+    if (hit)
+    {
+        snprintf(response, response_size, "%s", entry->response);
+        ctx->status_cache_stats.hits++;
+    }
+    else
+    {
+        *generation_out = entry->generation;
+        ctx->status_cache_stats.misses++;
+    }
+    xSemaphoreGive(ctx->status_cache_lock);
+    return hit;
+}
+
+static void sim7080g_status_cache_store(sim7080g_ctx_t *ctx, int field, uint32_t generation, const char *response)
+{
+    sim7080g_status_entry_t *entry = &ctx->status_cache[field];
+
+    xSemaphoreTake(ctx->status_cache_lock, portMAX_DELAY);
+    if (entry->generation == generation && strlen(response) < sizeof(entry->response))
+    {
+        strcpy(entry->response, response);
+        entry->read_at_us = esp_timer_get_time();
+        entry->valid = true;
+    }
+    xSemaphoreGive(ctx->status_cache_lock);
+}
+
+/// @brief send_at_cmd for a status read - answered from the cache while the last response is fresh
+static esp_err_t send_at_cmd_cached(const sim7080g_handle_t *sim7080g_handle,
+                                    const at_cmd_t *cmd,
+                                    at_cmd_type_t type,
+                                    char *response,
+                                    size_t response_size,
+                                    uint32_t timeout_ms)
+{
+    int field = sim7080g_status_cache_field(cmd, type);
+    if (field < 0 || !sim7080g_handle || sim7080g_handle->ctx == NULL || response == NULL || response_size == 0)
+    {
+        return send_at_cmd(sim7080g_handle, cmd, type, NULL, response, response_size, timeout_ms);
+    }
+
+    uint32_t generation;
+    if (sim7080g_status_cache_lookup(sim7080g_handle->ctx, field, response, response_size, &generation))
+    {
+        return ESP_OK;
+    }
+
+    esp_err_t err = send_at_cmd(sim7080g_handle, cmd, type, NULL, response, response_size, timeout_ms);
+    if (err == ESP_OK)
+    {
+        sim7080g_status_cache_store(sim7080g_handle->ctx, field, generation, response);
+    }
+    return err;
+}
+
+/// @brief sim7080g_send_at_batch for status reads - only the entries the cache can not answer are sent, still as one exchange
+static esp_err_t sim7080g_send_at_batch_cached(const sim7080g_handle_t *sim7080g_handle,
+                                               sim7080g_at_batch_entry_t *entries,
+                                               size_t num_entries,
+                                               uint32_t timeout_ms)
+{
+    if (!sim7080g_handle || sim7080g_handle->ctx == NULL || !entries || num_entries == 0 || num_entries > SIM7080G_AT_BATCH_MAX_CMDS)
+    {
+        return sim7080g_send_at_batch(sim7080g_handle, entries, num_entries, timeout_ms);
+    }
+
+    sim7080g_at_batch_entry_t misses[SIM7080G_AT_BATCH_MAX_CMDS];
+    size_t miss_index[SIM7080G_AT_BATCH_MAX_CMDS];
+    int miss_field[SIM7080G_AT_BATCH_MAX_CMDS];
+    uint32_t miss_generation[SIM7080G_AT_BATCH_MAX_CMDS];
+    size_t num_misses = 0;
+
+    for (size_t i = 0; i < num_entries; i++)
+    {
+        sim7080g_at_batch_entry_t *entry = &entries[i];
+        int field = (entry->response != NULL && entry->response_size > 0) ? sim7080g_status_cache_field(entry->cmd, entry->type) : -1;
+        if (field >= 0 &&
+            sim7080g_status_cache_lookup(sim7080g_handle->ctx, field, entry->response, entry->response_size, &miss_generation[num_misses]))
+        {
+            entry->result = ESP_OK;
+            continue;
+        }
+        miss_index[num_misses] = i;
+        miss_field[num_misses] = field;
+        misses[num_misses++] = *entry;
+    }
+
+    if (num_misses > 0)
+    {
+        sim7080g_send_at_batch(sim7080g_handle, misses, num_misses, timeout_ms);
+    }
+
+    esp_err_t ret = ESP_OK;
+    for (size_t i = 0, miss = 0; i < num_entries; i++)
+    {
+        if (miss < num_misses && miss_index[miss] == i)
+        {
+            entries[i].result = misses[miss].result;
+            if (misses[miss].result == ESP_OK && miss_field[miss] >= 0)
+            {
+                sim7080g_status_cache_store(sim7080g_handle->ctx, miss_field[miss], miss_generation[miss], entries[i].response);
+            }
+            miss++;
+        }
+        if (ret == ESP_OK && entries[i].result != ESP_OK)
+        {
+            ret = entries[i].result;
+        }
+    }
+    return ret;
+}
+
+esp_err_t sim7080g_get_status_cache_stats(const sim7080g_handle_t *sim7080g_handle, sim7080g_status_cache_stats_t *stats_out)
+{
+    if (!sim7080g_handle || sim7080g_handle->ctx == NULL || !stats_out)
+    {
+        ESP_LOGE(TAG, "Invalid parameters");
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    sim7080g_ctx_t *ctx = sim7080g_handle->ctx;
+    xSemaphoreTake(ctx->status_cache_lock, portMAX_DELAY);
+    *stats_out = ctx->status_cache_stats;
+    xSemaphoreGive(ctx->status_cache_lock);
+    return ESP_OK;
+}
+
+esp_err_t sim7080g_status_cache_invalidate(const sim7080g_handle_t *sim7080g_handle)
+{
+    if (!sim7080g_handle || sim7080g_handle->ctx == NULL)
+    {
+        ESP_LOGE(TAG, "Invalid parameters");
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    sim7080g_status_cache_drop(sim7080g_handle->ctx, SIM7080G_STATUS_ALL);
+    return ESP_OK;
+}
+
+/// @brief Info line prefix a command answers with ("AT+CSQ" answers with "+CSQ: ..." lines), NULL for basic commands
+///        and for commands whose prefixed lines are URCs (a "+SMSUB:" message arriving during AT+SMSUB must be dispatched)
+static const char *at_cmd_solicited_prefix(const at_cmd_t *cmd)
+{
+    return (!cmd->info_lines_are_urcs && strncmp(cmd->name, "AT+", 3) == 0) ? cmd->name + 2 : NULL;
+}
+
+static esp_err_t send_at_cmd(const sim7080g_handle_t *sim7080g_handle,
+                             const at_cmd_t *cmd,
+                             at_cmd_type_t type,
+                             const char *args,
+                             char *response,
+                             size_t response_size,
+                             uint32_t timeout_ms)
+{
+    return send_at_cmd_expect(sim7080g_handle, cmd, type, args, NULL, response, response_size, timeout_ms);
+}
+
+/// @brief Send an AT command, and if 'expect' is given also wait for a line starting with it after the OK
+/// @note Used for commands whose real outcome is reported by a URC following the OK (e.g. '+APP PDP' after AT+CNACT)
+static esp_err_t send_at_cmd_expect(const sim7080g_handle_t *sim7080g_handle,
+                                    const at_cmd_t *cmd,
+                                    at_cmd_type_t type,
+                                    const char *args,
+                                    const char *expect,
+                                    char *response,
+                                    size_t response_size,
+                                    uint32_t timeout_ms)
+{
+    if (!sim7080g_handle || !sim7080g_handle->uart_initialized || sim7080g_handle->ctx == NULL)
+    {
+        ESP_LOGE(TAG, "Send AT cmd failed: SIM7080G driver not initialized");
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    if (cmd == NULL || response == NULL || response_size == 0)
+    {
+        ESP_LOGE(TAG, "Send AT cmd failed: Invalid parameters");
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    char at_cmd[AT_CMD_MAX_LEN] = {0};
+    esp_err_t err = at_cmd_format(cmd, type, args, at_cmd, sizeof(at_cmd) - 2);
+    if (err != ESP_OK)
+    {
+        return err;
+    }
+    strcat(at_cmd, "\r\n");
+
+    sim7080g_status_cache_command(sim7080g_handle->ctx, cmd, type);
+    const char *solicited = at_cmd_solicited_prefix(cmd);
+
+    err = send_at_line(sim7080g_handle,
+                       at_cmd,
+                       cmd->description,
+                       &solicited,
+                       solicited != NULL ? 1 : 0,
+                       expect,
+                       response,
+                       response_size,
+                       timeout_ms,
+                       cmd->retry != NULL ? cmd->retry : &AT_RETRY_DEFAULT,
+                       at_cmd_is_idempotent(cmd, type));
+
+    // Even a failed command may have been acted on
+    sim7080g_status_cache_command(sim7080g_handle->ctx, cmd, type);
+    return err;
+}
+
+/// @brief Whether sending the command twice has the same effect as sending it once
+static bool at_cmd_is_idempotent(const at_cmd_t *cmd, at_cmd_type_t type)
+{
+    return type == AT_CMD_TYPE_TEST || type == AT_CMD_TYPE_READ || cmd->idempotent;
+}
+
+/// @brief Send a fully formatted AT command line and collect its response, retrying on failure
+/// @param solicited Info line prefixes the command line answers with - routed to the response rather than URC handlers
+/// @param retry When and how often to send the line again
+/// @param idempotent The line may be sent again when it is unknown whether the device acted on it (no final result code)
+static esp_err_t send_at_line(const sim7080g_handle_t *sim7080g_handle,
+                              const char *at_cmd,
+                              const char *description,
+                              const char *const *solicited,
+                              size_t num_solicited,
+                              const char *expect,
+                              char *response,
+                              size_t response_size,
+                              uint32_t timeout_ms,
+                              const at_retry_policy_t *retry,
+                              bool idempotent)
+{
+    const int64_t start_us = esp_timer_get_time();
+    const int max_attempts = retry->max_attempts > 0 ? retry->max_attempts : 1;
+    esp_err_t ret = ESP_FAIL;
+
+    for (int attempt = 1; attempt <= max_attempts; attempt++)
+    {
+        ESP_LOGI(TAG, "Sending AT command (attempt %d/%d): %s", attempt, max_attempts, at_cmd);
+        ESP_LOGI(TAG, "Command description: %s", description);
+
+        // Never wait past the overall deadline
+        uint32_t attempt_timeout_ms = timeout_ms;
+        if (retry->deadline_ms > 0)
+        {
+            uint32_t elapsed_ms = (uint32_t)((esp_timer_get_time() - start_us) / 1000);
+            uint32_t remaining_ms = elapsed_ms < retry->deadline_ms ? retry->deadline_ms - elapsed_ms : 0;
+            if (remaining_ms < attempt_timeout_ms)
+            {
+                attempt_timeout_ms = remaining_ms;
+            }
+        }
+
+        sim7080g_rx_waiter_t waiter = {
+            .buf = response,
+            .size = response_size,
+            .expect = expect,
+            .num_solicited = num_solicited,
+        };
+        for (size_t i = 0; i < num_solicited && i < SIM7080G_AT_BATCH_MAX_CMDS; i++)
+        {
+            waiter.solicited[i] = solicited[i];
+        }
+
+        // Returns as soon as a final result code arrives rather than waiting out the full timeout
+        int bytes_read = 0;
+        esp_err_t err = sim7080g_exchange(sim7080g_handle, at_cmd, strlen(at_cmd), &waiter, attempt_timeout_ms, &bytes_read);
+        bool may_retry;
+        if (err == ESP_ERR_TIMEOUT)
+        {
+            ESP_LOGE(TAG, "Send AT cmd failed: Device busy with other requests");
+            return err;
+        }
+        else if (err != ESP_OK)
+        {
+            ESP_LOGE(TAG, "Send AT cmd failed: Failed to send AT command");
+            ret = ESP_FAIL;
+            may_retry = true;
+        }
+        else
+        {
+            ESP_LOGI(TAG, "Received %d bytes. Raw Response: %s", bytes_read, response);
+
+            // Check for the final result code line (a substring search could match 'OK' inside other output)
+            if (waiter.ok_seen)
+            {
+                ESP_LOGI(TAG, "Send AT cmd SUCCESS: AT command send returned OK");
+                return ESP_OK;
+            }
+            else if (waiter.error_seen)
+            {
+                // The device rejected the command - so sending it again is safe, but only worth it if the error can clear
+                ret = ESP_FAIL;
+                may_retry = at_response_error_is_retryable(response);
+                ESP_LOGE(TAG, "Send AT cmd failed: AT command send returned %s error", may_retry ? "a transient" : "a fatal");
+            }
+            else
+            {
+                // No final result code - the device may or may not have acted on the command
+                ret = (bytes_read == 0) ? ESP_ERR_TIMEOUT : ESP_FAIL;
+                may_retry = idempotent;
+                ESP_LOGW(TAG, "Send AT cmd failed: %s", bytes_read == 0 ? "AT command timeout" : "Unexpected AT command response");
+            }
+        }
+
+        if (!may_retry)
+        {
+            ESP_LOGE(TAG, "Send AT cmd failed: Not retrying after attempt %d", attempt);
+            return ret;
+        }
+
+        if (attempt < max_attempts)
+        {
+            uint32_t delay_ms = at_retry_delay_ms(retry, attempt);
+            uint32_t elapsed_ms = (uint32_t)((esp_timer_get_time() - start_us) / 1000);
+            if (retry->deadline_ms > 0 && elapsed_ms + delay_ms >= retry->deadline_ms)
+            {
+                ESP_LOGE(TAG, "Send AT cmd failed: Retry deadline of %lu ms reached", (unsigned long)retry->deadline_ms);
+                return ret;
+            }
+            vTaskDelay(pdMS_TO_TICKS(delay_ms));
+        }
+    }
+
+    ESP_LOGE(TAG, "Send AT cmd failed after %d attempts", max_attempts);
+    return ret;
+}
+
+/// @brief Backoff before the attempt after 'attempt' - doubles every attempt, the upper half is randomized
+/// @note The jitter keeps several tasks (or devices) that failed together from retrying in lockstep
+static uint32_t at_retry_delay_ms(const at_retry_policy_t *retry, int attempt)
+{
+    uint32_t delay_ms = retry->base_delay_ms;
+    for (int i = 1; i < attempt && delay_ms < retry->max_delay_ms; i++)
+    {
+        delay_ms *= 2;
+    }
+    if (delay_ms > retry->max_delay_ms)
+    {
+        delay_ms = retry->max_delay_ms;
+    }
+
+    uint32_t half = delay_ms / 2;
+    return half + (half > 0 ? esp_random() % (half + 1) : 0);
+}
+
+// Error codes (3GPP TS 27.007 9.2 / 27.005 3.2.5) that can clear on their own - any other error reply is fatal.
+// Matched by number (AT+CMEE=1) or by text (AT+CMEE=2).
+typedef struct
+{
+    int code;
+    const char *text;
+} at_error_code_t;
+
+static const at_error_code_t at_cme_retryable_errors[] = {
+    {14, "SIM busy"},
+    {30, "no network service"},
+    {31, "network timeout"},
+    {100, "unknown"},
+};
+
+static const at_error_code_t at_cms_retryable_errors[] = {
+    {332, "network timeout"},
+    {500, "unknown error"},
+};
+
+static bool at_error_in_list(const char *value, const at_error_code_t *list, size_t list_len)
+{
+    while (*value == ' ')
+    {
+        value++;
+    }
+
+    char *end;
+    long code = strtol(value, &end, 10);
+    bool numeric = end != value;
+
+    for (size_t i = 0; i < list_len; i++)
+    {
+        if (numeric ? (code == list[i].code)
+                    : (strncasecmp(value, list[i].text, strlen(list[i].text)) == 0))
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+/// @brief Classify the error reply in a response - a plain 'ERROR' carries no reason, so it is treated as transient
+static bool at_response_error_is_retryable(const char *response)
+{
+    const char *cme = strstr(response, "+CME ERROR:");
+    if (cme != NULL)
+    {
+        return at_error_in_list(cme + 11, at_cme_retryable_errors, sizeof(at_cme_retryable_errors) / sizeof(at_cme_retryable_errors[0]));
+    }
+
+    const char *cms = strstr(response, "+CMS ERROR:");
+    if (cms != NULL)
+    {
+        return at_error_in_list(cms + 11, at_cms_retryable_errors, sizeof(at_cms_retryable_errors) / sizeof(at_cms_retryable_errors[0]));
+    }
+
+    return true;
+}
+
+/// @brief Compile every SIM7080G_DECODER_TABLE entry from its command's response_format
+static esp_err_t sim7080g_compile_decoders(void)
+{
+    if (sim7080g_decoders_compiled)
+    {
+        return ESP_OK;
+    }
+
+    for (int i = 0; i < SIM7080G_DECODER_COUNT; i++)
+    {
+        const sim7080g_decoder_entry_t *entry = &SIM7080G_DECODER_TABLE[i];
+
+        for (int f = 0; f < entry->layout_len; f++)
+        {
+            if (entry->layout[f].offset + entry->layout[f].size > entry->reply_size)
+            {
+                ESP_LOGE(TAG, "Decoder for %s: field %d outside its reply struct", entry->info->cmd_string, f);
+                return ESP_ERR_INVALID_SIZE;
+            }
+        }
+
+        if (!at_decoder_compile(&sim7080g_decoders[i], entry->info->response_format, entry->layout, entry->layout_len))
+        {
+            ESP_LOGE(TAG, "Decoder for %s: response format '%s' does not match its layout",
+                     entry->info->cmd_string, entry->info->response_format);
+            return ESP_ERR_INVALID_ARG;
+        }
+    }
+
+    sim7080g_decoders_compiled = true;
+    return ESP_OK;
+}
+
+/// @brief Decode the first reply line of a response into the decoder's reply struct
+/// @return Number of fields decoded, or -1 if the response has no reply line
+static int sim7080g_decode(sim7080g_decoder_id_t id, const char *response, void *reply_out)
+{
+    return at_decoder_decode(&sim7080g_decoders[id], response, strlen(response), reply_out);
+}
+
+/// @brief Check if a received line is a final result code (OK, ERROR, +CME ERROR, +CMS ERROR)
+static bool at_line_is_final_result(const char *line)
+{
+    return strcmp(line, "OK") == 0 || at_line_is_error(line);
+}
+
+static bool at_line_is_error(const char *line)
+{
+    return strcmp(line, "ERROR") == 0 ||
+           strncmp(line, "+CME ERROR:", 11) == 0 ||
+           strncmp(line, "+CMS ERROR:", 11) == 0;
+}
+
+/// @brief Register a waiter that the RX task fills with the lines of the next response
+/// @note Must be called BEFORE the command is written so that a fast response can not be missed
+static void sim7080g_rx_begin(const sim7080g_handle_t *sim7080g_handle, sim7080g_rx_waiter_t *waiter)
+{
+    sim7080g_ctx_t *ctx = sim7080g_handle->ctx;
+
+    waiter->len = 0;
+    waiter->buf[0] = '\0';
+
+    xSemaphoreTake(ctx->rx_lock, portMAX_DELAY);
+    // Discard a completion left over from a previous waiter that timed out just as it completed
+    xSemaphoreTake(ctx->rx_done, 0);
+    ctx->waiter = waiter;
+    xSemaphoreGive(ctx->rx_lock);
+}
+
+/// @brief Raise a UART pattern event (waking the RX task at once) on pattern_chr rather than on the RX FIFO timeout
+static esp_err_t sim7080g_rx_set_pattern(const sim7080g_ctx_t *ctx, char pattern_chr)
+{
+    return uart_enable_pattern_det_baud_intr(ctx->port, pattern_chr, 1, 9, 0, 0);
+}
+
+/// @brief Wait for the RX task to complete the registered waiter, then unregister it
+/// @return Number of response bytes collected (the response is null terminated)
+static int sim7080g_rx_wait(const sim7080g_handle_t *sim7080g_handle, sim7080g_rx_waiter_t *waiter, uint32_t timeout_ms)
+{
+    sim7080g_ctx_t *ctx = sim7080g_handle->ctx;
+
+    if (timeout_ms > 0)
+    {
+        xSemaphoreTake(ctx->rx_done, pdMS_TO_TICKS(timeout_ms));
+    }
+
+    xSemaphoreTake(ctx->rx_lock, portMAX_DELAY);
+    ctx->waiter = NULL;
+    xSemaphoreGive(ctx->rx_lock);
+
+    return (int)waiter->len;
+}
+
+static void sim7080g_rx_waiter_append(sim7080g_rx_waiter_t *waiter, const char *data, size_t len)
+{
+    size_t space = waiter->size - 1 - waiter->len;
+    if (len > space)
+    {
+        len = space;
+    }
+    memcpy(waiter->buf + waiter->len, data, len);
+    waiter->len += len;
+    waiter->buf[waiter->len] = '\0';
+}
+
+/// @brief Route a complete line (or the '>' data prompt) to the URC handlers and/or the waiting command
+/// @note Lines answering the command in flight go to that command only. Other lines matching a registered
+///       URC prefix go to the URC handlers only, except the command's 'expect' line which goes to both.
+static void sim7080g_rx_deliver_line(sim7080g_ctx_t *ctx, const char *line, size_t len, bool is_prompt)
+{
+    xSemaphoreTake(ctx->rx_lock, portMAX_DELAY);
+
+    sim7080g_rx_waiter_t *waiter = ctx->waiter;
+    if (waiter != NULL && waiter->complete)
+    {
+        waiter = NULL;
+    }
+
+    bool expected = waiter != NULL && waiter->expect != NULL &&
+                    strncmp(line, waiter->expect, strlen(waiter->expect)) == 0;
+    bool solicited = false;
+    for (size_t i = 0; waiter != NULL && i < waiter->num_solicited && !solicited; i++)
+    {
+        size_t prefix_len = strlen(waiter->solicited[i]);
+        solicited = len > prefix_len &&
+                    strncmp(line, waiter->solicited[i], prefix_len) == 0 &&
+                    line[prefix_len] == ':';
+    }
+
+    if (!is_prompt && !solicited)
+    {
+        if (sim7080g_urc_dispatch(ctx, line, len) && !expected)
+        {
+            xSemaphoreGive(ctx->rx_lock);
+            return;
+        }
+    }
+
+    if (waiter == NULL)
+    {
+        xSemaphoreGive(ctx->rx_lock);
+        ESP_LOGD(TAG, "RX line with no command waiting: %s", line);
+        return;
+    }
+
+    sim7080g_rx_waiter_append(waiter, line, len);
+    if (is_prompt)
+    {
+        waiter->complete = waiter->wait_for_prompt;
+    }
+    else
+    {
+        sim7080g_rx_waiter_append(waiter, "\r\n", 2);
+
+        if (expected)
+        {
+            waiter->expect_seen = true;
+            waiter->complete = waiter->expect_only || waiter->ok_seen;
+        }
+        else if (at_line_is_error(line))
+        {
+            waiter->error_seen = true;
+            waiter->complete = true;
+        }
+        else if (at_line_is_final_result(line))
+        {
+            waiter->ok_seen = true;
+            waiter->complete = (waiter->expect == NULL) || waiter->expect_seen;
+        }
+    }
+
+    if (waiter->complete)
+    {
+        xSemaphoreGive(ctx->rx_done);
+    }
+
+    xSemaphoreGive(ctx->rx_lock);
+}
+
+/// @brief Call every registered handler whose prefix starts the line
+/// @return true if at least one handler matched
+static bool sim7080g_urc_dispatch(sim7080g_ctx_t *ctx, const char *line, size_t len)
+{
+    bool matched = false;
+
+    xSemaphoreTake(ctx->urc_lock, portMAX_DELAY);
+    for (int8_t i = ctx->urc_buckets[sim7080g_urc_bucket(line)]; i >= 0; i = ctx->urc_entries[i].next)
+    {
+        const sim7080g_urc_entry_t *entry = &ctx->urc_entries[i];
+        if (len >= entry->prefix_len && memcmp(line, entry->prefix, entry->prefix_len) == 0)
+        {
+            entry->handler(line, len, entry->user_ctx);
+            matched = true;
+        }
+    }
+    xSemaphoreGive(ctx->urc_lock);
+
+    return matched;
+}
+
+// "+APP PDP: <pdpidx>,ACTIVE" / "+APP PDP: <pdpidx>,DEACTIVE"
+static void sim7080g_urc_app_pdp(const char *line, size_t len, void *user_ctx)
+{
+    sim7080g_ctx_t *ctx = (sim7080g_ctx_t *)user_ctx;
+    int pdpidx;
+    at_str_t state;
+    at_parser_t fields;
+    at_parser_init(&fields, line, len);
+    if (!at_parser_match(&fields, "+APP PDP:") || !at_parser_int(&fields, &pdpidx) || !at_parser_str(&fields, &state))
+    {
+        ESP_LOGW(TAG, "URC: Failed to parse: %s", line);
+        return;
+    }
+
+    bool active = at_str_eq(state, "ACTIVE");
+    ESP_LOGI(TAG, "URC: PDP context %d %s", pdpidx, active ? "activated" : "deactivated");
+    sim7080g_status_cache_drop(ctx, SIM7080G_STATUS_BEARER); // The MQTT session goes with the bearer
+    if (pdpidx == 0)
+    {
+        if (active)
+        {
+            xEventGroupSetBits(ctx->status_events, SIM7080G_EVT_PDP_ACTIVE);
+        }
+        else
+        {
+            xEventGroupClearBits(ctx->status_events, SIM7080G_EVT_PDP_ACTIVE);
+        }
+    }
+}
+
+// "+SMSTATE: <status>" - reported by the device when the MQTT session drops
+static void sim7080g_urc_smstate(const char *line, size_t len, void *user_ctx)
+{
+    sim7080g_ctx_t *ctx = (sim7080g_ctx_t *)user_ctx;
+    int status;
+    at_parser_t fields;
+    at_parser_init(&fields, line, len);
+    if (!at_parser_match(&fields, "+SMSTATE:") || !at_parser_int(&fields, &status))
+    {
+        ESP_LOGW(TAG, "URC: Failed to parse: %s", line);
+        return;
+    }
+
+    ESP_LOGI(TAG, "URC: MQTT state %d", status);
+    sim7080g_status_cache_drop(ctx, SIM7080G_STATUS_BIT(SIM7080G_STATUS_SMSTATE));
+    if (status > 0)
+    {
+        xEventGroupSetBits(ctx->status_events, SIM7080G_EVT_MQTT_CONNECTED);
+    }
+    else
+    {
+        xEventGroupClearBits(ctx->status_events, SIM7080G_EVT_MQTT_CONNECTED);
+        sim7080g_inflight_fail_all(ctx, ESP_ERR_INVALID_STATE); // Acks from the old session will not come
+    }
+}
+
+// "+SMPUB: [<id>,]<result>" - ASYNCMODE only, the broker's ack (result 0) of the oldest publish in flight
+static void sim7080g_urc_smpub(const char *line, size_t len, void *user_ctx)
+{
+    sim7080g_ctx_t *ctx = (sim7080g_ctx_t *)user_ctx;
+    int value;
+    int result = -1;
+    at_parser_t fields;
+    at_parser_init(&fields, line, len);
+    if (!at_parser_match(&fields, "+SMPUB:"))
+    {
+        return;
+    }
+    while (at_parser_int(&fields, &value))
+    {
+        result = value; // The result is the last field
+    }
+    if (result < 0 || !at_parser_done(&fields))
+    {
+        ESP_LOGW(TAG, "URC: Failed to parse: %s", line);
+        return;
+    }
+
+    sim7080g_inflight_ack(ctx, result == 0 ? ESP_OK : ESP_FAIL);
+}
+
+/// @brief Parse "<stat>[,<tac>,<ci>,<AcT>]" - the location fields are only there with AT+CEREG=2, while registered
+static bool sim7080g_parse_cereg(at_parser_t *fields, sim7080g_registration_t *out)
+{
+    int stat;
+    if (!at_parser_int(fields, &stat))
+    {
+        return false;
+    }
+    *out = (sim7080g_registration_t){.stat = (uint8_t)stat};
+
+    at_str_t tac;
+    at_str_t ci;
+    int act;
+    char hex[9];
+    if (at_parser_str(fields, &tac) && at_parser_str(fields, &ci))
+    {
+        if (at_str_copy(tac, hex, sizeof(hex)))
+        {
+            out->tac = (uint16_t)strtoul(hex, NULL, 16);
+        }
+        if (at_str_copy(ci, hex, sizeof(hex)))
+        {
+            out->cell_id = (uint32_t)strtoul(hex, NULL, 16);
+        }
+        if (at_parser_int(fields, &act))
+        {
+            out->act = (uint8_t)act;
+        }
+    }
+    return true;
+}
+
+/// @brief Record a registration status and update the registered bit - called with urc_lock held
+static void sim7080g_registration_update(sim7080g_ctx_t *ctx, const sim7080g_registration_t *registration)
+{
+    ctx->registration = *registration;
+    // 1 = home network, 5 = roaming
+    if (registration->stat == 1 || registration->stat == 5)
+    {
+        xEventGroupSetBits(ctx->status_events, SIM7080G_EVT_REGISTERED);
+    }
+    else
+    {
+        xEventGroupClearBits(ctx->status_events, SIM7080G_EVT_REGISTERED);
+    }
+}
+
+// "+CEREG: <stat>[,<tac>,<ci>,<AcT>]" - unsolicited form carries no <n> field
+static void sim7080g_urc_cereg(const char *line, size_t len, void *user_ctx)
+{
+    sim7080g_ctx_t *ctx = (sim7080g_ctx_t *)user_ctx;
+    sim7080g_registration_t registration;
+    at_parser_t fields;
+    at_parser_init(&fields, line, len);
+    if (!at_parser_match(&fields, "+CEREG:") || !sim7080g_parse_cereg(&fields, &registration))
+    {
+        ESP_LOGW(TAG, "URC: Failed to parse: %s", line);
+        return;
+    }
+
+    ESP_LOGI(TAG, "URC: EPS registration status %d (TAC %04X, cell %08lX)",
+             registration.stat, registration.tac, (unsigned long)registration.cell_id);
+    ctx->registration_reports++;
+    sim7080g_registration_update(ctx, &registration);
+    sim7080g_status_cache_drop(ctx, SIM7080G_STATUS_REGISTRATION);
+}
+
+// "+CPIN: <code>" - reported after power up / CFUN=1 once the SIM state is known
+static void sim7080g_urc_cpin(const char *line, size_t len, void *user_ctx)
+{
+    sim7080g_ctx_t *ctx = (sim7080g_ctx_t *)user_ctx;
+
+    at_str_t code;
+    at_parser_t fields;
+    at_parser_init(&fields, line, len);
+
+    ESP_LOGI(TAG, "URC: %s", line);
+    sim7080g_status_cache_drop(ctx, SIM7080G_STATUS_ALL);
+    if (at_parser_match(&fields, "+CPIN:") && at_parser_str(&fields, &code) && at_str_eq(code, "READY"))
+    {
+        xEventGroupSetBits(ctx->status_events, SIM7080G_EVT_SIM_READY);
+    }
+    else
+    {
+        xEventGroupClearBits(ctx->status_events, SIM7080G_EVT_SIM_READY);
+    }
+}
+
+// "+CFUN: <fun>" - reported after power up and functionality changes
+static void sim7080g_urc_cfun(const char *line, size_t len, void *user_ctx)
+{
+    sim7080g_ctx_t *ctx = (sim7080g_ctx_t *)user_ctx;
+    int fun;
+    at_parser_t fields;
+    at_parser_init(&fields, line, len);
+    if (!at_parser_match(&fields, "+CFUN:") || !at_parser_int(&fields, &fun))
+    {
+        ESP_LOGW(TAG, "URC: Failed to parse: %s", line);
+        return;
+    }
+
+    ESP_LOGI(TAG, "URC: Functionality level %d", fun);
+    sim7080g_status_cache_drop(ctx, SIM7080G_STATUS_ALL);
+    if (fun == 1)
+    {
+        xEventGroupSetBits(ctx->status_events, SIM7080G_EVT_FUNCTIONAL);
+    }
+    else
+    {
+        sim7080g_functionality_lost(ctx);
+    }
+}
+
+/// @brief Without full functionality there is no SIM access, registration or data connection
+static void sim7080g_functionality_lost(sim7080g_ctx_t *ctx)
+{
+    xEventGroupClearBits(ctx->status_events, SIM7080G_EVT_FUNCTIONAL | SIM7080G_EVT_SIM_READY |
+                                                 SIM7080G_EVT_SMS_READY | SIM7080G_EVT_REGISTERED |
+                                                 SIM7080G_EVT_PDP_ACTIVE | SIM7080G_EVT_MQTT_CONNECTED);
+    sim7080g_inflight_fail_all(ctx, ESP_ERR_INVALID_STATE);
+}
+
+// "SMS Ready" - the device has finished starting up (after power up or CFUN=1)
+static void sim7080g_urc_sms_ready(const char *line, size_t len, void *user_ctx)
+{
+    sim7080g_ctx_t *ctx = (sim7080g_ctx_t *)user_ctx;
+    ESP_LOGI(TAG, "URC: %s", line);
+    xEventGroupSetBits(ctx->status_events, SIM7080G_EVT_SMS_READY);
+}
+
+typedef struct
+{
+    const char *topic;
+    size_t topic_len;
+    const uint8_t *payload;
+    size_t payload_len;
+} sim7080g_mqtt_message_t;
+
+static void sim7080g_subscription_deliver(void *value, void *arg)
+{
+    const sim7080g_subscription_t *sub = value;
+    const sim7080g_mqtt_message_t *message = arg;
+    sub->handler(message->topic, message->topic_len, message->payload, message->payload_len, sub->user_ctx);
+}
+
+// "+SMSUB: "<topic>","<message>"" - message received on a subscribed topic
+// Parsed in place - the topic runs to the first "," and the message to the last quote, so it may hold quotes and commas.
+// With SUBHEX=1 the payload is decoded into ctx->sub_payload - the line itself is left as every other handler sees it.
+static void sim7080g_urc_smsub(const char *line, size_t len, void *user_ctx)
+{
+    sim7080g_ctx_t *ctx = (sim7080g_ctx_t *)user_ctx;
+    const char *end = line + len;
+    const char *topic = memchr(line, '"', len);
+    const char *topic_end = (topic != NULL) ? strstr(topic + 1, "\",\"") : NULL;
+    if (topic_end == NULL || end[-1] != '"' || end - 1 < topic_end + 3)
+    {
+        ESP_LOGW(TAG, "URC: Malformed MQTT message: %s", line);
+        return;
+    }
+
+    sim7080g_mqtt_message_t message = {
+        .topic = topic + 1,
+        .topic_len = (size_t)(topic_end - (topic + 1)),
+        .payload = (const uint8_t *)topic_end + 3,
+        .payload_len = (size_t)((end - 1) - (topic_end + 3)),
+    };
+
+    // SUBHEX=1 - URC handlers only run on the RX task, which owns sub_payload
+    if (ctx->sub_hex)
+    {
+        if (message.payload_len / 2 > sizeof(ctx->sub_payload) ||
+            !at_hex_decode((const char *)message.payload, message.payload_len, ctx->sub_payload))
+        {
+            ESP_LOGW(TAG, "URC: MQTT message on %.*s is not valid hex", (int)message.topic_len, message.topic);
+            return;
+        }
+        message.payload = ctx->sub_payload;
+        message.payload_len /= 2;
+    }
+
+    xSemaphoreTake(ctx->sub_lock, portMAX_DELAY);
+    size_t handled = topic_trie_match(&ctx->subscriptions, message.topic, message.topic_len,
+                                      sim7080g_subscription_deliver, &message);
+    xSemaphoreGive(ctx->sub_lock);
+
+    if (handled == 0)
+    {
+        ESP_LOGW(TAG, "URC: MQTT message on %.*s (%u bytes) matches no subscription",
+                 (int)message.topic_len, message.topic, (unsigned)message.payload_len);
+    }
+}
+
+static esp_err_t sim7080g_urc_register_builtin_handlers(const sim7080g_handle_t *sim7080g_handle)
+{
+    const struct
+    {
+        const char *prefix;
+        sim7080g_urc_handler_t handler;
+    } builtin_handlers[] = {
+        {"+APP PDP:", sim7080g_urc_app_pdp},
+        {"+SMSTATE:", sim7080g_urc_smstate},
+        {"+CEREG:", sim7080g_urc_cereg},
+        {"+CPIN:", sim7080g_urc_cpin},
+        {"+CFUN:", sim7080g_urc_cfun},
+        {"SMS Ready", sim7080g_urc_sms_ready},
+        {"+SMSUB:", sim7080g_urc_smsub},
+        {"+SMPUB:", sim7080g_urc_smpub},
+    };
+
+    for (size_t i = 0; i < sizeof(builtin_handlers) / sizeof(builtin_handlers[0]); i++)
+    {
+        esp_err_t err = sim7080g_urc_register(sim7080g_handle,
+                                              builtin_handlers[i].prefix,
+                                              builtin_handlers[i].handler,
+                                              sim7080g_handle->ctx);
+        if (err != ESP_OK)
+        {
+            return err;
+        }
+    }
+    return ESP_OK;
+}
+
+/// @brief Split received bytes into CRLF delimited lines
+static void sim7080g_rx_frame_bytes(sim7080g_ctx_t *ctx, const uint8_t *data, size_t len)
+{
+    for (size_t i = 0; i < len; i++)
+    {
+        char c = (char)data[i];
+        if (c == '\r')
+        {
+            continue;
+        }
+        if (c == '\n')
+        {
+            if (ctx->line_len > 0)
+            {
+                ctx->line[ctx->line_len] = '\0';
+                if (ctx->line_truncated)
+                {
+                    ESP_LOGW(TAG, "RX line longer than %d bytes - truncated", SIM7080G_RX_LINE_MAX_LEN - 1);
+                }
+                sim7080g_rx_deliver_line(ctx, ctx->line, ctx->line_len, false);
+            }
+            ctx->line_len = 0;
+            ctx->line_truncated = false;
+            continue;
+        }
+
+        if (ctx->line_len < sizeof(ctx->line) - 1)
+        {
+            ctx->line[ctx->line_len++] = c;
+        }
+        else
+        {
+            ctx->line_truncated = true;
+        }
+    }
+
+    // The '>' data prompt is not followed by a line ending - deliver it as soon as it shows up
+    if (ctx->line_len > 0 && ctx->line[0] == '>')
+    {
+        ctx->line[ctx->line_len] = '\0';
+        sim7080g_rx_deliver_line(ctx, ctx->line, ctx->line_len, true);
+        ctx->line_len = 0;
+    }
+}
+
+/// @brief Driver owned RX task - blocks on the UART event queue so it costs nothing while the line is idle
+static void sim7080g_rx_task(void *arg)
+{
+    sim7080g_ctx_t *ctx = (sim7080g_ctx_t *)arg;
+    uart_event_t event;
+    uint8_t chunk[SIM7080G_RX_CHUNK_LEN];
+
+    for (;;)
+    {
+        if (xQueueReceive(ctx->uart_event_queue, &event, portMAX_DELAY) != pdTRUE)
+        {
+            continue;
+        }
+
+        switch (event.type)
+        {
+        case UART_DATA:
+        case UART_PATTERN_DET:
+        {
+            size_t buffered = 0;
+            uart_get_buffered_data_len(ctx->port, &buffered);
+            while (buffered > 0)
+            {
+                int bytes_read = uart_read_bytes(ctx->port, chunk, buffered < sizeof(chunk) ? buffered : sizeof(chunk), 0);
+                if (bytes_read <= 0)
+                {
+                    break;
+                }
+                sim7080g_rx_frame_bytes(ctx, chunk, (size_t)bytes_read);
+                buffered -= (size_t)bytes_read;
+            }
+            // Positions are not used - the framer finds line endings itself - so keep the pattern queue from filling up
+            while (uart_pattern_pop_pos(ctx->port) != -1)
+            {
+            }
+            // Publish callbacks of any acks just handled - URC handlers only queue them, as they run under the RX locks
+            sim7080g_inflight_flush(ctx);
+            break;
+        }
+
+        case UART_FIFO_OVF:
+        case UART_BUFFER_FULL:
+            // Whatever is buffered is already missing bytes - drop it and start framing again from a clean line
+            ctx->rx_overflow_count++;
+            ESP_LOGW(TAG, "UART RX overflow (%s) - flushing input, count: %lu",
+                     event.type == UART_FIFO_OVF ? "FIFO" : "ring buffer",
+                     (unsigned long)ctx->rx_overflow_count);
+            uart_flush_input(ctx->port);
+            xQueueReset(ctx->uart_event_queue);
+            ctx->line_len = 0;
+            ctx->line_truncated = false;
+            break;
+
+        default:
+            ESP_LOGD(TAG, "Unhandled UART event type: %d", event.type);
+            break;
+        }
+    }
+}
+
+/// @brief Take the highest priority (then oldest) pending request off the list, NULL if none
+static sim7080g_arbiter_req_t *sim7080g_arbiter_next(sim7080g_ctx_t *ctx)
+{
+    int best = -1;
+
+    xSemaphoreTake(ctx->arbiter_lock, portMAX_DELAY);
+    for (int i = 0; i < SIM7080G_ARBITER_QUEUE_LEN; i++)
+    {
+        const sim7080g_arbiter_req_t *req = ctx->pending[i];
+        if (req == NULL)
+        {
+            continue;
+        }
+        if (best < 0 ||
+            req->priority > ctx->pending[best]->priority ||
+            (req->priority == ctx->pending[best]->priority && (int32_t)(req->seq - ctx->pending[best]->seq) < 0))
+        {
+            best = i;
+        }
+    }
+
+    sim7080g_arbiter_req_t *req = NULL;
+    if (best >= 0)
+    {
+        req = ctx->pending[best];
+        ctx->pending[best] = NULL;
+    }
+    xSemaphoreGive(ctx->arbiter_lock);
+
+    if (req != NULL)
+    {
+        xSemaphoreGive(ctx->arbiter_slots);
+    }
+    return req;
+}
+
+static void sim7080g_arbiter_task(void *arg)
+{
+    sim7080g_ctx_t *ctx = (sim7080g_ctx_t *)arg;
+    bool stopping = false;
+
+    while (!stopping)
+    {
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+
+        sim7080g_arbiter_req_t *req;
+        while ((req = sim7080g_arbiter_next(ctx)) != NULL)
+        {
+            esp_err_t result;
+            if (req->has_deadline && (int32_t)(xTaskGetTickCount() - req->deadline) >= 0)
+            {
+                result = ESP_ERR_TIMEOUT;
+            }
+            else
+            {
+                result = req->fn(req->handle, req->arg);
+            }
+
+            if (req->async != NULL)
+            {
+                sim7080g_async_complete(ctx, req->async, result);
+                continue;
+            }
+
+            // The request lives on the caller's stack - it must not be touched once done is set
+            TaskHandle_t caller = req->caller;
+            xSemaphoreTake(ctx->arbiter_lock, portMAX_DELAY);
+            req->result = result;
+            req->done = true;
+            xSemaphoreGive(ctx->arbiter_lock);
+            xTaskNotifyGiveIndexed(caller, SIM7080G_ARBITER_NOTIFY_INDEX);
+        }
+
+        xSemaphoreTake(ctx->arbiter_lock, portMAX_DELAY);
+        stopping = ctx->arbiter_stopping;
+        xSemaphoreGive(ctx->arbiter_lock);
+    }
+
+    xSemaphoreGive(ctx->arbiter_stopped);
+    vTaskDelete(NULL);
+}
+
+typedef struct
+{
+    const char *data;
+    size_t len;
+    sim7080g_rx_waiter_t *waiter;
+    uint32_t timeout_ms;
+    int bytes_read;
+} sim7080g_exchange_args_t;
+
+static esp_err_t sim7080g_exchange_fn(const sim7080g_handle_t *sim7080g_handle, void *arg)
+{
+    sim7080g_exchange_args_t *args = (sim7080g_exchange_args_t *)arg;
+
+    // Lines are collected by the RX task from here on - nothing received in between is thrown away
+    sim7080g_rx_begin(sim7080g_handle, args->waiter);
+
+    int bytes_written = uart_write_bytes(sim7080g_handle->uart_config.port_num, args->data, args->len);
+    if (bytes_written != (int)args->len)
+    {
+        sim7080g_rx_wait(sim7080g_handle, args->waiter, 0);
+        return ESP_FAIL;
+    }
+
+    // Returns as soon as the waiter completes rather than waiting out the full timeout
+    args->bytes_read = sim7080g_rx_wait(sim7080g_handle, args->waiter, args->timeout_ms);
+    return ESP_OK;
+}
+
+/// @brief Write data and collect the response into the waiter, run through the command arbiter
+/// @return ESP_FAIL if the write failed, ESP_ERR_TIMEOUT if the device stayed busy past the default deadline, else ESP_OK
+static esp_err_t sim7080g_exchange(const sim7080g_handle_t *sim7080g_handle,
+                                   const char *data,
+                                   size_t len,
+                                   sim7080g_rx_waiter_t *waiter,
+                                   uint32_t timeout_ms,
+                                   int *bytes_read_out)
+{
+    sim7080g_exchange_args_t args = {
+        .data = data,
+        .len = len,
+        .waiter = waiter,
+        .timeout_ms = timeout_ms,
+    };
+
+    esp_err_t err = sim7080g_arbiter_call(sim7080g_handle,
+                                          sim7080g_exchange_fn,
+                                          &args,
+                                          SIM7080G_CMD_PRIORITY_NORMAL,
+                                          SIM7080G_ARBITER_DEFAULT_DEADLINE_MS);
+    *bytes_read_out = args.bytes_read;
+    return err;
+}
+
+static void sim7080g_log_config_params(const sim7080g_handle_t *sim7080g_handle)
+{
+    ESP_LOGI(TAG, "SIM7080G UART Config:");
+    ESP_LOGI(TAG, "  - RX GPIO: %d", sim7080g_handle->uart_config.gpio_num_rx);
+    ESP_LOGI(TAG, "  - TX GPIO: %d", sim7080g_handle->uart_config.gpio_num_tx);
+    ESP_LOGI(TAG, "  - Port Num: %d", sim7080g_handle->uart_config.port_num);
+    ESP_LOGI(TAG, "  - Target Baud Rate: %lu", (unsigned long)sim7080g_handle->uart_config.target_baud_rate);
+    ESP_LOGI(TAG, "  - HW Flow Control: %s", sim7080g_handle->uart_config.hw_flow_control ? "RTS/CTS" : "Disabled");
+    if (sim7080g_handle->uart_config.hw_flow_control)
+    {
+        ESP_LOGI(TAG, "  - RTS GPIO: %d", sim7080g_handle->uart_config.gpio_num_rts);
+        ESP_LOGI(TAG, "  - CTS GPIO: %d", sim7080g_handle->uart_config.gpio_num_cts);
+    }
+
+    ESP_LOGI(TAG, "SIM7080G MQTT Config:");
+    ESP_LOGI(TAG, "  - Broker URL: %s", sim7080g_handle->mqtt_config.broker_url);
+    ESP_LOGI(TAG, "  - Username: %s", sim7080g_handle->mqtt_config.username);
+    ESP_LOGI(TAG, "  - Client ID: %s", sim7080g_handle->mqtt_config.client_id);
+    ESP_LOGI(TAG, "  - Client Password: %s", sim7080g_handle->mqtt_config.client_password);
+    ESP_LOGI(TAG, "  - Port: %d", sim7080g_handle->mqtt_config.port);
+
+    return;
+}
+
+static esp_err_t sim7080g_uart_init(sim7080g_handle_t *sim7080g_handle)
+{
+    const sim7080g_uart_config_t *sim7080g_uart_config = &sim7080g_handle->uart_config;
+    const uart_port_t port = (uart_port_t)sim7080g_uart_config->port_num;
+
+    uart_config_t uart_config = {
+        .baud_rate = SIM7080G_UART_BAUD_RATE,
+        .data_bits = UART_DATA_8_BITS,
+        .parity = UART_PARITY_DISABLE,
+        .stop_bits = UART_STOP_BITS_1,
+        .flow_ctrl = UART_HW_FLOWCTRL_DISABLE,
+        .source_clk = UART_SCLK_DEFAULT,
+    };
+
+    sim7080g_ctx_t *ctx = calloc(1, sizeof(sim7080g_ctx_t));
+    if (ctx == NULL)
+    {
+        ESP_LOGE(TAG, "Error allocating driver runtime state");
+        return ESP_ERR_NO_MEM;
+    }
+    ctx->port = port;
+    ctx->baud_rate = SIM7080G_UART_BAUD_RATE;
+    ctx->chunk_msg_id = (uint16_t)esp_random(); // So ids from before an ESP32 restart are not reused straight away
+    ctx->status_cache_ttl_ms = sim7080g_uart_config->status_cache_ttl_ms > 0 ? sim7080g_uart_config->status_cache_ttl_ms
+                                                                             : SIM7080G_STATUS_CACHE_DEFAULT_TTL_MS;
+
+    memset(ctx->urc_buckets, -1, sizeof(ctx->urc_buckets));
+
+    esp_err_t err = ESP_OK;
+    ctx->rx_lock = xSemaphoreCreateMutex();
+    ctx->rx_done = xSemaphoreCreateBinary();
+    ctx->urc_lock = xSemaphoreCreateMutex();
+    ctx->status_events = xEventGroupCreate();
+    ctx->arbiter_lock = xSemaphoreCreateMutex();
+    ctx->arbiter_stopped = xSemaphoreCreateBinary();
+    ctx->arbiter_slots = xSemaphoreCreateCounting(SIM7080G_ARBITER_QUEUE_LEN, SIM7080G_ARBITER_QUEUE_LEN);
+    ctx->inflight_lock = xSemaphoreCreateMutex();
+    ctx->inflight_slots = xSemaphoreCreateCounting(SIM7080G_MQTT_INFLIGHT_WINDOW, SIM7080G_MQTT_INFLIGHT_WINDOW);
+    ctx->sub_lock = xSemaphoreCreateMutex();
+    ctx->status_cache_lock = xSemaphoreCreateMutex();
+    topic_trie_init(&ctx->subscriptions);
+    if (ctx->rx_lock == NULL || ctx->rx_done == NULL || ctx->urc_lock == NULL || ctx->status_events == NULL ||
+        ctx->arbiter_lock == NULL || ctx->arbiter_stopped == NULL || ctx->arbiter_slots == NULL || ctx->inflight_lock == NULL || ctx->inflight_slots == NULL ||
+        ctx->sub_lock == NULL || ctx->status_cache_lock == NULL)
+    {
+        ESP_LOGE(TAG, "Error creating RX semaphores");
+        err = ESP_ERR_NO_MEM;
+        goto err_free_ctx;
+    }
+
+    err = uart_driver_install(port, SIM87080G_UART_BUFF_SIZE * 2, 0, SIM7080G_UART_EVENT_QUEUE_LEN, &ctx->uart_event_queue, 0);
+    if (err != ESP_OK)
+    {
+        ESP_LOGE(TAG, "Error installing UART driver: %s", esp_err_to_name(err));
+        goto err_free_ctx;
+    }
+
+    err = uart_param_config(port, &uart_config);
+    if (err != ESP_OK)
+    {
+        ESP_LOGE(TAG, "Error configuring UART parameters: %s", esp_err_to_name(err));
+        goto err_delete_driver;
+    }
+
+    // Flow control itself is only switched on once the device has agreed to it (see sim7080g_enable_hw_flow_control)
+    err = uart_set_pin(port,
+                       sim7080g_uart_config->gpio_num_rx,
+                       sim7080g_uart_config->gpio_num_tx,
+                       sim7080g_uart_config->hw_flow_control ? sim7080g_uart_config->gpio_num_rts : UART_PIN_NO_CHANGE,
+                       sim7080g_uart_config->hw_flow_control ? sim7080g_uart_config->gpio_num_cts : UART_PIN_NO_CHANGE);
+    if (err != ESP_OK)
+    {
+        ESP_LOGE(TAG, "Error setting UART pins: %s", esp_err_to_name(err));
+        goto err_delete_driver;
+    }
+
+    // Raise a pattern event on every line feed so complete lines reach the RX task without waiting on the RX FIFO timeout
+    err = sim7080g_rx_set_pattern(ctx, SIM7080G_RX_LINE_PATTERN);
+    if (err == ESP_OK)
+    {
+        err = uart_pattern_queue_reset(port, SIM7080G_UART_EVENT_QUEUE_LEN);
+    }
+    if (err != ESP_OK)
+    {
+        ESP_LOGE(TAG, "Error enabling UART line pattern detection: %s", esp_err_to_name(err));
+        goto err_delete_driver;
+    }
+
+    UBaseType_t priority = sim7080g_uart_config->rx_task_priority > 0 ? (UBaseType_t)sim7080g_uart_config->rx_task_priority
+                                                                       : SIM7080G_RX_TASK_DEFAULT_PRIORITY;
+    BaseType_t core_id = sim7080g_uart_config->rx_task_pin_to_core ? (BaseType_t)sim7080g_uart_config->rx_task_core_id
+                                                                   : tskNO_AFFINITY;
+    if (xTaskCreatePinnedToCore(sim7080g_rx_task, "sim7080g_rx", SIM7080G_RX_TASK_STACK_SIZE, ctx, priority, &ctx->rx_task, core_id) != pdPASS)
+    {
+        ESP_LOGE(TAG, "Error creating UART RX task");
+        err = ESP_ERR_NO_MEM;
+        goto err_delete_driver;
+    }
+
+    UBaseType_t arbiter_priority = sim7080g_uart_config->arbiter_task_priority > 0 ? (UBaseType_t)sim7080g_uart_config->arbiter_task_priority
+                                                                                : SIM7080G_ARBITER_TASK_DEFAULT_PRIORITY;
+    if (xTaskCreatePinnedToCore(sim7080g_arbiter_task, "sim7080g_cmd", SIM7080G_ARBITER_TASK_STACK_SIZE, ctx, arbiter_priority, &ctx->arbiter_task, core_id) != pdPASS)
+    {
+        ESP_LOGE(TAG, "Error creating command arbiter task");
+        err = ESP_ERR_NO_MEM;
+        goto err_delete_rx_task;
+    }
+
+    sim7080g_handle->ctx = ctx;
+    return ESP_OK;
+
+err_delete_rx_task:
+    vTaskDelete(ctx->rx_task);
+err_delete_driver:
+    uart_driver_delete(port);
+err_free_ctx:
+    if (ctx->status_cache_lock != NULL)
+    {
+        vSemaphoreDelete(ctx->status_cache_lock);
+    }
+    if (ctx->sub_lock != NULL)
+    {
+        vSemaphoreDelete(ctx->sub_lock);
+    }
+    if (ctx->inflight_slots != NULL)
+    {
+        vSemaphoreDelete(ctx->inflight_slots);
+    }
+    if (ctx->inflight_lock != NULL)
+    {
+        vSemaphoreDelete(ctx->inflight_lock);
+    }
+    if (ctx->arbiter_slots != NULL)
+    {
+        vSemaphoreDelete(ctx->arbiter_slots);
+    }
+    if (ctx->arbiter_stopped != NULL)
+    {
+        vSemaphoreDelete(ctx->arbiter_stopped);
+    }
+    if (ctx->arbiter_lock != NULL)
+    {
+        vSemaphoreDelete(ctx->arbiter_lock);
+    }
+    if (ctx->status_events != NULL)
+    {
+        vEventGroupDelete(ctx->status_events);
+    }
+    if (ctx->urc_lock != NULL)
+    {
+        vSemaphoreDelete(ctx->urc_lock);
+    }
+    if (ctx->rx_done != NULL)
+    {
+        vSemaphoreDelete(ctx->rx_done);
+    }
+    if (ctx->rx_lock != NULL)
+    {
+        vSemaphoreDelete(ctx->rx_lock);
+    }
+    free(ctx);
+    return err;
+}
+
+/// @brief Switch the ESP32 side of the link to a new baud rate
+static void sim7080g_set_local_baud_rate(const sim7080g_handle_t *sim7080g_handle, uint32_t baud_rate)
+{
+    sim7080g_ctx_t *ctx = sim7080g_handle->ctx;
+
+    uart_wait_tx_done(ctx->port, pdMS_TO_TICKS(100));
+    uart_set_baudrate(ctx->port, baud_rate);
+    ctx->baud_rate = baud_rate;
+
+    // Let the device finish its own switch, then drop anything garbled while the two ends disagreed
+    vTaskDelay(pdMS_TO_TICKS(20));
+    uart_flush_input(ctx->port);
+}
+
+static esp_err_t sim7080g_probe_link(const sim7080g_handle_t *sim7080g_handle)
+{
+    char response[AT_RESPONSE_MAX_LEN] = {0};
+    return send_at_cmd(sim7080g_handle, &AT_AT, AT_CMD_TYPE_EXECUTE, NULL, response, sizeof(response), SIM7080G_BAUD_PROBE_TIMEOUT_MS);
+}
+
+/// @brief Find the rate the device UART is running at, starting with the current one
+static esp_err_t sim7080g_detect_baud_rate(const sim7080g_handle_t *sim7080g_handle)
+{
+    sim7080g_ctx_t *ctx = sim7080g_handle->ctx;
+    const uint32_t initial_rate = ctx->baud_rate;
+
+    if (sim7080g_probe_link(sim7080g_handle) == ESP_OK)
+    {
+        ESP_LOGI(TAG, "Device responding at %lu baud", (unsigned long)ctx->baud_rate);
+        return ESP_OK;
+    }
+
+    for (size_t i = 0; i < SIM7080G_NUM_SUPPORTED_BAUD_RATES; i++)
+    {
+        if (sim7080g_supported_baud_rates[i] == initial_rate)
+        {
+            continue;
+        }
+
+        sim7080g_set_local_baud_rate(sim7080g_handle, sim7080g_supported_baud_rates[i]);
+        if (sim7080g_probe_link(sim7080g_handle) == ESP_OK)
+        {
+            ESP_LOGI(TAG, "Device responding at %lu baud", (unsigned long)ctx->baud_rate);
+            return ESP_OK;
+        }
+    }
+
+    sim7080g_set_local_baud_rate(sim7080g_handle, initial_rate);
+    return ESP_ERR_NOT_FOUND;
+}
+
+static esp_err_t sim7080g_enable_hw_flow_control(const sim7080g_handle_t *sim7080g_handle)
+{
+    char response[AT_RESPONSE_MAX_LEN] = {0};
+    esp_err_t err = send_at_cmd(sim7080g_handle, &AT_IFC, AT_CMD_TYPE_WRITE, "2,2", response, sizeof(response), 1000);
+    if (err != ESP_OK)
+    {
+        return err;
+    }
+
+    err = uart_set_hw_flow_ctrl(sim7080g_handle->ctx->port, UART_HW_FLOWCTRL_CTS_RTS, SIM7080G_UART_RTS_THRESHOLD);
+    if (err != ESP_OK)
+    {
+        return err;
+    }
+
+    ESP_LOGI(TAG, "RTS/CTS flow control enabled");
+    return sim7080g_probe_link(sim7080g_handle);
+}
+
+/// @brief Move both ends of the link to a new rate with AT+IPR and verify it
+/// @return ESP_OK if the link works at the new rate - otherwise both ends are returned to the previous rate
+static esp_err_t sim7080g_switch_baud_rate(const sim7080g_handle_t *sim7080g_handle, uint32_t baud_rate)
+{
+    sim7080g_ctx_t *ctx = sim7080g_handle->ctx;
+    const uint32_t prev_rate = ctx->baud_rate;
+
+    char args[16];
+    snprintf(args, sizeof(args), "%lu", (unsigned long)baud_rate);
+
+    // The OK still comes back at the old rate - the device switches straight after it
+    char response[AT_RESPONSE_MAX_LEN] = {0};
+    esp_err_t err = send_at_cmd(sim7080g_handle, &AT_IPR, AT_CMD_TYPE_WRITE, args, response, sizeof(response), 1000);
+    if (err != ESP_OK)
+    {
+        ESP_LOGW(TAG, "Device rejected %lu baud", (unsigned long)baud_rate);
+        return err;
+    }
+
+    sim7080g_set_local_baud_rate(sim7080g_handle, baud_rate);
+    if (sim7080g_probe_link(sim7080g_handle) == ESP_OK)
+    {
+        ESP_LOGI(TAG, "Link verified at %lu baud", (unsigned long)baud_rate);
+        return ESP_OK;
+    }
+
+    // The device may have switched but the link is unreliable at this rate - ask it (blind) to go back
+    ESP_LOGW(TAG, "Link check failed at %lu baud - falling back to %lu", (unsigned long)baud_rate, (unsigned long)prev_rate);
+    char cmd[AT_CMD_MAX_LEN];
+    int cmd_len = snprintf(cmd, sizeof(cmd), "%s%lu\r\n", AT_IPR.write.cmd_string, (unsigned long)prev_rate);
+    uart_write_bytes(ctx->port, cmd, cmd_len);
+
+    sim7080g_set_local_baud_rate(sim7080g_handle, prev_rate);
+    if (sim7080g_probe_link(sim7080g_handle) != ESP_OK)
+    {
+        // Lost track of the device rate - go looking for it
+        sim7080g_detect_baud_rate(sim7080g_handle);
+    }
+    return ESP_FAIL;
+}
+
+/// @brief Switch to the configured target rate, stepping down through the supported rates until one verifies
+static esp_err_t sim7080g_negotiate_baud_rate(const sim7080g_handle_t *sim7080g_handle)
+{
+    sim7080g_ctx_t *ctx = sim7080g_handle->ctx;
+    const uint32_t target = sim7080g_handle->uart_config.target_baud_rate;
+
+    if (target == 0 || target == ctx->baud_rate)
+    {
+        return ESP_OK;
+    }
+
+    for (size_t i = 0; i < SIM7080G_NUM_SUPPORTED_BAUD_RATES; i++)
+    {
+        uint32_t rate = sim7080g_supported_baud_rates[i];
+        if (rate > target)
+        {
+            continue;
+        }
+        if (rate == ctx->baud_rate)
+        {
+            break;
+        }
+        if (sim7080g_switch_baud_rate(sim7080g_handle, rate) == ESP_OK)
+        {
+            return ESP_OK;
+        }
+    }
+
+    ESP_LOGW(TAG, "Could not reach target of %lu baud - staying at %lu", (unsigned long)target, (unsigned long)ctx->baud_rate);
+    return (sim7080g_probe_link(sim7080g_handle) == ESP_OK) ? ESP_OK : ESP_ERR_INVALID_STATE;
+}
+
+/// @brief CRC-32 of every config value the device holds state for - a warm start needs the same on both sides of the restart
+static uint32_t sim7080g_config_fingerprint(const sim7080g_handle_t *sim7080g_handle)
+{
+    const sim7080g_mqtt_config_t *mqtt = &sim7080g_handle->mqtt_config;
+    const char *const strings[] = {mqtt->broker_url, mqtt->client_id, mqtt->username, mqtt->client_password};
+    uint32_t crc = 0;
+    for (size_t i = 0; i < sizeof(strings) / sizeof(strings[0]); i++)
+    {
+        crc = esp_rom_crc32_le(crc, (const uint8_t *)strings[i], strlen(strings[i]) + 1); // With the null, so "ab","c" != "a","bc"
+    }
+
+    // Field by field - struct padding is not guaranteed to be zero
+    uint32_t target_baud_rate = sim7080g_handle->uart_config.target_baud_rate;
+    const uint8_t values[] = {
+        (uint8_t)mqtt->port,
+        (uint8_t)(mqtt->port >> 8),
+        mqtt->async_publish,
+        mqtt->binary_downlink,
+        sim7080g_handle->uart_config.hw_flow_control,
+        (uint8_t)target_baud_rate,
+        (uint8_t)(target_baud_rate >> 8),
+        (uint8_t)(target_baud_rate >> 16),
+        (uint8_t)(target_baud_rate >> 24),
+    };
+    return esp_rom_crc32_le(crc, values, sizeof(values));
+}
+
+static uint32_t sim7080g_warm_state_crc(const sim7080g_warm_state_t *state)
+{
+    return esp_rom_crc32_le(0, (const uint8_t *)state, offsetof(sim7080g_warm_state_t, crc));
+}
+
+/// @brief Record the config and UART rate the device was just brought up with
+static void sim7080g_warm_state_save(const sim7080g_handle_t *sim7080g_handle)
+{
+    sim7080g_warm_state.magic = SIM7080G_WARM_STATE_MAGIC;
+    sim7080g_warm_state.fingerprint = sim7080g_config_fingerprint(sim7080g_handle);
+    sim7080g_warm_state.baud_rate = sim7080g_handle->ctx->baud_rate;
+    sim7080g_warm_state.crc = sim7080g_warm_state_crc(&sim7080g_warm_state);
+}
+
+/// @brief Take over a device left online by the previous run, in one exchange
+/// @note The device settings (UART rate, flow control, echo, MQTT parameters) are known from the fingerprint, so only
+///       the bearer and session need checking. On any failure the caller runs the full init - nothing here needs undoing.
+static esp_err_t sim7080g_warm_start(const sim7080g_handle_t *sim7080g_handle)
+{
+    sim7080g_ctx_t *ctx = sim7080g_handle->ctx;
+    const sim7080g_warm_state_t *state = &sim7080g_warm_state;
+    if (state->magic != SIM7080G_WARM_STATE_MAGIC || state->crc != sim7080g_warm_state_crc(state) ||
+        state->fingerprint != sim7080g_config_fingerprint(sim7080g_handle))
+    {
+        ESP_LOGI(TAG, "Warm start: no record of this device and config - cold start");
+        return ESP_ERR_NOT_FOUND;
+    }
+
+    sim7080g_set_local_baud_rate(sim7080g_handle, state->baud_rate);
+    if (sim7080g_handle->uart_config.hw_flow_control)
+    {
+        esp_err_t err = uart_set_hw_flow_ctrl(ctx->port, UART_HW_FLOWCTRL_CTS_RTS, SIM7080G_UART_RTS_THRESHOLD);
+        if (err != ESP_OK)
+        {
+            return err;
+        }
+    }
+
+    char cnact_response[AT_RESPONSE_MAX_LEN] = {0};
+    char smstate_response[64] = {0};
+    sim7080g_at_batch_entry_t entries[] = {
+        {.cmd = &AT_CNACT, .type = AT_CMD_TYPE_READ, .response = cnact_response, .response_size = sizeof(cnact_response)},
+        {.cmd = &AT_SMSTATE, .type = AT_CMD_TYPE_READ, .response = smstate_response, .response_size = sizeof(smstate_response)},
+    };
+    esp_err_t err = sim7080g_send_at_batch(sim7080g_handle, entries, sizeof(entries) / sizeof(entries[0]), SIM7080G_BAUD_PROBE_TIMEOUT_MS);
+    if (err != ESP_OK)
+    {
+        ESP_LOGI(TAG, "Warm start: device not answering at %lu baud - cold start", (unsigned long)state->baud_rate);
+        sim7080g_set_local_baud_rate(sim7080g_handle, SIM7080G_UART_BAUD_RATE);
+        return err;
+    }
+
+    bool pdp_active = false;
+    sim7080g_cnact_reply_t cnact;
+    at_parser_t parser;
+    at_parser_init(&parser, cnact_response, strlen(cnact_response));
+    while (!pdp_active && at_decoder_next(&sim7080g_decoders[SIM7080G_DECODER_CNACT], &parser, &cnact) >= 2)
+    {
+        pdp_active = cnact.pdpidx == 0 && sim7080g_cnact_status_active(cnact.status);
+    }
+
+    sim7080g_int_reply_t smstate;
+    bool mqtt_connected = sim7080g_decode(SIM7080G_DECODER_SMSTATE, smstate_response, &smstate) == 1 &&
+                          (smstate.value == 1 || smstate.value == 2);
+    if (!pdp_active || !mqtt_connected)
+    {
+        ESP_LOGI(TAG, "Warm start: bearer %s, MQTT %s - cold start",
+                 pdp_active ? "up" : "down", mqtt_connected ? "connected" : "disconnected");
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    // The session needs a working registration and SIM - so every status bit is known to be set
+    xEventGroupSetBits(ctx->status_events, SIM7080G_EVT_FUNCTIONAL | SIM7080G_EVT_SIM_READY | SIM7080G_EVT_SMS_READY |
+                                               SIM7080G_EVT_REGISTERED | SIM7080G_EVT_PDP_ACTIVE |
+                                               SIM7080G_EVT_MQTT_CONNECTED);
+    ctx->async_publish = sim7080g_handle->mqtt_config.async_publish;
+    ctx->sub_hex = sim7080g_handle->mqtt_config.binary_downlink;
+    ctx->warm_started = true;
+    ESP_LOGI(TAG, "Warm start: bearer and MQTT session up at %lu baud", (unsigned long)ctx->baud_rate);
+    return ESP_OK;
+}
+
+/**
+ * @brief Check if current device MQTT parameters match those in the handle config
+ *
+ * @param sim7080g_handle Pointer to initialized device handle
+ * @param params_match_out Pointer to store match result
+ * @return esp_err_t ESP_OK if check completed successfully
+ */
+static esp_err_t sim7080g_mqtt_check_parameters_match(const sim7080g_handle_t *sim7080g_handle,
+                                                      bool *params_match_out)
+{
+    if (!sim7080g_handle || !params_match_out)
+    {
+        ESP_LOGE(TAG, "Invalid parameters");
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    // Initialize output
+    *params_match_out = false;
+
+    // Get current device parameters
+    mqtt_parameters_t current_params;
+    esp_err_t ret = sim7080g_mqtt_get_parameters(sim7080g_handle, &current_params);
+    if (ret != ESP_OK)
+    {
+        ESP_LOGE(TAG, "Failed to get current MQTT parameters");
+        return ret;
+    }
+
+    // Compare relevant parameters from handle config
+    bool match = true; // Start true, set false if any mismatch
+
+    // Check URL
+    if (strcmp(current_params.broker_url, sim7080g_handle->mqtt_config.broker_url) != 0)
+    {
+        ESP_LOGD(TAG, "URL mismatch - Current: %s, Config: %s",
+                 current_params.broker_url, sim7080g_handle->mqtt_config.broker_url);
+        match = false;
+    }
+
+    // Check port
+    if (current_params.port != sim7080g_handle->mqtt_config.port)
+    {
+        ESP_LOGD(TAG, "Port mismatch - Current: %d, Config: %d",
+                 current_params.port, sim7080g_handle->mqtt_config.port);
+        match = false;
+    }
+
+    // Check client ID
+    if (strcmp(current_params.client_id, sim7080g_handle->mqtt_config.client_id) != 0)
+    {
+        ESP_LOGD(TAG, "Client ID mismatch - Current: %s, Config: %s",
+                 current_params.client_id, sim7080g_handle->mqtt_config.client_id);
+        match = false;
+    }
+
+    // Check username
+    if (strcmp(current_params.username, sim7080g_handle->mqtt_config.username) != 0)
+    {
+        ESP_LOGD(TAG, "Username mismatch - Current: %s, Config: %s",
+                 current_params.username, sim7080g_handle->mqtt_config.username);
+        match = false;
+    }
+
+    // Check password
+    if (strcmp(current_params.client_password, sim7080g_handle->mqtt_config.client_password) != 0)
+    {
+        ESP_LOGD(TAG, "Password mismatch - Current: %s, Config: %s",
+                 current_params.client_password, sim7080g_handle->mqtt_config.client_password);
+        match = false;
+    }
+
+    // Check the modes the driver depends on
+    if (current_params.async_mode != sim7080g_handle->mqtt_config.async_publish ||
+        current_params.sub_hex != sim7080g_handle->mqtt_config.binary_downlink)
+    {
+        ESP_LOGD(TAG, "Mode mismatch - Current: ASYNCMODE %d SUBHEX %d, Config: %d %d",
+                 current_params.async_mode, current_params.sub_hex,
+                 sim7080g_handle->mqtt_config.async_publish, sim7080g_handle->mqtt_config.binary_downlink);
+        match = false;
+    }
+
+    *params_match_out = match;
+
+    if (match)
+    {
+        ESP_LOGI(TAG, "MQTT parameters match current config");
+    }
+    else
+    {
+        ESP_LOGI(TAG, "MQTT parameters differ from current config");
+    }
+
+    return ESP_OK;
+}
+
+/// @brief Parse an AT+SMCONF? response - one "<TAG>: <value>" line per parameter
+/// @return true if at least one parameter was found
+static bool sim7080g_parse_mqtt_parameters(const char *response, size_t len, mqtt_parameters_t *params_out)
+{
+    at_parser_t parser, line;
+    at_parser_init(&parser, response, len);
+    bool found_any = false;
+
+    while (at_parser_next_line(&parser, &line))
+    {
+        at_str_t str;
+        int value;
+
+        if (at_parser_match(&line, "CLIENTID:"))
+        {
+            if (at_parser_str(&line, &str))
+            {
+                at_str_copy(str, params_out->client_id, sizeof(params_out->client_id));
+                found_any = true;
+            }
+        }
+        else if (at_parser_match(&line, "URL:"))
+        {
+            // 'URL: "url",port'
+            if (at_parser_str(&line, &str) && at_parser_int(&line, &value))
+            {
+                at_str_copy(str, params_out->broker_url, sizeof(params_out->broker_url));
+                params_out->port = (uint16_t)value;
+                found_any = true;
+            }
+        }
+        else if (at_parser_match(&line, "USERNAME:"))
+        {
+            if (at_parser_str(&line, &str))
+            {
+                at_str_copy(str, params_out->username, sizeof(params_out->username));
+                found_any = true;
+            }
+        }
+        else if (at_parser_match(&line, "PASSWORD:"))
+        {
+            if (at_parser_str(&line, &str))
+            {
+                at_str_copy(str, params_out->client_password, sizeof(params_out->client_password));
+                found_any = true;
+            }
+        }
+        else if (at_parser_match(&line, "KEEPTIME:"))
+        {
+            if (at_parser_int(&line, &value))
+            {
+                params_out->keepalive = (uint16_t)value;
+                found_any = true;
+            }
+        }
+        else if (at_parser_match(&line, "CLEANSS:"))
+        {
+            if (at_parser_int(&line, &value))
+            {
+                params_out->clean_session = (value == 1);
+                found_any = true;
+            }
+        }
+        else if (at_parser_match(&line, "QOS:"))
+        {
+            if (at_parser_int(&line, &value))
+            {
+                params_out->qos = (uint8_t)value;
+                found_any = true;
+            }
+        }
+        else if (at_parser_match(&line, "RETAIN:"))
+        {
+            if (at_parser_int(&line, &value))
+            {
+                params_out->retain = (value == 1);
+                found_any = true;
+            }
+        }
+        else if (at_parser_match(&line, "SUBHEX:"))
+        {
+            if (at_parser_int(&line, &value))
+            {
+                params_out->sub_hex = (value == 1);
+                found_any = true;
+            }
+        }
+        else if (at_parser_match(&line, "ASYNCMODE:"))
+        {
+            if (at_parser_int(&line, &value))
+            {
+                params_out->async_mode = (value == 1);
+                found_any = true;
+            }
+        }
+    }
+
+    return found_any;
+}
+
+/**
+ * @brief Parse MQTT parameters from bulk response
+ */
+esp_err_t sim7080g_mqtt_get_parameters(const sim7080g_handle_t *sim7080g_handle,
+                                       mqtt_parameters_t *params_out)
+{
+    if (!sim7080g_handle || !params_out)
+    {
+        ESP_LOGE(TAG, "Invalid parameters");
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    // Initialize output structure
+    memset(params_out, 0, sizeof(mqtt_parameters_t));
+
+    char response[512] = {0};
+    esp_err_t ret = send_at_cmd(sim7080g_handle,
+                                &AT_SMCONF,
+                                AT_CMD_TYPE_READ,
+                                NULL,
+                                response,
+                                sizeof(response),
+                                5000);
+
+    if (ret != ESP_OK)
+    {
+        ESP_LOGE(TAG, "Failed to read MQTT parameters");
+        return ret;
+    }
+
+    bool found_any = sim7080g_parse_mqtt_parameters(response, strlen(response), params_out);
+
+    if (!found_any)
+    {
+        ESP_LOGW(TAG, "No MQTT parameters found in response");
+        return ESP_ERR_NOT_FOUND;
+    }
+
+    // Log all retrieved parameters
+    ESP_LOGI(TAG, "Current MQTT Parameters:");
+    ESP_LOGI(TAG, "  URL: %s", params_out->broker_url);
+    ESP_LOGI(TAG, "  Port: %d", params_out->port);
+    ESP_LOGI(TAG, "  Client ID: %s", params_out->client_id);
+    ESP_LOGI(TAG, "  Username: %s", params_out->username);
+    ESP_LOGI(TAG, "  Keepalive: %d", params_out->keepalive);
+    ESP_LOGI(TAG, "  Clean Session: %d", params_out->clean_session);
+    ESP_LOGI(TAG, "  QoS: %d", params_out->qos);
+    ESP_LOGI(TAG, "  Retain: %d", params_out->retain);
+    ESP_LOGI(TAG, "  SubHex: %d", params_out->sub_hex);
+    ESP_LOGI(TAG, "  AsyncMode: %d", params_out->async_mode);
+
+    return ESP_OK;
+}
+
+// ----------------------------------------------------- NEW API FXNS ----------------------------------------------------- //
+// -----------------------------------------------------              ----------------------------------------------------- //
+
+// Check:
+// - AT+CPIN? (SIM status)
+// - AT+CSQ (Signal quality)
+// - AT+CPSI? (System mode)
+esp_err_t sim7080g_is_physical_layer_connected(const sim7080g_handle_t *handle, bool *connected)
+{
+    if (!handle || !connected)
+    {
+        ESP_LOGE(TAG, "Is physical layer connected fail: Invalid parameters");
+        return ESP_ERR_INVALID_ARG;
+    }
+    *connected = false;
+    esp_err_t err;
+    char response[AT_RESPONSE_MAX_LEN] = {0};
+
+    // Check SIM card status (AT+CPIN?) and signal quality (AT+CSQ) in one exchange
+    char cpin_response[64] = {0};
+    sim7080g_at_batch_entry_t batch[] = {
+        {.cmd = &AT_CPIN, .type = AT_CMD_TYPE_READ, .response = cpin_response, .response_size = sizeof(cpin_response)},
+        {.cmd = &AT_CSQ, .type = AT_CMD_TYPE_EXECUTE, .response = response, .response_size = sizeof(response)},
+    };
+    sim7080g_send_at_batch_cached(handle, batch, sizeof(batch) / sizeof(batch[0]), 5000);
+
+    err = batch[0].result;
+    if (err != ESP_OK)
+    {
+        ESP_LOGE(TAG, "SIM card status check failed: %s", esp_err_to_name(err));
+        return err;
+    }
+
+    if (sim7080g_parse_sim_status(cpin_response) != ESP_OK)
+    {
+        ESP_LOGE(TAG, "SIM card not ready: %s", cpin_response);
+        return ESP_FAIL;
+    }
+
+    err = batch[1].result;
+    if (err != ESP_OK)
+    {
+        ESP_LOGE(TAG, "Signal quality check failed: %s", esp_err_to_name(err));
+        return err;
+    }
+
+    sim7080g_csq_reply_t csq;
+    if (sim7080g_decode(SIM7080G_DECODER_CSQ, response, &csq) != 2)
+    {
+        ESP_LOGE(TAG, "Failed to parse signal quality response: %s", response);
+        return ESP_ERR_INVALID_RESPONSE;
+    }
+
+    int rssi = csq.rssi;
+    int ber = csq.ber;
+
+    // Check if signal strength is acceptable (RSSI >= -105 dBm, corresponds to CSQ >= 5)
+    // and not unknown (99)
+    if (rssi >= 1 && rssi != 99)
+    {
+        *connected = true;
+        ESP_LOGI(TAG, "Physical layer connected (RSSI: %d, BER: %d)", rssi, ber);
+    }
+    else
+    {
+        ESP_LOGW(TAG, "Physical layer not connected (RSSI: %d, BER: %d)", rssi, ber);
+    }
+
+    // TODO - CPSI Command check
+
+    return ESP_OK;
+}
+
+// Check:
+// - AT+CEREG? (Network registration)
+// - AT+CGATT? (GPRS attach status)
+// - AT+CGDCONT? (PDP context)
+esp_err_t sim7080g_is_data_link_layer_connected(const sim7080g_handle_t *handle, bool *connected)
+{
+    if (!handle || !connected)
+    {
+        ESP_LOGE(TAG, "Is data link layer connected fail: Invalid parameters");
+        return ESP_ERR_INVALID_ARG;
+    }
+    *connected = false;
+    esp_err_t err;
+    char response[AT_RESPONSE_MAX_LEN] = {0};
+
+    // TODO - this
+    // Check network registration status with AT+CEREG?
+    err = send_at_cmd_cached(handle, &AT_CEREG, AT_CMD_TYPE_READ, response, sizeof(response), 5000);
+    if (err != ESP_OK)
+    {
+        ESP_LOGE(TAG, "Network registration status check failed: %s", esp_err_to_name(err));
+        return err;
+    }
+
+    // Parse just the mode and status
+    sim7080g_cereg_reply_t cereg;
+    if (sim7080g_decode(SIM7080G_DECODER_CEREG, response, &cereg) != 2)
+    {
+        ESP_LOGE(TAG, "Failed to parse network registration status: %s", response);
+        return ESP_ERR_INVALID_RESPONSE;
+    }
+    int stat = cereg.stat;
+
+    // Check registration status (1 = home network, 5 = roaming)
+    if (stat == 1 || stat == 5)
+    {
+        ESP_LOGI(TAG, "Network registration ok (status: %s)",
+                 stat == 1 ? "home network" : "roaming");
+    }
+    else
+    {
+        const char *status_str;
+        switch (stat)
+        {
+        case 0:
+            status_str = "not registered, not searching";
+            break;
+        case 2:
+            status_str = "searching";
+            break;
+        case 3:
+            status_str = "registration denied";
+            break;
+        case 4:
+            status_str = "unknown";
+            break;
+        default:
+            status_str = "invalid status";
+            break;
+        }
+        ESP_LOGE(TAG, "Network not registered: %s", status_str);
+        return ESP_OK; // Not an error, just not registered
+    }
+
+    // Check GPRS attachment status with AT+CGATT?
+    err = send_at_cmd_cached(handle, &AT_CGATT, AT_CMD_TYPE_READ, response, sizeof(response), 15000);
+    if (err != ESP_OK)
+    {
+        ESP_LOGE(TAG, "GPRS attach status check failed: %s", esp_err_to_name(err));
+        return err;
+    }
+
+    sim7080g_int_reply_t cgatt;
+    if (sim7080g_decode(SIM7080G_DECODER_CGATT, response, &cgatt) != 1)
+    {
+        ESP_LOGE(TAG, "Failed to parse GPRS attach status: %s", response);
+        return ESP_ERR_INVALID_RESPONSE;
+    }
+
+    if (!cgatt.value)
+    {
+        ESP_LOGE(TAG, "Data link layer not connected: Not attached to GPRS");
+        return ESP_OK;
+    }
+
+    // Check operator info with AT+COPS?
+    memset(response, 0, sizeof(response));
+    err = send_at_cmd_cached(handle, &AT_COPS, AT_CMD_TYPE_READ, response, sizeof(response), 5000);
+    if (err != ESP_OK)
+    {
+        ESP_LOGE(TAG, "Operator info check failed: %s", esp_err_to_name(err));
+        return err;
+    }
+
+    sim7080g_cops_reply_t cops;
+    if (sim7080g_decode(SIM7080G_DECODER_COPS, response, &cops) >= 3)
+    {
+        if (cops.mode != 2)
+        { // 2 = deregistered
+            *connected = true;
+            ESP_LOGI(TAG, "Data link layer connected (Operator: %s)", cops.name);
         }
         else
         {
-            ESP_LOGE(TAG, "Got OK but connection status check failed");
-            return ESP_ERR_INVALID_STATE;
+            ESP_LOGE(TAG, "Data link layer not connected (Operator mode: %d)", cops.mode);
+        }
+    }
+    else
+    {
+        ESP_LOGE(TAG, "Failed to parse operator info: %s", response);
+        return ESP_ERR_INVALID_RESPONSE;
+    }
+
+    return ESP_OK;
+}
+
+// Check:
+// AT+CNACT? (PDP context)
+// AT+CGPADDR (IP address)
+esp_err_t sim7080g_is_network_layer_connected(const sim7080g_handle_t *handle, bool *connected)
+{
+    if (!handle || !connected)
+    {
+        ESP_LOGE(TAG, "Is network layer connected fail: Invalid parameters");
+        return ESP_ERR_INVALID_ARG;
+    }
+    *connected = false;
+    esp_err_t err;
+    char response[AT_RESPONSE_MAX_LEN] = {0};
+
+    // Check PDP context status with AT+CNACT?
+    err = send_at_cmd_cached(handle, &AT_CNACT, AT_CMD_TYPE_READ, response, sizeof(response), 20000);
+    if (err != ESP_OK)
+    {
+        ESP_LOGE(TAG, "PDP context status check failed: %s", esp_err_to_name(err));
+        return err;
+    }
+
+    // Parse response for the first PDP context (index 0)
+    sim7080g_cnact_reply_t cnact = {0};
+    int decoded = sim7080g_decode(SIM7080G_DECODER_CNACT, response, &cnact);
+    if (decoded >= 0)
+    {
+        int status = cnact.status;
+
+        if (decoded >= 2)
+        {
+            if (cnact.pdpidx == 0 && sim7080g_cnact_status_active(status) && cnact.address[0] != '\0')
+            {
+                *connected = true;
+                ESP_LOGI(TAG, "Network layer connected (IP: %s)", cnact.address);
+            }
+            else
+            {
+                ESP_LOGE(TAG, "Network layer not connected (PDP status: %d)", status);
+            }
+        }
+        else
+        {
+            ESP_LOGE(TAG, "Failed to parse PDP context status: %s", response);
+            return ESP_ERR_INVALID_RESPONSE;
+        }
+    }
+    else
+    {
+        ESP_LOGE(TAG, "No CNACT response found");
+        return ESP_ERR_INVALID_RESPONSE;
+    }
+
+    // TODO - this
+    //  Check IP address with AT+CGPADDR
+
+    return ESP_OK;
+}
+
+// Check:
+// AT+CASTATE (TCP/UDP connection status)
+// TODO - FIX THIS (if its even needed?)
+// esp_err_t sim7080g_is_transport_layer_connected(const sim7080g_handle_t *handle, bool *connected)
+// {
+//     if (!handle || !connected)
+//     {
+//         ESP_LOGE(TAG, "Is transport layer connected fail: Invalid parameters");
+//         return ESP_ERR_INVALID_ARG;
+//     }
+
+//     // TODO - this
+//     // Check TCP/UDP connection status with AT+CASTATE
+
+//     *connected = false;
+//     char response[AT_RESPONSE_MAX_LEN] = {0};
+//     esp_err_t err;
+
+//     err = send_at_cmd(handle, &AT_CASTATE, AT_CMD_TYPE_READ, NULL, response, sizeof(response), 5000);
+//     if (err != ESP_OK)
+//     {
+//         ESP_LOGE(TAG, "Transport layer status check failed: %s", esp_err_to_name(err));
+//         return err;
+//     }
+
+//     char *castate_response = strstr(response, "+CASTATE:");
+//     if (castate_response)
+//     {
+//         int status;
+//         if (sscanf(castate_response, "+CASTATE: %d", &status) == 1)
+//         {
+//             // Status values: 0=disconnected, 1=connected
+//             if (status > 0)
+//             {
+//                 *connected = true;
+//                 ESP_LOGI(TAG, "Transport layer connected (CASTATE: %d)", status);
+//             }
+//             else
+//             {
+//                 ESP_LOGE(TAG, "Transport layer not connected (CASTATE: %d)", status);
+//             }
+//         }
+//         else
+//         {
+//             ESP_LOGE(TAG, "Failed to parse transport layer status: %s", response);
+//             return ESP_ERR_INVALID_RESPONSE;
+//         }
+//     }
+//     else
+//     {
+//         ESP_LOGE(TAG, "No CASTATE response found");
+//         return ESP_ERR_INVALID_RESPONSE;
+//     }
+
+//     return ESP_OK;
+// }
+
+// Check:
+// AT+SMSTATE (MQTT connection status)
+esp_err_t sim7080g_is_application_layer_connected(const sim7080g_handle_t *handle, bool *connected)
+{
+    if (!handle || !connected)
+    {
+        ESP_LOGE(TAG, "Is application layer connected fail: Invalid parameters");
+        return ESP_ERR_INVALID_ARG;
+    }
+    *connected = false;
+    esp_err_t err;
+    char response[AT_RESPONSE_MAX_LEN] = {0};
+
+    // Check MQTT connection status with AT+SMSTATE?
+    err = send_at_cmd_cached(handle, &AT_SMSTATE, AT_CMD_TYPE_READ, response, sizeof(response), 5000);
+    if (err != ESP_OK)
+    {
+        ESP_LOGE(TAG, "MQTT status check failed: %s", esp_err_to_name(err));
+        return err;
+    }
+
+    sim7080g_int_reply_t smstate;
+    int decoded = sim7080g_decode(SIM7080G_DECODER_SMSTATE, response, &smstate);
+    if (decoded >= 0)
+    {
+        int status = smstate.value;
+        if (decoded == 1)
+        {
+            // Status values: 0=disconnected, 1=connected, 2=connected with session
+            if (status > 0)
+            {
+                *connected = true;
+                ESP_LOGI(TAG, "Application layer connected (MQTT Status: %d)", status);
+            }
+            else
+            {
+                ESP_LOGE(TAG, "Application layer not connected (MQTT Status: %d)", status);
+            }
+        }
+        else
+        {
+            ESP_LOGE(TAG, "Failed to parse MQTT status: %s", response);
+            return ESP_ERR_INVALID_RESPONSE;
         }
     }
+    else
+    {
+        ESP_LOGE(TAG, "No SMSTATE response found");
+        return ESP_ERR_INVALID_RESPONSE;
+    }
 
-    ESP_LOGE(TAG, "Unexpected response from MQTT connect command: %s", response);
-    return ESP_ERR_INVALID_RESPONSE;
+    return ESP_OK;
 }
 
-esp_err_t sim7080g_mqtt_get_broker_connection_status(
-    const sim7080g_handle_t *sim7080g_handle,
-    sim7080g_mqtt_connection_status_t *status_out)
+static esp_err_t sim7080g_echo_off(const sim7080g_handle_t *sim7080g_handle)
 {
-    if (!sim7080g_handle || !status_out)
+    if (!sim7080g_handle || !sim7080g_handle->uart_initialized)
     {
-        ESP_LOGE(TAG, "Invalid parameters");
-        return ESP_ERR_INVALID_ARG;
+        ESP_LOGE(TAG, "SIM7080G driver not initialized");
+        return ESP_ERR_INVALID_STATE;
     }
-    ESP_LOGI(TAG, "Checking MQTT broker connection status");
-
-    *status_out = MQTT_STATUS_DISCONNECTED;
 
     char response[AT_RESPONSE_MAX_LEN] = {0};
     esp_err_t ret = send_at_cmd(sim7080g_handle,
-                                &AT_SMSTATE,
-                                AT_CMD_TYPE_READ,
+                                &AT_ECHO_OFF,
+                                AT_CMD_TYPE_EXECUTE,
                                 NULL,
                                 response,
                                 sizeof(response),
                                 5000);
 
-    if (ret == ESP_OK)
+    if (ret != ESP_OK)
     {
-        // Look for the "+SMSTATE:" response line
-        char *status_line = strstr(response, "+SMSTATE:");
-        if (status_line != NULL)
-        {
-            int raw_status;
-            if (sscanf(status_line, "+SMSTATE: %d", &raw_status) == 1)
-            {
-                // Validate status value
-                if (raw_status < 0 || raw_status > 2)
-                {
-                    ESP_LOGE(TAG, "Invalid MQTT status value: %d", raw_status);
-                    return ESP_ERR_INVALID_RESPONSE;
-                }
-
-                // Store status in output parameter
-                *status_out = (sim7080g_mqtt_connection_status_t)raw_status;
-
-                static const char *const status_str[] = {
-                    "Disconnected",
-                    "Connected",
-                    "Connected (Session Present)"};
-
-                ESP_LOGI(TAG, "MQTT Broker Status: %s", status_str[raw_status]);
-
-                return ESP_OK;
-            }
-            else
-            {
-                ESP_LOGE(TAG, "Failed to parse MQTT status number");
-                return ESP_ERR_INVALID_RESPONSE;
-            }
-        }
-        else
-        {
-            ESP_LOGE(TAG, "No SMSTATE response found in: %s", response);
-            return ESP_ERR_INVALID_RESPONSE;
-        }
+        ESP_LOGE(TAG, "Failed to turn off echo");
+        return ret;
     }
 
-    ESP_LOGE(TAG, "Failed to check MQTT broker connection status: %d", ret);
-    return ret;
+    ESP_LOGI(TAG, "Echo off");
+    return ESP_OK;
 }
 
-esp_err_t sim7080g_mqtt_publish(const sim7080g_handle_t *sim7080g_handle,
-                                const char *topic,
-                                const char *message,
-                                uint8_t qos,
-                                bool retain)
+// ---------------------  INTERNAL TESTING FXNs  ---------------------//
+
+bool sim7080g_test_uart_loopback(sim7080g_handle_t *sim7080g_handle)
 {
-    if (!sim7080g_handle || !topic || !message)
+    if (!sim7080g_handle->uart_initialized)
     {
-        ESP_LOGE(TAG, "Invalid parameters");
-        return ESP_ERR_INVALID_ARG;
+        ESP_LOGE(TAG, "SIM7080G driver not initialized");
+        return false;
     }
 
-    if (qos > 2)
-    {
-        ESP_LOGE(TAG, "Invalid QoS value: %d", qos);
-        return ESP_ERR_INVALID_ARG;
-    }
+    const char *test_str = "Hello, SIM7080G!";
+    char rx_buffer[128] = {0};
+
+    // The RX task frames input into lines - so the test string is sent as a line and the looped back line is awaited
+    sim7080g_rx_waiter_t waiter = {
+        .buf = rx_buffer,
+        .size = sizeof(rx_buffer),
+        .expect = test_str,
+        .expect_only = true,
+    };
 
-    // Get message length
-    size_t message_len = strlen(message);
-    if (message_len == 0)
+    // Send data and read it back
+    char tx_line[32];
+    int tx_bytes = snprintf(tx_line, sizeof(tx_line), "%s\r\n", test_str);
+    int len = 0;
+    sim7080g_exchange(sim7080g_handle, tx_line, tx_bytes, &waiter, 1000, &len);
+    ESP_LOGI(TAG, "Sent %d bytes: %s", tx_bytes, test_str);
+
+    // Strip the line ending restored by the RX task
+    rx_buffer[strcspn(rx_buffer, "\r\n")] = '\0';
+
+    ESP_LOGI(TAG, "Received %d bytes: %s", len, rx_buffer);
+
+    // Compare sent and received data
+    if (strcmp(test_str, rx_buffer) == 0)
     {
-        ESP_LOGW(TAG, "Empty message content");
-        return ESP_ERR_INVALID_ARG;
+        ESP_LOGI(TAG, "UART loopback test passed!");
+        return true;
     }
-
-    // First construct and send the publish command
-    char cmd[256] = {0};
-    if (snprintf(cmd, sizeof(cmd), "AT+SMPUB=\"%s\",%zu,%d,%d\r\n",
-                 topic,
-                 message_len,
-                 qos,
-                 retain ? 1 : 0) >= sizeof(cmd))
+    else
     {
-        ESP_LOGE(TAG, "Publish command too long");
-        return ESP_ERR_INVALID_SIZE;
+        ESP_LOGE(TAG, "UART loopback test failed!");
+        return false;
     }
+}
 
-    ESP_LOGI(TAG, "Sending MQTT publish command: %s", cmd);
+typedef struct
+{
+    uint32_t lines_ok;
+    uint32_t lines_bad;
+    uint32_t bytes_ok;
+    int64_t last_rx_us;
+    SemaphoreHandle_t last_line_rx;
+} uart_throughput_stats_t;
+
+static char uart_throughput_test_char(int line_num, int pos)
+{
+    return (char)('A' + ((line_num + pos) % 26));
+}
 
-    // Send command and wait for '>' prompt
-    int bytes_written = uart_write_bytes(sim7080g_handle->uart_config.port_num,
-                                         cmd,
-                                         strlen(cmd));
-    if (bytes_written != strlen(cmd))
+// Looped back test lines: "#LB<line num>:<payload>"
+static void uart_throughput_line_handler(const char *line, size_t len, void *user_ctx)
+{
+    uart_throughput_stats_t *stats = (uart_throughput_stats_t *)user_ctx;
+    stats->last_rx_us = esp_timer_get_time();
+
+    int line_num;
+    int payload_start = 0;
+    bool ok = sscanf(line, "#LB%d:%n", &line_num, &payload_start) == 1 && payload_start > 0 &&
+              len - payload_start == UART_THROUGHPUT_TEST_PAYLOAD_LEN;
+    for (int i = 0; ok && i < UART_THROUGHPUT_TEST_PAYLOAD_LEN; i++)
     {
-        ESP_LOGE(TAG, "Failed to send complete publish command");
-        return ESP_ERR_INVALID_STATE;
+        ok = line[payload_start + i] == uart_throughput_test_char(line_num, i);
     }
 
-    // Wait for '>' prompt with timeout
-    char response[AT_RESPONSE_MAX_LEN] = {0};
-    int bytes_read = uart_read_bytes(sim7080g_handle->uart_config.port_num,
-                                     response,
-                                     sizeof(response) - 1,
-                                     pdMS_TO_TICKS(1000));
-
-    if (bytes_read <= 0)
+    if (ok)
     {
-        ESP_LOGE(TAG, "Timeout waiting for '>' prompt");
-        return ESP_ERR_TIMEOUT;
+        stats->lines_ok++;
+        stats->bytes_ok += len + 2;
     }
-
-    response[bytes_read] = '\0';
-    ESP_LOGD(TAG, "Response after publish command: %s", response);
-
-    if (strstr(response, ">") == NULL)
+    else
     {
-        ESP_LOGE(TAG, "Did not receive '>' prompt");
-        return ESP_ERR_INVALID_RESPONSE;
+        stats->lines_bad++;
     }
 
-    // Now send the actual message content
-    ESP_LOGI(TAG, "Sending message content (length %zu bytes)", message_len);
-    ESP_LOGD(TAG, "Message: %s", message);
-
-    bytes_written = uart_write_bytes(sim7080g_handle->uart_config.port_num,
-                                     message,
-                                     message_len);
-    if (bytes_written != message_len)
+    if (ok && line_num == UART_THROUGHPUT_TEST_LINES - 1)
     {
-        ESP_LOGE(TAG, "Failed to send complete message content");
-        return ESP_ERR_INVALID_STATE;
+        xSemaphoreGive(stats->last_line_rx);
     }
+}
 
-    memset(response, 0, sizeof(response));
-    bytes_read = uart_read_bytes(sim7080g_handle->uart_config.port_num,
-                                 response,
-                                 sizeof(response) - 1,
-                                 pdMS_TO_TICKS(5000));
+// Runs on the arbiter task - nothing else may use the link while the rate is being changed
+static esp_err_t uart_throughput_test_fn(const sim7080g_handle_t *sim7080g_handle, void *arg)
+{
+    sim7080g_ctx_t *ctx = sim7080g_handle->ctx;
+    const uint32_t initial_rate = ctx->baud_rate;
 
-    if (bytes_read <= 0)
+    uart_throughput_stats_t stats = {0};
+    stats.last_line_rx = xSemaphoreCreateBinary();
+    if (stats.last_line_rx == NULL)
     {
-        ESP_LOGE(TAG, "Timeout waiting for publish confirmation");
-        return ESP_ERR_TIMEOUT;
+        return ESP_ERR_NO_MEM;
     }
 
-    response[bytes_read] = '\0';
-    ESP_LOGD(TAG, "Publish response: %s", response);
+    // The looped back lines are counted by a URC handler so the whole burst can be in flight at once
+    if (sim7080g_urc_register(sim7080g_handle, "#LB", uart_throughput_line_handler, &stats) != ESP_OK)
+    {
+        vSemaphoreDelete(stats.last_line_rx);
+        return ESP_FAIL;
+    }
 
-    if (strstr(response, "ERROR") != NULL)
+    bool passed = true;
+    for (size_t r = 0; r < SIM7080G_NUM_SUPPORTED_BAUD_RATES; r++)
     {
-        char *error_start = strstr(response, "+CME ERROR:");
-        if (error_start)
+        const uint32_t rate = sim7080g_supported_baud_rates[r];
+        sim7080g_set_local_baud_rate(sim7080g_handle, rate);
+
+        stats.lines_ok = 0;
+        stats.lines_bad = 0;
+        stats.bytes_ok = 0;
+        xSemaphoreTake(stats.last_line_rx, 0);
+
+        int64_t start_us = esp_timer_get_time();
+        for (int line_num = 0; line_num < UART_THROUGHPUT_TEST_LINES; line_num++)
         {
-            int error_code;
-            if (sscanf(error_start, "+CME ERROR: %d", &error_code) == 1)
+            char line[UART_THROUGHPUT_TEST_PAYLOAD_LEN + 16];
+            int len = snprintf(line, sizeof(line), "#LB%d:", line_num);
+            for (int i = 0; i < UART_THROUGHPUT_TEST_PAYLOAD_LEN; i++)
             {
-                ESP_LOGE(TAG, "Publish failed with CME ERROR: %d", error_code);
-                return ESP_ERR_INVALID_RESPONSE;
+                line[len++] = uart_throughput_test_char(line_num, i);
             }
+            line[len++] = '\r';
+            line[len++] = '\n';
+            uart_write_bytes(ctx->port, line, len);
         }
-        ESP_LOGE(TAG, "Publish failed with ERROR response");
-        return ESP_ERR_INVALID_RESPONSE;
-    }
 
-    if (strstr(response, "OK") == NULL)
-    {
-        ESP_LOGE(TAG, "Did not receive OK response");
-        return ESP_ERR_INVALID_RESPONSE;
+        bool complete = xSemaphoreTake(stats.last_line_rx, pdMS_TO_TICKS(2000)) == pdTRUE;
+        if (!complete)
+        {
+            stats.last_rx_us = esp_timer_get_time();
+        }
+
+        int64_t elapsed_us = stats.last_rx_us - start_us;
+        uint32_t bytes_per_sec = elapsed_us > 0 ? (uint32_t)(((int64_t)stats.bytes_ok * 1000000) / elapsed_us) : 0;
+        uint32_t lines_lost = UART_THROUGHPUT_TEST_LINES - stats.lines_ok;
+
+        ESP_LOGI(TAG, "UART throughput @ %7lu baud: %lu bytes/s, %lu/%d lines ok, %lu corrupt, error rate %lu.%02lu%%",
+                 (unsigned long)rate,
+                 (unsigned long)bytes_per_sec,
+                 (unsigned long)stats.lines_ok,
+                 UART_THROUGHPUT_TEST_LINES,
+                 (unsigned long)stats.lines_bad,
+                 (unsigned long)(lines_lost * 100 / UART_THROUGHPUT_TEST_LINES),
+                 (unsigned long)((lines_lost * 10000 / UART_THROUGHPUT_TEST_LINES) % 100));
+
+        if (lines_lost > 0)
+        {
+            passed = false;
+        }
     }
 
-    ESP_LOGI(TAG, "Successfully published %zu bytes to topic '%s'",
-             message_len, topic);
+    sim7080g_urc_unregister(sim7080g_handle, "#LB", uart_throughput_line_handler);
+    vSemaphoreDelete(stats.last_line_rx);
+    sim7080g_set_local_baud_rate(sim7080g_handle, initial_rate);
+
+    *(bool *)arg = passed;
     return ESP_OK;
 }
 
-esp_err_t sim7080g_set_verbose_error_reporting(const sim7080g_handle_t *sim7080g_handle)
+bool sim7080g_test_uart_throughput(sim7080g_handle_t *sim7080g_handle)
 {
-    if (!sim7080g_handle)
+    if (!sim7080g_handle->uart_initialized || sim7080g_handle->ctx == NULL)
     {
-        ESP_LOGE(TAG, "Invalid device handle");
-        return ESP_ERR_INVALID_ARG;
+        ESP_LOGE(TAG, "SIM7080G driver not initialized");
+        return false;
     }
 
-    ESP_LOGI(TAG, "Setting verbose error reporting");
-
-    char response[AT_RESPONSE_MAX_LEN] = {0};
-    esp_err_t ret = send_at_cmd(sim7080g_handle,
-                                &AT_CMEE,
-                                AT_CMD_TYPE_WRITE,
-                                "2",
-                                response,
-                                sizeof(response),
-                                5000);
+    bool passed = false;
+    esp_err_t err = sim7080g_arbiter_call(sim7080g_handle, uart_throughput_test_fn, &passed, SIM7080G_CMD_PRIORITY_NORMAL, 0);
 
-    if (ret != ESP_OK)
+    if (err == ESP_OK && passed)
     {
-        ESP_LOGE(TAG, "Failed to set verbose error reporting");
-        return ret;
+        ESP_LOGI(TAG, "UART throughput test passed!");
+        return true;
     }
-
-    ESP_LOGI(TAG, "Verbose error reporting enabled");
-    return ESP_OK;
-}
-
-// ---------------------  INTERNAL HELPER / STATIC FXNs  ---------------------//
-
-static esp_err_t send_at_cmd(const sim7080g_handle_t *sim7080g_handle,
-                             const at_cmd_t *cmd,
-                             at_cmd_type_t type,
-                             const char *args,
-                             char *response,
-                             size_t response_size,
-                             uint32_t timeout_ms)
-{
-    if (!sim7080g_handle || !sim7080g_handle->uart_initialized)
+    else
     {
-        ESP_LOGE(TAG, "Send AT cmd failed: SIM7080G driver not initialized");
-        return ESP_ERR_INVALID_STATE;
+        ESP_LOGE(TAG, "UART throughput test failed! Lines lost or corrupted at one or more rates");
+        return false;
     }
+}
 
-    if (cmd == NULL || response == NULL || response_size == 0)
-    {
-        ESP_LOGE(TAG, "Send AT cmd failed: Invalid parameters");
-        return ESP_ERR_INVALID_ARG;
-    }
+// ------ Response parser benchmark ------ //
 
-    char at_cmd[AT_CMD_MAX_LEN] = {0};
-    const at_cmd_info_t *cmd_info;
+static const char AT_PARSER_TEST_SMCONF[] =
+    "\r\n+SMCONF:\r\nCLIENTID: \"sim7080g-test-client\"\r\nURL: \"mqtt.example.com\",1883\r\n"
+    "KEEPTIME: 60\r\nCLEANSS: 1\r\nQOS: 1\r\nTOPIC: \"\"\r\nMESSAGE: \"\"\r\nRETAIN: 0\r\n"
+    "SUBHEX: 0\r\nASYNCMODE: 0\r\n\r\nOK\r\n";
+static const char AT_PARSER_TEST_COPS[] = "\r\n+COPS: 0,0,\"Example Operator\",7\r\n\r\nOK\r\n";
 
-    // Determine the correct command string based on the command type
-    switch (type)
-    {
-    case AT_CMD_TYPE_TEST:
-        cmd_info = &cmd->test;
-        break;
-    case AT_CMD_TYPE_READ:
-        cmd_info = &cmd->read;
-        break;
-    case AT_CMD_TYPE_WRITE:
-        cmd_info = &cmd->write;
-        break;
-    case AT_CMD_TYPE_EXECUTE:
-        cmd_info = &cmd->execute;
-        break;
-    default:
-        ESP_LOGE(TAG, "Send AT cmd failed: Invalid command type");
-        return ESP_ERR_INVALID_ARG;
-    }
+typedef struct
+{
+    bool legacy;
+    int iterations;
+    bool ok;
+    uint64_t cycles;
+    UBaseType_t stack_free;
+    SemaphoreHandle_t done;
+} at_parser_test_run_t;
+
+/// @brief The strtok/sscanf parsing the driver used before the zero-copy parser - kept only as the benchmark baseline
+static bool at_parser_test_legacy_smconf(const char *text, mqtt_parameters_t *params_out)
+{
+    char response[AT_RESPONSE_MAX_LEN * 2];
+    strncpy(response, text, sizeof(response) - 1);
+    response[sizeof(response) - 1] = '\0';
 
-    if (cmd_info->cmd_string == NULL)
-    {
-        ESP_LOGE(TAG, "Send AT cmd failed: Command string is NULL");
-        return ESP_ERR_INVALID_ARG;
-    }
+    // Parse each line of the response
+    char *line = strtok(response, "\r\n");
+    bool found_any = false;
 
-    // Format the AT command string
-    if (type == AT_CMD_TYPE_WRITE && args != NULL)
+    while (line != NULL)
     {
-        if (snprintf(at_cmd, sizeof(at_cmd), "%s%s\r\n", cmd_info->cmd_string, args) >= sizeof(at_cmd))
+        // Skip the initial +SMCONF: line
+        if (strncmp(line, "CLIENTID:", 9) == 0)
         {
-            ESP_LOGE(TAG, "Send AT cmd failed: AT command too long");
-            return ESP_ERR_INVALID_SIZE;
+            // Parse string parameter format: 'CLIENTID: "value"'
+            char value[256];
+            if (sscanf(line + 9, " \"%[^\"]\"", value) == 1)
+            {
+                strncpy(params_out->client_id, value, sizeof(params_out->client_id) - 1);
+                found_any = true;
+            }
         }
-    }
-    else
-    {
-        if (snprintf(at_cmd, sizeof(at_cmd), "%s\r\n", cmd_info->cmd_string) >= sizeof(at_cmd))
+        else if (strncmp(line, "URL:", 4) == 0)
         {
-            ESP_LOGE(TAG, "Send AT cmd failed: AT command too long");
-            return ESP_ERR_INVALID_SIZE;
+            // Parse URL and port format: 'URL: "url",port'
+            char url[256];
+            int port;
+            if (sscanf(line + 4, " \"%[^\"]\"%*[,]%d", url, &port) == 2)
+            {
+                strncpy(params_out->broker_url, url, sizeof(params_out->broker_url) - 1);
+                params_out->port = (uint16_t)port;
+                found_any = true;
+            }
         }
-    }
-
-    esp_err_t ret = ESP_FAIL;
-    for (int retry = 0; retry < AT_CMD_MAX_RETRIES; retry++)
-    {
-        ESP_LOGI(TAG, "Sending AT command (attempt %d/%d): %s", retry + 1, AT_CMD_MAX_RETRIES, at_cmd);
-        ESP_LOGI(TAG, "Command description: %s", cmd->description);
-
-        // Clear any pending data in UART buffers
-        uart_flush(sim7080g_handle->uart_config.port_num);
-
-        int bytes_written = uart_write_bytes(sim7080g_handle->uart_config.port_num,
-                                             at_cmd, strlen(at_cmd));
-        if (bytes_written < 0)
+        else if (strncmp(line, "USERNAME:", 9) == 0)
         {
-            ESP_LOGE(TAG, "Send AT cmd failed: Failed to send AT command");
-            ret = ESP_FAIL;
-            continue;
+            char value[256];
+            if (sscanf(line + 9, " \"%[^\"]\"", value) == 1)
+            {
+                strncpy(params_out->username, value, sizeof(params_out->username) - 1);
+                found_any = true;
+            }
         }
-
-        int bytes_read = uart_read_bytes(sim7080g_handle->uart_config.port_num,
-                                         response,
-                                         response_size - 1,
-                                         pdMS_TO_TICKS(timeout_ms));
-        if (bytes_read < 0)
+        else if (strncmp(line, "PASSWORD:", 9) == 0)
         {
-            ESP_LOGE(TAG, "Send AT cmd failed: Failed to read AT command response");
-            ret = ESP_FAIL;
-            continue;
+            char value[256];
+            if (sscanf(line + 9, " \"%[^\"]\"", value) == 1)
+            {
+                strncpy(params_out->client_password, value, sizeof(params_out->client_password) - 1);
+                found_any = true;
+            }
         }
-
-        ESP_LOGI(TAG, "Received %d bytes. Raw Response: %s", bytes_read, response);
-
-        // Ensure null-termination
-        response[bytes_read] = '\0';
-
-        // Check for expected response or error
-        if (strstr(response, "OK") != NULL)
+        else if (strncmp(line, "KEEPTIME:", 9) == 0)
         {
-            ESP_LOGI(TAG, "Send AT cmd SUCCESS: AT command send returned OK");
-            return ESP_OK;
+            int value;
+            if (sscanf(line + 9, " %d", &value) == 1)
+            {
+                params_out->keepalive = (uint16_t)value;
+                found_any = true;
+            }
         }
-        else if (strstr(response, "ERROR") != NULL)
+        else if (strncmp(line, "CLEANSS:", 8) == 0)
         {
-            ESP_LOGE(TAG, "Send AT cmd failed: AT command send returned ERROR");
-            ret = ESP_FAIL;
-            continue;
+            int value;
+            if (sscanf(line + 8, " %d", &value) == 1)
+            {
+                params_out->clean_session = (value == 1);
+                found_any = true;
+            }
         }
-        else if (bytes_read == 0)
+        else if (strncmp(line, "QOS:", 4) == 0)
         {
-            ESP_LOGW(TAG, "Send AT cmd failed: AT command timeout");
-            ret = ESP_ERR_TIMEOUT;
-            continue;
+            int value;
+            if (sscanf(line + 4, " %d", &value) == 1)
+            {
+                params_out->qos = (uint8_t)value;
+                found_any = true;
+            }
         }
-        else
+        else if (strncmp(line, "RETAIN:", 7) == 0)
         {
-            ESP_LOGW(TAG, "Send AT cmd failed: Unexpected AT command response");
-            ret = ESP_FAIL;
+            int value;
+            if (sscanf(line + 7, " %d", &value) == 1)
+            {
+                params_out->retain = (value == 1);
+                found_any = true;
+            }
+        }
+        else if (strncmp(line, "SUBHEX:", 7) == 0)
+        {
+            int value;
+            if (sscanf(line + 7, " %d", &value) == 1)
+            {
+                params_out->sub_hex = (value == 1);
+                found_any = true;
+            }
+        }
+        else if (strncmp(line, "ASYNCMODE:", 10) == 0)
+        {
+            int value;
+            if (sscanf(line + 10, " %d", &value) == 1)
+            {
+                params_out->async_mode = (value == 1);
+                found_any = true;
+            }
         }
+
+        line = strtok(NULL, "\r\n");
     }
 
-    ESP_LOGE(TAG, "Send AT cmd failed after %d attempts", AT_CMD_MAX_RETRIES);
-    return ret;
+    return found_any;
 }
 
-static void sim7080g_log_config_params(const sim7080g_handle_t *sim7080g_handle)
+static bool at_parser_test_legacy_cops(const char *text, char *operator_name, size_t operator_name_size)
 {
-    ESP_LOGI(TAG, "SIM7080G UART Config:");
-    ESP_LOGI(TAG, "  - RX GPIO: %d", sim7080g_handle->uart_config.gpio_num_rx);
-    ESP_LOGI(TAG, "  - TX GPIO: %d", sim7080g_handle->uart_config.gpio_num_tx);
-    ESP_LOGI(TAG, "  - Port Num: %d", sim7080g_handle->uart_config.port_num);
-
-    ESP_LOGI(TAG, "SIM7080G MQTT Config:");
-    ESP_LOGI(TAG, "  - Broker URL: %s", sim7080g_handle->mqtt_config.broker_url);
-    ESP_LOGI(TAG, "  - Username: %s", sim7080g_handle->mqtt_config.username);
-    ESP_LOGI(TAG, "  - Client ID: %s", sim7080g_handle->mqtt_config.client_id);
-    ESP_LOGI(TAG, "  - Client Password: %s", sim7080g_handle->mqtt_config.client_password);
-    ESP_LOGI(TAG, "  - Port: %d", sim7080g_handle->mqtt_config.port);
-
-    return;
+    int mode, format, act;
+    char name[64];
+    const char *cops = strstr(text, "+COPS:");
+    if (!cops || sscanf(cops, "+COPS: %d,%d,\"%63[^\"]\",%d", &mode, &format, name, &act) < 3)
+    {
+        return false;
+    }
+    strncpy(operator_name, name, operator_name_size - 1);
+    operator_name[operator_name_size - 1] = '\0';
+    return true;
 }
 
-static esp_err_t sim7080g_uart_init(const sim7080g_uart_config_t sim7080g_uart_config)
+static void at_parser_test_task(void *arg)
 {
-    uart_config_t uart_config = {
-        .baud_rate = SIM7080G_UART_BAUD_RATE,
-        .data_bits = UART_DATA_8_BITS,
-        .parity = UART_PARITY_DISABLE,
-        .stop_bits = UART_STOP_BITS_1,
-        .flow_ctrl = UART_HW_FLOWCTRL_DISABLE,
-        .source_clk = UART_SCLK_DEFAULT,
-    };
+    at_parser_test_run_t *run = (at_parser_test_run_t *)arg;
+    run->ok = true;
 
-    esp_err_t err = uart_driver_install((uart_port_t)sim7080g_uart_config.port_num, SIM87080G_UART_BUFF_SIZE * 2, 0, 0, NULL, 0);
-    if (err != ESP_OK)
+    uint64_t cycles = 0;
+    for (int i = 0; i < run->iterations; i++)
     {
-        ESP_LOGE(TAG, "Error installing UART driver: %s", esp_err_to_name(err));
-        return err;
-    }
+        mqtt_parameters_t params = {0};
+        char operator_name[64] = {0};
+        int mode = 0;
+        int format = 0;
+        bool ok;
 
-    err = uart_param_config((uart_port_t)sim7080g_uart_config.port_num, &uart_config);
-    if (err != ESP_OK)
-    {
-        ESP_LOGE(TAG, "Error configuring UART parameters: %s", esp_err_to_name(err));
-        return err;
-    }
+        esp_cpu_cycle_count_t start = esp_cpu_get_cycle_count();
+        if (run->legacy)
+        {
+            ok = at_parser_test_legacy_smconf(AT_PARSER_TEST_SMCONF, &params) &&
+                 at_parser_test_legacy_cops(AT_PARSER_TEST_COPS, operator_name, sizeof(operator_name));
+        }
+        else
+        {
+            ok = sim7080g_parse_mqtt_parameters(AT_PARSER_TEST_SMCONF, sizeof(AT_PARSER_TEST_SMCONF) - 1, &params) &&
+                 sim7080g_parse_operator_info(AT_PARSER_TEST_COPS, &mode, &format, operator_name, sizeof(operator_name)) == ESP_OK;
+        }
+        cycles += (esp_cpu_cycle_count_t)(esp_cpu_get_cycle_count() - start);
 
-    err = uart_set_pin((uart_port_t)sim7080g_uart_config.port_num, sim7080g_uart_config.gpio_num_rx, sim7080g_uart_config.gpio_num_tx, UART_PIN_NO_CHANGE, UART_PIN_NO_CHANGE);
-    if (err != ESP_OK)
-    {
-        ESP_LOGE(TAG, "Error setting UART pins: %s", esp_err_to_name(err));
-        return err;
+        if (!ok || params.port != 1883 || params.keepalive != 60 ||
+            strcmp(params.client_id, "sim7080g-test-client") != 0 || strcmp(operator_name, "Example Operator") != 0)
+        {
+            run->ok = false;
+            break;
+        }
     }
 
-    return ESP_OK;
+    run->cycles = cycles;
+    run->stack_free = uxTaskGetStackHighWaterMark(NULL);
+    xSemaphoreGive(run->done);
+    vTaskDelete(NULL);
 }
 
-/**
- * @brief Check if current device MQTT parameters match those in the handle config
- *
- * @param sim7080g_handle Pointer to initialized device handle
- * @param params_match_out Pointer to store match result
- * @return esp_err_t ESP_OK if check completed successfully
- */
-static esp_err_t sim7080g_mqtt_check_parameters_match(const sim7080g_handle_t *sim7080g_handle,
-                                                      bool *params_match_out)
+// Each variant runs in its own task with the same fixed stack, so the high water mark gives its peak stack use
+static bool at_parser_test_run(at_parser_test_run_t *run)
 {
-    if (!sim7080g_handle || !params_match_out)
+    run->done = xSemaphoreCreateBinary();
+    if (run->done == NULL)
     {
-        ESP_LOGE(TAG, "Invalid parameters");
-        return ESP_ERR_INVALID_ARG;
+        return false;
     }
 
-    // Initialize output
-    *params_match_out = false;
-
-    // Get current device parameters
-    mqtt_parameters_t current_params;
-    esp_err_t ret = sim7080g_mqtt_get_parameters(sim7080g_handle, &current_params);
-    if (ret != ESP_OK)
+    bool started = xTaskCreate(at_parser_test_task, "at_parser_test", AT_PARSER_TEST_STACK_SIZE, run,
+                               uxTaskPriorityGet(NULL), NULL) == pdPASS;
+    if (started)
     {
-        ESP_LOGE(TAG, "Failed to get current MQTT parameters");
-        return ret;
+        xSemaphoreTake(run->done, portMAX_DELAY);
     }
+    vSemaphoreDelete(run->done);
+    return started && run->ok;
+}
 
-    // Compare relevant parameters from handle config
-    bool match = true; // Start true, set false if any mismatch
-
-    // Check URL
-    if (strcmp(current_params.broker_url, sim7080g_handle->mqtt_config.broker_url) != 0)
+bool sim7080g_test_response_parser(int iterations)
+{
+    if (iterations <= 0)
     {
-        ESP_LOGD(TAG, "URL mismatch - Current: %s, Config: %s",
-                 current_params.broker_url, sim7080g_handle->mqtt_config.broker_url);
-        match = false;
+        ESP_LOGE(TAG, "Response parser test: Invalid parameters");
+        return false;
     }
 
-    // Check port
-    if (current_params.port != sim7080g_handle->mqtt_config.port)
+    if (sim7080g_compile_decoders() != ESP_OK)
     {
-        ESP_LOGD(TAG, "Port mismatch - Current: %d, Config: %d",
-                 current_params.port, sim7080g_handle->mqtt_config.port);
-        match = false;
+        return false;
     }
 
-    // Check client ID
-    if (strcmp(current_params.client_id, sim7080g_handle->mqtt_config.client_id) != 0)
-    {
-        ESP_LOGD(TAG, "Client ID mismatch - Current: %s, Config: %s",
-                 current_params.client_id, sim7080g_handle->mqtt_config.client_id);
-        match = false;
-    }
+    at_parser_test_run_t legacy = {.legacy = true, .iterations = iterations};
+    at_parser_test_run_t parser = {.legacy = false, .iterations = iterations};
 
-    // Check username
-    if (strcmp(current_params.username, sim7080g_handle->mqtt_config.username) != 0)
+    if (!at_parser_test_run(&legacy) || !at_parser_test_run(&parser))
     {
-        ESP_LOGD(TAG, "Username mismatch - Current: %s, Config: %s",
-                 current_params.username, sim7080g_handle->mqtt_config.username);
-        match = false;
+        ESP_LOGE(TAG, "Response parser test failed! Parsed values did not match (legacy %s, parser %s)",
+                 legacy.ok ? "ok" : "bad", parser.ok ? "ok" : "bad");
+        return false;
     }
 
-    // Check password
-    if (strcmp(current_params.client_password, sim7080g_handle->mqtt_config.client_password) != 0)
-    {
-        ESP_LOGD(TAG, "Password mismatch - Current: %s, Config: %s",
-                 current_params.client_password, sim7080g_handle->mqtt_config.client_password);
-        match = false;
-    }
+    ESP_LOGI(TAG, "Response parser test: SMCONF + COPS parse, %d iterations", iterations);
+    ESP_LOGI(TAG, "  strtok/sscanf: %llu cycles/parse, peak stack %u bytes",
+             (unsigned long long)(legacy.cycles / iterations),
+             (unsigned)(AT_PARSER_TEST_STACK_SIZE - legacy.stack_free));
+    ESP_LOGI(TAG, "  at_parser:     %llu cycles/parse, peak stack %u bytes",
+             (unsigned long long)(parser.cycles / iterations),
+             (unsigned)(AT_PARSER_TEST_STACK_SIZE - parser.stack_free));
 
-    *params_match_out = match;
+    ESP_LOGI(TAG, "Response parser test passed!");
+    return true;
+}
 
-    if (match)
-    {
-        ESP_LOGI(TAG, "MQTT parameters match current config");
-    }
-    else
-    {
-        ESP_LOGI(TAG, "MQTT parameters differ from current config");
-    }
+// ------ Response decoder fuzz test ------ //
 
-    return ESP_OK;
-}
+#define AT_DECODER_TEST_GUARD_LEN 16
+#define AT_DECODER_TEST_GUARD_BYTE 0xA5
+#define AT_DECODER_TEST_MAX_REPLY 128
 
-/**
- * @brief Parse MQTT parameters from bulk response
- */
-esp_err_t sim7080g_mqtt_get_parameters(const sim7080g_handle_t *sim7080g_handle,
-                                       mqtt_parameters_t *params_out)
+// A well formed response per decoder - each iteration corrupts a few bytes of one
+static const char *const AT_DECODER_TEST_SAMPLES[SIM7080G_DECODER_COUNT] = {
+    [SIM7080G_DECODER_CPIN] = "\r\n+CPIN: READY\r\n\r\nOK\r\n",
+    [SIM7080G_DECODER_CSQ] = "\r\n+CSQ: 24,99\r\n\r\nOK\r\n",
+    [SIM7080G_DECODER_CGATT] = "\r\n+CGATT: 1\r\n\r\nOK\r\n",
+    [SIM7080G_DECODER_COPS] = "\r\n+COPS: 0,0,\"Example Operator\",7\r\n\r\nOK\r\n",
+    [SIM7080G_DECODER_CGNAPN] = "\r\n+CGNAPN: 1,\"example.apn\"\r\n\r\nOK\r\n",
+    [SIM7080G_DECODER_CNACT] = "\r\n+CNACT: 0,1,\"10.64.12.7\"\r\n+CNACT: 1,0,\"0.0.0.0\"\r\n\r\nOK\r\n",
+    [SIM7080G_DECODER_SMSTATE] = "\r\n+SMSTATE: 1\r\n\r\nOK\r\n",
+    [SIM7080G_DECODER_CEREG] = "\r\n+CEREG: 0,1\r\n\r\nOK\r\n",
+};
+
+// Bytes that matter to the decoder - corrupting with these reaches the edge cases far more often than random bytes
+static const char AT_DECODER_TEST_ALPHABET[] = "0123456789-+,\"() :\r\nAZaz\x00\xff";
+
+bool sim7080g_test_response_decoder(int iterations)
 {
-    if (!sim7080g_handle || !params_out)
+    if (iterations <= 0)
     {
-        ESP_LOGE(TAG, "Invalid parameters");
-        return ESP_ERR_INVALID_ARG;
+        ESP_LOGE(TAG, "Response decoder test: Invalid parameters");
+        return false;
     }
 
-    // Initialize output structure
-    memset(params_out, 0, sizeof(mqtt_parameters_t));
-
-    char response[512] = {0};
-    esp_err_t ret = send_at_cmd(sim7080g_handle,
-                                &AT_SMCONF,
-                                AT_CMD_TYPE_READ,
-                                NULL,
-                                response,
-                                sizeof(response),
-                                5000);
-
-    if (ret != ESP_OK)
+    if (sim7080g_compile_decoders() != ESP_OK)
     {
-        ESP_LOGE(TAG, "Failed to read MQTT parameters");
-        return ret;
+        ESP_LOGE(TAG, "Response decoder test failed! Decoder table does not compile");
+        return false;
+    }
+    for (int i = 0; i < SIM7080G_DECODER_COUNT; i++)
+    {
+        if (SIM7080G_DECODER_TABLE[i].reply_size > AT_DECODER_TEST_MAX_REPLY)
+        {
+            ESP_LOGE(TAG, "Response decoder test: %s reply struct larger than the test buffer",
+                     SIM7080G_DECODER_TABLE[i].info->cmd_string);
+            return false;
+        }
     }
 
-    // Parse each line of the response
-    char *line = strtok(response, "\r\n");
-    bool found_any = false;
-
-    while (line != NULL)
+    uint32_t decoded_lines = 0;
+    for (int i = 0; i < iterations; i++)
     {
-        // Skip the initial +SMCONF: line
-        if (strncmp(line, "CLIENTID:", 9) == 0)
+        sim7080g_decoder_id_t id = (sim7080g_decoder_id_t)(esp_random() % SIM7080G_DECODER_COUNT);
+        const at_decoder_t *decoder = &sim7080g_decoders[id];
+        const char *sample = AT_DECODER_TEST_SAMPLES[id];
+        size_t len = strlen(sample);
+
+        // Corrupt a few bytes, and sometimes cut the response short - the copy is not null terminated
+        char response[AT_RESPONSE_MAX_LEN];
+        memcpy(response, sample, len);
+        int corruptions = (int)(esp_random() % 4);
+        for (int c = 0; c < corruptions; c++)
         {
-            // Parse string parameter format: 'CLIENTID: "value"'
-            char value[256];
-            if (sscanf(line + 9, " \"%[^\"]\"", value) == 1)
-            {
-                strncpy(params_out->client_id, value, sizeof(params_out->client_id) - 1);
-                found_any = true;
-            }
+            response[esp_random() % len] = AT_DECODER_TEST_ALPHABET[esp_random() % (sizeof(AT_DECODER_TEST_ALPHABET) - 1)];
         }
-        else if (strncmp(line, "URL:", 4) == 0)
+        if (esp_random() % 4 == 0)
         {
-            // Parse URL and port format: 'URL: "url",port'
-            char url[256];
-            int port;
-            if (sscanf(line + 4, " \"%[^\"]\"%*[,]%d", url, &port) == 2)
-            {
-                strncpy(params_out->broker_url, url, sizeof(params_out->broker_url) - 1);
-                params_out->port = (uint16_t)port;
-                found_any = true;
-            }
+            len = esp_random() % (len + 1);
         }
-        else if (strncmp(line, "USERNAME:", 9) == 0)
+
+        uint8_t reply[AT_DECODER_TEST_MAX_REPLY + AT_DECODER_TEST_GUARD_LEN];
+        memset(reply, AT_DECODER_TEST_GUARD_BYTE, sizeof(reply));
+
+        at_parser_t parser;
+        at_parser_init(&parser, response, len);
+        int decoded;
+        while ((decoded = at_decoder_next(decoder, &parser, reply)) >= 0)
         {
-            char value[256];
-            if (sscanf(line + 9, " \"%[^\"]\"", value) == 1)
+            decoded_lines++;
+            if (decoded > decoder->field_count || parser.pos > response + len)
             {
-                strncpy(params_out->username, value, sizeof(params_out->username) - 1);
-                found_any = true;
+                ESP_LOGE(TAG, "Response decoder test failed! %s decoded %d fields past its input",
+                         SIM7080G_DECODER_TABLE[id].info->cmd_string, decoded);
+                return false;
             }
-        }
-        else if (strncmp(line, "PASSWORD:", 9) == 0)
-        {
-            char value[256];
-            if (sscanf(line + 9, " \"%[^\"]\"", value) == 1)
+
+            // Every decoded string must be null terminated inside its field
+            for (int f = 0; f < decoded; f++)
             {
-                strncpy(params_out->client_password, value, sizeof(params_out->client_password) - 1);
-                found_any = true;
+                const at_field_desc_t *desc = &decoder->fields[f];
+                if (desc->type != AT_FIELD_INT && desc->size > 0 && memchr(reply + desc->offset, '\0', desc->size) == NULL)
+                {
+                    ESP_LOGE(TAG, "Response decoder test failed! %s field %d not null terminated",
+                             SIM7080G_DECODER_TABLE[id].info->cmd_string, f);
+                    return false;
+                }
             }
         }
-        else if (strncmp(line, "KEEPTIME:", 9) == 0)
+
+        // Nothing may be written past the reply struct
+        for (size_t g = SIM7080G_DECODER_TABLE[id].reply_size; g < sizeof(reply); g++)
         {
-            int value;
-            if (sscanf(line + 9, " %d", &value) == 1)
+            if (reply[g] != AT_DECODER_TEST_GUARD_BYTE)
             {
-                params_out->keepalive = (uint16_t)value;
-                found_any = true;
+                ESP_LOGE(TAG, "Response decoder test failed! %s wrote past its reply struct",
+                         SIM7080G_DECODER_TABLE[id].info->cmd_string);
+                return false;
             }
         }
-        else if (strncmp(line, "CLEANSS:", 8) == 0)
+    }
+
+    ESP_LOGI(TAG, "Response decoder test passed! %d corrupted responses, %lu reply lines decoded",
+             iterations, (unsigned long)decoded_lines);
+    return true;
+}
+
+// ------ Publish rate benchmark ------ //
+
+#define FAKE_MODEM_MAX_ACKS 32
+
+/// @brief Minimal stand-in for the device on a second UART - answers every AT line with OK, AT+CSQ with a signal report
+///        first and AT+SMPUB with the '>' prompt
+typedef struct
+{
+    uart_port_t port;
+    volatile bool stop;
+    SemaphoreHandle_t stopped;
+    uint32_t publishes; // Payloads fully received
+    bool async_acks;    // As in ASYNCMODE - each publish is also acked by a +SMPUB URC once the line goes quiet
+    uint8_t ack_results[FAKE_MODEM_MAX_ACKS]; // +SMPUB results still to send (a ring) - 1 for payloads starting with 'F'
+    uint32_t acks_queued;
+    volatile uint32_t acks_sent;
+} fake_modem_t;
+
+static void fake_modem_task(void *arg)
+{
+    fake_modem_t *modem = (fake_modem_t *)arg;
+    uint8_t chunk[SIM7080G_RX_CHUNK_LEN];
+    char line[AT_CMD_MAX_LEN];
+    size_t line_len = 0;
+    int payload_left = 0;
+    bool payload_start = false;
+    uint8_t payload_first = 0;
+
+    while (!modem->stop)
+    {
+        int bytes_read = uart_read_bytes(modem->port, chunk, sizeof(chunk), pdMS_TO_TICKS(10));
+        while (bytes_read == 0 && modem->acks_sent < modem->acks_queued)
         {
-            int value;
-            if (sscanf(line + 8, " %d", &value) == 1)
-            {
-                params_out->clean_session = (value == 1);
-                found_any = true;
-            }
+            char ack[24];
+            int ack_len = snprintf(ack, sizeof(ack), "\r\n+SMPUB: %d\r\n", modem->ack_results[modem->acks_sent % FAKE_MODEM_MAX_ACKS]);
+            uart_write_bytes(modem->port, ack, ack_len);
+            modem->acks_sent++;
         }
-        else if (strncmp(line, "QOS:", 4) == 0)
+
+        for (int i = 0; i < bytes_read; i++)
         {
-            int value;
-            if (sscanf(line + 4, " %d", &value) == 1)
+            if (payload_left > 0)
             {
-                params_out->qos = (uint8_t)value;
-                found_any = true;
+                if (payload_start)
+                {
+                    payload_first = chunk[i];
+                    payload_start = false;
+                }
+                if (--payload_left == 0)
+                {
+                    uart_write_bytes(modem->port, "\r\nOK\r\n", 6);
+                    modem->publishes++;
+                    if (modem->async_acks)
+                    {
+                        modem->ack_results[modem->acks_queued % FAKE_MODEM_MAX_ACKS] = payload_first == 'F' ? 1 : 0;
+                        modem->acks_queued++;
+                    }
+                }
+                continue;
             }
-        }
-        else if (strncmp(line, "RETAIN:", 7) == 0)
-        {
-            int value;
-            if (sscanf(line + 7, " %d", &value) == 1)
+
+            char c = (char)chunk[i];
+            if (c != '\n')
             {
-                params_out->retain = (value == 1);
-                found_any = true;
+                if (c != '\r' && line_len < sizeof(line) - 1)
+                {
+                    line[line_len++] = c;
+                }
+                continue;
             }
-        }
-        else if (strncmp(line, "SUBHEX:", 7) == 0)
-        {
-            int value;
-            if (sscanf(line + 7, " %d", &value) == 1)
+
+            at_parser_t fields;
+            at_str_t topic;
+            int message_len;
+            at_parser_init(&fields, line, line_len);
+            if (at_parser_match(&fields, "AT+SMPUB=") && at_parser_str(&fields, &topic) &&
+                at_parser_int(&fields, &message_len) && message_len > 0)
             {
-                params_out->sub_hex = (value == 1);
-                found_any = true;
+                payload_left = message_len;
+                payload_start = true;
+                uart_write_bytes(modem->port, "> ", 2);
             }
-        }
-        else if (strncmp(line, "ASYNCMODE:", 10) == 0)
-        {
-            int value;
-            if (sscanf(line + 10, " %d", &value) == 1)
+            else if (line_len == 6 && strncmp(line, "AT+CSQ", 6) == 0)
             {
-                params_out->async_mode = (value == 1);
-                found_any = true;
+                static const char csq[] = "\r\n+CSQ: 20,99\r\n\r\nOK\r\n";
+                uart_write_bytes(modem->port, csq, sizeof(csq) - 1);
+            }
+            else if (line_len >= 2 && strncmp(line, "AT", 2) == 0)
+            {
+                uart_write_bytes(modem->port, "\r\nOK\r\n", 6);
             }
+            line_len = 0;
         }
-
-        line = strtok(NULL, "\r\n");
-    }
-
-    if (!found_any)
-    {
-        ESP_LOGW(TAG, "No MQTT parameters found in response");
-        return ESP_ERR_NOT_FOUND;
     }
 
-    // Log all retrieved parameters
-    ESP_LOGI(TAG, "Current MQTT Parameters:");
-    ESP_LOGI(TAG, "  URL: %s", params_out->broker_url);
-    ESP_LOGI(TAG, "  Port: %d", params_out->port);
-    ESP_LOGI(TAG, "  Client ID: %s", params_out->client_id);
-    ESP_LOGI(TAG, "  Username: %s", params_out->username);
-    ESP_LOGI(TAG, "  Keepalive: %d", params_out->keepalive);
-    ESP_LOGI(TAG, "  Clean Session: %d", params_out->clean_session);
-    ESP_LOGI(TAG, "  QoS: %d", params_out->qos);
-    ESP_LOGI(TAG, "  Retain: %d", params_out->retain);
-    ESP_LOGI(TAG, "  SubHex: %d", params_out->sub_hex);
-    ESP_LOGI(TAG, "  AsyncMode: %d", params_out->async_mode);
-
-    return ESP_OK;
+    xSemaphoreGive(modem->stopped);
+    vTaskDelete(NULL);
 }
 
-// ----------------------------------------------------- NEW API FXNS ----------------------------------------------------- //
-// -----------------------------------------------------              ----------------------------------------------------- //
-
-// Check:
-// - AT+CPIN? (SIM status)
-// - AT+CSQ (Signal quality)
-// - AT+CPSI? (System mode)
-esp_err_t sim7080g_is_physical_layer_connected(const sim7080g_handle_t *handle, bool *connected)
+/// @brief Start the fake modem on its own UART
+/// @note The fake modem takes over the driver's pins through the GPIO matrix (its TX on the driver's RX and the other way round)
+static bool fake_modem_start(sim7080g_handle_t *sim7080g_handle, fake_modem_t *modem)
 {
-    if (!handle || !connected)
-    {
-        ESP_LOGE(TAG, "Is physical layer connected fail: Invalid parameters");
-        return ESP_ERR_INVALID_ARG;
-    }
-    *connected = false;
-    esp_err_t err;
-    char response[AT_RESPONSE_MAX_LEN] = {0};
+    const sim7080g_uart_config_t *sim7080g_uart_config = &sim7080g_handle->uart_config;
+    uart_config_t uart_config = {
+        .baud_rate = (int)sim7080g_handle->ctx->baud_rate,
+        .data_bits = UART_DATA_8_BITS,
+        .parity = UART_PARITY_DISABLE,
+        .stop_bits = UART_STOP_BITS_1,
+        .flow_ctrl = UART_HW_FLOWCTRL_DISABLE,
+        .source_clk = UART_SCLK_DEFAULT,
+    };
 
-    // Check SIM card status with AT+CPIN?
-    err = send_at_cmd(handle, &AT_CPIN, AT_CMD_TYPE_READ, NULL, response, sizeof(response), 5000);
+    esp_err_t err = uart_driver_install(modem->port, SIM87080G_UART_BUFF_SIZE * 2, SIM87080G_UART_BUFF_SIZE, 0, NULL, 0);
     if (err != ESP_OK)
     {
-        ESP_LOGE(TAG, "SIM card status check failed: %s", esp_err_to_name(err));
-        return err;
+        ESP_LOGE(TAG, "Error installing fake modem UART: %s", esp_err_to_name(err));
+        return false;
     }
-
-    if (strstr(response, "READY") == NULL)
+    modem->stopped = xSemaphoreCreateBinary();
+    if (modem->stopped == NULL ||
+        uart_param_config(modem->port, &uart_config) != ESP_OK ||
+        uart_set_pin(modem->port, sim7080g_uart_config->gpio_num_rx, sim7080g_uart_config->gpio_num_tx,
+                     UART_PIN_NO_CHANGE, UART_PIN_NO_CHANGE) != ESP_OK ||
+        xTaskCreate(fake_modem_task, "fake_modem", 3072, modem, uxTaskPriorityGet(NULL) + 1, NULL) != pdPASS)
     {
-        ESP_LOGE(TAG, "SIM card not ready: %s", response);
-        return ESP_FAIL;
+        ESP_LOGE(TAG, "Error starting fake modem");
+        if (modem->stopped != NULL)
+        {
+            vSemaphoreDelete(modem->stopped);
+        }
+        uart_driver_delete(modem->port);
+        return false;
     }
+    return true;
+}
 
-    // Check signal quality with AT+CSQ
-    memset(response, 0, sizeof(response));
-    err = send_at_cmd(handle, &AT_CSQ, AT_CMD_TYPE_EXECUTE, NULL, response, sizeof(response), 5000);
-    if (err != ESP_OK)
+static void fake_modem_stop(sim7080g_handle_t *sim7080g_handle, fake_modem_t *modem)
+{
+    const sim7080g_uart_config_t *sim7080g_uart_config = &sim7080g_handle->uart_config;
+    modem->stop = true;
+    xSemaphoreTake(modem->stopped, portMAX_DELAY);
+    vSemaphoreDelete(modem->stopped);
+    uart_driver_delete(modem->port);
+
+    // Hand the pins back to the driver's UART
+    uart_set_pin((uart_port_t)sim7080g_uart_config->port_num, sim7080g_uart_config->gpio_num_tx, sim7080g_uart_config->gpio_num_rx,
+                 UART_PIN_NO_CHANGE, UART_PIN_NO_CHANGE);
+}
+
+bool sim7080g_test_publish_rate(sim7080g_handle_t *sim7080g_handle, int fake_modem_port_num, int publishes)
+{
+    if (!sim7080g_handle->uart_initialized || sim7080g_handle->ctx == NULL)
     {
-        ESP_LOGE(TAG, "Signal quality check failed: %s", esp_err_to_name(err));
-        return err;
+        ESP_LOGE(TAG, "SIM7080G driver not initialized");
+        return false;
+    }
+    if (publishes <= 0 || fake_modem_port_num == sim7080g_handle->uart_config.port_num)
+    {
+        ESP_LOGE(TAG, "Publish rate test: Invalid parameters");
+        return false;
     }
 
-    int rssi, ber;
-    char *csq_response = strstr(response, "+CSQ:");
-    if (!csq_response || sscanf(csq_response, "+CSQ: %d,%d", &rssi, &ber) != 2)
+    fake_modem_t modem = {.port = (uart_port_t)fake_modem_port_num};
+    if (!fake_modem_start(sim7080g_handle, &modem))
     {
-        ESP_LOGE(TAG, "Failed to parse signal quality response: %s", response);
-        return ESP_ERR_INVALID_RESPONSE;
+        return false;
     }
 
-    // Check if signal strength is acceptable (RSSI >= -105 dBm, corresponds to CSQ >= 5)
-    // and not unknown (99)
-    if (rssi >= 1 && rssi != 99)
+    esp_err_t err;
+    bool passed = true;
+    int64_t max_us = 0;
+    int64_t start_us = esp_timer_get_time();
+    for (int i = 0; i < publishes && passed; i++)
     {
-        *connected = true;
-        ESP_LOGI(TAG, "Physical layer connected (RSSI: %d, BER: %d)", rssi, ber);
+        int64_t publish_start_us = esp_timer_get_time();
+        err = sim7080g_mqtt_publish(sim7080g_handle, PUBLISH_RATE_TEST_TOPIC, PUBLISH_RATE_TEST_MESSAGE, 0, false);
+        int64_t elapsed_us = esp_timer_get_time() - publish_start_us;
+        max_us = elapsed_us > max_us ? elapsed_us : max_us;
+
+        if (err != ESP_OK)
+        {
+            ESP_LOGE(TAG, "Publish rate test: publish %d failed: %s", i, esp_err_to_name(err));
+            passed = false;
+        }
     }
-    else
+    int64_t total_us = esp_timer_get_time() - start_us;
+    fake_modem_stop(sim7080g_handle, &modem);
+
+    if (!passed || modem.publishes != (uint32_t)publishes)
     {
-        ESP_LOGW(TAG, "Physical layer not connected (RSSI: %d, BER: %d)", rssi, ber);
+        ESP_LOGE(TAG, "Publish rate test failed! Fake modem received %lu of %d payloads",
+                 (unsigned long)modem.publishes, publishes);
+        return false;
     }
 
-    // TODO - CPSI Command check
+    ESP_LOGI(TAG, "Publish rate test: %d publishes of %d bytes at %lu baud - %.1f publishes/s, avg %lld us, max %lld us",
+             publishes, (int)strlen(PUBLISH_RATE_TEST_MESSAGE), (unsigned long)sim7080g_handle->ctx->baud_rate,
+             publishes * 1000000.0 / (double)total_us, (long long)(total_us / publishes), (long long)max_us);
+    ESP_LOGI(TAG, "Publish rate test passed!");
+    return true;
+}
 
-    return ESP_OK;
+// ------ AT command latency ------ //
+
+static int at_latency_test_cmp(const void *a, const void *b)
+{
+    int64_t lhs = *(const int64_t *)a;
+    int64_t rhs = *(const int64_t *)b;
+    return (lhs > rhs) - (lhs < rhs);
 }
 
-// Check:
-// - AT+CEREG? (Network registration)
-// - AT+CGATT? (GPRS attach status)
-// - AT+CGDCONT? (PDP context)
-esp_err_t sim7080g_is_data_link_layer_connected(const sim7080g_handle_t *handle, bool *connected)
+bool sim7080g_test_at_cmd_latency(sim7080g_handle_t *sim7080g_handle, int fake_modem_port_num, int iterations)
 {
-    if (!handle || !connected)
+    if (!sim7080g_handle->uart_initialized || sim7080g_handle->ctx == NULL)
     {
-        ESP_LOGE(TAG, "Is data link layer connected fail: Invalid parameters");
-        return ESP_ERR_INVALID_ARG;
+        ESP_LOGE(TAG, "SIM7080G driver not initialized");
+        return false;
     }
-    *connected = false;
-    esp_err_t err;
-    char response[AT_RESPONSE_MAX_LEN] = {0};
-
-    // TODO - this
-    // Check network registration status with AT+CEREG?
-    err = send_at_cmd(handle, &AT_CEREG, AT_CMD_TYPE_READ, NULL, response, sizeof(response), 5000);
-    if (err != ESP_OK)
+    if (iterations <= 0 || fake_modem_port_num == sim7080g_handle->uart_config.port_num)
     {
-        ESP_LOGE(TAG, "Network registration status check failed: %s", esp_err_to_name(err));
-        return err;
+        ESP_LOGE(TAG, "AT latency test: Invalid parameters");
+        return false;
     }
 
-    // Parse just the mode and status
-    int n, stat;
-    char *cereg_response = strstr(response, "+CEREG:");
-    if (!cereg_response || sscanf(cereg_response, "+CEREG: %d,%d", &n, &stat) != 2)
+    int64_t *samples_us = malloc((size_t)iterations * sizeof(int64_t));
+    if (samples_us == NULL)
     {
-        ESP_LOGE(TAG, "Failed to parse network registration status: %s", response);
-        return ESP_ERR_INVALID_RESPONSE;
+        ESP_LOGE(TAG, "AT latency test: Error allocating %d samples", iterations);
+        return false;
     }
 
-    // Check registration status (1 = home network, 5 = roaming)
-    if (stat == 1 || stat == 5)
+    fake_modem_t modem = {.port = (uart_port_t)fake_modem_port_num};
+    if (!fake_modem_start(sim7080g_handle, &modem))
     {
-        ESP_LOGI(TAG, "Network registration ok (status: %s)",
-                 stat == 1 ? "home network" : "roaming");
+        free(samples_us);
+        return false;
     }
-    else
+
+    esp_err_t err = ESP_OK;
+    int completed = 0;
+    for (; completed < iterations; completed++)
     {
-        const char *status_str;
-        switch (stat)
+        char response[AT_RESPONSE_MAX_LEN] = {0};
+        int64_t start_us = esp_timer_get_time();
+        err = send_at_cmd(sim7080g_handle, &AT_CSQ, AT_CMD_TYPE_EXECUTE, NULL, response, sizeof(response), 5000);
+        samples_us[completed] = esp_timer_get_time() - start_us;
+
+        if (err != ESP_OK)
         {
-        case 0:
-            status_str = "not registered, not searching";
-            break;
-        case 2:
-            status_str = "searching";
-            break;
-        case 3:
-            status_str = "registration denied";
-            break;
-        case 4:
-            status_str = "unknown";
-            break;
-        default:
-            status_str = "invalid status";
+            ESP_LOGE(TAG, "AT latency test: command failed on iteration %d: %s", completed, esp_err_to_name(err));
             break;
         }
-        ESP_LOGE(TAG, "Network not registered: %s", status_str);
-        return ESP_OK; // Not an error, just not registered
     }
+    fake_modem_stop(sim7080g_handle, &modem);
+
+    if (err != ESP_OK)
+    {
+        free(samples_us);
+        return false;
+    }
+
+    // The fake modem answers at once, so this is the driver's own share of a round trip plus the time on the wire
+    qsort(samples_us, (size_t)iterations, sizeof(int64_t), at_latency_test_cmp);
+    ESP_LOGI(TAG, "AT latency test: %d round trips at %lu baud - p50 %lld us, p90 %lld us, p99 %lld us, max %lld us",
+             iterations, (unsigned long)sim7080g_handle->ctx->baud_rate,
+             (long long)samples_us[(iterations - 1) * 50 / 100],
+             (long long)samples_us[(iterations - 1) * 90 / 100],
+             (long long)samples_us[(iterations - 1) * 99 / 100],
+             (long long)samples_us[iterations - 1]);
+    free(samples_us);
+
+    ESP_LOGI(TAG, "AT latency test passed!");
+    return true;
+}
+
+// ------ Mixed publish ack test ------ //
+
+typedef struct
+{
+    uint32_t acked; // Pipelined publishes reported with the result the fake modem gave them
+    uint32_t wrong; // Reported with another publish's result
+} publish_mixed_counts_t;
 
-    // Check GPRS attachment status with AT+CGATT?
-    err = send_at_cmd(handle, &AT_CGATT, AT_CMD_TYPE_READ, NULL, response, sizeof(response), 15000);
-    if (err != ESP_OK)
+static void publish_mixed_test_ok_cb(uint16_t msg_id, esp_err_t result, void *user_ctx)
+{
+    publish_mixed_counts_t *counts = (publish_mixed_counts_t *)user_ctx;
+    if (result == ESP_OK)
     {
-        ESP_LOGE(TAG, "GPRS attach status check failed: %s", esp_err_to_name(err));
-        return err;
+        counts->acked++;
     }
-
-    int attach_status;
-    char *cgatt_response = strstr(response, "+CGATT:");
-    if (!cgatt_response || sscanf(cgatt_response, "+CGATT: %d", &attach_status) != 1)
+    else
     {
-        ESP_LOGE(TAG, "Failed to parse GPRS attach status: %s", response);
-        return ESP_ERR_INVALID_RESPONSE;
+        counts->wrong++;
     }
+}
 
-    if (!attach_status)
+static void publish_mixed_test_fail_cb(uint16_t msg_id, esp_err_t result, void *user_ctx)
+{
+    publish_mixed_counts_t *counts = (publish_mixed_counts_t *)user_ctx;
+    if (result == ESP_FAIL)
     {
-        ESP_LOGE(TAG, "Data link layer not connected: Not attached to GPRS");
-        return ESP_OK;
+        counts->acked++;
     }
-
-    // Check operator info with AT+COPS?
-    memset(response, 0, sizeof(response));
-    err = send_at_cmd(handle, &AT_COPS, AT_CMD_TYPE_READ, NULL, response, sizeof(response), 5000);
-    if (err != ESP_OK)
+    else
     {
-        ESP_LOGE(TAG, "Operator info check failed: %s", esp_err_to_name(err));
-        return err;
+        counts->wrong++;
     }
+}
 
-    int mode, format, act_c;
-    char operator_str[64] = {0};
-    char *cops_response = strstr(response, "+COPS:");
+bool sim7080g_test_publish_mixed(sim7080g_handle_t *sim7080g_handle, int fake_modem_port_num, int rounds)
+{
+    if (!sim7080g_handle->uart_initialized || sim7080g_handle->ctx == NULL)
+    {
+        ESP_LOGE(TAG, "SIM7080G driver not initialized");
+        return false;
+    }
+    if (rounds <= 0 || fake_modem_port_num == sim7080g_handle->uart_config.port_num)
+    {
+        ESP_LOGE(TAG, "Mixed publish test: Invalid parameters");
+        return false;
+    }
 
-    if (cops_response &&
-        sscanf(cops_response, "+COPS: %d,%d,\"%63[^\"]\",%d", &mode, &format, operator_str, &act_c) >= 3)
+    sim7080g_ctx_t *ctx = sim7080g_handle->ctx;
+    fake_modem_t modem = {.port = (uart_port_t)fake_modem_port_num, .async_acks = true};
+    if (!fake_modem_start(sim7080g_handle, &modem))
     {
-        if (mode != 2)
-        { // 2 = deregistered
-            *connected = true;
-            ESP_LOGI(TAG, "Data link layer connected (Operator: %s)", operator_str);
+        return false;
+    }
+    const bool async_publish = ctx->async_publish;
+    ctx->async_publish = true;
+
+    // Each round: a pipelined publish the broker acks, a blocking one, then a pipelined one the broker rejects.
+    // The blocking publish's ack sits between the other two - taken for the wrong publish, it shifts every result after it.
+    publish_mixed_counts_t counts = {0};
+    uint32_t sent = 0;
+    bool passed = true;
+    for (int i = 0; i < rounds && passed; i++)
+    {
+        const sim7080g_iovec_t pass_iov = {.base = "P", .len = 1};
+        const sim7080g_iovec_t fail_iov = {.base = "F", .len = 1};
+        esp_err_t err = sim7080g_mqtt_publish_pipelined(sim7080g_handle, PUBLISH_RATE_TEST_TOPIC, &pass_iov, 1, 1, false,
+                                                        publish_mixed_test_ok_cb, &counts, SIM7080G_MQTT_INFLIGHT_TIMEOUT_MS, NULL);
+        sent += (err == ESP_OK) ? 1 : 0;
+        if (err == ESP_OK)
+        {
+            err = sim7080g_mqtt_publish(sim7080g_handle, PUBLISH_RATE_TEST_TOPIC, "B", 1, false);
+            sent += (err == ESP_OK) ? 1 : 0;
+            if (err == ESP_OK && modem.acks_sent < sent)
+            {
+                ESP_LOGE(TAG, "Mixed publish test failed! Blocking publish returned before the broker acked it");
+                passed = false;
+            }
         }
-        else
+        if (err == ESP_OK)
+        {
+            err = sim7080g_mqtt_publish_pipelined(sim7080g_handle, PUBLISH_RATE_TEST_TOPIC, &fail_iov, 1, 1, false,
+                                                  publish_mixed_test_fail_cb, &counts, SIM7080G_MQTT_INFLIGHT_TIMEOUT_MS, NULL);
+            sent += (err == ESP_OK) ? 1 : 0;
+        }
+        if (err != ESP_OK)
         {
-            ESP_LOGE(TAG, "Data link layer not connected (Operator mode: %d)", mode);
+            ESP_LOGE(TAG, "Mixed publish test: round %d failed: %s", i, esp_err_to_name(err));
+            passed = false;
         }
     }
-    else
+    esp_err_t err = sim7080g_mqtt_wait_inflight(sim7080g_handle, 5000);
+
+    ctx->async_publish = async_publish;
+    fake_modem_stop(sim7080g_handle, &modem);
+
+    if (!passed || err != ESP_OK || counts.wrong > 0 || counts.acked != (uint32_t)rounds * 2)
     {
-        ESP_LOGE(TAG, "Failed to parse operator info: %s", response);
-        return ESP_ERR_INVALID_RESPONSE;
+        ESP_LOGE(TAG, "Mixed publish test failed! %lu of %d pipelined publishes got their own ack, %lu got another's (%s)",
+                 (unsigned long)counts.acked, rounds * 2, (unsigned long)counts.wrong, esp_err_to_name(err));
+        return false;
     }
 
-    return ESP_OK;
+    ESP_LOGI(TAG, "Mixed publish test passed! %d rounds, %lu acks", rounds, (unsigned long)modem.acks_sent);
+    return true;
 }
 
-// Check:
-// AT+CNACT? (PDP context)
-// AT+CGPADDR (IP address)
-esp_err_t sim7080g_is_network_layer_connected(const sim7080g_handle_t *handle, bool *connected)
+// ------ Hex decode benchmark ------ //
+
+#define HEX_DECODE_TEST_LEN SIM7080G_MQTT_MAX_PAYLOAD_LEN
+
+/// @brief The obvious decoder, for comparison - one sscanf per byte
+static bool hex_decode_sscanf(const char *hex, size_t hex_len, uint8_t *out)
 {
-    if (!handle || !connected)
+    if (hex_len % 2 != 0)
     {
-        ESP_LOGE(TAG, "Is network layer connected fail: Invalid parameters");
-        return ESP_ERR_INVALID_ARG;
+        return false;
     }
-    *connected = false;
-    esp_err_t err;
-    char response[AT_RESPONSE_MAX_LEN] = {0};
 
-    // Check PDP context status with AT+CNACT?
-    err = send_at_cmd(handle, &AT_CNACT, AT_CMD_TYPE_READ, NULL, response, sizeof(response), 20000);
-    if (err != ESP_OK)
+    for (size_t i = 0; i < hex_len / 2; i++)
     {
-        ESP_LOGE(TAG, "PDP context status check failed: %s", esp_err_to_name(err));
-        return err;
+        char digits[3] = {hex[2 * i], hex[2 * i + 1], '\0'};
+        unsigned int value;
+        if (sscanf(digits, "%2x", &value) != 1)
+        {
+            return false;
+        }
+        out[i] = (uint8_t)value;
     }
+    return true;
+}
 
-    // Parse response for the first PDP context (index 0)
-    char *cnact_response = strstr(response, "+CNACT:");
-    if (cnact_response)
+bool sim7080g_test_hex_decode(int iterations)
+{
+    if (iterations <= 0)
     {
-        int pdp_idx, status;
-        char ip_addr[64] = {0};
+        ESP_LOGE(TAG, "Hex decode test: Invalid parameters");
+        return false;
+    }
 
-        if (sscanf(cnact_response, "+CNACT: %d,%d,\"%63[^\"]\"",
-                   &pdp_idx, &status, ip_addr) >= 2)
-        {
-            if (pdp_idx == 0 && status > 0 && strlen(ip_addr) > 0)
-            {
-                *connected = true;
-                ESP_LOGI(TAG, "Network layer connected (IP: %s)", ip_addr);
-            }
-            else
-            {
-                ESP_LOGE(TAG, "Network layer not connected (PDP status: %d)", status);
-            }
-        }
-        else
-        {
-            ESP_LOGE(TAG, "Failed to parse PDP context status: %s", response);
-            return ESP_ERR_INVALID_RESPONSE;
-        }
+    uint8_t *payload = malloc(HEX_DECODE_TEST_LEN);
+    char *hex = malloc(2 * HEX_DECODE_TEST_LEN);
+    uint8_t *work = malloc(2 * HEX_DECODE_TEST_LEN);
+    if (payload == NULL || hex == NULL || work == NULL)
+    {
+        ESP_LOGE(TAG, "Hex decode test: Out of memory");
+        free(payload);
+        free(hex);
+        free(work);
+        return false;
     }
-    else
+
+    // Random bytes, encoded with both digit cases as modems differ
+    static const char upper[] = "0123456789ABCDEF";
+    static const char lower[] = "0123456789abcdef";
+    esp_fill_random(payload, HEX_DECODE_TEST_LEN);
+    for (size_t i = 0; i < HEX_DECODE_TEST_LEN; i++)
     {
-        ESP_LOGE(TAG, "No CNACT response found");
-        return ESP_ERR_INVALID_RESPONSE;
+        const char *digits = (i % 2 == 0) ? upper : lower;
+        hex[2 * i] = digits[payload[i] >> 4];
+        hex[2 * i + 1] = digits[payload[i] & 0x0F];
     }
 
-    // TODO - this
-    //  Check IP address with AT+CGPADDR
+    bool ok = true;
 
-    return ESP_OK;
-}
+    // In place, as the +SMSUB handler decodes
+    memcpy(work, hex, 2 * HEX_DECODE_TEST_LEN);
+    ok = ok && at_hex_decode((const char *)work, 2 * HEX_DECODE_TEST_LEN, work) &&
+         memcmp(work, payload, HEX_DECODE_TEST_LEN) == 0;
 
-// Check:
-// AT+CASTATE (TCP/UDP connection status)
-// TODO - FIX THIS (if its even needed?)
-// esp_err_t sim7080g_is_transport_layer_connected(const sim7080g_handle_t *handle, bool *connected)
-// {
-//     if (!handle || !connected)
-//     {
-//         ESP_LOGE(TAG, "Is transport layer connected fail: Invalid parameters");
-//         return ESP_ERR_INVALID_ARG;
-//     }
+    // Odd length, and a bad digit in either position of a byte
+    memcpy(work, hex, 2 * HEX_DECODE_TEST_LEN);
+    ok = ok && !at_hex_decode((const char *)work, 2 * HEX_DECODE_TEST_LEN - 1, work);
+    work[HEX_DECODE_TEST_LEN] = 'g';
+    ok = ok && !at_hex_decode((const char *)work, 2 * HEX_DECODE_TEST_LEN, work);
+    memcpy(work, hex, 2 * HEX_DECODE_TEST_LEN);
+    work[HEX_DECODE_TEST_LEN + 1] = '"';
+    ok = ok && !at_hex_decode((const char *)work, 2 * HEX_DECODE_TEST_LEN, work);
+    if (!ok)
+    {
+        ESP_LOGE(TAG, "Hex decode test failed! Decoding in place or rejecting bad input went wrong");
+        goto done;
+    }
 
-//     // TODO - this
-//     // Check TCP/UDP connection status with AT+CASTATE
+    int64_t start = esp_timer_get_time();
+    for (int i = 0; i < iterations; i++)
+    {
+        ok = hex_decode_sscanf(hex, 2 * HEX_DECODE_TEST_LEN, work) && ok;
+    }
+    int64_t sscanf_us = esp_timer_get_time() - start;
+    ok = ok && memcmp(work, payload, HEX_DECODE_TEST_LEN) == 0;
 
-//     *connected = false;
-//     char response[AT_RESPONSE_MAX_LEN] = {0};
-//     esp_err_t err;
+    memset(work, 0, HEX_DECODE_TEST_LEN);
+    start = esp_timer_get_time();
+    for (int i = 0; i < iterations; i++)
+    {
+        ok = at_hex_decode(hex, 2 * HEX_DECODE_TEST_LEN, work) && ok;
+    }
+    int64_t table_us = esp_timer_get_time() - start;
+    ok = ok && memcmp(work, payload, HEX_DECODE_TEST_LEN) == 0;
 
-//     err = send_at_cmd(handle, &AT_CASTATE, AT_CMD_TYPE_READ, NULL, response, sizeof(response), 5000);
-//     if (err != ESP_OK)
-//     {
-//         ESP_LOGE(TAG, "Transport layer status check failed: %s", esp_err_to_name(err));
-//         return err;
-//     }
+    if (!ok)
+    {
+        ESP_LOGE(TAG, "Hex decode test failed! Decoded bytes did not match the payload");
+        goto done;
+    }
 
-//     char *castate_response = strstr(response, "+CASTATE:");
-//     if (castate_response)
-//     {
-//         int status;
-//         if (sscanf(castate_response, "+CASTATE: %d", &status) == 1)
-//         {
-//             // Status values: 0=disconnected, 1=connected
-//             if (status > 0)
-//             {
-//                 *connected = true;
-//                 ESP_LOGI(TAG, "Transport layer connected (CASTATE: %d)", status);
-//             }
-//             else
-//             {
-//                 ESP_LOGE(TAG, "Transport layer not connected (CASTATE: %d)", status);
-//             }
-//         }
-//         else
-//         {
-//             ESP_LOGE(TAG, "Failed to parse transport layer status: %s", response);
-//             return ESP_ERR_INVALID_RESPONSE;
-//         }
-//     }
-//     else
-//     {
-//         ESP_LOGE(TAG, "No CASTATE response found");
-//         return ESP_ERR_INVALID_RESPONSE;
-//     }
+    // Bytes per microsecond is MB/s
+    double total = (double)HEX_DECODE_TEST_LEN * iterations;
+    double sscanf_mbps = total / (double)(sscanf_us > 0 ? sscanf_us : 1);
+    double table_mbps = total / (double)(table_us > 0 ? table_us : 1);
+    ESP_LOGI(TAG, "Hex decode test: %d byte payload, %d iterations", HEX_DECODE_TEST_LEN, iterations);
+    ESP_LOGI(TAG, "  sscanf:        %.2f MB/s", sscanf_mbps);
+    ESP_LOGI(TAG, "  at_hex_decode: %.2f MB/s (%.1fx)", table_mbps, table_mbps / sscanf_mbps);
+    ESP_LOGI(TAG, "Hex decode test passed!");
 
-//     return ESP_OK;
-// }
+done:
+    free(payload);
+    free(hex);
+    free(work);
+    return ok;
+}
 
-// Check:
-// AT+SMSTATE (MQTT connection status)
-esp_err_t sim7080g_is_application_layer_connected(const sim7080g_handle_t *handle, bool *connected)
+// ------ Status cache benchmark ------ //
+
+/// @brief One health check - every layer, as an application watching its connection would poll them
+static esp_err_t status_cache_test_check(sim7080g_handle_t *sim7080g_handle)
 {
-    if (!handle || !connected)
+    bool connected;
+    esp_err_t err = sim7080g_is_physical_layer_connected(sim7080g_handle, &connected);
+    if (err == ESP_OK)
     {
-        ESP_LOGE(TAG, "Is application layer connected fail: Invalid parameters");
-        return ESP_ERR_INVALID_ARG;
+        err = sim7080g_is_data_link_layer_connected(sim7080g_handle, &connected);
     }
-    *connected = false;
-    esp_err_t err;
-    char response[AT_RESPONSE_MAX_LEN] = {0};
-
-    // Check MQTT connection status with AT+SMSTATE?
-    err = send_at_cmd(handle, &AT_SMSTATE, AT_CMD_TYPE_READ, NULL, response, sizeof(response), 5000);
-    if (err != ESP_OK)
+    if (err == ESP_OK)
     {
-        ESP_LOGE(TAG, "MQTT status check failed: %s", esp_err_to_name(err));
-        return err;
+        err = sim7080g_is_network_layer_connected(sim7080g_handle, &connected);
+    }
+    if (err == ESP_OK)
+    {
+        err = sim7080g_is_application_layer_connected(sim7080g_handle, &connected);
     }
+    return err;
+}
+
+typedef struct
+{
+    sim7080g_ctx_t *ctx;
+    uint32_t generation_before; // CEREG cache generation before the command
+    volatile bool command_done;
+    bool in_flight; // The reader missed the cache while the command was in flight
+    SemaphoreHandle_t finished;
+} status_cache_race_t;
+
+#define STATUS_CACHE_RACE_STALE "+CEREG: 0,0\r\n\r\nOK"
+
+/// @brief A status read racing a state changing command - misses the cache as soon as the command drops it, then stores
+///        what it read (the state from before the command) once the command is done
+static void status_cache_race_reader(void *arg)
+{
+    status_cache_race_t *race = arg;
+    const sim7080g_status_entry_t *entry = &race->ctx->status_cache[SIM7080G_STATUS_CEREG];
 
-    char *smstate_response = strstr(response, "+SMSTATE:");
-    if (smstate_response)
+    for (;;)
     {
-        int status;
-        if (sscanf(smstate_response, "+SMSTATE: %d", &status) == 1)
+        xSemaphoreTake(race->ctx->status_cache_lock, portMAX_DELAY);
+        uint32_t generation = entry->generation;
+        xSemaphoreGive(race->ctx->status_cache_lock);
+        if (generation != race->generation_before || race->command_done)
         {
-            // Status values: 0=disconnected, 1=connected, 2=connected with session
-            if (status > 0)
-            {
-                *connected = true;
-                ESP_LOGI(TAG, "Application layer connected (MQTT Status: %d)", status);
-            }
-            else
-            {
-                ESP_LOGE(TAG, "Application layer not connected (MQTT Status: %d)", status);
-            }
-        }
-        else
-        {
-            ESP_LOGE(TAG, "Failed to parse MQTT status: %s", response);
-            return ESP_ERR_INVALID_RESPONSE;
+            break;
         }
+        vTaskDelay(1);
     }
-    else
+
+    char response[AT_RESPONSE_MAX_LEN];
+    uint32_t generation;
+    if (!sim7080g_status_cache_lookup(race->ctx, SIM7080G_STATUS_CEREG, response, sizeof(response), &generation))
     {
-        ESP_LOGE(TAG, "No SMSTATE response found");
-        return ESP_ERR_INVALID_RESPONSE;
+        // One drop before the command is sent, one once it is done
+        race->in_flight = generation == race->generation_before + 1;
+        while (!race->command_done)
+        {
+            vTaskDelay(1);
+        }
+        sim7080g_status_cache_store(race->ctx, SIM7080G_STATUS_CEREG, generation, STATUS_CACHE_RACE_STALE);
     }
 
-    return ESP_OK;
+    xSemaphoreGive(race->finished);
+    vTaskDelete(NULL);
 }
 
-static esp_err_t sim7080g_echo_off(const sim7080g_handle_t *sim7080g_handle)
+/// @brief Send AT+CEREG=2 (what sim7080g_wait_for_registration sets anyway) while another task reads +CEREG through the cache
+/// @return false if the state read while the command was in flight outlived the command
+static bool status_cache_test_race(sim7080g_handle_t *sim7080g_handle)
 {
-    if (!sim7080g_handle || !sim7080g_handle->uart_initialized)
+    sim7080g_ctx_t *ctx = sim7080g_handle->ctx;
+    status_cache_race_t race = {.ctx = ctx};
+    race.finished = xSemaphoreCreateBinary();
+    if (race.finished == NULL)
     {
-        ESP_LOGE(TAG, "SIM7080G driver not initialized");
-        return ESP_ERR_INVALID_STATE;
+        ESP_LOGE(TAG, "Status cache test: out of memory");
+        return false;
     }
 
-    char response[AT_RESPONSE_MAX_LEN] = {0};
-    esp_err_t ret = send_at_cmd(sim7080g_handle,
-                                &AT_ECHO_OFF,
-                                AT_CMD_TYPE_EXECUTE,
-                                NULL,
-                                response,
-                                sizeof(response),
-                                5000);
+    xSemaphoreTake(ctx->status_cache_lock, portMAX_DELAY);
+    race.generation_before = ctx->status_cache[SIM7080G_STATUS_CEREG].generation;
+    xSemaphoreGive(ctx->status_cache_lock);
 
-    if (ret != ESP_OK)
+    if (xTaskCreate(status_cache_race_reader, "cache_race", 3072, &race, uxTaskPriorityGet(NULL) + 1, NULL) != pdPASS)
     {
-        ESP_LOGE(TAG, "Failed to turn off echo");
-        return ret;
+        ESP_LOGE(TAG, "Status cache test: could not start the reader task");
+        vSemaphoreDelete(race.finished);
+        return false;
     }
 
-    ESP_LOGI(TAG, "Echo off");
-    return ESP_OK;
-}
+    char response[AT_RESPONSE_MAX_LEN] = {0};
+    esp_err_t err = send_at_cmd(sim7080g_handle, &AT_CEREG, AT_CMD_TYPE_WRITE, "2", response, sizeof(response), 5000);
+    race.command_done = true;
+    xSemaphoreTake(race.finished, portMAX_DELAY);
+    vSemaphoreDelete(race.finished);
+    if (err != ESP_OK)
+    {
+        ESP_LOGE(TAG, "Status cache test: AT+CEREG=2 failed: %s", esp_err_to_name(err));
+        return false;
+    }
+    if (!race.in_flight)
+    {
+        ESP_LOGW(TAG, "Status cache test: the reader did not get in while AT+CEREG=2 was in flight - race not exercised");
+        return true;
+    }
 
-// ---------------------  INTERNAL TESTING FXNs  ---------------------//
+    xSemaphoreTake(ctx->status_cache_lock, portMAX_DELAY);
+    const sim7080g_status_entry_t *entry = &ctx->status_cache[SIM7080G_STATUS_CEREG];
+    bool stale = entry->valid && strcmp(entry->response, STATUS_CACHE_RACE_STALE) == 0;
+    xSemaphoreGive(ctx->status_cache_lock);
+    if (stale)
+    {
+        ESP_LOGE(TAG, "Status cache test failed! A +CEREG read from before AT+CEREG=2 was cached after it");
+        return false;
+    }
+    return true;
+}
 
-bool sim7080g_test_uart_loopback(sim7080g_handle_t *sim7080g_handle)
+bool sim7080g_test_status_cache(sim7080g_handle_t *sim7080g_handle, int iterations)
 {
-    if (!sim7080g_handle->uart_initialized)
+    if (!sim7080g_handle->uart_initialized || sim7080g_handle->ctx == NULL || iterations <= 0)
     {
         ESP_LOGE(TAG, "SIM7080G driver not initialized");
         return false;
     }
 
-    const char *test_str = "Hello, SIM7080G!";
-    char rx_buffer[128];
-
-    // Send data
-    int tx_bytes = uart_write_bytes(sim7080g_handle->uart_config.port_num, test_str, strlen(test_str));
-    ESP_LOGI(TAG, "Sent %d bytes: %s", tx_bytes, test_str);
-
-    // Read data
-    int len = uart_read_bytes(sim7080g_handle->uart_config.port_num, rx_buffer, sizeof(rx_buffer) - 1, 1000);
+    sim7080g_status_cache_stats_t start_stats;
+    sim7080g_status_cache_stats_t filled_stats;
+    sim7080g_status_cache_stats_t end_stats;
+    sim7080g_status_cache_invalidate(sim7080g_handle);
+    sim7080g_get_status_cache_stats(sim7080g_handle, &start_stats);
 
-    if (len < 0)
+    int64_t start_us = esp_timer_get_time();
+    esp_err_t err = status_cache_test_check(sim7080g_handle);
+    int64_t device_us = esp_timer_get_time() - start_us;
+    if (err != ESP_OK)
     {
-        ESP_LOGE(TAG, "UART read error");
+        ESP_LOGE(TAG, "Status cache test: health check failed: %s", esp_err_to_name(err));
         return false;
     }
+    sim7080g_get_status_cache_stats(sim7080g_handle, &filled_stats);
 
-    // Add null terminator to the byte data read to handle it like a string
-    rx_buffer[len] = '\0';
+    start_us = esp_timer_get_time();
+    for (int i = 0; i < iterations && err == ESP_OK; i++)
+    {
+        err = status_cache_test_check(sim7080g_handle);
+    }
+    int64_t cached_us = esp_timer_get_time() - start_us;
+    sim7080g_get_status_cache_stats(sim7080g_handle, &end_stats);
+    if (err != ESP_OK)
+    {
+        ESP_LOGE(TAG, "Status cache test: cached health check failed: %s", esp_err_to_name(err));
+        return false;
+    }
 
-    ESP_LOGI(TAG, "Received %d bytes: %s", len, rx_buffer);
+    uint32_t reads = filled_stats.misses - start_stats.misses;
+    uint32_t resent = end_stats.misses - filled_stats.misses;
+    ESP_LOGI(TAG, "Status cache test: %lu status reads per health check", (unsigned long)reads);
+    ESP_LOGI(TAG, "  from the device: %lld us", (long long)device_us);
+    ESP_LOGI(TAG, "  from the cache:  %lld us avg over %d checks (%lu hits)",
+             (long long)(cached_us / iterations), iterations, (unsigned long)(end_stats.hits - filled_stats.hits));
 
-    // Compare sent and received data
-    if (strcmp(test_str, rx_buffer) == 0)
+    if (resent > 0)
     {
-        ESP_LOGI(TAG, "UART loopback test passed!");
-        return true;
+        // A URC arriving mid test legitimately forces a read - say so rather than report a cache bug
+        ESP_LOGE(TAG, "Status cache test failed! %lu reads went to the device within the TTL (%lu invalidations)",
+                 (unsigned long)resent, (unsigned long)(end_stats.invalidations - filled_stats.invalidations));
+        return false;
     }
-    else
+
+    if (!status_cache_test_race(sim7080g_handle))
     {
-        ESP_LOGE(TAG, "UART loopback test failed!");
         return false;
     }
-}
\ No newline at end of file
+
+    ESP_LOGI(TAG, "Status cache test passed!");
+    return true;
+}
@@ -0,0 +1,330 @@
+#include <stdlib.h>
+#include <string.h>
+#include <esp_err.h>
+#include <esp_log.h>
+#include <esp_timer.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/semphr.h>
+#include <freertos/task.h>
+
+#include "sim7080g_mqtt_batch.h"
+
+static const char *TAG = "SIM7080G Batch";
+
+typedef enum
+{
+    SIM7080G_BATCH_FLUSH_SIZE,
+    SIM7080G_BATCH_FLUSH_AGE,
+    SIM7080G_BATCH_FLUSH_MANUAL,
+} sim7080g_batch_flush_reason_t;
+
+struct sim7080g_batch
+{
+    const sim7080g_handle_t *sim7080g_handle;
+    sim7080g_batch_config_t config;
+    size_t topic_len;
+    SemaphoreHandle_t mutex;
+    esp_timer_handle_t age_timer; // NULL if config.max_age_ms is 0
+    bool deleting;                // Set by sim7080g_batch_delete - the age timer callback then leaves the buffer alone
+    uint8_t *buf;                 // config.max_bytes long
+    size_t len;
+    uint32_t buffered_records;
+    uint32_t pending_bytes_saved; // Credited to the stats once the buffered records are actually published
+    sim7080g_batch_stats_t stats;
+};
+
+/// @brief Bytes of MQTT PUBLISH header sent with a payload of payload_len on its own
+/// @note Fixed header byte + remaining length (1-3 bytes at these sizes) + topic length + topic + packet id (QoS 1/2 only)
+static size_t sim7080g_batch_publish_overhead(const sim7080g_batch_t *batch, size_t payload_len)
+{
+    size_t variable_len = 2 + batch->topic_len + (batch->config.qos > 0 ? 2 : 0);
+    size_t remaining_len = variable_len + payload_len;
+    size_t remaining_len_bytes = (remaining_len < 128) ? 1 : (remaining_len < 16384) ? 2 : 3;
+    return 1 + remaining_len_bytes + variable_len;
+}
+
+/// @brief Queue the buffered records as one publish - called with the mutex held
+static esp_err_t sim7080g_batch_flush_locked(sim7080g_batch_t *batch, sim7080g_batch_flush_reason_t reason)
+{
+    if (batch->len == 0)
+    {
+        return ESP_OK;
+    }
+
+    if (batch->age_timer != NULL)
+    {
+        esp_timer_stop(batch->age_timer); // Not running if this is the age flush itself
+    }
+
+    sim7080g_iovec_t iov = {.base = batch->buf, .len = batch->len};
+    esp_err_t err = sim7080g_mqtt_publish_iov_async(batch->sim7080g_handle, batch->config.topic, &iov, 1,
+                                                    batch->config.qos, false, NULL, NULL);
+    if (err != ESP_OK)
+    {
+        // Keep the records for the next flush - the age timer tries again if there is one
+        ESP_LOGW(TAG, "Could not queue batch of %lu records: %s", (unsigned long)batch->buffered_records, esp_err_to_name(err));
+        batch->stats.flush_errors++;
+        if (batch->age_timer != NULL)
+        {
+            esp_timer_start_once(batch->age_timer, (uint64_t)batch->config.max_age_ms * 1000);
+        }
+        return err;
+    }
+
+    ESP_LOGD(TAG, "Queued batch of %lu records (%u bytes)", (unsigned long)batch->buffered_records, (unsigned)batch->len);
+    batch->stats.publishes++;
+    batch->stats.messages_coalesced += batch->buffered_records - 1;
+    batch->stats.bytes_saved += batch->pending_bytes_saved;
+    switch (reason)
+    {
+    case SIM7080G_BATCH_FLUSH_SIZE:
+        batch->stats.size_flushes++;
+        break;
+    case SIM7080G_BATCH_FLUSH_AGE:
+        batch->stats.age_flushes++;
+        break;
+    case SIM7080G_BATCH_FLUSH_MANUAL:
+        batch->stats.manual_flushes++;
+        break;
+    }
+
+    batch->len = 0;
+    batch->buffered_records = 0;
+    batch->pending_bytes_saved = 0;
+    return ESP_OK;
+}
+
+/// @brief esp_timer callback - the oldest buffered record has waited max_age_ms
+static void sim7080g_batch_age_timer_cb(void *arg)
+{
+    sim7080g_batch_t *batch = arg;
+    xSemaphoreTake(batch->mutex, portMAX_DELAY);
+    if (!batch->deleting)
+    {
+        sim7080g_batch_flush_locked(batch, SIM7080G_BATCH_FLUSH_AGE);
+    }
+    xSemaphoreGive(batch->mutex);
+}
+
+static void sim7080g_batch_fence_cb(void *arg)
+{
+    xSemaphoreGive((SemaphoreHandle_t)arg);
+}
+
+/// @brief Wait for an age timer callback that esp_timer_stop was too late to cancel
+/// @note ESP_TIMER_TASK callbacks run one at a time on the esp_timer task, so once a callback queued after it has run it is done
+static void sim7080g_batch_timer_join(void)
+{
+    SemaphoreHandle_t done = xSemaphoreCreateBinary();
+    esp_timer_handle_t fence = NULL;
+    const esp_timer_create_args_t fence_args = {
+        .callback = sim7080g_batch_fence_cb,
+        .arg = done,
+        .dispatch_method = ESP_TIMER_TASK,
+        .name = "sim7080g_batch_fence",
+    };
+    if (done == NULL || esp_timer_create(&fence_args, &fence) != ESP_OK || esp_timer_start_once(fence, 0) != ESP_OK)
+    {
+        // Out of memory - the callback only holds the mutex for one AT+SMPUB queue, give it well over that
+        ESP_LOGW(TAG, "Could not join the age timer - waiting instead");
+        vTaskDelay(pdMS_TO_TICKS(100));
+    }
+    else
+    {
+        xSemaphoreTake(done, portMAX_DELAY);
+    }
+
+    if (fence != NULL)
+    {
+        esp_timer_delete(fence);
+    }
+    if (done != NULL)
+    {
+        vSemaphoreDelete(done);
+    }
+}
+
+esp_err_t sim7080g_batch_create(const sim7080g_handle_t *sim7080g_handle,
+                                const sim7080g_batch_config_t *config,
+                                sim7080g_batch_handle_t *batch_out)
+{
+    if (sim7080g_handle == NULL || config == NULL || config->topic == NULL || config->topic[0] == '\0' ||
+        config->qos > 2 || batch_out == NULL)
+    {
+        ESP_LOGE(TAG, "Invalid parameters");
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    sim7080g_batch_t *batch = calloc(1, sizeof(*batch));
+    if (batch == NULL)
+    {
+        ESP_LOGE(TAG, "Error allocating batch");
+        return ESP_ERR_NO_MEM;
+    }
+
+    batch->sim7080g_handle = sim7080g_handle;
+    batch->config = *config;
+    if (batch->config.max_bytes == 0 || batch->config.max_bytes > SIM7080G_MQTT_MAX_PAYLOAD_LEN)
+    {
+        batch->config.max_bytes = SIM7080G_MQTT_MAX_PAYLOAD_LEN;
+    }
+    batch->topic_len = strlen(config->topic);
+
+    batch->buf = malloc(batch->config.max_bytes);
+    batch->mutex = xSemaphoreCreateMutex();
+    if (batch->buf == NULL || batch->mutex == NULL)
+    {
+        ESP_LOGE(TAG, "Error allocating batch buffer");
+        sim7080g_batch_delete(batch);
+        return ESP_ERR_NO_MEM;
+    }
+
+    if (batch->config.max_age_ms > 0)
+    {
+        const esp_timer_create_args_t timer_args = {
+            .callback = sim7080g_batch_age_timer_cb,
+            .arg = batch,
+            .dispatch_method = ESP_TIMER_TASK,
+            .name = "sim7080g_batch",
+        };
+        esp_err_t err = esp_timer_create(&timer_args, &batch->age_timer);
+        if (err != ESP_OK)
+        {
+            ESP_LOGE(TAG, "Error creating batch age timer: %s", esp_err_to_name(err));
+            batch->age_timer = NULL;
+            sim7080g_batch_delete(batch);
+            return err;
+        }
+    }
+
+    *batch_out = batch;
+    return ESP_OK;
+}
+
+esp_err_t sim7080g_batch_append(sim7080g_batch_handle_t batch, const void *record, size_t len)
+{
+    if (batch == NULL || (record == NULL && len > 0))
+    {
+        ESP_LOGE(TAG, "Invalid parameters");
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (len == 0)
+    {
+        return ESP_OK;
+    }
+    if (len > batch->config.max_bytes)
+    {
+        ESP_LOGE(TAG, "Record of %u bytes exceeds batch size of %u bytes", (unsigned)len, (unsigned)batch->config.max_bytes);
+        return ESP_ERR_INVALID_SIZE;
+    }
+
+    xSemaphoreTake(batch->mutex, portMAX_DELAY);
+
+    size_t separator_len = (batch->len > 0 && batch->config.separator != '\0') ? 1 : 0;
+    if (batch->len + separator_len + len > batch->config.max_bytes)
+    {
+        esp_err_t err = sim7080g_batch_flush_locked(batch, SIM7080G_BATCH_FLUSH_SIZE);
+        if (err != ESP_OK)
+        {
+            xSemaphoreGive(batch->mutex);
+            return err;
+        }
+        separator_len = 0;
+    }
+
+    if (separator_len > 0)
+    {
+        batch->buf[batch->len++] = (uint8_t)batch->config.separator;
+    }
+    memcpy(batch->buf + batch->len, record, len);
+    batch->len += len;
+    batch->stats.records++;
+
+    if (batch->buffered_records++ == 0)
+    {
+        if (batch->age_timer != NULL)
+        {
+            esp_timer_start_once(batch->age_timer, (uint64_t)batch->config.max_age_ms * 1000);
+        }
+    }
+    else
+    {
+        size_t overhead = sim7080g_batch_publish_overhead(batch, len);
+        batch->pending_bytes_saved += (overhead > separator_len) ? overhead - separator_len : 0;
+    }
+
+    if (batch->len == batch->config.max_bytes)
+    {
+        // Full - a failed flush here is not the caller's problem, the record is buffered
+        sim7080g_batch_flush_locked(batch, SIM7080G_BATCH_FLUSH_SIZE);
+    }
+
+    xSemaphoreGive(batch->mutex);
+    return ESP_OK;
+}
+
+esp_err_t sim7080g_batch_flush(sim7080g_batch_handle_t batch)
+{
+    if (batch == NULL)
+    {
+        ESP_LOGE(TAG, "Invalid parameters");
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    xSemaphoreTake(batch->mutex, portMAX_DELAY);
+    esp_err_t err = sim7080g_batch_flush_locked(batch, SIM7080G_BATCH_FLUSH_MANUAL);
+    xSemaphoreGive(batch->mutex);
+    return err;
+}
+
+esp_err_t sim7080g_batch_get_stats(sim7080g_batch_handle_t batch, sim7080g_batch_stats_t *stats_out)
+{
+    if (batch == NULL || stats_out == NULL)
+    {
+        ESP_LOGE(TAG, "Invalid parameters");
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    xSemaphoreTake(batch->mutex, portMAX_DELAY);
+    *stats_out = batch->stats;
+    xSemaphoreGive(batch->mutex);
+    return ESP_OK;
+}
+
+esp_err_t sim7080g_batch_delete(sim7080g_batch_handle_t batch)
+{
+    if (batch == NULL)
+    {
+        ESP_LOGE(TAG, "Invalid parameters");
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    // A callback already past esp_timer_stop may be waiting on the mutex - it must see the flag once it gets it
+    if (batch->mutex != NULL)
+    {
+        xSemaphoreTake(batch->mutex, portMAX_DELAY);
+        batch->deleting = true;
+        xSemaphoreGive(batch->mutex);
+    }
+
+    if (batch->age_timer != NULL)
+    {
+        esp_timer_stop(batch->age_timer);
+        esp_timer_delete(batch->age_timer);
+        sim7080g_batch_timer_join();
+    }
+
+    esp_err_t err = ESP_OK;
+    if (batch->mutex != NULL)
+    {
+        xSemaphoreTake(batch->mutex, portMAX_DELAY);
+        batch->age_timer = NULL;
+        err = sim7080g_batch_flush_locked(batch, SIM7080G_BATCH_FLUSH_MANUAL);
+        xSemaphoreGive(batch->mutex);
+        vSemaphoreDelete(batch->mutex);
+    }
+
+    free(batch->buf);
+    free(batch);
+    return err;
+}
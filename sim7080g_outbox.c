@@ -0,0 +1,1051 @@
+#include <stdlib.h>
+#include <string.h>
+#include <esp_err.h>
+#include <esp_log.h>
+#include <esp_rom_crc.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/semphr.h>
+#include <esp_partition.h>
+
+#include "sim7080g_outbox.h"
+
+#define OUTBOX_SEGMENT_MAGIC 0x3158424Fu // "OBX1"
+#define OUTBOX_RECORD_MAGIC 0x4D52u      // "RM"
+#define OUTBOX_ERASED_WORD 0xFFFFFFFFu
+#define OUTBOX_ERASED_HALF 0xFFFFu
+#define OUTBOX_COMMITTED_WORD 0x00000000u
+#define OUTBOX_NO_SEGMENT UINT16_MAX
+
+static const char *TAG = "SIM7080G Outbox";
+
+/// @brief Start of every segment - a segment without a valid header is free
+typedef struct
+{
+    uint32_t magic;
+    uint32_t seq;         // Order of the segment in the log
+    uint32_t erase_count; // Times this segment has been erased
+    uint32_t crc;         // Over the fields above
+} outbox_segment_header_t;
+
+/// @brief Start of every record - followed by the topic (null terminated) and the payload, padded to 4 bytes
+/// @note The CRC covers magic to reserved, the topic and the payload - not the commit word,
+///       which is the only field ever written after the record
+typedef struct
+{
+    uint32_t commit; // OUTBOX_ERASED_WORD until the message is published, then zeroed
+    uint16_t magic;
+    uint8_t qos;
+    uint8_t topic_len; // Without the null
+    uint16_t payload_len;
+    uint16_t reserved;
+    uint32_t crc;
+} outbox_record_header_t;
+
+_Static_assert(sizeof(outbox_segment_header_t) == 16, "outbox segment header must not be padded");
+_Static_assert(sizeof(outbox_record_header_t) == 16, "outbox record header must not be padded");
+
+typedef struct
+{
+    uint32_t seq;
+    uint32_t erase_count;
+    uint32_t write_offset; // End of the records - segment_size once full (or closed by a torn record)
+    uint32_t pending;      // Records not yet committed
+    bool valid;            // Header is valid
+} outbox_segment_t;
+
+typedef struct
+{
+    const esp_partition_t *partition;
+    size_t size;
+    size_t sector_size;
+} outbox_storage_t;
+
+struct sim7080g_outbox
+{
+    outbox_storage_t storage;
+    SemaphoreHandle_t mutex;
+    size_t segment_size;
+    uint16_t segment_count;
+    outbox_segment_t *segments;
+    uint16_t tail; // Segment appended to - OUTBOX_NO_SEGMENT until the first append to an empty log
+    uint32_t next_seq;
+    uint16_t cursor_segment; // Oldest record not yet committed - only meaningful while pending > 0
+    uint32_t cursor_offset;
+    uint8_t *record_buf; // Topic and payload of the peeked record
+    bool peeked;
+    uint32_t peeked_size;
+    bool replaying;
+    bool direct_publishing;        // sim7080g_outbox_publish is sending past an empty outbox - appends and replay wait for it
+    SemaphoreHandle_t direct_lock; // Held for the whole of a direct publish, including storing it if the publish fails
+    uint32_t pending;
+    uint32_t appended;
+    uint32_t replayed;
+    uint32_t corrupt_records;
+    uint32_t rejected_records;
+};
+
+// ------ Storage ------ //
+
+static esp_err_t outbox_storage_open(outbox_storage_t *storage, const sim7080g_outbox_config_t *config)
+{
+    if (config->partition_label == NULL)
+    {
+        ESP_LOGE(TAG, "Invalid parameters: no partition_label");
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    storage->partition = esp_partition_find_first(ESP_PARTITION_TYPE_DATA, ESP_PARTITION_SUBTYPE_ANY, config->partition_label);
+    if (storage->partition == NULL)
+    {
+        ESP_LOGE(TAG, "Partition '%s' not found", config->partition_label);
+        return ESP_ERR_NOT_FOUND;
+    }
+    storage->size = storage->partition->size;
+    storage->sector_size = storage->partition->erase_size;
+    return ESP_OK;
+}
+
+static esp_err_t outbox_storage_read(outbox_storage_t *storage, size_t offset, void *dst, size_t len)
+{
+    return esp_partition_read(storage->partition, offset, dst, len);
+}
+
+static esp_err_t outbox_storage_write(outbox_storage_t *storage, size_t offset, const void *src, size_t len)
+{
+    return esp_partition_write(storage->partition, offset, src, len);
+}
+
+static esp_err_t outbox_storage_erase(outbox_storage_t *storage, size_t offset, size_t len)
+{
+    return esp_partition_erase_range(storage->partition, offset, len);
+}
+
+// ------ Log ------ //
+
+static size_t outbox_record_size(size_t topic_len, size_t payload_len)
+{
+    return (sizeof(outbox_record_header_t) + topic_len + 1 + payload_len + 3) & ~(size_t)3;
+}
+
+static uint32_t outbox_segment_crc(const outbox_segment_header_t *header)
+{
+    return esp_rom_crc32_le(0, (const uint8_t *)header, offsetof(outbox_segment_header_t, crc));
+}
+
+/// @brief CRC of a record - data is the null terminated topic followed by the payload
+static uint32_t outbox_record_crc(const outbox_record_header_t *header, const uint8_t *data)
+{
+    uint32_t crc = esp_rom_crc32_le(0, (const uint8_t *)&header->magic,
+                                    offsetof(outbox_record_header_t, crc) - offsetof(outbox_record_header_t, magic));
+    return esp_rom_crc32_le(crc, data, header->topic_len + 1u + header->payload_len);
+}
+
+static size_t outbox_segment_base(const sim7080g_outbox_t *outbox, uint16_t segment)
+{
+    return (size_t)segment * outbox->segment_size;
+}
+
+static bool outbox_segment_in_use(const sim7080g_outbox_t *outbox, uint16_t segment)
+{
+    const outbox_segment_t *seg = &outbox->segments[segment];
+    return seg->valid && (seg->pending > 0 || segment == outbox->tail);
+}
+
+/// @brief Read the record at offset of segment into record_buf
+/// @return ESP_ERR_INVALID_CRC if the record is torn or corrupt, ESP_ERR_NOT_FOUND at the end of the written records
+static esp_err_t outbox_read_record(sim7080g_outbox_t *outbox, uint16_t segment, uint32_t offset, outbox_record_header_t *header_out)
+{
+    if (offset + sizeof(*header_out) > outbox->segment_size)
+    {
+        return ESP_ERR_NOT_FOUND;
+    }
+
+    size_t base = outbox_segment_base(outbox, segment);
+    esp_err_t err = outbox_storage_read(&outbox->storage, base + offset, header_out, sizeof(*header_out));
+    if (err != ESP_OK)
+    {
+        return err;
+    }
+    if (header_out->magic == OUTBOX_ERASED_HALF)
+    {
+        return ESP_ERR_NOT_FOUND;
+    }
+    if (header_out->magic != OUTBOX_RECORD_MAGIC || header_out->topic_len == 0 ||
+        header_out->payload_len > SIM7080G_MQTT_MAX_PAYLOAD_LEN ||
+        offset + outbox_record_size(header_out->topic_len, header_out->payload_len) > outbox->segment_size)
+    {
+        return ESP_ERR_INVALID_CRC;
+    }
+
+    err = outbox_storage_read(&outbox->storage, base + offset + sizeof(*header_out), outbox->record_buf,
+                              header_out->topic_len + 1u + header_out->payload_len);
+    if (err != ESP_OK)
+    {
+        return err;
+    }
+    if (outbox_record_crc(header_out, outbox->record_buf) != header_out->crc || outbox->record_buf[header_out->topic_len] != '\0')
+    {
+        return ESP_ERR_INVALID_CRC;
+    }
+    return ESP_OK;
+}
+
+/// @brief Find the write position and uncommitted records of a segment - segments must be scanned oldest first
+static void outbox_scan_segment(sim7080g_outbox_t *outbox, uint16_t segment, bool *cursor_found)
+{
+    outbox_segment_t *seg = &outbox->segments[segment];
+    uint32_t offset = sizeof(outbox_segment_header_t);
+
+    while (true)
+    {
+        outbox_record_header_t header;
+        esp_err_t err = outbox_read_record(outbox, segment, offset, &header);
+        if (err == ESP_ERR_NOT_FOUND)
+        {
+            break;
+        }
+        if (err != ESP_OK)
+        {
+            // Torn by power loss (or unreadable) - nothing after it can be trusted, so the segment is closed here
+            ESP_LOGW(TAG, "Segment %u: bad record at offset %lu - closing segment", segment, (unsigned long)offset);
+            outbox->corrupt_records++;
+            seg->write_offset = outbox->segment_size;
+            return;
+        }
+
+        if (header.commit == OUTBOX_ERASED_WORD)
+        {
+            seg->pending++;
+            outbox->pending++;
+            if (!*cursor_found)
+            {
+                outbox->cursor_segment = segment;
+                outbox->cursor_offset = offset;
+                *cursor_found = true;
+            }
+        }
+        offset += outbox_record_size(header.topic_len, header.payload_len);
+    }
+    seg->write_offset = offset;
+}
+
+/// @brief Erase the free segment erased the fewest times and make it the tail
+static esp_err_t outbox_start_segment(sim7080g_outbox_t *outbox)
+{
+    uint16_t best = OUTBOX_NO_SEGMENT;
+    for (uint16_t i = 0; i < outbox->segment_count; i++)
+    {
+        if (i == outbox->tail || outbox_segment_in_use(outbox, i))
+        {
+            continue;
+        }
+        if (best == OUTBOX_NO_SEGMENT || outbox->segments[i].erase_count < outbox->segments[best].erase_count)
+        {
+            best = i;
+        }
+    }
+    if (best == OUTBOX_NO_SEGMENT)
+    {
+        return ESP_ERR_NO_MEM;
+    }
+
+    outbox_segment_t *seg = &outbox->segments[best];
+    esp_err_t err = outbox_storage_erase(&outbox->storage, outbox_segment_base(outbox, best), outbox->segment_size);
+    if (err != ESP_OK)
+    {
+        ESP_LOGE(TAG, "Error erasing segment %u: %s", best, esp_err_to_name(err));
+        return err;
+    }
+
+    outbox_segment_header_t header = {
+        .magic = OUTBOX_SEGMENT_MAGIC,
+        .seq = outbox->next_seq,
+        .erase_count = seg->erase_count + 1,
+    };
+    header.crc = outbox_segment_crc(&header);
+    *seg = (outbox_segment_t){.erase_count = header.erase_count, .valid = false};
+    err = outbox_storage_write(&outbox->storage, outbox_segment_base(outbox, best), &header, sizeof(header));
+    if (err != ESP_OK)
+    {
+        ESP_LOGE(TAG, "Error writing segment %u header: %s", best, esp_err_to_name(err));
+        return err;
+    }
+
+    seg->seq = header.seq;
+    seg->write_offset = sizeof(header);
+    seg->valid = true;
+    outbox->next_seq++;
+    outbox->tail = best;
+    ESP_LOGD(TAG, "Started segment %u (seq %lu, erase count %lu)", best, (unsigned long)seg->seq, (unsigned long)seg->erase_count);
+    return ESP_OK;
+}
+
+/// @brief Oldest segment after seq that still holds uncommitted records
+static uint16_t outbox_next_pending_segment(const sim7080g_outbox_t *outbox, uint32_t seq)
+{
+    uint16_t next = OUTBOX_NO_SEGMENT;
+    for (uint16_t i = 0; i < outbox->segment_count; i++)
+    {
+        const outbox_segment_t *seg = &outbox->segments[i];
+        if (seg->valid && seg->pending > 0 && seg->seq > seq &&
+            (next == OUTBOX_NO_SEGMENT || seg->seq < outbox->segments[next].seq))
+        {
+            next = i;
+        }
+    }
+    return next;
+}
+
+/// @brief Read the record at the cursor, moving the cursor past committed, corrupt and exhausted segments
+static esp_err_t outbox_peek_locked(sim7080g_outbox_t *outbox, sim7080g_outbox_record_t *record_out)
+{
+    while (outbox->pending > 0)
+    {
+        outbox_segment_t *seg = &outbox->segments[outbox->cursor_segment];
+        if (seg->pending == 0 || outbox->cursor_offset >= seg->write_offset)
+        {
+            uint16_t next = outbox_next_pending_segment(outbox, seg->seq);
+            if (next == OUTBOX_NO_SEGMENT)
+            {
+                ESP_LOGE(TAG, "Lost track of %lu pending records", (unsigned long)outbox->pending);
+                outbox->pending = 0;
+                break;
+            }
+            outbox->cursor_segment = next;
+            outbox->cursor_offset = sizeof(outbox_segment_header_t);
+            continue;
+        }
+
+        outbox_record_header_t header;
+        esp_err_t err = outbox_read_record(outbox, outbox->cursor_segment, outbox->cursor_offset, &header);
+        if (err == ESP_ERR_INVALID_CRC || err == ESP_ERR_NOT_FOUND)
+        {
+            // Damaged since it was written - what is left of the segment is given up
+            ESP_LOGW(TAG, "Segment %u: bad record at offset %lu - dropping %lu pending records",
+                     outbox->cursor_segment, (unsigned long)outbox->cursor_offset, (unsigned long)seg->pending);
+            outbox->corrupt_records++;
+            outbox->pending -= seg->pending;
+            seg->pending = 0;
+            seg->write_offset = outbox->segment_size;
+            continue;
+        }
+        if (err != ESP_OK)
+        {
+            return err;
+        }
+
+        size_t size = outbox_record_size(header.topic_len, header.payload_len);
+        if (header.commit != OUTBOX_ERASED_WORD)
+        {
+            outbox->cursor_offset += size;
+            continue;
+        }
+
+        *record_out = (sim7080g_outbox_record_t){
+            .topic = (const char *)outbox->record_buf,
+            .payload = outbox->record_buf + header.topic_len + 1,
+            .payload_len = header.payload_len,
+            .qos = header.qos,
+        };
+        outbox->peeked = true;
+        outbox->peeked_size = (uint32_t)size;
+        return ESP_OK;
+    }
+    return ESP_ERR_NOT_FOUND;
+}
+
+static esp_err_t outbox_commit_locked(sim7080g_outbox_t *outbox)
+{
+    if (!outbox->peeked)
+    {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    const uint32_t committed = OUTBOX_COMMITTED_WORD;
+    size_t base = outbox_segment_base(outbox, outbox->cursor_segment);
+    esp_err_t err = outbox_storage_write(&outbox->storage, base + outbox->cursor_offset, &committed, sizeof(committed));
+    if (err != ESP_OK)
+    {
+        ESP_LOGE(TAG, "Error writing commit word: %s", esp_err_to_name(err));
+        return err;
+    }
+
+    outbox->segments[outbox->cursor_segment].pending--;
+    outbox->pending--;
+    outbox->replayed++;
+    outbox->cursor_offset += outbox->peeked_size;
+    outbox->peeked = false;
+    return ESP_OK;
+}
+
+// ------ Public API ------ //
+
+esp_err_t sim7080g_outbox_open(const sim7080g_outbox_config_t *config, sim7080g_outbox_handle_t *outbox_out)
+{
+    if (config == NULL || outbox_out == NULL)
+    {
+        ESP_LOGE(TAG, "Invalid parameters");
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    sim7080g_outbox_t *outbox = calloc(1, sizeof(*outbox));
+    if (outbox == NULL)
+    {
+        ESP_LOGE(TAG, "Error allocating outbox");
+        return ESP_ERR_NO_MEM;
+    }
+    outbox->tail = OUTBOX_NO_SEGMENT;
+    outbox->next_seq = 1;
+
+    esp_err_t err = outbox_storage_open(&outbox->storage, config);
+    if (err != ESP_OK)
+    {
+        free(outbox);
+        return err;
+    }
+
+    outbox->segment_size = (config->segment_size > 0) ? config->segment_size : SIM7080G_OUTBOX_DEFAULT_SEGMENT_SIZE;
+    size_t segment_count = outbox->storage.size / outbox->segment_size;
+    if (outbox->storage.sector_size == 0 || outbox->segment_size % outbox->storage.sector_size != 0 ||
+        segment_count < 2 || segment_count >= OUTBOX_NO_SEGMENT)
+    {
+        ESP_LOGE(TAG, "Invalid parameters: %u byte segments in %u bytes of storage (sector size %u)",
+                 (unsigned)outbox->segment_size, (unsigned)outbox->storage.size, (unsigned)outbox->storage.sector_size);
+        free(outbox);
+        return ESP_ERR_INVALID_SIZE;
+    }
+    outbox->segment_count = (uint16_t)segment_count;
+
+    outbox->segments = calloc(segment_count, sizeof(outbox_segment_t));
+    outbox->record_buf = malloc(SIM7080G_OUTBOX_MAX_TOPIC_LEN + 1 + SIM7080G_MQTT_MAX_PAYLOAD_LEN);
+    uint16_t *order = malloc(segment_count * sizeof(uint16_t));
+    outbox->mutex = xSemaphoreCreateMutex();
+    outbox->direct_lock = xSemaphoreCreateMutex();
+    if (outbox->segments == NULL || outbox->record_buf == NULL || order == NULL || outbox->mutex == NULL ||
+        outbox->direct_lock == NULL)
+    {
+        ESP_LOGE(TAG, "Error allocating outbox");
+        free(order);
+        sim7080g_outbox_close(outbox);
+        return ESP_ERR_NO_MEM;
+    }
+
+    // Read every segment header, keeping the valid ones in log order
+    size_t valid_count = 0;
+    for (uint16_t i = 0; i < outbox->segment_count; i++)
+    {
+        outbox_segment_header_t header;
+        if (outbox_storage_read(&outbox->storage, outbox_segment_base(outbox, i), &header, sizeof(header)) != ESP_OK ||
+            header.magic != OUTBOX_SEGMENT_MAGIC || header.crc != outbox_segment_crc(&header))
+        {
+            continue;
+        }
+
+        outbox_segment_t *seg = &outbox->segments[i];
+        seg->seq = header.seq;
+        seg->erase_count = header.erase_count;
+        seg->valid = true;
+
+        size_t pos = valid_count++;
+        while (pos > 0 && outbox->segments[order[pos - 1]].seq > header.seq)
+        {
+            order[pos] = order[pos - 1];
+            pos--;
+        }
+        order[pos] = i;
+    }
+
+    bool cursor_found = false;
+    for (size_t i = 0; i < valid_count; i++)
+    {
+        outbox_scan_segment(outbox, order[i], &cursor_found);
+    }
+    if (valid_count > 0)
+    {
+        outbox->tail = order[valid_count - 1];
+        outbox->next_seq = outbox->segments[outbox->tail].seq + 1;
+    }
+    free(order);
+
+    unsigned in_use = 0;
+    for (uint16_t i = 0; i < outbox->segment_count; i++)
+    {
+        in_use += outbox_segment_in_use(outbox, i) ? 1 : 0;
+    }
+    ESP_LOGI(TAG, "Opened outbox: %u segments of %u bytes, %u in use, %lu pending messages",
+             outbox->segment_count, (unsigned)outbox->segment_size, in_use, (unsigned long)outbox->pending);
+    *outbox_out = outbox;
+    return ESP_OK;
+}
+
+esp_err_t sim7080g_outbox_close(sim7080g_outbox_handle_t outbox)
+{
+    if (outbox == NULL)
+    {
+        ESP_LOGE(TAG, "Invalid parameters");
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    if (outbox->mutex != NULL)
+    {
+        vSemaphoreDelete(outbox->mutex);
+    }
+    if (outbox->direct_lock != NULL)
+    {
+        vSemaphoreDelete(outbox->direct_lock);
+    }
+    free(outbox->segments);
+    free(outbox->record_buf);
+    free(outbox);
+    return ESP_OK;
+}
+
+/// @brief Wait for a direct publish to finish - called with the mutex held, which is given up while waiting
+/// @note Its message may yet be stored, so anything stored or replayed meanwhile could overtake it
+static void outbox_wait_direct_locked(sim7080g_outbox_t *outbox)
+{
+    while (outbox->direct_publishing)
+    {
+        xSemaphoreGive(outbox->mutex);
+        xSemaphoreTake(outbox->direct_lock, portMAX_DELAY);
+        xSemaphoreGive(outbox->direct_lock);
+        xSemaphoreTake(outbox->mutex, portMAX_DELAY);
+    }
+}
+
+/// @param wait_direct false only for the direct publish storing its own message
+static esp_err_t outbox_append(sim7080g_outbox_t *outbox,
+                               const char *topic,
+                               const void *payload,
+                               size_t payload_len,
+                               uint8_t qos,
+                               bool wait_direct)
+{
+    // Zero-length messages are refused by the publish, so one stored here would block replay for good
+    if (outbox == NULL || topic == NULL || topic[0] == '\0' || payload == NULL || payload_len == 0 || qos > 2)
+    {
+        ESP_LOGE(TAG, "Invalid parameters");
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    size_t topic_len = strlen(topic);
+    size_t size = outbox_record_size(topic_len, payload_len);
+    if (topic_len > SIM7080G_OUTBOX_MAX_TOPIC_LEN || payload_len > SIM7080G_MQTT_MAX_PAYLOAD_LEN ||
+        size > outbox->segment_size - sizeof(outbox_segment_header_t))
+    {
+        ESP_LOGE(TAG, "Message of %u bytes too large for the outbox", (unsigned)payload_len);
+        return ESP_ERR_INVALID_SIZE;
+    }
+
+    outbox_record_header_t header = {
+        .commit = OUTBOX_ERASED_WORD,
+        .magic = OUTBOX_RECORD_MAGIC,
+        .qos = qos,
+        .topic_len = (uint8_t)topic_len,
+        .payload_len = (uint16_t)payload_len,
+        .reserved = OUTBOX_ERASED_HALF,
+    };
+    uint32_t crc = esp_rom_crc32_le(0, (const uint8_t *)&header.magic,
+                                    offsetof(outbox_record_header_t, crc) - offsetof(outbox_record_header_t, magic));
+    crc = esp_rom_crc32_le(crc, (const uint8_t *)topic, topic_len + 1);
+    header.crc = esp_rom_crc32_le(crc, payload, payload_len);
+
+    xSemaphoreTake(outbox->mutex, portMAX_DELAY);
+    if (wait_direct)
+    {
+        outbox_wait_direct_locked(outbox);
+    }
+
+    esp_err_t err = ESP_OK;
+    if (outbox->tail == OUTBOX_NO_SEGMENT || outbox->segments[outbox->tail].write_offset + size > outbox->segment_size)
+    {
+        err = outbox_start_segment(outbox);
+        if (err == ESP_ERR_NO_MEM)
+        {
+            ESP_LOGW(TAG, "Outbox full - %lu messages waiting", (unsigned long)outbox->pending);
+        }
+    }
+
+    if (err == ESP_OK)
+    {
+        // Header first - if power is lost part way the CRC no longer matches and the segment is closed on the next open
+        outbox_segment_t *seg = &outbox->segments[outbox->tail];
+        size_t offset = outbox_segment_base(outbox, outbox->tail) + seg->write_offset;
+        err = outbox_storage_write(&outbox->storage, offset, &header, sizeof(header));
+        if (err == ESP_OK)
+        {
+            err = outbox_storage_write(&outbox->storage, offset + sizeof(header), topic, topic_len + 1);
+        }
+        if (err == ESP_OK && payload_len > 0)
+        {
+            err = outbox_storage_write(&outbox->storage, offset + sizeof(header) + topic_len + 1, payload, payload_len);
+        }
+
+        if (err != ESP_OK)
+        {
+            ESP_LOGE(TAG, "Error writing record: %s", esp_err_to_name(err));
+            seg->write_offset = outbox->segment_size; // Partly written - append to a fresh segment next time
+        }
+        else
+        {
+            if (outbox->pending == 0)
+            {
+                outbox->cursor_segment = outbox->tail;
+                outbox->cursor_offset = seg->write_offset;
+            }
+            seg->write_offset += size;
+            seg->pending++;
+            outbox->pending++;
+            outbox->appended++;
+        }
+    }
+
+    xSemaphoreGive(outbox->mutex);
+    return err;
+}
+
+esp_err_t sim7080g_outbox_append(sim7080g_outbox_handle_t outbox,
+                                 const char *topic,
+                                 const void *payload,
+                                 size_t payload_len,
+                                 uint8_t qos)
+{
+    return outbox_append(outbox, topic, payload, payload_len, qos, true);
+}
+
+esp_err_t sim7080g_outbox_peek(sim7080g_outbox_handle_t outbox, sim7080g_outbox_record_t *record_out)
+{
+    if (outbox == NULL || record_out == NULL)
+    {
+        ESP_LOGE(TAG, "Invalid parameters");
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    xSemaphoreTake(outbox->mutex, portMAX_DELAY);
+    esp_err_t err = outbox->replaying ? ESP_ERR_INVALID_STATE : outbox_peek_locked(outbox, record_out);
+    xSemaphoreGive(outbox->mutex);
+    return err;
+}
+
+esp_err_t sim7080g_outbox_commit(sim7080g_outbox_handle_t outbox)
+{
+    if (outbox == NULL)
+    {
+        ESP_LOGE(TAG, "Invalid parameters");
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    xSemaphoreTake(outbox->mutex, portMAX_DELAY);
+    esp_err_t err = outbox->replaying ? ESP_ERR_INVALID_STATE : outbox_commit_locked(outbox);
+    xSemaphoreGive(outbox->mutex);
+    return err;
+}
+
+static bool outbox_broker_connected(const sim7080g_handle_t *sim7080g_handle)
+{
+    sim7080g_mqtt_connection_status_t status;
+    return sim7080g_mqtt_get_broker_connection_status(sim7080g_handle, &status) == ESP_OK &&
+           (status == MQTT_STATUS_CONNECTED || status == MQTT_STATUS_CONNECTED_SESSION);
+}
+
+esp_err_t sim7080g_outbox_replay(sim7080g_outbox_handle_t outbox,
+                                 const sim7080g_handle_t *sim7080g_handle,
+                                 uint32_t max_messages,
+                                 uint32_t *sent_out)
+{
+    if (outbox == NULL || sim7080g_handle == NULL)
+    {
+        ESP_LOGE(TAG, "Invalid parameters");
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (sent_out != NULL)
+    {
+        *sent_out = 0;
+    }
+
+    xSemaphoreTake(outbox->mutex, portMAX_DELAY);
+    outbox_wait_direct_locked(outbox);
+    bool busy = outbox->replaying;
+    bool empty = outbox->pending == 0;
+    xSemaphoreGive(outbox->mutex);
+    if (busy)
+    {
+        return ESP_ERR_INVALID_STATE;
+    }
+    if (empty)
+    {
+        return ESP_OK;
+    }
+    if (!outbox_broker_connected(sim7080g_handle))
+    {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    xSemaphoreTake(outbox->mutex, portMAX_DELAY);
+    outbox_wait_direct_locked(outbox);
+    busy = outbox->replaying;
+    outbox->replaying = true;
+    xSemaphoreGive(outbox->mutex);
+    if (busy)
+    {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    // Appends may run between messages - record_buf is only written by peek, which only this loop calls while replaying
+    esp_err_t err = ESP_OK;
+    uint32_t sent = 0;
+    while (err == ESP_OK && (max_messages == 0 || sent < max_messages))
+    {
+        sim7080g_outbox_record_t record;
+        xSemaphoreTake(outbox->mutex, portMAX_DELAY);
+        err = outbox_peek_locked(outbox, &record);
+        xSemaphoreGive(outbox->mutex);
+        if (err == ESP_ERR_NOT_FOUND)
+        {
+            err = ESP_OK;
+            break;
+        }
+        if (err != ESP_OK)
+        {
+            break;
+        }
+
+        sim7080g_iovec_t iov = {.base = record.payload, .len = record.payload_len};
+        err = sim7080g_mqtt_publish_iov(sim7080g_handle, record.topic, &iov, 1, record.qos, false);
+        bool rejected = err == ESP_ERR_INVALID_ARG || err == ESP_ERR_INVALID_SIZE;
+        if (rejected)
+        {
+            // Retrying cannot help - drop it rather than stall every message behind it
+            ESP_LOGE(TAG, "Dropping stored message on '%s' (%u bytes): %s", record.topic, (unsigned)record.payload_len, esp_err_to_name(err));
+        }
+        else if (err != ESP_OK)
+        {
+            ESP_LOGW(TAG, "Replay stopped after %lu messages: %s", (unsigned long)sent, esp_err_to_name(err));
+            break;
+        }
+
+        xSemaphoreTake(outbox->mutex, portMAX_DELAY);
+        err = outbox_commit_locked(outbox);
+        if (err == ESP_OK && rejected)
+        {
+            outbox->replayed--;
+            outbox->rejected_records++;
+        }
+        xSemaphoreGive(outbox->mutex);
+        if (err == ESP_OK && !rejected)
+        {
+            sent++;
+        }
+    }
+
+    xSemaphoreTake(outbox->mutex, portMAX_DELAY);
+    outbox->peeked = false;
+    outbox->replaying = false;
+    xSemaphoreGive(outbox->mutex);
+
+    if (sent > 0)
+    {
+        ESP_LOGI(TAG, "Replayed %lu messages", (unsigned long)sent);
+    }
+    if (sent_out != NULL)
+    {
+        *sent_out = sent;
+    }
+    return err;
+}
+
+esp_err_t sim7080g_outbox_publish(sim7080g_outbox_handle_t outbox,
+                                  const sim7080g_handle_t *sim7080g_handle,
+                                  const char *topic,
+                                  const void *payload,
+                                  size_t payload_len,
+                                  uint8_t qos)
+{
+    if (outbox == NULL || sim7080g_handle == NULL || topic == NULL || (payload == NULL && payload_len > 0))
+    {
+        ESP_LOGE(TAG, "Invalid parameters");
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    // One direct publish at a time - until it is sent or stored, nothing may be stored or replayed ahead of it
+    xSemaphoreTake(outbox->direct_lock, portMAX_DELAY);
+    xSemaphoreTake(outbox->mutex, portMAX_DELAY);
+    bool empty = outbox->pending == 0 && !outbox->replaying;
+    outbox->direct_publishing = empty;
+    xSemaphoreGive(outbox->mutex);
+    if (!empty)
+    {
+        xSemaphoreGive(outbox->direct_lock);
+        return sim7080g_outbox_append(outbox, topic, payload, payload_len, qos);
+    }
+
+    esp_err_t err = ESP_ERR_INVALID_STATE;
+    if (outbox_broker_connected(sim7080g_handle))
+    {
+        sim7080g_iovec_t iov = {.base = payload, .len = payload_len};
+        err = sim7080g_mqtt_publish_iov(sim7080g_handle, topic, &iov, 1, qos, false);
+        if (err != ESP_OK)
+        {
+            ESP_LOGW(TAG, "Publish failed - storing message for replay");
+        }
+    }
+    if (err != ESP_OK)
+    {
+        err = outbox_append(outbox, topic, payload, payload_len, qos, false);
+    }
+
+    xSemaphoreTake(outbox->mutex, portMAX_DELAY);
+    outbox->direct_publishing = false;
+    xSemaphoreGive(outbox->mutex);
+    xSemaphoreGive(outbox->direct_lock);
+    return err;
+}
+
+esp_err_t sim7080g_outbox_get_stats(sim7080g_outbox_handle_t outbox, sim7080g_outbox_stats_t *stats_out)
+{
+    if (outbox == NULL || stats_out == NULL)
+    {
+        ESP_LOGE(TAG, "Invalid parameters");
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    xSemaphoreTake(outbox->mutex, portMAX_DELAY);
+    *stats_out = (sim7080g_outbox_stats_t){
+        .pending = outbox->pending,
+        .appended = outbox->appended,
+        .replayed = outbox->replayed,
+        .corrupt_records = outbox->corrupt_records,
+        .rejected_records = outbox->rejected_records,
+        .segments = outbox->segment_count,
+        .min_erase_count = UINT32_MAX,
+    };
+    for (uint16_t i = 0; i < outbox->segment_count; i++)
+    {
+        const outbox_segment_t *seg = &outbox->segments[i];
+        stats_out->segments_in_use += outbox_segment_in_use(outbox, i) ? 1 : 0;
+        stats_out->min_erase_count = (seg->erase_count < stats_out->min_erase_count) ? seg->erase_count : stats_out->min_erase_count;
+        stats_out->max_erase_count = (seg->erase_count > stats_out->max_erase_count) ? seg->erase_count : stats_out->max_erase_count;
+    }
+    xSemaphoreGive(outbox->mutex);
+    return ESP_OK;
+}
+
+// ------ INTERNAL TESTING ------ //
+
+#define OUTBOX_TEST_TOPIC "test/outbox"
+#define OUTBOX_TEST_PAYLOAD_LEN 200
+#define OUTBOX_TEST_WEAR_ROUNDS 3 // Times every segment is filled and drained
+
+static esp_err_t outbox_test_append(sim7080g_outbox_t *outbox, uint32_t seq)
+{
+    uint8_t payload[OUTBOX_TEST_PAYLOAD_LEN];
+    for (size_t i = 0; i < sizeof(payload); i++)
+    {
+        payload[i] = (uint8_t)(seq + i);
+    }
+    memcpy(payload, &seq, sizeof(seq));
+    return sim7080g_outbox_append(outbox, OUTBOX_TEST_TOPIC, payload, sizeof(payload), 1);
+}
+
+/// @brief Peek and commit count messages, checking they are seq onwards, in order and intact
+static bool outbox_test_drain(sim7080g_outbox_t *outbox, uint32_t seq, uint32_t count)
+{
+    for (uint32_t i = 0; i < count; i++, seq++)
+    {
+        sim7080g_outbox_record_t record;
+        esp_err_t err = sim7080g_outbox_peek(outbox, &record);
+        if (err != ESP_OK)
+        {
+            ESP_LOGE(TAG, "Outbox test: peek of message %lu failed: %s", (unsigned long)seq, esp_err_to_name(err));
+            return false;
+        }
+
+        uint32_t stored_seq;
+        memcpy(&stored_seq, record.payload, sizeof(stored_seq));
+        bool intact = record.payload_len == OUTBOX_TEST_PAYLOAD_LEN && record.qos == 1 && strcmp(record.topic, OUTBOX_TEST_TOPIC) == 0;
+        for (size_t j = sizeof(stored_seq); intact && j < record.payload_len; j++)
+        {
+            intact = record.payload[j] == (uint8_t)(seq + j);
+        }
+        if (stored_seq != seq || !intact)
+        {
+            ESP_LOGE(TAG, "Outbox test: expected message %lu, read %lu (%s)", (unsigned long)seq, (unsigned long)stored_seq,
+                     intact ? "intact" : "corrupt");
+            return false;
+        }
+
+        err = sim7080g_outbox_commit(outbox);
+        if (err != ESP_OK)
+        {
+            ESP_LOGE(TAG, "Outbox test: commit of message %lu failed: %s", (unsigned long)seq, esp_err_to_name(err));
+            return false;
+        }
+    }
+    return true;
+}
+
+/// @brief Close and open the outbox again, as after a restart
+static bool outbox_test_reopen(sim7080g_outbox_t **outbox, const sim7080g_outbox_config_t *config)
+{
+    sim7080g_outbox_close(*outbox);
+    *outbox = NULL;
+    esp_err_t err = sim7080g_outbox_open(config, outbox);
+    if (err != ESP_OK)
+    {
+        ESP_LOGE(TAG, "Outbox test: reopen failed: %s", esp_err_to_name(err));
+        return false;
+    }
+    return true;
+}
+
+static bool outbox_test_run(sim7080g_outbox_t **outbox, const sim7080g_outbox_config_t *config)
+{
+    sim7080g_outbox_stats_t stats;
+    sim7080g_outbox_get_stats(*outbox, &stats);
+    if (stats.segments < 3)
+    {
+        ESP_LOGE(TAG, "Outbox test: partition holds %u segments - needs at least 3", stats.segments);
+        return false;
+    }
+
+    // Segment rotation - fill and drain every segment a few times, each new segment must be the least worn free one
+    const uint32_t per_segment = ((*outbox)->segment_size - sizeof(outbox_segment_header_t)) /
+                                 outbox_record_size(strlen(OUTBOX_TEST_TOPIC), OUTBOX_TEST_PAYLOAD_LEN);
+    uint32_t seq = 0;
+    for (uint32_t round = 0; round < OUTBOX_TEST_WEAR_ROUNDS * stats.segments; round++)
+    {
+        for (uint32_t i = 0; i < per_segment; i++)
+        {
+            if (outbox_test_append(*outbox, seq + i) != ESP_OK)
+            {
+                ESP_LOGE(TAG, "Outbox test: append of message %lu failed", (unsigned long)(seq + i));
+                return false;
+            }
+        }
+        if (!outbox_test_drain(*outbox, seq, per_segment))
+        {
+            return false;
+        }
+        seq += per_segment;
+    }
+    sim7080g_outbox_get_stats(*outbox, &stats);
+    if (stats.pending != 0 || stats.min_erase_count < OUTBOX_TEST_WEAR_ROUNDS - 1 || stats.max_erase_count - stats.min_erase_count > 1)
+    {
+        ESP_LOGE(TAG, "Outbox test: uneven wear after rotation - erase counts %lu to %lu, %lu pending",
+                 (unsigned long)stats.min_erase_count, (unsigned long)stats.max_erase_count, (unsigned long)stats.pending);
+        return false;
+    }
+    ESP_LOGI(TAG, "Outbox test: %lu messages through %u segments, erase counts %lu to %lu", (unsigned long)seq,
+             stats.segments, (unsigned long)stats.min_erase_count, (unsigned long)stats.max_erase_count);
+
+    // Cursor recovery - committed messages must not come back after a reopen, uncommitted ones must
+    for (uint32_t i = 0; i < 5; i++)
+    {
+        if (outbox_test_append(*outbox, seq + i) != ESP_OK)
+        {
+            ESP_LOGE(TAG, "Outbox test: append of message %lu failed", (unsigned long)(seq + i));
+            return false;
+        }
+    }
+    if (!outbox_test_drain(*outbox, seq, 2) || !outbox_test_reopen(outbox, config))
+    {
+        return false;
+    }
+    sim7080g_outbox_get_stats(*outbox, &stats);
+    if (stats.pending != 3 || !outbox_test_drain(*outbox, seq + 2, 3))
+    {
+        ESP_LOGE(TAG, "Outbox test: cursor not recovered - %lu pending after reopen, expected 3", (unsigned long)stats.pending);
+        return false;
+    }
+    seq += 5;
+
+    // Torn record - a header written without its topic and payload, as if power was lost part way through an append
+    uint32_t stored = 0;
+    const size_t record_size = outbox_record_size(strlen(OUTBOX_TEST_TOPIC), OUTBOX_TEST_PAYLOAD_LEN);
+    while (stored < 3 || (*outbox)->segments[(*outbox)->tail].write_offset + record_size > (*outbox)->segment_size)
+    {
+        if (outbox_test_append(*outbox, seq + stored) != ESP_OK)
+        {
+            ESP_LOGE(TAG, "Outbox test: append of message %lu failed", (unsigned long)(seq + stored));
+            return false;
+        }
+        stored++;
+    }
+    const outbox_record_header_t torn = {
+        .commit = OUTBOX_ERASED_WORD,
+        .magic = OUTBOX_RECORD_MAGIC,
+        .qos = 1,
+        .topic_len = (uint8_t)strlen(OUTBOX_TEST_TOPIC),
+        .payload_len = OUTBOX_TEST_PAYLOAD_LEN,
+        .reserved = OUTBOX_ERASED_HALF,
+        .crc = 0,
+    };
+    size_t torn_offset = outbox_segment_base(*outbox, (*outbox)->tail) + (*outbox)->segments[(*outbox)->tail].write_offset;
+    if (outbox_storage_write(&(*outbox)->storage, torn_offset, &torn, sizeof(torn)) != ESP_OK || !outbox_test_reopen(outbox, config))
+    {
+        ESP_LOGE(TAG, "Outbox test: Error writing torn record");
+        return false;
+    }
+    sim7080g_outbox_get_stats(*outbox, &stats);
+    if (stats.corrupt_records != 1 || stats.pending != stored)
+    {
+        ESP_LOGE(TAG, "Outbox test: torn record not skipped - %lu corrupt, %lu of %lu pending", (unsigned long)stats.corrupt_records,
+                 (unsigned long)stats.pending, (unsigned long)stored);
+        return false;
+    }
+
+    // The torn segment is closed - the next message goes into a fresh one and is replayed after the old ones
+    if (outbox_test_append(*outbox, seq + stored) != ESP_OK || !outbox_test_reopen(outbox, config))
+    {
+        ESP_LOGE(TAG, "Outbox test: append after torn record failed");
+        return false;
+    }
+    stored++;
+    sim7080g_outbox_get_stats(*outbox, &stats);
+    if (stats.pending != stored || !outbox_test_drain(*outbox, seq, stored))
+    {
+        ESP_LOGE(TAG, "Outbox test: %lu of %lu messages pending around the torn record", (unsigned long)stats.pending, (unsigned long)stored);
+        return false;
+    }
+    return true;
+}
+
+bool sim7080g_test_outbox(const char *partition_label)
+{
+    const esp_partition_t *partition =
+        (partition_label != NULL) ? esp_partition_find_first(ESP_PARTITION_TYPE_DATA, ESP_PARTITION_SUBTYPE_ANY, partition_label) : NULL;
+    if (partition == NULL)
+    {
+        ESP_LOGE(TAG, "Outbox test: Invalid parameters - partition not found");
+        return false;
+    }
+    esp_err_t err = esp_partition_erase_range(partition, 0, partition->size);
+    if (err != ESP_OK)
+    {
+        ESP_LOGE(TAG, "Outbox test: Error erasing partition: %s", esp_err_to_name(err));
+        return false;
+    }
+
+    const sim7080g_outbox_config_t config = {.partition_label = partition_label};
+    sim7080g_outbox_t *outbox = NULL;
+    err = sim7080g_outbox_open(&config, &outbox);
+    if (err != ESP_OK)
+    {
+        ESP_LOGE(TAG, "Outbox test: open failed: %s", esp_err_to_name(err));
+        return false;
+    }
+
+    bool passed = outbox_test_run(&outbox, &config);
+    if (outbox != NULL)
+    {
+        sim7080g_outbox_close(outbox);
+    }
+
+    if (!passed)
+    {
+        ESP_LOGE(TAG, "Outbox test failed!");
+        return false;
+    }
+    ESP_LOGI(TAG, "Outbox test passed!");
+    return true;
+}
@@ -0,0 +1,505 @@
+#include <stdatomic.h>
+#include <stdlib.h>
+#include <string.h>
+#include <esp_err.h>
+#include <esp_log.h>
+#include <esp_random.h>
+#include <esp_timer.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include <freertos/semphr.h>
+
+#include "sim7080g_at_parser.h"
+#include "sim7080g_supervisor.h"
+
+#define SUPERVISOR_PROBE_TIMEOUT_MS 10000
+#define SUPERVISOR_REATTACH_TIMEOUT_MS 75000 // AT+CGATT may take this long to answer
+#define SUPERVISOR_NO_REPAIR SIM7080G_REPAIR_COUNT
+
+static const char *TAG = "SIM7080G Supervisor";
+
+// Device reports that may mean a layer changed - each one wakes the supervisor for a probe
+static const char *const SUPERVISOR_URC_PREFIXES[] = {"+SMSTATE:", "+APP PDP:", "+CEREG:", "+CPIN:", "+CFUN:"};
+#define SUPERVISOR_NUM_URC_PREFIXES (sizeof(SUPERVISOR_URC_PREFIXES) / sizeof(SUPERVISOR_URC_PREFIXES[0]))
+
+struct sim7080g_supervisor
+{
+    const sim7080g_handle_t *sim7080g_handle;
+    sim7080g_supervisor_config_t config;
+    TaskHandle_t task;
+    SemaphoreHandle_t task_stopped;
+    SemaphoreHandle_t lock; // Guards stats
+    atomic_bool stop;
+    sim7080g_supervisor_stats_t stats;
+    int64_t down_since_us[SIM7080G_LAYER_COUNT]; // Only meaningful while the layer is down
+    bool ever_up[SIM7080G_LAYER_COUNT];          // Bringing a layer up the first time is not a recovery
+
+    // Escalation state of the current outage - reset once every layer is up
+    sim7080g_repair_t rung;         // Repair to run next, SUPERVISOR_NO_REPAIR if none chosen yet
+    sim7080g_repair_t highest_rung; // Highest repair run so far in this outage
+    uint8_t rung_failures;          // Consecutive failures of rung
+    uint32_t outage_failures;       // Failed repairs in this outage - drives the backoff
+};
+
+/// @brief Repair each layer starts at - the ladder and the layers run in opposite directions
+static sim7080g_repair_t sim7080g_supervisor_base_rung(sim7080g_layer_t layer)
+{
+    return (sim7080g_repair_t)(SIM7080G_LAYER_APPLICATION - layer);
+}
+
+/// @brief Layer a repair brings back - the power cycle brings back the same layer as the CFUN cycle
+static sim7080g_layer_t sim7080g_supervisor_rung_layer(sim7080g_repair_t rung)
+{
+    return (rung >= SIM7080G_REPAIR_CFUN_CYCLE) ? SIM7080G_LAYER_PHYSICAL : (sim7080g_layer_t)(SIM7080G_LAYER_APPLICATION - rung);
+}
+
+static sim7080g_repair_t sim7080g_supervisor_top_rung(const sim7080g_supervisor_t *supervisor)
+{
+    return (supervisor->config.power_cycle != NULL) ? SIM7080G_REPAIR_POWER_CYCLE : SIM7080G_REPAIR_CFUN_CYCLE;
+}
+
+const char *sim7080g_layer_name(sim7080g_layer_t layer)
+{
+    static const char *const names[SIM7080G_LAYER_COUNT] = {"physical", "data link", "network", "application"};
+    return (layer < SIM7080G_LAYER_COUNT) ? names[layer] : "unknown";
+}
+
+const char *sim7080g_repair_name(sim7080g_repair_t repair)
+{
+    static const char *const names[SIM7080G_REPAIR_COUNT] = {"MQTT reconnect", "PDP reactivate", "reattach", "CFUN cycle", "power cycle"};
+    return (repair < SIM7080G_REPAIR_COUNT) ? names[repair] : "none";
+}
+
+static void sim7080g_supervisor_urc(const char *line, size_t len, void *user_ctx)
+{
+    sim7080g_supervisor_t *supervisor = user_ctx;
+    xTaskNotifyGive(supervisor->task);
+}
+
+/// @brief Read every layer in one exchange
+/// @note A layer only counts as up if every layer below it is up too. If the device stops at a failing command
+///       (e.g. AT+CPIN? with the radio off) the layers after it are left down.
+static void sim7080g_supervisor_probe(sim7080g_supervisor_t *supervisor, bool up[SIM7080G_LAYER_COUNT])
+{
+    char cfun_response[64] = {0};
+    char cpin_response[64] = {0};
+    char cereg_response[128] = {0};
+    char cnact_response[256] = {0};
+    char smstate_response[64] = {0};
+    sim7080g_at_batch_entry_t entries[] = {
+        {.cmd = &AT_CFUN, .type = AT_CMD_TYPE_READ, .response = cfun_response, .response_size = sizeof(cfun_response)},
+        {.cmd = &AT_CPIN, .type = AT_CMD_TYPE_READ, .response = cpin_response, .response_size = sizeof(cpin_response)},
+        {.cmd = &AT_CEREG, .type = AT_CMD_TYPE_READ, .response = cereg_response, .response_size = sizeof(cereg_response)},
+        {.cmd = &AT_CNACT, .type = AT_CMD_TYPE_READ, .response = cnact_response, .response_size = sizeof(cnact_response)},
+        {.cmd = &AT_SMSTATE, .type = AT_CMD_TYPE_READ, .response = smstate_response, .response_size = sizeof(smstate_response)},
+    };
+    sim7080g_send_at_batch(supervisor->sim7080g_handle, entries, sizeof(entries) / sizeof(entries[0]), SUPERVISOR_PROBE_TIMEOUT_MS);
+
+    at_parser_t parser;
+    at_parser_t fields;
+    at_str_t str;
+    int value;
+    int stat;
+    memset(up, 0, SIM7080G_LAYER_COUNT * sizeof(up[0]));
+
+    at_parser_init(&parser, cfun_response, strlen(cfun_response));
+    bool functional = entries[0].result == ESP_OK && at_parser_find_line(&parser, "+CFUN:", &fields) &&
+                      at_parser_int(&fields, &value) && value == 1;
+    at_parser_init(&parser, cpin_response, strlen(cpin_response));
+    bool sim_ready = entries[1].result == ESP_OK && at_parser_find_line(&parser, "+CPIN:", &fields) &&
+                     at_parser_str(&fields, &str) && at_str_eq(str, "READY");
+    up[SIM7080G_LAYER_PHYSICAL] = functional && sim_ready;
+
+    // "+CEREG: <n>,<stat>[,...]" - 1 = home network, 5 = roaming
+    at_parser_init(&parser, cereg_response, strlen(cereg_response));
+    up[SIM7080G_LAYER_DATA_LINK] = up[SIM7080G_LAYER_PHYSICAL] && entries[2].result == ESP_OK &&
+                                   at_parser_find_line(&parser, "+CEREG:", &fields) && at_parser_int(&fields, &value) &&
+                                   at_parser_int(&fields, &stat) && (stat == 1 || stat == 5);
+
+    // "+CNACT: <pdpidx>,<status>,<address>" - one line per context
+    bool pdp_active = false;
+    at_parser_init(&parser, cnact_response, strlen(cnact_response));
+    while (!pdp_active && entries[3].result == ESP_OK && at_parser_find_line(&parser, "+CNACT:", &fields))
+    {
+        pdp_active = at_parser_int(&fields, &value) && value == 0 && at_parser_int(&fields, &stat) &&
+                     sim7080g_cnact_status_active(stat);
+    }
+    up[SIM7080G_LAYER_NETWORK] = up[SIM7080G_LAYER_DATA_LINK] && pdp_active;
+
+    at_parser_init(&parser, smstate_response, strlen(smstate_response));
+    up[SIM7080G_LAYER_APPLICATION] = up[SIM7080G_LAYER_NETWORK] && entries[4].result == ESP_OK &&
+                                     at_parser_find_line(&parser, "+SMSTATE:", &fields) &&
+                                     at_parser_int(&fields, &value) && value > 0;
+}
+
+/// @brief Record what a probe found and report the layers that changed
+static void sim7080g_supervisor_update(sim7080g_supervisor_t *supervisor, const bool up[SIM7080G_LAYER_COUNT])
+{
+    int64_t now = esp_timer_get_time();
+    bool changed[SIM7080G_LAYER_COUNT] = {0};
+
+    xSemaphoreTake(supervisor->lock, portMAX_DELAY);
+    supervisor->stats.probes++;
+    for (int layer = 0; layer < SIM7080G_LAYER_COUNT; layer++)
+    {
+        sim7080g_layer_stats_t *stats = &supervisor->stats.layers[layer];
+        if (stats->up == up[layer])
+        {
+            continue;
+        }
+        changed[layer] = true;
+        stats->up = up[layer];
+
+        if (!up[layer])
+        {
+            supervisor->down_since_us[layer] = now;
+            stats->drops++;
+        }
+        else if (supervisor->ever_up[layer])
+        {
+            uint32_t recover_ms = (uint32_t)((now - supervisor->down_since_us[layer]) / 1000);
+            stats->recoveries++;
+            stats->last_recover_ms = recover_ms;
+            stats->total_recover_ms += recover_ms;
+            if (recover_ms > stats->max_recover_ms)
+            {
+                stats->max_recover_ms = recover_ms;
+            }
+        }
+        supervisor->ever_up[layer] |= up[layer];
+    }
+    xSemaphoreGive(supervisor->lock);
+
+    for (int layer = 0; layer < SIM7080G_LAYER_COUNT; layer++)
+    {
+        if (!changed[layer])
+        {
+            continue;
+        }
+        if (up[layer])
+        {
+            ESP_LOGI(TAG, "%s layer up", sim7080g_layer_name(layer));
+        }
+        else
+        {
+            ESP_LOGW(TAG, "%s layer down", sim7080g_layer_name(layer));
+        }
+        if (supervisor->config.on_layer_change != NULL)
+        {
+            supervisor->config.on_layer_change(layer, up[layer], supervisor->config.on_layer_change_arg);
+        }
+    }
+}
+
+/// @brief Run one repair
+/// @param up Layers as last probed - a repair escalated to from a layer above tears its own layer down first,
+///        since e.g. AT+CNACT=0,1 on a context that looks active does nothing
+static esp_err_t sim7080g_supervisor_repair(sim7080g_supervisor_t *supervisor, sim7080g_repair_t rung, const bool up[SIM7080G_LAYER_COUNT])
+{
+    const sim7080g_handle_t *sim7080g_handle = supervisor->sim7080g_handle;
+    esp_err_t err;
+
+    switch (rung)
+    {
+    case SIM7080G_REPAIR_MQTT_RECONNECT:
+        return sim7080g_mqtt_connect_to_broker(sim7080g_handle);
+
+    case SIM7080G_REPAIR_PDP_REACTIVATE:
+        if (up[SIM7080G_LAYER_NETWORK])
+        {
+            sim7080g_app_network_deactivate(sim7080g_handle);
+        }
+        return sim7080g_app_network_reactivate(sim7080g_handle);
+
+    case SIM7080G_REPAIR_REATTACH:
+    {
+        sim7080g_at_batch_entry_t detach = {.cmd = &AT_CGATT, .type = AT_CMD_TYPE_WRITE, .args = "0"};
+        sim7080g_at_batch_entry_t attach = {.cmd = &AT_CGATT, .type = AT_CMD_TYPE_WRITE, .args = "1"};
+        if (up[SIM7080G_LAYER_DATA_LINK])
+        {
+            sim7080g_send_at_batch(sim7080g_handle, &detach, 1, SUPERVISOR_REATTACH_TIMEOUT_MS);
+        }
+        // The device also attaches on its own - a refused attach is not the end of the repair, the wait decides
+        err = sim7080g_send_at_batch(sim7080g_handle, &attach, 1, SUPERVISOR_REATTACH_TIMEOUT_MS);
+        if (err != ESP_OK)
+        {
+            ESP_LOGW(TAG, "AT+CGATT=1 failed: %s", esp_err_to_name(err));
+        }
+        return sim7080g_wait_for_registration(sim7080g_handle, supervisor->config.registration_timeout_ms, NULL);
+    }
+
+    case SIM7080G_REPAIR_CFUN_CYCLE:
+        return sim7080g_cycle_cfun(sim7080g_handle, NULL);
+
+    case SIM7080G_REPAIR_POWER_CYCLE:
+        return supervisor->config.power_cycle(sim7080g_handle, supervisor->config.power_cycle_arg);
+
+    default:
+        return ESP_ERR_INVALID_ARG;
+    }
+}
+
+/// @brief Exponential backoff with jitter - between half and all of base * 2^(failures - 1), capped
+static uint32_t sim7080g_supervisor_backoff_ms(const sim7080g_supervisor_t *supervisor)
+{
+    uint32_t delay_ms = supervisor->config.backoff_base_ms;
+    for (uint32_t i = 1; i < supervisor->outage_failures && delay_ms < supervisor->config.backoff_max_ms; i++)
+    {
+        delay_ms *= 2;
+    }
+    if (delay_ms > supervisor->config.backoff_max_ms)
+    {
+        delay_ms = supervisor->config.backoff_max_ms;
+    }
+
+    uint32_t half = delay_ms / 2;
+    return half + (half > 0 ? esp_random() % (half + 1) : 0);
+}
+
+/// @brief Sleep for ms, or until stopped - a device report only cuts the sleep short if wake_on_report
+static void sim7080g_supervisor_sleep(sim7080g_supervisor_t *supervisor, uint32_t ms, bool wake_on_report)
+{
+    TickType_t start = xTaskGetTickCount();
+    TickType_t ticks = pdMS_TO_TICKS(ms);
+    TickType_t elapsed;
+    while (!atomic_load(&supervisor->stop) && (elapsed = xTaskGetTickCount() - start) < ticks)
+    {
+        if (ulTaskNotifyTake(pdTRUE, ticks - elapsed) > 0 && wake_on_report)
+        {
+            return;
+        }
+    }
+}
+
+static void sim7080g_supervisor_task(void *arg)
+{
+    sim7080g_supervisor_t *supervisor = arg;
+    bool up[SIM7080G_LAYER_COUNT];
+
+    while (!atomic_load(&supervisor->stop))
+    {
+        ulTaskNotifyTake(pdTRUE, 0); // Reports that arrived up to now are covered by this probe
+        sim7080g_supervisor_probe(supervisor, up);
+        sim7080g_supervisor_update(supervisor, up);
+
+        int lowest_down = 0;
+        while (lowest_down < SIM7080G_LAYER_COUNT && up[lowest_down])
+        {
+            lowest_down++;
+        }
+        if (lowest_down == SIM7080G_LAYER_COUNT)
+        {
+            if (supervisor->highest_rung != SUPERVISOR_NO_REPAIR)
+            {
+                ESP_LOGI(TAG, "Connection restored - highest repair needed: %s", sim7080g_repair_name(supervisor->highest_rung));
+            }
+            supervisor->rung = SUPERVISOR_NO_REPAIR;
+            supervisor->highest_rung = SUPERVISOR_NO_REPAIR;
+            supervisor->rung_failures = 0;
+            supervisor->outage_failures = 0;
+            sim7080g_supervisor_sleep(supervisor, supervisor->config.check_interval_ms, true);
+            continue;
+        }
+
+        // Start at the lowest broken layer's own repair - a rung already climbed to for this outage is kept
+        sim7080g_repair_t base = sim7080g_supervisor_base_rung((sim7080g_layer_t)lowest_down);
+        if (supervisor->rung == SUPERVISOR_NO_REPAIR || supervisor->rung < base)
+        {
+            supervisor->rung = base;
+            supervisor->rung_failures = 0;
+        }
+        sim7080g_repair_t rung = supervisor->rung;
+        if (supervisor->highest_rung == SUPERVISOR_NO_REPAIR || rung > supervisor->highest_rung)
+        {
+            supervisor->highest_rung = rung;
+        }
+
+        ESP_LOGI(TAG, "%s layer down - %s", sim7080g_layer_name(lowest_down), sim7080g_repair_name(rung));
+        esp_err_t err = sim7080g_supervisor_repair(supervisor, rung, up);
+
+        // The repair worked if its layer answers as up - the layers above it are rebuilt one by one from here
+        sim7080g_layer_t target = sim7080g_supervisor_rung_layer(rung);
+        bool repaired = false;
+        if (err == ESP_OK)
+        {
+            ulTaskNotifyTake(pdTRUE, 0);
+            sim7080g_supervisor_probe(supervisor, up);
+            sim7080g_supervisor_update(supervisor, up);
+            repaired = up[target];
+        }
+
+        xSemaphoreTake(supervisor->lock, portMAX_DELAY);
+        supervisor->stats.repairs[rung]++;
+        if (!repaired)
+        {
+            supervisor->stats.repair_failures[rung]++;
+        }
+        xSemaphoreGive(supervisor->lock);
+
+        if (repaired)
+        {
+            supervisor->rung = SUPERVISOR_NO_REPAIR;
+            supervisor->rung_failures = 0;
+            continue;
+        }
+
+        ESP_LOGW(TAG, "%s did not bring the %s layer back: %s", sim7080g_repair_name(rung), sim7080g_layer_name(target),
+                 esp_err_to_name(err));
+        supervisor->outage_failures++;
+        if (++supervisor->rung_failures >= supervisor->config.attempts_per_rung)
+        {
+            // Climb past every repair this outage has already tried, so rebuilding upwards cannot loop on the same ones
+            sim7080g_repair_t next = supervisor->highest_rung + 1;
+            sim7080g_repair_t top = sim7080g_supervisor_top_rung(supervisor);
+            supervisor->rung = (next < top) ? next : top;
+            supervisor->rung_failures = 0;
+        }
+        sim7080g_supervisor_sleep(supervisor, sim7080g_supervisor_backoff_ms(supervisor), false);
+    }
+
+    xSemaphoreGive(supervisor->task_stopped);
+    vTaskDelete(NULL);
+}
+
+static void sim7080g_supervisor_free(sim7080g_supervisor_t *supervisor)
+{
+    if (supervisor->task_stopped != NULL)
+    {
+        vSemaphoreDelete(supervisor->task_stopped);
+    }
+    if (supervisor->lock != NULL)
+    {
+        vSemaphoreDelete(supervisor->lock);
+    }
+    free(supervisor);
+}
+
+static void sim7080g_supervisor_unregister_urcs(sim7080g_supervisor_t *supervisor)
+{
+    for (size_t i = 0; i < SUPERVISOR_NUM_URC_PREFIXES; i++)
+    {
+        sim7080g_urc_unregister(supervisor->sim7080g_handle, SUPERVISOR_URC_PREFIXES[i], sim7080g_supervisor_urc);
+    }
+}
+
+esp_err_t sim7080g_supervisor_create(const sim7080g_handle_t *sim7080g_handle,
+                                     const sim7080g_supervisor_config_t *config,
+                                     sim7080g_supervisor_handle_t *supervisor_out)
+{
+    if (sim7080g_handle == NULL || supervisor_out == NULL)
+    {
+        ESP_LOGE(TAG, "Invalid parameters");
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    sim7080g_supervisor_t *supervisor = calloc(1, sizeof(*supervisor));
+    if (supervisor == NULL)
+    {
+        ESP_LOGE(TAG, "Error allocating supervisor");
+        return ESP_ERR_NO_MEM;
+    }
+    supervisor->sim7080g_handle = sim7080g_handle;
+    if (config != NULL)
+    {
+        supervisor->config = *config;
+    }
+    if (supervisor->config.check_interval_ms == 0)
+    {
+        supervisor->config.check_interval_ms = SIM7080G_SUPERVISOR_DEFAULT_CHECK_INTERVAL_MS;
+    }
+    if (supervisor->config.attempts_per_rung == 0)
+    {
+        supervisor->config.attempts_per_rung = SIM7080G_SUPERVISOR_DEFAULT_ATTEMPTS_PER_RUNG;
+    }
+    if (supervisor->config.backoff_base_ms == 0)
+    {
+        supervisor->config.backoff_base_ms = SIM7080G_SUPERVISOR_DEFAULT_BACKOFF_BASE_MS;
+    }
+    if (supervisor->config.backoff_max_ms == 0)
+    {
+        supervisor->config.backoff_max_ms = SIM7080G_SUPERVISOR_DEFAULT_BACKOFF_MAX_MS;
+    }
+    if (supervisor->config.registration_timeout_ms == 0)
+    {
+        supervisor->config.registration_timeout_ms = SIM7080G_SUPERVISOR_DEFAULT_REGISTRATION_TIMEOUT_MS;
+    }
+    supervisor->rung = SUPERVISOR_NO_REPAIR;
+    supervisor->highest_rung = SUPERVISOR_NO_REPAIR;
+    atomic_init(&supervisor->stop, false);
+
+    int64_t now = esp_timer_get_time();
+    for (int layer = 0; layer < SIM7080G_LAYER_COUNT; layer++)
+    {
+        supervisor->down_since_us[layer] = now;
+    }
+
+    int priority = (supervisor->config.task_priority > 0) ? supervisor->config.task_priority : SIM7080G_SUPERVISOR_TASK_DEFAULT_PRIORITY;
+    supervisor->lock = xSemaphoreCreateMutex();
+    supervisor->task_stopped = xSemaphoreCreateBinary();
+    if (supervisor->lock == NULL || supervisor->task_stopped == NULL ||
+        xTaskCreate(sim7080g_supervisor_task, "sim7080g_super", SIM7080G_SUPERVISOR_TASK_STACK_SIZE,
+                    supervisor, priority, &supervisor->task) != pdPASS)
+    {
+        ESP_LOGE(TAG, "Error creating supervisor task");
+        sim7080g_supervisor_free(supervisor);
+        return ESP_ERR_NO_MEM;
+    }
+
+    // The task is running before its reports are wired up - its first probe does not depend on them
+    for (size_t i = 0; i < SUPERVISOR_NUM_URC_PREFIXES; i++)
+    {
+        esp_err_t err = sim7080g_urc_register(sim7080g_handle, SUPERVISOR_URC_PREFIXES[i], sim7080g_supervisor_urc, supervisor);
+        if (err != ESP_OK)
+        {
+            ESP_LOGE(TAG, "Error registering handler for %s: %s", SUPERVISOR_URC_PREFIXES[i], esp_err_to_name(err));
+            sim7080g_supervisor_delete(supervisor);
+            return err;
+        }
+    }
+
+    *supervisor_out = supervisor;
+    return ESP_OK;
+}
+
+esp_err_t sim7080g_supervisor_check_now(sim7080g_supervisor_handle_t supervisor)
+{
+    if (supervisor == NULL)
+    {
+        ESP_LOGE(TAG, "Invalid parameters");
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    xTaskNotifyGive(supervisor->task);
+    return ESP_OK;
+}
+
+esp_err_t sim7080g_supervisor_get_stats(sim7080g_supervisor_handle_t supervisor, sim7080g_supervisor_stats_t *stats_out)
+{
+    if (supervisor == NULL || stats_out == NULL)
+    {
+        ESP_LOGE(TAG, "Invalid parameters");
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    xSemaphoreTake(supervisor->lock, portMAX_DELAY);
+    *stats_out = supervisor->stats;
+    xSemaphoreGive(supervisor->lock);
+    return ESP_OK;
+}
+
+esp_err_t sim7080g_supervisor_delete(sim7080g_supervisor_handle_t supervisor)
+{
+    if (supervisor == NULL)
+    {
+        ESP_LOGE(TAG, "Invalid parameters");
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    // Unregistering first means no handler can notify the task once it is gone
+    sim7080g_supervisor_unregister_urcs(supervisor);
+    atomic_store(&supervisor->stop, true);
+    xTaskNotifyGive(supervisor->task);
+    xSemaphoreTake(supervisor->task_stopped, portMAX_DELAY);
+    sim7080g_supervisor_free(supervisor);
+    return ESP_OK;
+}
@@ -0,0 +1,479 @@
+#include <stdatomic.h>
+#include <stdlib.h>
+#include <string.h>
+#include <esp_err.h>
+#include <esp_log.h>
+#include <esp_cpu.h>
+#include <esp_timer.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include <freertos/semphr.h>
+
+#include "sim7080g_telemetry_queue.h"
+
+#define TELEMETRY_TEST_PRODUCERS 3
+#define TELEMETRY_TEST_CAPACITY 64
+#define TELEMETRY_TEST_STALL_MS 1000
+
+static const char *TAG = "SIM7080G Telemetry";
+
+/// @brief One record slot - 'sequence' hands the slot back and forth between producers and the drain task
+/// @note A slot at ring position pos is free for the producer claiming pos while sequence == pos,
+///       and holds a record for the drain task once sequence == pos + 1
+typedef struct
+{
+    _Atomic uint32_t sequence;
+    uint16_t topic_id;
+    uint16_t len;
+    uint8_t payload[];
+} sim7080g_telemetry_slot_t;
+
+struct sim7080g_telemetry_queue
+{
+    const sim7080g_handle_t *sim7080g_handle;
+    sim7080g_telemetry_config_t config;
+    uint8_t *slots;
+    size_t slot_stride;
+    uint32_t mask;
+    _Atomic uint32_t enqueue_pos;     // Next position a producer claims
+    uint32_t dequeue_pos;             // Only touched by the drain task
+    atomic_bool drain_waiting;        // Drain task is (about to be) blocked waiting for a notification
+    atomic_bool stop;
+    TaskHandle_t drain_task;
+    SemaphoreHandle_t drain_stopped;
+    _Atomic uint32_t enqueued;
+    _Atomic uint32_t dropped;
+    uint32_t published;
+    uint32_t publish_errors;
+};
+
+static sim7080g_telemetry_slot_t *sim7080g_telemetry_slot(sim7080g_telemetry_queue_t *queue, uint32_t pos)
+{
+    return (sim7080g_telemetry_slot_t *)(queue->slots + (size_t)(pos & queue->mask) * queue->slot_stride);
+}
+
+/// @brief Allocate a queue without starting its drain task
+static sim7080g_telemetry_queue_t *sim7080g_telemetry_alloc(const sim7080g_telemetry_config_t *config)
+{
+    sim7080g_telemetry_queue_t *queue = calloc(1, sizeof(*queue));
+    if (queue == NULL)
+    {
+        return NULL;
+    }
+
+    queue->config = *config;
+    if (queue->config.capacity == 0)
+    {
+        queue->config.capacity = SIM7080G_TELEMETRY_DEFAULT_CAPACITY;
+    }
+    if (queue->config.max_payload_len == 0)
+    {
+        queue->config.max_payload_len = SIM7080G_TELEMETRY_DEFAULT_PAYLOAD_LEN;
+    }
+
+    size_t capacity = 2;
+    while (capacity < queue->config.capacity)
+    {
+        capacity <<= 1;
+    }
+    queue->config.capacity = capacity;
+    queue->mask = (uint32_t)(capacity - 1);
+
+    // Keep every slot's sequence word aligned
+    size_t align = _Alignof(sim7080g_telemetry_slot_t);
+    queue->slot_stride = (sizeof(sim7080g_telemetry_slot_t) + queue->config.max_payload_len + align - 1) & ~(align - 1);
+    queue->slots = malloc(queue->slot_stride * capacity);
+    if (queue->slots == NULL)
+    {
+        free(queue);
+        return NULL;
+    }
+
+    for (uint32_t pos = 0; pos < capacity; pos++)
+    {
+        atomic_init(&sim7080g_telemetry_slot(queue, pos)->sequence, pos);
+    }
+    atomic_init(&queue->enqueue_pos, 0);
+    atomic_init(&queue->drain_waiting, false);
+    atomic_init(&queue->stop, false);
+    atomic_init(&queue->enqueued, 0);
+    atomic_init(&queue->dropped, 0);
+    return queue;
+}
+
+static void sim7080g_telemetry_free(sim7080g_telemetry_queue_t *queue)
+{
+    if (queue->drain_stopped != NULL)
+    {
+        vSemaphoreDelete(queue->drain_stopped);
+    }
+    free(queue->slots);
+    free(queue);
+}
+
+/// @brief Oldest queued record, or NULL if the queue is empty - drain side only
+static sim7080g_telemetry_slot_t *sim7080g_telemetry_peek(sim7080g_telemetry_queue_t *queue)
+{
+    sim7080g_telemetry_slot_t *slot = sim7080g_telemetry_slot(queue, queue->dequeue_pos);
+    uint32_t sequence = atomic_load_explicit(&slot->sequence, memory_order_acquire);
+    return (sequence == queue->dequeue_pos + 1) ? slot : NULL;
+}
+
+/// @brief Hand the slot returned by sim7080g_telemetry_peek back to the producers
+static void sim7080g_telemetry_release(sim7080g_telemetry_queue_t *queue, sim7080g_telemetry_slot_t *slot)
+{
+    atomic_store_explicit(&slot->sequence, queue->dequeue_pos + queue->mask + 1, memory_order_release);
+    queue->dequeue_pos++;
+}
+
+static void sim7080g_telemetry_drain_task(void *arg)
+{
+    sim7080g_telemetry_queue_t *queue = arg;
+
+    while (true)
+    {
+        sim7080g_telemetry_slot_t *slot;
+        while ((slot = sim7080g_telemetry_peek(queue)) != NULL)
+        {
+            // Published straight from the slot - producers see it as taken until it is released
+            sim7080g_iovec_t iov = {.base = slot->payload, .len = slot->len};
+            esp_err_t err = sim7080g_mqtt_publish_iov(queue->sim7080g_handle, queue->config.topics[slot->topic_id],
+                                                      &iov, 1, queue->config.qos, false);
+            if (err == ESP_OK)
+            {
+                queue->published++;
+            }
+            else
+            {
+                ESP_LOGW(TAG, "Error publishing record to %s: %s", queue->config.topics[slot->topic_id], esp_err_to_name(err));
+                queue->publish_errors++;
+            }
+            sim7080g_telemetry_release(queue, slot);
+        }
+
+        if (atomic_load(&queue->stop))
+        {
+            break;
+        }
+
+        // Announce the wait, then look once more - a producer that published before seeing the flag is caught here,
+        // one that publishes after it sees the flag and sends the notification
+        atomic_store(&queue->drain_waiting, true);
+        atomic_thread_fence(memory_order_seq_cst);
+        if (sim7080g_telemetry_peek(queue) != NULL || atomic_load(&queue->stop))
+        {
+            atomic_store(&queue->drain_waiting, false);
+            continue;
+        }
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+    }
+
+    xSemaphoreGive(queue->drain_stopped);
+    vTaskDelete(NULL);
+}
+
+esp_err_t sim7080g_telemetry_create(const sim7080g_handle_t *sim7080g_handle,
+                                    const sim7080g_telemetry_config_t *config,
+                                    sim7080g_telemetry_queue_handle_t *queue_out)
+{
+    if (sim7080g_handle == NULL || config == NULL || config->topics == NULL || config->topic_count == 0 ||
+        config->topic_count > UINT16_MAX + 1 || config->max_payload_len > SIM7080G_MQTT_MAX_PAYLOAD_LEN ||
+        config->capacity > (1u << 16) || config->qos > 2 || queue_out == NULL)
+    {
+        ESP_LOGE(TAG, "Invalid parameters");
+        return ESP_ERR_INVALID_ARG;
+    }
+    for (size_t i = 0; i < config->topic_count; i++)
+    {
+        if (config->topics[i] == NULL || config->topics[i][0] == '\0')
+        {
+            ESP_LOGE(TAG, "Invalid parameters: topic_id %u has no topic", (unsigned)i);
+            return ESP_ERR_INVALID_ARG;
+        }
+    }
+
+    sim7080g_telemetry_queue_t *queue = sim7080g_telemetry_alloc(config);
+    if (queue == NULL)
+    {
+        ESP_LOGE(TAG, "Error allocating telemetry queue");
+        return ESP_ERR_NO_MEM;
+    }
+    queue->sim7080g_handle = sim7080g_handle;
+
+    int priority = (config->drain_task_priority > 0) ? config->drain_task_priority : SIM7080G_TELEMETRY_DRAIN_TASK_DEFAULT_PRIORITY;
+    queue->drain_stopped = xSemaphoreCreateBinary();
+    if (queue->drain_stopped == NULL ||
+        xTaskCreate(sim7080g_telemetry_drain_task, "sim7080g_telem", SIM7080G_TELEMETRY_DRAIN_TASK_STACK_SIZE,
+                    queue, priority, &queue->drain_task) != pdPASS)
+    {
+        ESP_LOGE(TAG, "Error creating telemetry drain task");
+        sim7080g_telemetry_free(queue);
+        return ESP_ERR_NO_MEM;
+    }
+
+    *queue_out = queue;
+    return ESP_OK;
+}
+
+esp_err_t sim7080g_telemetry_enqueue(sim7080g_telemetry_queue_handle_t queue, uint16_t topic_id, const void *payload, size_t len)
+{
+    // An empty record would be refused by the publish when drained - so it is refused here, where the caller sees it
+    if (queue == NULL || topic_id >= queue->config.topic_count || payload == NULL || len == 0)
+    {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (len > queue->config.max_payload_len)
+    {
+        return ESP_ERR_INVALID_SIZE;
+    }
+
+    // Claim a position - the CAS only fails if another producer claimed the same one first
+    sim7080g_telemetry_slot_t *slot;
+    uint32_t pos = atomic_load_explicit(&queue->enqueue_pos, memory_order_relaxed);
+    while (true)
+    {
+        slot = sim7080g_telemetry_slot(queue, pos);
+        int32_t diff = (int32_t)(atomic_load_explicit(&slot->sequence, memory_order_acquire) - pos);
+        if (diff == 0)
+        {
+            uint32_t expected = pos;
+            if (atomic_compare_exchange_weak_explicit(&queue->enqueue_pos, &expected, pos + 1,
+                                                      memory_order_relaxed, memory_order_relaxed))
+            {
+                break;
+            }
+            pos = expected;
+        }
+        else if (diff < 0)
+        {
+            // Slot still holds the record from one lap ago - the queue is full
+            atomic_fetch_add_explicit(&queue->dropped, 1, memory_order_relaxed);
+            return ESP_ERR_NO_MEM;
+        }
+        else
+        {
+            pos = atomic_load_explicit(&queue->enqueue_pos, memory_order_relaxed);
+        }
+    }
+
+    slot->topic_id = topic_id;
+    slot->len = (uint16_t)len;
+    if (len > 0)
+    {
+        memcpy(slot->payload, payload, len);
+    }
+    atomic_store_explicit(&slot->sequence, pos + 1, memory_order_release);
+    atomic_fetch_add_explicit(&queue->enqueued, 1, memory_order_relaxed);
+
+    // Only wake the drain task if it is waiting - the common case costs one load
+    atomic_thread_fence(memory_order_seq_cst);
+    if (atomic_load_explicit(&queue->drain_waiting, memory_order_relaxed) &&
+        atomic_exchange(&queue->drain_waiting, false) && queue->drain_task != NULL)
+    {
+        xTaskNotifyGive(queue->drain_task);
+    }
+    return ESP_OK;
+}
+
+esp_err_t sim7080g_telemetry_get_stats(sim7080g_telemetry_queue_handle_t queue, sim7080g_telemetry_stats_t *stats_out)
+{
+    if (queue == NULL || stats_out == NULL)
+    {
+        ESP_LOGE(TAG, "Invalid parameters");
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    // Each counter is read on its own - they may be a record apart while the queue is busy
+    stats_out->enqueued = atomic_load_explicit(&queue->enqueued, memory_order_relaxed);
+    stats_out->dropped = atomic_load_explicit(&queue->dropped, memory_order_relaxed);
+    stats_out->published = queue->published;
+    stats_out->publish_errors = queue->publish_errors;
+    return ESP_OK;
+}
+
+esp_err_t sim7080g_telemetry_delete(sim7080g_telemetry_queue_handle_t queue)
+{
+    if (queue == NULL)
+    {
+        ESP_LOGE(TAG, "Invalid parameters");
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    atomic_store(&queue->stop, true);
+    xTaskNotifyGive(queue->drain_task);
+    xSemaphoreTake(queue->drain_stopped, portMAX_DELAY);
+    sim7080g_telemetry_free(queue);
+    return ESP_OK;
+}
+
+// ------ INTERNAL TESTING ------ //
+
+typedef struct
+{
+    sim7080g_telemetry_queue_t *queue;
+    uint16_t producer_id;
+    int iterations;
+    SemaphoreHandle_t done;
+    uint64_t cycles; // Total over the enqueues that succeeded
+    uint32_t max_cycles;
+    uint32_t full; // Enqueues refused because the queue was full (retried)
+} telemetry_test_producer_t;
+
+typedef struct
+{
+    uint16_t producer_id;
+    uint32_t seq;
+} telemetry_test_record_t;
+
+static void telemetry_test_producer_task(void *arg)
+{
+    telemetry_test_producer_t *producer = arg;
+
+    for (int i = 0; i < producer->iterations; i++)
+    {
+        telemetry_test_record_t record = {.producer_id = producer->producer_id, .seq = (uint32_t)i};
+        while (true)
+        {
+            esp_cpu_cycle_count_t start = esp_cpu_get_cycle_count();
+            esp_err_t err = sim7080g_telemetry_enqueue(producer->queue, producer->producer_id, &record, sizeof(record));
+            uint32_t cycles = (uint32_t)(esp_cpu_get_cycle_count() - start);
+            if (err == ESP_OK)
+            {
+                producer->cycles += cycles;
+                producer->max_cycles = (cycles > producer->max_cycles) ? cycles : producer->max_cycles;
+                break;
+            }
+            producer->full++;
+            vTaskDelay(1);
+        }
+    }
+
+    xSemaphoreGive(producer->done);
+    vTaskDelete(NULL);
+}
+
+bool sim7080g_test_telemetry_queue(int iterations)
+{
+    if (iterations <= 0)
+    {
+        ESP_LOGE(TAG, "Telemetry queue test: Invalid parameters");
+        return false;
+    }
+
+    static const char *const topics[TELEMETRY_TEST_PRODUCERS] = {"test/0", "test/1", "test/2"};
+    const sim7080g_telemetry_config_t config = {
+        .topics = topics,
+        .topic_count = TELEMETRY_TEST_PRODUCERS,
+        .capacity = TELEMETRY_TEST_CAPACITY,
+        .max_payload_len = sizeof(telemetry_test_record_t),
+    };
+    sim7080g_telemetry_queue_t *queue = sim7080g_telemetry_alloc(&config); // No drain task - this task drains it
+    SemaphoreHandle_t done = xSemaphoreCreateCounting(TELEMETRY_TEST_PRODUCERS, 0);
+    if (queue == NULL || done == NULL)
+    {
+        ESP_LOGE(TAG, "Telemetry queue test: Error allocating queue");
+        if (queue != NULL)
+        {
+            sim7080g_telemetry_free(queue);
+        }
+        if (done != NULL)
+        {
+            vSemaphoreDelete(done);
+        }
+        return false;
+    }
+
+    telemetry_test_producer_t producers[TELEMETRY_TEST_PRODUCERS] = {0};
+    int started = 0;
+    for (int i = 0; i < TELEMETRY_TEST_PRODUCERS; i++)
+    {
+        producers[i] = (telemetry_test_producer_t){.queue = queue, .producer_id = (uint16_t)i, .iterations = iterations, .done = done};
+        if (xTaskCreate(telemetry_test_producer_task, "telem_producer", 2048, &producers[i], uxTaskPriorityGet(NULL), NULL) != pdPASS)
+        {
+            ESP_LOGE(TAG, "Telemetry queue test: Error creating producer task");
+            break;
+        }
+        started++;
+    }
+
+    bool passed = started == TELEMETRY_TEST_PRODUCERS;
+    uint32_t next_seq[TELEMETRY_TEST_PRODUCERS] = {0};
+    uint32_t expected = (uint32_t)started * (uint32_t)iterations;
+    uint32_t received = 0;
+    int64_t last_progress = esp_timer_get_time();
+    while (received < expected)
+    {
+        sim7080g_telemetry_slot_t *slot = sim7080g_telemetry_peek(queue);
+        if (slot == NULL)
+        {
+            if (esp_timer_get_time() - last_progress > TELEMETRY_TEST_STALL_MS * 1000LL)
+            {
+                ESP_LOGE(TAG, "Telemetry queue test: Stalled after %lu of %lu records", (unsigned long)received, (unsigned long)expected);
+                passed = false;
+                break;
+            }
+            vTaskDelay(1);
+            continue;
+        }
+
+        telemetry_test_record_t record;
+        memcpy(&record, slot->payload, sizeof(record));
+        if (slot->len != sizeof(record) || slot->topic_id != record.producer_id || record.producer_id >= TELEMETRY_TEST_PRODUCERS ||
+            record.seq != next_seq[record.producer_id])
+        {
+            ESP_LOGE(TAG, "Telemetry queue test: Bad record (topic_id %u, producer %u, seq %lu)",
+                     slot->topic_id, record.producer_id, (unsigned long)record.seq);
+            passed = false;
+        }
+        else
+        {
+            next_seq[record.producer_id]++;
+        }
+        sim7080g_telemetry_release(queue, slot);
+        received++;
+        last_progress = esp_timer_get_time();
+    }
+
+    // Producers hold pointers into this frame - wait for them whatever happened above, discarding anything
+    // still queued so none is left retrying against a full queue
+    int finished = 0;
+    while (finished < started)
+    {
+        if (xSemaphoreTake(done, pdMS_TO_TICKS(10)) == pdTRUE)
+        {
+            finished++;
+            continue;
+        }
+        sim7080g_telemetry_slot_t *slot;
+        while ((slot = sim7080g_telemetry_peek(queue)) != NULL)
+        {
+            sim7080g_telemetry_release(queue, slot);
+        }
+    }
+
+    uint64_t total_cycles = 0;
+    uint32_t max_cycles = 0;
+    uint32_t full = 0;
+    for (int i = 0; i < started; i++)
+    {
+        total_cycles += producers[i].cycles;
+        max_cycles = (producers[i].max_cycles > max_cycles) ? producers[i].max_cycles : max_cycles;
+        full += producers[i].full;
+    }
+
+    ESP_LOGI(TAG, "Telemetry queue test: %d producers x %d records, capacity %u", started, iterations, TELEMETRY_TEST_CAPACITY);
+    if (received > 0)
+    {
+        ESP_LOGI(TAG, "  enqueue: %llu cycles avg, %lu cycles max, %lu enqueues refused while full",
+                 (unsigned long long)(total_cycles / received), (unsigned long)max_cycles, (unsigned long)full);
+    }
+
+    sim7080g_telemetry_free(queue);
+    vSemaphoreDelete(done);
+
+    if (passed)
+    {
+        ESP_LOGI(TAG, "Telemetry queue test passed!");
+    }
+    return passed;
+}
@@ -0,0 +1,295 @@
+#include <stdlib.h>
+#include <string.h>
+#include "sim7080g_topic_trie.h"
+
+typedef struct topic_trie_value
+{
+    void *value;
+    struct topic_trie_value *next;
+} topic_trie_value_t;
+
+struct topic_trie_node
+{
+    topic_trie_node_t *children; // Exact levels
+    topic_trie_node_t *next;     // Next sibling in the parent's children
+    topic_trie_node_t *plus;     // '+' level
+    topic_trie_node_t *hash;     // '#' level - always a leaf
+    topic_trie_value_t *values;  // Values of the filter ending at this node, in insertion order
+    uint32_t level_hash;
+    uint16_t level_len;
+    char level[]; // Not null terminated
+};
+
+/// @brief FNV-1a - lets a sibling scan skip most levels without comparing them
+static uint32_t topic_level_hash(const char *level, size_t len)
+{
+    uint32_t hash = 2166136261u;
+    for (size_t i = 0; i < len; i++)
+    {
+        hash = (hash ^ (uint8_t)level[i]) * 16777619u;
+    }
+    return hash;
+}
+
+static size_t topic_level_len(const char *level, const char *end)
+{
+    const char *slash = memchr(level, '/', (size_t)(end - level));
+    return (size_t)(((slash != NULL) ? slash : end) - level);
+}
+
+/// @brief Start of the level after one of len bytes, or NULL if it was the last
+static const char *topic_next_level(const char *level, size_t len, const char *end)
+{
+    return (level + len < end) ? level + len + 1 : NULL;
+}
+
+static topic_trie_node_t *topic_trie_node_new(const char *level, size_t len)
+{
+    topic_trie_node_t *node = calloc(1, sizeof(*node) + len);
+    if (node != NULL)
+    {
+        memcpy(node->level, level, len);
+        node->level_len = (uint16_t)len;
+        node->level_hash = topic_level_hash(level, len);
+    }
+    return node;
+}
+
+/// @brief Where the child for a filter level is (or would be) linked - wildcards have their own slots
+static topic_trie_node_t **topic_trie_child_slot(topic_trie_node_t *node, const char *level, size_t len)
+{
+    if (len == 1 && level[0] == '+')
+    {
+        return &node->plus;
+    }
+    if (len == 1 && level[0] == '#')
+    {
+        return &node->hash;
+    }
+
+    uint32_t hash = topic_level_hash(level, len);
+    topic_trie_node_t **slot = &node->children;
+    while (*slot != NULL &&
+           !((*slot)->level_hash == hash && (*slot)->level_len == len && memcmp((*slot)->level, level, len) == 0))
+    {
+        slot = &(*slot)->next;
+    }
+    return slot;
+}
+
+static bool topic_trie_node_is_empty(const topic_trie_node_t *node)
+{
+    return node->children == NULL && node->plus == NULL && node->hash == NULL && node->values == NULL;
+}
+
+static void topic_trie_free_node(topic_trie_node_t *node, topic_trie_release_t release)
+{
+    while (node != NULL)
+    {
+        topic_trie_node_t *next = node->next;
+        topic_trie_free_node(node->children, release);
+        topic_trie_free_node(node->plus, release);
+        topic_trie_free_node(node->hash, release);
+        for (topic_trie_value_t *value = node->values; value != NULL;)
+        {
+            topic_trie_value_t *next_value = value->next;
+            if (release != NULL)
+            {
+                release(value->value);
+            }
+            free(value);
+            value = next_value;
+        }
+        free(node);
+        node = next;
+    }
+}
+
+void topic_trie_init(topic_trie_t *trie)
+{
+    trie->root = NULL;
+}
+
+void topic_trie_clear(topic_trie_t *trie, topic_trie_release_t release)
+{
+    topic_trie_free_node(trie->root, release);
+    trie->root = NULL;
+}
+
+bool topic_filter_is_valid(const char *filter)
+{
+    if (filter == NULL || filter[0] == '\0' || strlen(filter) > UINT16_MAX)
+    {
+        return false;
+    }
+
+    const char *end = filter + strlen(filter);
+    for (const char *level = filter; level != NULL;)
+    {
+        size_t len = topic_level_len(level, end);
+        const char *next = topic_next_level(level, len, end);
+        bool wildcard = memchr(level, '+', len) != NULL || memchr(level, '#', len) != NULL;
+        if (wildcard && (len != 1 || (level[0] == '#' && next != NULL)))
+        {
+            return false;
+        }
+        level = next;
+    }
+    return true;
+}
+
+bool topic_trie_insert(topic_trie_t *trie, const char *filter, void *value)
+{
+    if (!topic_filter_is_valid(filter))
+    {
+        return false;
+    }
+    if (trie->root == NULL && (trie->root = topic_trie_node_new("", 0)) == NULL)
+    {
+        return false;
+    }
+
+    const char *end = filter + strlen(filter);
+    topic_trie_node_t *node = trie->root;
+    for (const char *level = filter; level != NULL;)
+    {
+        size_t len = topic_level_len(level, end);
+        topic_trie_node_t **slot = topic_trie_child_slot(node, level, len);
+        if (*slot == NULL && (*slot = topic_trie_node_new(level, len)) == NULL)
+        {
+            return false; // Nodes added so far are empty - removed with the next removal on this path
+        }
+        node = *slot;
+        level = topic_next_level(level, len, end);
+    }
+
+    topic_trie_value_t *entry = malloc(sizeof(*entry));
+    if (entry == NULL)
+    {
+        return false;
+    }
+    entry->value = value;
+    entry->next = NULL;
+
+    topic_trie_value_t **tail = &node->values;
+    while (*tail != NULL)
+    {
+        tail = &(*tail)->next;
+    }
+    *tail = entry;
+    return true;
+}
+
+/// @brief Remove values from the filter below *slot, unlinking every node left empty on the way back up
+static size_t topic_trie_remove_at(topic_trie_node_t **slot, const char *level, const char *end,
+                                   void *value, topic_trie_release_t release)
+{
+    topic_trie_node_t *node = *slot;
+    size_t removed = 0;
+
+    if (level == NULL)
+    {
+        for (topic_trie_value_t **entry = &node->values; *entry != NULL;)
+        {
+            if (value != NULL && (*entry)->value != value)
+            {
+                entry = &(*entry)->next;
+                continue;
+            }
+            topic_trie_value_t *found = *entry;
+            *entry = found->next;
+            if (release != NULL)
+            {
+                release(found->value);
+            }
+            free(found);
+            removed++;
+        }
+    }
+    else
+    {
+        size_t len = topic_level_len(level, end);
+        topic_trie_node_t **child = topic_trie_child_slot(node, level, len);
+        if (*child != NULL)
+        {
+            removed = topic_trie_remove_at(child, topic_next_level(level, len, end), end, value, release);
+        }
+    }
+
+    if (topic_trie_node_is_empty(node))
+    {
+        *slot = node->next;
+        free(node);
+    }
+    return removed;
+}
+
+size_t topic_trie_remove(topic_trie_t *trie, const char *filter, void *value, topic_trie_release_t release)
+{
+    if (trie->root == NULL || !topic_filter_is_valid(filter))
+    {
+        return 0;
+    }
+    return topic_trie_remove_at(&trie->root, filter, filter + strlen(filter), value, release);
+}
+
+static size_t topic_trie_visit_values(const topic_trie_node_t *node, topic_trie_visit_t visit, void *arg)
+{
+    size_t visited = 0;
+    for (const topic_trie_value_t *entry = node->values; entry != NULL; entry = entry->next)
+    {
+        visit(entry->value, arg);
+        visited++;
+    }
+    return visited;
+}
+
+static size_t topic_trie_match_node(const topic_trie_node_t *node, const char *level, const char *end, bool first,
+                                    topic_trie_visit_t visit, void *arg)
+{
+    if (level == NULL)
+    {
+        // Every level matched - "a/#" also matches "a" itself
+        size_t visited = topic_trie_visit_values(node, visit, arg);
+        if (node->hash != NULL)
+        {
+            visited += topic_trie_visit_values(node->hash, visit, arg);
+        }
+        return visited;
+    }
+
+    size_t visited = 0;
+    size_t len = topic_level_len(level, end);
+    const char *next = topic_next_level(level, len, end);
+    bool wildcards = !(first && len > 0 && level[0] == '$');
+
+    if (wildcards && node->hash != NULL)
+    {
+        visited += topic_trie_visit_values(node->hash, visit, arg);
+    }
+
+    uint32_t hash = topic_level_hash(level, len);
+    for (const topic_trie_node_t *child = node->children; child != NULL; child = child->next)
+    {
+        if (child->level_hash == hash && child->level_len == len && memcmp(child->level, level, len) == 0)
+        {
+            visited += topic_trie_match_node(child, next, end, false, visit, arg);
+            break;
+        }
+    }
+
+    if (wildcards && node->plus != NULL)
+    {
+        visited += topic_trie_match_node(node->plus, next, end, false, visit, arg);
+    }
+    return visited;
+}
+
+size_t topic_trie_match(const topic_trie_t *trie, const char *topic, size_t topic_len, topic_trie_visit_t visit, void *arg)
+{
+    if (trie->root == NULL || topic == NULL || visit == NULL)
+    {
+        return 0;
+    }
+    return topic_trie_match_node(trie->root, topic, topic + topic_len, true, visit, arg);
+}